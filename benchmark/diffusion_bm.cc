@@ -0,0 +1,146 @@
+// -----------------------------------------------------------------------------
+//
+// Copyright (C) 2021 CERN & University of Surrey for the benefit of the
+// BioDynaMo collaboration. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+//
+// See the LICENSE file distributed with this work for details.
+// See the NOTICE file distributed with this work for additional information
+// regarding copyright ownership.
+//
+// -----------------------------------------------------------------------------
+
+#include <benchmark/benchmark.h>
+#include <memory>
+#include <vector>
+#include "core/diffusion/euler_grid.h"
+#include "core/diffusion/sparse_euler_grid.h"
+#include "core/environment/environment.h"
+#include "core/param/param.h"
+#include "core/simulation.h"
+
+namespace bdm {
+namespace diffusion_bm {
+
+// Number of boxes of the STREAM-like copy benchmark. Large enough to not fit
+// into the last level cache.
+constexpr size_t kStreamSize = 1 << 25;
+
+// Number of time steps that are integrated per benchmark iteration.
+constexpr int kSteps = 8;
+
+// Memory bandwidth ceiling of the roofline model: copy `kStreamSize` values
+// from one array to another.
+static void StreamCopy(benchmark::State& state) {
+  std::vector<real_t> a(kStreamSize, 1);
+  std::vector<real_t> b(kStreamSize, 0);
+  for (auto _ : state) {
+#pragma omp parallel for simd schedule(static)
+    for (size_t i = 0; i < kStreamSize; i++) {
+      b[i] = a[i];
+    }
+    benchmark::DoNotOptimize(b.data());
+    benchmark::ClobberMemory();
+  }
+  state.SetBytesProcessed(state.iterations() * 2 * sizeof(real_t) *
+                          kStreamSize);
+}
+
+BENCHMARK(StreamCopy)->UseRealTime();
+
+// Integrates a substance for `kSteps` time steps.
+// Arguments: resolution, Param::diffusion_temporal_blocking.
+// `bytes_per_second` is the effective bandwidth, i.e. the traffic of the
+// unblocked kernel (one read and one write per box and step) divided by the
+// run time. Compare it against `StreamCopy`: the unblocked kernel is bounded
+// by the copy bandwidth for large grids, while temporal blocking can exceed
+// it. `flops` counts the floating point operations of the stencil update.
+static void EulerGridMultiStep(benchmark::State& state) {
+  const int resolution = state.range(0);
+  const uint64_t temporal_blocking = state.range(1);
+  auto set_param = [&](Param* param) {
+    param->bound_space = Param::BoundSpaceMode::kClosed;
+    param->min_bound = -500;
+    param->max_bound = 500;
+    param->diffusion_boundary_condition = "Neumann";
+    param->diffusion_temporal_blocking = temporal_blocking;
+  };
+  Simulation simulation("EulerGridMultiStep", set_param);
+  simulation.GetEnvironment()->Update();
+
+  EulerGrid dgrid(0, "Substance", 1.0, 0.01, resolution);
+  dgrid.Initialize();
+  dgrid.ChangeConcentrationBy({0, 0, 0}, 1e3);
+  const real_t dt = 0.1 * dgrid.GetBoxLength() * dgrid.GetBoxLength();
+
+  for (auto _ : state) {
+    dgrid.MultiStep(dt, kSteps);
+    benchmark::DoNotOptimize(dgrid.GetAllConcentrations());
+  }
+
+  const double box_updates = static_cast<double>(state.iterations()) *
+                             kSteps * dgrid.GetNumBoxes();
+  state.SetBytesProcessed(
+      static_cast<int64_t>(box_updates * 2 * sizeof(real_t)));
+  // The stencil update of one box takes 13 floating point operations. The
+  // arithmetic intensity refers to the main memory traffic of one pass over
+  // the grid, which advances `temporal_blocking` steps.
+  state.counters["flops"] =
+      benchmark::Counter(box_updates * 13, benchmark::Counter::kIsRate);
+  state.counters["intensity"] =
+      benchmark::Counter(13.0 / (2 * sizeof(real_t)) * temporal_blocking);
+}
+
+BENCHMARK(EulerGridMultiStep)
+    ->ArgsProduct({{64, 256}, {1, 2, 4, 8}})
+    ->UseRealTime();
+
+// Integrates a substance that is secreted in the center of the grid for
+// `kSteps` time steps. Arguments: resolution, use `SparseEulerGrid`,
+// Param::diffusion_sparse_tolerance (in units of 1e-9). `active_bricks` is the
+// fraction of bricks that the sparse grid updated in the last step.
+static void SparseEulerGridLocalSource(benchmark::State& state) {
+  const int resolution = state.range(0);
+  const bool sparse = state.range(1);
+  auto set_param = [&](Param* param) {
+    param->bound_space = Param::BoundSpaceMode::kClosed;
+    param->min_bound = -500;
+    param->max_bound = 500;
+    param->diffusion_boundary_condition = "closed";
+    param->diffusion_sparse_tolerance = state.range(2) * 1e-9;
+  };
+  Simulation simulation("SparseEulerGridLocalSource", set_param);
+  simulation.GetEnvironment()->Update();
+
+  std::unique_ptr<EulerGrid> dgrid;
+  if (sparse) {
+    dgrid = std::make_unique<SparseEulerGrid>(0, "Substance", 1.0, 0.01,
+                                              resolution);
+  } else {
+    dgrid = std::make_unique<EulerGrid>(0, "Substance", 1.0, 0.01, resolution);
+  }
+  dgrid->Initialize();
+  const real_t dt = 0.1 * dgrid->GetBoxLength() * dgrid->GetBoxLength();
+
+  for (auto _ : state) {
+    dgrid->ChangeConcentrationBy({0, 0, 0}, 1.0);
+    dgrid->MultiStep(dt, kSteps);
+    benchmark::DoNotOptimize(dgrid->GetAllConcentrations());
+  }
+
+  if (sparse) {
+    auto* sparse_grid = static_cast<SparseEulerGrid*>(dgrid.get());
+    state.counters["active_bricks"] =
+        static_cast<double>(sparse_grid->GetNumActiveBricks()) /
+        sparse_grid->GetNumBricks();
+  }
+}
+
+BENCHMARK(SparseEulerGridLocalSource)
+    ->ArgsProduct({{256}, {0, 1}, {0, 1}})
+    ->UseRealTime();
+
+}  // namespace diffusion_bm
+}  // namespace bdm
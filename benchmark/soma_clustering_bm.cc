@@ -40,5 +40,17 @@ static void SomaClustering0(benchmark::State& state) {
 
 BENCHMARK(SomaClustering0)->MeasureProcessCPUTime();
 
+static void SomaClusteringCountingSort(benchmark::State& state) {
+  const char* argv[3] = {
+      "./soma_clustering_counting_sort", "--inline-config",
+      "{ \"bdm::Param\":{ \"export_visualization\": false, "
+      "\"uniform_grid_counting_sort\": true } }"};
+  for (auto _ : state) {
+    Simulate(3, argv);
+  }
+}
+
+BENCHMARK(SomaClusteringCountingSort)->MeasureProcessCPUTime();
+
 }  // namespace soma_clustering
 }  // namespace bdm
@@ -42,5 +42,17 @@ static void TumorConcept0(benchmark::State& state) {
 
 BENCHMARK(TumorConcept0)->MeasureProcessCPUTime();
 
+static void TumorConceptCountingSort(benchmark::State& state) {
+  const char* argv[3] = {
+      "./tumor_concept_counting_sort", "--inline-config",
+      "{ \"bdm::Param\":{ \"export_visualization\": false, "
+      "\"uniform_grid_counting_sort\": true } }"};
+  for (auto _ : state) {
+    Simulate(3, argv);
+  }
+}
+
+BENCHMARK(TumorConceptCountingSort)->MeasureProcessCPUTime();
+
 }  // namespace tumor_concept
 }  // namespace bdm
@@ -18,6 +18,7 @@
 #include <atomic>
 #include <limits>
 #include <mutex>
+#include <utility>
 #include "core/agent/agent_handle.h"
 #include "core/agent/agent_uid.h"
 #include "core/container/agent_uid_map.h"
@@ -42,7 +43,12 @@ class AgentUidGenerator {
   /// and increments the reused field.
   /// Thread-safe.
   AgentUid GenerateUid() {
-    auto& old_uids = tl_uids_[tinfo_->GetMyThreadId()];
+    auto tid = tinfo_->GetMyThreadId();
+    auto& range = tl_ranges_[tid];
+    if (range.first < range.second) {
+      return AgentUid(range.first++);
+    }
+    auto& old_uids = tl_uids_[tid];
     if (old_uids.size()) {
       auto uid = old_uids.back();
       old_uids.pop_back();
@@ -55,6 +61,19 @@ class AgentUidGenerator {
   /// Thread-safe.
   AgentUid::Index_t GetHighestIndex() const { return counter_; }
 
+  /// Reserves `count` consecutive index values for the calling thread.
+  /// Subsequent calls to GenerateUid from this thread return these values
+  /// first. Hence, agents that are created in bulk obtain a contiguous range
+  /// of AgentUids with a single atomic operation.
+  /// Index values of a previous reservation that have not been used yet are
+  /// discarded.
+  /// Thread-safe.
+  void ReserveUids(uint64_t count) {
+    auto& range = tl_ranges_[tinfo_->GetMyThreadId()];
+    range.first = counter_.fetch_add(count);
+    range.second = range.first + count;
+  }
+
   /// Adds AgentUid that can be reused after AgentUid::reused_ is incremented.
   /// Thread-safe.
   void ReuseAgentUid(const AgentUid& uid) {
@@ -64,7 +83,10 @@ class AgentUidGenerator {
   /// Resizes internal data structures to the number of threads.
   /// NB: If Update is called, calls to GenerateUid or ReuseAgentUid are not
   /// allowed!
-  void Update() { tl_uids_.resize(tinfo_->GetMaxThreads()); }
+  void Update() {
+    tl_uids_.resize(tinfo_->GetMaxThreads());
+    tl_ranges_.resize(tinfo_->GetMaxThreads());
+  }
 
  private:
   std::atomic<typename AgentUid::Index_t> counter_;  //!
@@ -74,6 +96,10 @@ class AgentUidGenerator {
 
   /// Thread local vector of AgentUids that can be reused
   SharedData<std::vector<AgentUid>> tl_uids_;
+  /// Thread local ranges [first, second) of reserved index values
+  SharedData<std::pair<typename AgentUid::Index_t,
+                       typename AgentUid::Index_t>>
+      tl_ranges_;  //!
   ThreadInfo* tinfo_ = nullptr;  //!
 
   BDM_CLASS_DEF_NV(AgentUidGenerator, 1);
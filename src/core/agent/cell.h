@@ -34,11 +34,12 @@
 #include "core/param/param.h"
 #include "core/shape.h"
 #include "core/util/math.h"
+#include "core/util/random.h"
 
 namespace bdm {
 
 class Cell : public Agent {
-  BDM_AGENT_HEADER(Cell, Agent, 1);
+  BDM_AGENT_HEADER(Cell, Agent, 2);
 
  public:
   /// First axis of the local coordinate system.
@@ -120,6 +121,11 @@ class Cell : public Agent {
 
       daughter->SetAdherence(mother_cell->GetAdherence());
       daughter->SetDensity(mother_cell->GetDensity());
+
+      // The keys of both cells are derived from the key of the mother, such
+      // that they do not depend on the order in which cells divide.
+      daughter->rng_key_ = PhiloxRng::SplitKey(mother_cell->rng_key_, 1);
+      mother_cell->rng_key_ = PhiloxRng::SplitKey(mother_cell->rng_key_, 0);
       // G) TODO(lukas) Copy the intracellular and membrane bound Substances
     }
   }
@@ -132,7 +138,15 @@ class Cell : public Agent {
   /// The axis of division is random.
   /// \see CellDivisionEvent
   virtual Cell* Divide() {
-    auto* random = Simulation::GetActive()->GetRandom();
+    auto* sim = Simulation::GetActive();
+    if (sim->GetParam()->use_counter_based_rng) {
+      auto rng = Random::GetCounterBasedRng(rng_key_, kDivisionRngStream);
+      auto volume_ratio = rng.Uniform(real_t(0.9), real_t(1.1));
+      real_t theta = 2 * Math::kPi * rng.Uniform(0, 1);
+      real_t phi = std::acos(2 * rng.Uniform(0, 1) - 1);
+      return Divide(volume_ratio, phi, theta);
+    }
+    auto* random = sim->GetRandom();
     return Divide(random->Uniform(real_t(0.9), real_t(1.1)));
   }
 
@@ -143,7 +157,14 @@ class Cell : public Agent {
   virtual Cell* Divide(real_t volume_ratio) {
     // find random point on sphere (based on :
     // http://mathworld.wolfram.com/SpherePointPicking.html)
-    auto* random = Simulation::GetActive()->GetRandom();
+    auto* sim = Simulation::GetActive();
+    if (sim->GetParam()->use_counter_based_rng) {
+      auto rng = Random::GetCounterBasedRng(rng_key_, kDivisionRngStream);
+      real_t theta = 2 * Math::kPi * rng.Uniform(0, 1);
+      real_t phi = std::acos(2 * rng.Uniform(0, 1) - 1);
+      return Divide(volume_ratio, phi, theta);
+    }
+    auto* random = sim->GetRandom();
     real_t theta = 2 * Math::kPi * random->Uniform(0, 1);
     real_t phi = std::acos(2 * random->Uniform(0, 1) - 1);
     return Divide(volume_ratio, phi, theta);
@@ -154,8 +175,14 @@ class Cell : public Agent {
   /// CellDivisionEvent::volume_ratio will be between 0.9 and 1.1\n
   /// \see CellDivisionEvent
   virtual Cell* Divide(const Real3& axis) {
-    auto* random = Simulation::GetActive()->GetRandom();
     auto polarcoord = TransformCoordinatesGlobalToPolar(axis + position_);
+    auto* sim = Simulation::GetActive();
+    if (sim->GetParam()->use_counter_based_rng) {
+      auto rng = Random::GetCounterBasedRng(rng_key_, kDivisionRngStream);
+      return Divide(rng.Uniform(real_t(0.9), real_t(1.1)), polarcoord[1],
+                    polarcoord[2]);
+    }
+    auto* random = sim->GetRandom();
     return Divide(random->Uniform(real_t(0.9), real_t(1.1)), polarcoord[1],
                   polarcoord[2]);
   }
@@ -179,6 +206,12 @@ class Cell : public Agent {
 
   real_t GetAdherence() const { return adherence_; }
 
+  /// Returns the key of the counter-based random number generator of this
+  /// cell (see `Param::use_counter_based_rng`). Cells that are not created
+  /// by division use their uid. At division, the mother and the daughter
+  /// obtain new keys that are derived from the key of the mother.
+  uint64_t GetRngKey() const { return rng_key_; }
+
   real_t GetDiameter() const override { return diameter_; }
 
   real_t GetMass() const { return density_ * volume_; }
@@ -270,22 +303,6 @@ class Cell : public Agent {
     // is not applied if the total Force is smaller than adherence.
     // Once, I should look at this more carefully.
 
-    // fixme why? copying
-    const auto& tf = GetTractorForce();
-
-    // the 3 types of movement that can occur
-    // bool biological_translation = false;
-    bool physical_translation = false;
-    // bool physical_rotation = false;
-
-    real_t h = dt;
-    Real3 movement_at_next_step{0, 0, 0};
-
-    // BIOLOGY :
-    // 0) Start with tractor force : What the biology defined as active
-    // movement------------
-    movement_at_next_step += tf * h;
-
     // PHYSICS
     // the physics force to move the point mass
     Real3 translation_force_on_point_mass{0, 0, 0};
@@ -317,12 +334,39 @@ class Cell : public Agent {
             }
           });
       ctxt->ForEachNeighbor(calculate_neighbor_forces, *this, squared_radius);
+    }
 
-      if (non_zero_neighbor_forces > 1) {
-        SetStaticnessNextTimestep(false);
-      }
+    return CalculateDisplacement(translation_force_on_point_mass,
+                                 non_zero_neighbor_forces, dt);
+  }
+
+  /// Calculates the displacement of this cell given the sum of all forces
+  /// that its neighbors exert on it (`translation_force_on_point_mass`), and
+  /// the number of neighbors that exert a non-zero force.\n
+  /// This function is used if the neighbor forces have been computed
+  /// beforehand (see `Param::pairwise_mechanical_forces`).
+  Real3 CalculateDisplacement(const Real3& translation_force_on_point_mass,
+                              uint64_t non_zero_neighbor_forces, real_t dt) {
+    if (non_zero_neighbor_forces > 1) {
+      SetStaticnessNextTimestep(false);
     }
 
+    // fixme why? copying
+    const auto& tf = GetTractorForce();
+
+    // the 3 types of movement that can occur
+    // bool biological_translation = false;
+    bool physical_translation = false;
+    // bool physical_rotation = false;
+
+    real_t h = dt;
+    Real3 movement_at_next_step{0, 0, 0};
+
+    // BIOLOGY :
+    // 0) Start with tractor force : What the biology defined as active
+    // movement------------
+    movement_at_next_step += tf * h;
+
     // 4) PhysicalBonds
     // How the physics influences the next displacement
     real_t norm_of_force = std::sqrt(translation_force_on_point_mass *
@@ -359,6 +403,10 @@ class Cell : public Agent {
   }
 
  protected:
+  /// Stream of the counter-based random number generator used for cell
+  /// division (see `Param::use_counter_based_rng`)
+  static constexpr uint32_t kDivisionRngStream = 1;
+
   /// Returns the position in the polar coordinate system (cylindrical or
   /// spherical) of a point expressed in global cartesian coordinates
   /// ([1,0,0],[0,1,0],[0,0,1]).
@@ -377,6 +425,8 @@ class Cell : public Agent {
   real_t adherence_ = 0;
   /// NB: Use setter and don't assign values directly
   real_t density_ = 0;
+  /// \see GetRngKey
+  uint64_t rng_key_ = GetUid();
 };
 
 }  // namespace bdm
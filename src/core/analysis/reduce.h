@@ -178,11 +178,28 @@ inline void GenericReducer<T, TResult>::Streamer(TBuffer& R__b) {
 /// \endcode
 /// The optional argument `filter` allows to reduce only a subset of
 /// all agents.\n
+/// If `Param::deterministic_scheduling` is set, there is one partial result
+/// per chunk of `Param::scheduling_batch_size` agents instead of one per
+/// thread. The result is then independent of the number of threads, also for
+/// non-associative operations like floating point additions.\n
 /// NB: For better performance consider using `GenericReducer` instead.
 template <typename T>
 inline T Reduce(Simulation* sim, Functor<void, Agent*, T*>& agent_functor,
                 Functor<T, const SharedData<T>&>& reduce_partial_results,
                 Functor<bool, Agent*>* filter = nullptr) {
+  auto* rm = sim->GetResourceManager();
+  auto* param = sim->GetParam();
+  if (param->deterministic_scheduling) {
+    auto chunk = param->scheduling_batch_size;
+    SharedData<T> chunk_results(rm->GetNumChunks(chunk), T());
+    auto chunk_agent_func =
+        L2F([&](Agent* agent, AgentHandle, uint64_t chunk_idx) {
+          agent_functor(agent, &(chunk_results[chunk_idx]));
+        });
+    rm->ForEachAgentParallelDeterministic(chunk, chunk_agent_func, filter);
+    return reduce_partial_results(chunk_results);
+  }
+
   // The thread-local (partial) results
   SharedData<T> tl_results;
   // initialize thread local data
@@ -197,7 +214,6 @@ inline T Reduce(Simulation* sim, Functor<void, Agent*, T*>& agent_functor,
     auto tid = ThreadInfo::GetInstance()->GetMyThreadId();
     agent_functor(agent, &(tl_results[tid]));
   });
-  auto* rm = sim->GetResourceManager();
   rm->ForEachAgentParallel(actual_agent_func, filter);
   //   combine thread-local results
   return reduce_partial_results(tl_results);
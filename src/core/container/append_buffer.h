@@ -0,0 +1,102 @@
+// -----------------------------------------------------------------------------
+//
+// Copyright (C) 2021 CERN & University of Surrey for the benefit of the
+// BioDynaMo collaboration. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+//
+// See the LICENSE file distributed with this work for details.
+// See the NOTICE file distributed with this work for additional information
+// regarding copyright ownership.
+//
+// -----------------------------------------------------------------------------
+
+#ifndef CORE_CONTAINER_APPEND_BUFFER_H_
+#define CORE_CONTAINER_APPEND_BUFFER_H_
+
+#include <algorithm>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace bdm {
+
+/// \brief Append-only buffer that stores its elements in fixed-size chunks.
+/// In contrast to std::vector, growing the buffer never moves elements and
+/// `clear` keeps the allocated chunks for reuse in the next iteration.
+/// Designed as thread-local staging area: each thread appends to its own
+/// buffer without synchronization; the buffers are merged afterwards with
+/// an exclusive prefix sum over their sizes.
+template <typename T, uint64_t kChunkSize = 1024>
+class AppendBuffer {
+  static_assert((kChunkSize & (kChunkSize - 1)) == 0,
+                "kChunkSize must be a power of two");
+
+ public:
+  using value_type = T;
+
+  struct Iterator {
+    const AppendBuffer* buffer;
+    uint64_t index;
+    Iterator& operator++() {
+      ++index;
+      return *this;
+    }
+    bool operator==(const Iterator& other) const {
+      return index == other.index && buffer == other.buffer;
+    }
+    bool operator!=(const Iterator& other) const { return !operator==(other); }
+    const T& operator*() const { return (*buffer)[index]; }
+  };
+
+  AppendBuffer() = default;
+
+  void push_back(const T& element) {  // NOLINT
+    auto chunk_idx = size_ / kChunkSize;
+    if (chunk_idx == chunks_.size()) {
+      chunks_.emplace_back(new T[kChunkSize]);
+    }
+    chunks_[chunk_idx][size_ % kChunkSize] = element;
+    ++size_;
+  }
+
+  T& operator[](uint64_t index) {
+    return chunks_[index / kChunkSize][index % kChunkSize];
+  }
+
+  const T& operator[](uint64_t index) const {
+    return chunks_[index / kChunkSize][index % kChunkSize];
+  }
+
+  uint64_t size() const { return size_; }  // NOLINT
+
+  bool empty() const { return size_ == 0; }  // NOLINT
+
+  /// Number of elements that can be stored without allocating a new chunk
+  uint64_t capacity() const { return chunks_.size() * kChunkSize; }  // NOLINT
+
+  /// Removes all elements, but keeps the allocated memory.
+  void clear() { size_ = 0; }  // NOLINT
+
+  /// Copies all elements to `dest`, which must provide space for `size()`
+  /// elements. Copies whole chunks at once.
+  void CopyTo(T* dest) const {
+    for (uint64_t i = 0; i < size_; i += kChunkSize) {
+      auto n = std::min(kChunkSize, size_ - i);
+      std::copy(chunks_[i / kChunkSize].get(),
+                chunks_[i / kChunkSize].get() + n, dest + i);
+    }
+  }
+
+  Iterator begin() const { return Iterator{this, 0}; }  // NOLINT
+  Iterator end() const { return Iterator{this, size_}; }  // NOLINT
+
+ private:
+  std::vector<std::unique_ptr<T[]>> chunks_;
+  uint64_t size_ = 0;
+};
+
+}  // namespace bdm
+
+#endif  // CORE_CONTAINER_APPEND_BUFFER_H_
@@ -0,0 +1,339 @@
+// -----------------------------------------------------------------------------
+//
+// Copyright (C) 2021 CERN & University of Surrey for the benefit of the
+// BioDynaMo collaboration. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+//
+// See the LICENSE file distributed with this work for details.
+// See the NOTICE file distributed with this work for additional information
+// regarding copyright ownership.
+//
+// -----------------------------------------------------------------------------
+
+#include "core/diffusion/adi_grid.h"
+
+#include <cmath>
+
+namespace bdm {
+
+namespace {
+
+/// Solves the tridiagonal systems of the lines `[xlo, xhi)` in place.
+/// Element `i` of line `x` is stored at `base[i * stride + x]`. Iterating over
+/// the lines in the innermost loop allows vectorization for the y and z axes.
+template <typename TSystem>
+void SolveLines(const TSystem& sys, bool fixed_boundary, real_t* base,
+                size_t stride, size_t xlo, size_t xhi,
+                std::vector<real_t>* scratch) {
+  const auto first = sys.first;
+  const auto last = sys.last;
+  const auto a = sys.off_diagonal;
+  // prescribed boundary values move to the right hand side
+  if (fixed_boundary) {
+    auto* v0 = base + first * stride;
+    auto* vb0 = base + (first - 1) * stride;
+    auto* vn = base + last * stride;
+    auto* vbn = base + (last + 1) * stride;
+#pragma omp simd
+    for (size_t x = xlo; x < xhi; ++x) {
+      v0[x] -= a * vb0[x];
+      vn[x] -= a * vbn[x];
+    }
+  }
+  // forward elimination
+  {
+    auto* v = base + first * stride;
+    const auto inv = sys.inv_diagonal[first];
+#pragma omp simd
+    for (size_t x = xlo; x < xhi; ++x) {
+      v[x] *= inv;
+    }
+  }
+  for (size_t i = first + 1; i <= last; ++i) {
+    auto* v = base + i * stride;
+    const auto* prev = v - stride;
+    const auto inv = sys.inv_diagonal[i];
+#pragma omp simd
+    for (size_t x = xlo; x < xhi; ++x) {
+      v[x] = (v[x] - a * prev[x]) * inv;
+    }
+  }
+  // back substitution
+  for (size_t i = last; i-- > first;) {
+    auto* v = base + i * stride;
+    const auto* next = v + stride;
+    const auto upper = sys.upper[i];
+#pragma omp simd
+    for (size_t x = xlo; x < xhi; ++x) {
+      v[x] -= upper * next[x];
+    }
+  }
+  // Sherman-Morrison correction for the corner elements of the cyclic system
+  if (sys.cyclic) {
+    scratch->resize(xhi);
+    auto* factor = scratch->data();
+    const auto* v0 = base + first * stride;
+    const auto* vn = base + last * stride;
+#pragma omp simd
+    for (size_t x = xlo; x < xhi; ++x) {
+      factor[x] = (v0[x] + a * vn[x] / sys.gamma) / sys.correction_denominator;
+    }
+    for (size_t i = first; i <= last; ++i) {
+      auto* v = base + i * stride;
+      const auto z = sys.correction[i];
+#pragma omp simd
+      for (size_t x = xlo; x < xhi; ++x) {
+        v[x] -= factor[x] * z;
+      }
+    }
+  }
+}
+
+}  // namespace
+
+void AdiGrid::DiffuseWithClosedEdge(real_t dt) { DiffuseAdi(dt); }
+
+void AdiGrid::DiffuseWithOpenEdge(real_t dt) { DiffuseAdi(dt); }
+
+void AdiGrid::DiffuseWithDirichlet(real_t dt) { DiffuseAdi(dt); }
+
+void AdiGrid::DiffuseWithNeumann(real_t dt) { DiffuseAdi(dt); }
+
+void AdiGrid::DiffuseWithPeriodic(real_t dt) { DiffuseAdi(dt); }
+
+void AdiGrid::ParametersCheck(real_t dt) {
+  for (auto n : num_boxes_axis_) {
+    if (n < 3) {
+      Log::Fatal("AdiGrid", "The resolution of substance [",
+                 GetContinuumName(),
+                 "] must be at least 3 along each axis (resolution = ", n,
+                 ").");
+    }
+  }
+}
+
+bool AdiGrid::HasFixedBoundary() const {
+  return bc_type_ == BoundaryConditionType::kClosedBoundaries ||
+         bc_type_ == BoundaryConditionType::kDirichlet;
+}
+
+void AdiGrid::DiffuseAdi(real_t dt) {
+  const size_t num_boxes = total_num_boxes_;
+  const real_t d = 1 - dc_[0];
+  std::array<real_t, 3> r;
+  for (size_t i = 0; i < 3; i++) {
+    r[i] = d * dt / (box_lengths_[i] * box_lengths_[i]);
+  }
+  const auto sim_time = GetSimulatedTime();
+
+  // explicit part: c2 = (I + r_x/2 A_x + r_y A_y + r_z A_z) c1 + r * flux
+#pragma omp parallel for simd
+  for (size_t c = 0; c < num_boxes; c++) {
+    c2_[c] = c1_[c];
+  }
+  SetFixedBoundary(sim_time);
+  AddSecondDifference(0, 0.5 * r[0], r[0], sim_time);
+  AddSecondDifference(1, r[1], r[1], sim_time);
+  AddSecondDifference(2, r[2], r[2], sim_time);
+
+  // implicit sweeps
+  SolveAxis(0, BuildSystem(0, 0.5 * r[0]));
+  AddSecondDifference(1, -0.5 * r[1], 0, sim_time);
+  SolveAxis(1, BuildSystem(1, 0.5 * r[1]));
+  AddSecondDifference(2, -0.5 * r[2], 0, sim_time);
+  SolveAxis(2, BuildSystem(2, 0.5 * r[2]));
+
+  // decay
+  if (mu_ != 0) {
+    const real_t decay = std::exp(-mu_ * dt);
+    const size_t nx = num_boxes_axis_[0];
+    const size_t ny = num_boxes_axis_[1];
+    const size_t nz = num_boxes_axis_[2];
+    const size_t lo = HasFixedBoundary() ? 1 : 0;
+    const size_t off = HasFixedBoundary() ? 1 : 0;
+#pragma omp parallel for collapse(2)
+    for (size_t z = lo; z < nz - off; z++) {
+      for (size_t y = lo; y < ny - off; y++) {
+        auto* line = &c2_[y * nx + z * nx * ny];
+#pragma omp simd
+        for (size_t x = lo; x < nx - off; x++) {
+          line[x] *= decay;
+        }
+      }
+    }
+  }
+  c1_.swap(c2_);
+}
+
+AdiGrid::TridiagonalSystem AdiGrid::BuildSystem(int axis,
+                                                real_t half_r) const {
+  const size_t n = num_boxes_axis_[axis];
+  TridiagonalSystem sys;
+  sys.off_diagonal = -half_r;
+  std::vector<real_t> diagonal(n, 1 + 2 * half_r);
+  if (HasFixedBoundary()) {
+    sys.first = 1;
+    sys.last = n - 2;
+  } else {
+    sys.first = 0;
+    sys.last = n - 1;
+  }
+  if (bc_type_ == BoundaryConditionType::kNeumann) {
+    // zero flux part of the boundary: ghost value equals the boundary box
+    diagonal[0] = 1 + half_r;
+    diagonal[n - 1] = 1 + half_r;
+  }
+  if (bc_type_ == BoundaryConditionType::kPeriodic) {
+    // Sherman-Morrison: A = A' + u v^T with u = [gamma, 0, ..., 0, a] and
+    // v = [1, 0, ..., 0, a / gamma]
+    sys.cyclic = true;
+    sys.gamma = -diagonal[0];
+    diagonal[0] -= sys.gamma;
+    diagonal[n - 1] -= sys.off_diagonal * sys.off_diagonal / sys.gamma;
+  }
+
+  const auto a = sys.off_diagonal;
+  sys.upper.resize(n);
+  sys.inv_diagonal.resize(n);
+  sys.inv_diagonal[sys.first] = 1 / diagonal[sys.first];
+  sys.upper[sys.first] = a * sys.inv_diagonal[sys.first];
+  for (size_t i = sys.first + 1; i <= sys.last; ++i) {
+    sys.inv_diagonal[i] = 1 / (diagonal[i] - a * sys.upper[i - 1]);
+    sys.upper[i] = a * sys.inv_diagonal[i];
+  }
+
+  if (sys.cyclic) {
+    // solve A' z = u once; it is the same for all lines
+    std::vector<real_t> z(n, 0);
+    z[0] = sys.gamma;
+    z[n - 1] = a;
+    TridiagonalSystem non_cyclic = sys;
+    non_cyclic.cyclic = false;
+    SolveLines(non_cyclic, false, z.data(), 1, 0, 1, nullptr);
+    sys.correction_denominator = 1 + z[0] + a * z[n - 1] / sys.gamma;
+    sys.correction = std::move(z);
+  }
+  return sys;
+}
+
+void AdiGrid::SetFixedBoundary(real_t time) {
+  if (bc_type_ != BoundaryConditionType::kDirichlet) {
+    // closed boundaries keep their values, which were copied from c1_
+    return;
+  }
+  const size_t nx = num_boxes_axis_[0];
+  const size_t ny = num_boxes_axis_[1];
+  const size_t nz = num_boxes_axis_[2];
+#pragma omp parallel for collapse(2)
+  for (size_t z = 0; z < nz; z++) {
+    for (size_t y = 0; y < ny; y++) {
+      const bool boundary_line =
+          y == 0 || y == ny - 1 || z == 0 || z == nz - 1;
+      for (size_t x = 0; x < nx; x++) {
+        if (boundary_line || x == 0 || x == nx - 1) {
+          real_t real_x = grid_dimensions_[0] + x * box_lengths_[0];
+          real_t real_y = grid_dimensions_[2] + y * box_lengths_[1];
+          real_t real_z = grid_dimensions_[4] + z * box_lengths_[2];
+          c2_[x + y * nx + z * nx * ny] =
+              boundary_condition_->Evaluate(real_x, real_y, real_z, time);
+        }
+      }
+    }
+  }
+}
+
+void AdiGrid::AddSecondDifference(int axis, real_t factor, real_t flux_factor,
+                                  real_t time) {
+  const size_t nx = num_boxes_axis_[0];
+  const size_t ny = num_boxes_axis_[1];
+  const size_t nz = num_boxes_axis_[2];
+  const size_t n = num_boxes_axis_[axis];
+  const size_t strides[3] = {1, nx, nx * ny};
+  const size_t s = strides[axis];
+  const size_t lo = HasFixedBoundary() ? 1 : 0;
+  const size_t off = HasFixedBoundary() ? 1 : 0;
+  const real_t h = box_lengths_[axis];
+  const auto bc_type = bc_type_;
+
+#pragma omp parallel for collapse(2)
+  for (size_t z = lo; z < nz - off; z++) {
+    for (size_t y = lo; y < ny - off; y++) {
+      for (size_t x = lo; x < nx - off; x++) {
+        const size_t coord[3] = {x, y, z};
+        const size_t i = coord[axis];
+        const size_t c = x + y * nx + z * nx * ny;
+        const real_t center = c1_[c];
+        real_t lower = 0;
+        real_t upper = 0;
+        real_t flux = 0;
+        if (i > 0) {
+          lower = c1_[c - s];
+        } else if (bc_type == BoundaryConditionType::kPeriodic) {
+          lower = c1_[c + (n - 1) * s];
+        } else if (bc_type == BoundaryConditionType::kNeumann) {
+          lower = center;
+        }
+        if (i < n - 1) {
+          upper = c1_[c + s];
+        } else if (bc_type == BoundaryConditionType::kPeriodic) {
+          upper = c1_[c - (n - 1) * s];
+        } else if (bc_type == BoundaryConditionType::kNeumann) {
+          upper = center;
+        }
+        if (bc_type == BoundaryConditionType::kNeumann && flux_factor != 0 &&
+            (i == 0 || i == n - 1)) {
+          real_t real_x = grid_dimensions_[0] + x * box_lengths_[0];
+          real_t real_y = grid_dimensions_[2] + y * box_lengths_[1];
+          real_t real_z = grid_dimensions_[4] + z * box_lengths_[2];
+          flux =
+              -h * boundary_condition_->Evaluate(real_x, real_y, real_z, time);
+        }
+        c2_[c] += factor * (lower - 2 * center + upper) + flux_factor * flux;
+      }
+    }
+  }
+}
+
+void AdiGrid::SolveAxis(int axis, const TridiagonalSystem& system) {
+  const size_t nx = num_boxes_axis_[0];
+  const size_t ny = num_boxes_axis_[1];
+  const size_t nz = num_boxes_axis_[2];
+  const bool fixed = HasFixedBoundary();
+  const size_t lo = fixed ? 1 : 0;
+  const size_t off = fixed ? 1 : 0;
+  auto* data = c2_.data();
+
+  if (axis == 0) {
+    // lines are contiguous in memory: solve one line at a time
+#pragma omp parallel
+    {
+      std::vector<real_t> scratch;
+#pragma omp for collapse(2)
+      for (size_t z = lo; z < nz - off; z++) {
+        for (size_t y = lo; y < ny - off; y++) {
+          SolveLines(system, fixed, data + y * nx + z * nx * ny, 1, 0, 1,
+                     &scratch);
+        }
+      }
+    }
+  } else {
+    // solve all lines of an xy (axis 1) or xz (axis 2) plane simultaneously
+    // to access memory contiguously along x
+    const size_t stride = axis == 1 ? nx : nx * ny;
+    const size_t plane_stride = axis == 1 ? nx * ny : nx;
+    const size_t num_planes = axis == 1 ? nz : ny;
+#pragma omp parallel
+    {
+      std::vector<real_t> scratch;
+#pragma omp for
+      for (size_t p = lo; p < num_planes - off; p++) {
+        SolveLines(system, fixed, data + p * plane_stride, stride, lo,
+                   nx - off, &scratch);
+      }
+    }
+  }
+}
+
+}  // namespace bdm
@@ -0,0 +1,126 @@
+// -----------------------------------------------------------------------------
+//
+// Copyright (C) 2021 CERN & University of Surrey for the benefit of the
+// BioDynaMo collaboration. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+//
+// See the LICENSE file distributed with this work for details.
+// See the NOTICE file distributed with this work for additional information
+// regarding copyright ownership.
+//
+// -----------------------------------------------------------------------------
+
+#ifndef CORE_DIFFUSION_ADI_GRID_H_
+#define CORE_DIFFUSION_ADI_GRID_H_
+
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "core/diffusion/diffusion_grid.h"
+
+namespace bdm {
+
+/** @brief Continuum model for the 3D heat equation with exponential decay
+           \f$ \partial_t u = \nabla D \nabla u - \mu u \f$.
+
+  In contrast to the EulerGrid, the diffusion term is integrated with the
+  alternating direction implicit (ADI) scheme of Douglas and Gunn, which is
+  based on the Crank-Nicolson method. Each time step consists of an explicit
+  update followed by one implicit sweep per axis:
+  \f[
+    (I - \tfrac{r_x}{2} A_x) u^* =
+      (I + \tfrac{r_x}{2} A_x + r_y A_y + r_z A_z) u^n
+    \\
+    (I - \tfrac{r_y}{2} A_y) u^{**} = u^* - \tfrac{r_y}{2} A_y u^n
+    \\
+    (I - \tfrac{r_z}{2} A_z) u^{n+1} = u^{**} - \tfrac{r_z}{2} A_z u^n
+  \f]
+  with \f$ r_i = D \Delta t / \Delta x_i^2 \f$ for the box length
+  \f$ \Delta x_i \f$ along axis \f$ i \f$ and the second difference
+  operators \f$ A_x, A_y, A_z \f$. Each implicit sweep solves one
+  tridiagonal system per grid line with the Thomas algorithm (cyclic for
+  periodic boundaries). The lines are independent and solved in parallel.
+  The decay is integrated exactly, i.e. the result is multiplied by
+  \f$ e^{-\mu \Delta t} \f$.
+
+  The scheme is unconditionally stable and second order accurate in time and
+  space. The time step is therefore only limited by accuracy and not by the
+  stability condition \f$ \frac{D \Delta t}{\Delta x^2} < \frac{1}{6} \f$ of
+  the EulerGrid. Note that large time steps can lead to oscillations close to
+  steep gradients (e.g. a point source). All `BoundaryConditionType`s are
+  supported with the same semantics as in the EulerGrid.
+
+  Further information:
+    - <a href="https://doi.org/10.1007/BF01386295">
+      Douglas and Gunn, A general formulation of alternating direction
+      methods, 1964</a>
+*/
+class AdiGrid : public DiffusionGrid {
+ public:
+  AdiGrid() = default;
+  AdiGrid(int substance_id, std::string substance_name, real_t dc, real_t mu,
+          int resolution = 10)
+      : DiffusionGrid(substance_id, std::move(substance_name), dc, mu,
+                      resolution) {}
+
+  void DiffuseWithClosedEdge(real_t dt) override;
+  void DiffuseWithOpenEdge(real_t dt) override;
+  void DiffuseWithDirichlet(real_t dt) override;
+  void DiffuseWithNeumann(real_t dt) override;
+  void DiffuseWithPeriodic(real_t dt) override;
+
+ private:
+  /// Matrix \f$ I - \tfrac{r}{2} A \f$ along one axis after the forward
+  /// elimination of the Thomas algorithm. The coefficients are identical for
+  /// all lines of the grid and are therefore only computed once per step.
+  struct TridiagonalSystem {
+    /// First and last (inclusive) unknown of each line
+    size_t first = 0;
+    size_t last = 0;
+    /// Off-diagonal entry
+    real_t off_diagonal = 0;
+    /// Modified upper diagonal
+    std::vector<real_t> upper;
+    /// Inverse of the modified diagonal
+    std::vector<real_t> inv_diagonal;
+    /// Sherman-Morrison correction for periodic boundaries
+    bool cyclic = false;
+    real_t gamma = 0;
+    real_t correction_denominator = 0;
+    std::vector<real_t> correction;
+  };
+
+  /// The ADI scheme is unconditionally stable. Hence, no restrictions on `dt`.
+  void ParametersCheck(real_t dt) override;
+
+  /// Integrates one time step for all boundary condition types.
+  void DiffuseAdi(real_t dt);
+
+  /// Returns true if the boundary boxes hold prescribed values
+  /// (closed and Dirichlet boundaries) and are not part of the solve.
+  bool HasFixedBoundary() const;
+
+  /// Builds the system of the lines along `axis`.
+  TridiagonalSystem BuildSystem(int axis, real_t half_r) const;
+
+  /// Sets the values of the boundary boxes in c2_ for closed and Dirichlet
+  /// boundaries.
+  void SetFixedBoundary(real_t time);
+
+  /// Adds `factor` times the second difference of c1_ along `axis` and
+  /// `flux_factor` times the Neumann boundary flux to c2_.
+  void AddSecondDifference(int axis, real_t factor, real_t flux_factor,
+                           real_t time);
+
+  /// Solves the tridiagonal systems of all lines along `axis` in place in c2_
+  void SolveAxis(int axis, const TridiagonalSystem& system);
+
+  BDM_CLASS_DEF_OVERRIDE(AdiGrid, 1);
+};
+
+}  // namespace bdm
+
+#endif  // CORE_DIFFUSION_ADI_GRID_H_
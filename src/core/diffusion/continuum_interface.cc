@@ -20,6 +20,15 @@
 namespace bdm {
 
 void Continuum::IntegrateTimeAsynchronously(real_t dt) {
+  real_t step_dt{0};
+  const int n_steps = ScheduleTimeSteps(dt, &step_dt);
+  if (n_steps > 0) {
+    MultiStep(step_dt, n_steps);
+  }
+  CompleteTimeSteps(n_steps, step_dt);
+}
+
+int Continuum::ScheduleTimeSteps(real_t dt, real_t *step_dt) {
   if (time_step_ != std::numeric_limits<real_t>::max()) {
     // Update the total time to simulate
     time_to_simulate_ += dt;
@@ -39,22 +48,23 @@ void Continuum::IntegrateTimeAsynchronously(real_t dt) {
     if (left_over < 0 && left_over > -absolute_tolerance) {
       n_steps++;
     }
-    // Simulate for the appropriate number of time steps
-    for (int i = 0; i < n_steps; i++) {
-      Step(time_step_);
-    }
-    // Update the total simulated time
-    simulated_time_ += n_steps * time_step_;
     // Keep track of time that has not been simulated yet
     time_to_simulate_ -= n_steps * time_step_;
+    *step_dt = time_step_;
+    return n_steps;
   } else {
     // If time_step_ is not set, we simply forward the time step to the Step
     // method.
-    Step(dt);
-    simulated_time_ += dt;
+    *step_dt = dt;
+    return 1;
   }
 }
 
+void Continuum::CompleteTimeSteps(int n_steps, real_t step_dt) {
+  // Update the total simulated time
+  simulated_time_ += n_steps * step_dt;
+}
+
 void Continuum::SetTimeStep(real_t dt) { time_step_ = dt; }
 
 real_t Continuum::GetTimeStep() const {
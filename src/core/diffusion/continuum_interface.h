@@ -61,6 +61,17 @@ class Continuum {
   /// the time step is not set, `dt` is used.
   void IntegrateTimeAsynchronously(real_t dt);
 
+  /// First half of `IntegrateTimeAsynchronously`: adds `dt` to the time that
+  /// the continuum has to integrate and returns the number of steps that are
+  /// due. The length of the steps is written to `step_dt`. The caller must
+  /// perform the steps and afterwards call `CompleteTimeSteps`. Used to
+  /// integrate several continua together (see `EulerGrid::DiffuseFused`).
+  int ScheduleTimeSteps(real_t dt, real_t *step_dt);
+
+  /// Second half of `IntegrateTimeAsynchronously`: adds the time of `n_steps`
+  /// steps of length `step_dt` to the simulated time.
+  void CompleteTimeSteps(int n_steps, real_t step_dt);
+
   /// Initializes the continuum. This method is called via
   /// `Scheduler::Initialize`. For some implementations, this method may be
   /// useful, other may not require it. A possibly use case is that agents move
@@ -83,6 +94,17 @@ class Continuum {
   /// to verify them in this method.
   virtual void Step(real_t dt) = 0;
 
+  /// Integrates the continuum model in time by `n_steps` consecutive steps of
+  /// length `dt`. `IntegrateTimeAsynchronously` calls this method whenever it
+  /// has to catch up with more than one time step. The default implementation
+  /// calls `Step` `n_steps` times. Implementations may override it to fuse the
+  /// steps, e.g. to reuse data while it is still in the cache.
+  virtual void MultiStep(real_t dt, int n_steps) {
+    for (int i = 0; i < n_steps; i++) {
+      Step(dt);
+    }
+  }
+
   /// Returns the ID of the continuum.
   int GetContinuumId() const { return continuum_id_; }
 
@@ -13,6 +13,7 @@
 // -----------------------------------------------------------------------------
 
 #include <algorithm>
+#include <cmath>
 #include <mutex>
 
 #include "core/diffusion/diffusion_grid.h"
@@ -40,6 +41,19 @@ std::string BoundaryTypeToString(const BoundaryConditionType& type) {
   }
 }
 
+namespace {
+
+/// Returns 1 / h_x^2 + 1 / h_y^2 + 1 / h_z^2 for the box lengths h
+real_t SumOfInverseSquares(const std::array<real_t, 3>& box_lengths) {
+  real_t sum = 0;
+  for (auto h : box_lengths) {
+    sum += 1 / (h * h);
+  }
+  return sum;
+}
+
+}  // namespace
+
 /// Transforms a string to the corresponding BoundaryConditionType
 BoundaryConditionType StringToBoundaryType(const std::string& type) {
   if (type == "Neumann") {
@@ -75,39 +89,43 @@ DiffusionGrid::DiffusionGrid(int substance_id,
 }
 
 void DiffusionGrid::Initialize() {
-  if (resolution_ == 0) {
+  if (resolution_ == 0 && axis_resolution_[0] == 0) {
     Log::Fatal("DiffusionGrid::Initialize",
                "Resolution cannot be zero. (substance '", GetContinuumName(),
                "')");
   }
 
-  // Get neighbor grid dimensions
-  auto* env = Simulation::GetActive()->GetEnvironment();
-  auto bounds = env->GetDimensionThresholds();
-
-  grid_dimensions_ = {bounds[0], bounds[1]};
-  if (bounds[0] > bounds[1]) {
-    Log::Fatal("DiffusionGrid::Initialize",
-               "The grid dimensions are not correct. Lower bound is greater",
-               " than upper bound. (substance '", GetContinuumName(), "')");
+  if (!fixed_domain_) {
+    // Get neighbor grid dimensions
+    auto* env = Simulation::GetActive()->GetEnvironment();
+    auto bounds = env->GetDimensionThresholds();
+    grid_dimensions_ = {bounds[0], bounds[1], bounds[0],
+                        bounds[1], bounds[0], bounds[1]};
+  }
+  for (size_t i = 0; i < 3; i++) {
+    if (grid_dimensions_[2 * i] > grid_dimensions_[2 * i + 1]) {
+      Log::Fatal("DiffusionGrid::Initialize",
+                 "The grid dimensions are not correct. Lower bound is greater",
+                 " than upper bound. (substance '", GetContinuumName(), "')");
+    }
   }
 
-  auto adjusted_res =
-      resolution_ == 1 ? 2 : resolution_;  // avoid division by 0
-  box_length_ = (grid_dimensions_[1] - grid_dimensions_[0]) /
-                static_cast<real_t>(adjusted_res);
+  InitializeBoxes();
 
   // Check if box length is not too small
-  if (box_length_ <= 1e-13) {
+  if (*std::min_element(box_lengths_.begin(), box_lengths_.end()) <= 1e-13) {
     Log::Fatal("DiffusionGrid::Initialize",
                "The box length was found to be (close to) zero. Please check "
                "the parameters for substance '",
                GetContinuumName(), "'");
   }
 
-  box_volume_ = box_length_ * box_length_ * box_length_;
-  parity_ = resolution_ % 2;
-  total_num_boxes_ = resolution_ * resolution_ * resolution_;
+  box_volume_ = box_lengths_[0] * box_lengths_[1] * box_lengths_[2];
+  for (size_t i = 0; i < 3; i++) {
+    parity_[i] = num_boxes_axis_[i] % 2;
+  }
+  total_num_boxes_ =
+      num_boxes_axis_[0] * num_boxes_axis_[1] * num_boxes_axis_[2];
 
   // Allocate memory for the concentration and gradient arrays
   locks_.resize(total_num_boxes_);
@@ -122,6 +140,68 @@ void DiffusionGrid::Initialize() {
   }
 }
 
+void DiffusionGrid::InitializeBoxes() {
+  std::array<real_t, 3> extent;
+  for (size_t i = 0; i < 3; i++) {
+    extent[i] = grid_dimensions_[2 * i + 1] - grid_dimensions_[2 * i];
+  }
+
+  if (axis_resolution_[0] != 0) {
+    // User-defined number of boxes along each axis
+    num_boxes_axis_ = axis_resolution_;
+    for (size_t i = 0; i < 3; i++) {
+      box_lengths_[i] = extent[i] / static_cast<real_t>(num_boxes_axis_[i]);
+    }
+  } else {
+    // `resolution_` boxes along the longest axis. The shorter axes get the
+    // number of boxes that keeps the boxes as close to cubic as possible.
+    const real_t max_extent = *std::max_element(extent.begin(), extent.end());
+    auto adjusted_res =
+        resolution_ == 1 ? 2 : resolution_;  // avoid division by 0
+    for (size_t i = 0; i < 3; i++) {
+      if (extent[i] == max_extent) {
+        num_boxes_axis_[i] = resolution_;
+        box_lengths_[i] = extent[i] / static_cast<real_t>(adjusted_res);
+      } else {
+        num_boxes_axis_[i] = std::max<size_t>(
+            1, std::lround(extent[i] / max_extent * resolution_));
+        box_lengths_[i] =
+            extent[i] / static_cast<real_t>(resolution_ == 1
+                                                ? adjusted_res
+                                                : num_boxes_axis_[i]);
+      }
+    }
+  }
+  resolution_ =
+      *std::max_element(num_boxes_axis_.begin(), num_boxes_axis_.end());
+}
+
+void DiffusionGrid::SetResolution(const std::array<size_t, 3>& resolution) {
+  if (initialized_) {
+    Log::Fatal("DiffusionGrid::SetResolution",
+               "The resolution must be set before the grid is initialized. "
+               "(substance '",
+               GetContinuumName(), "')");
+  }
+  if (resolution[0] == 0 || resolution[1] == 0 || resolution[2] == 0) {
+    Log::Fatal("DiffusionGrid::SetResolution",
+               "Resolution cannot be zero. (substance '", GetContinuumName(),
+               "')");
+  }
+  axis_resolution_ = resolution;
+}
+
+void DiffusionGrid::SetDomain(const std::array<int32_t, 6>& domain) {
+  if (initialized_) {
+    Log::Fatal("DiffusionGrid::SetDomain",
+               "The domain must be set before the grid is initialized. "
+               "(substance '",
+               GetContinuumName(), "')");
+  }
+  grid_dimensions_ = domain;
+  fixed_domain_ = true;
+}
+
 void DiffusionGrid::Diffuse(real_t dt) {
   // check if diffusion coefficient and decay constant are 0
   // i.e. if we don't need to calculate diffusion update
@@ -154,34 +234,38 @@ void DiffusionGrid::Diffuse(real_t dt) {
 }
 
 void DiffusionGrid::Update() {
+  // A user-defined domain is not adapted to the environment
+  if (fixed_domain_) {
+    return;
+  }
+
   // Get neighbor grid dimensions
   auto* env = Simulation::GetActive()->GetEnvironment();
   auto bounds = env->GetDimensionThresholds();
-  // Update the grid dimensions such that each dimension ranges from
-  // {bounds[0] - bounds[1]}
-  grid_dimensions_ = {bounds[0], bounds[1]};
-
-  // If the grid is not perfectly divisible along each dimension by the
-  // box length, extend the grid so that it is
-  int dimension_length = bounds[1] - bounds[0];
-  for (int i = 0; i < 1; i++) {
-    int r = fmod(dimension_length, box_length_);
+
+  auto new_num_boxes_axis = num_boxes_axis_;
+  bool grid_increased = false;
+  for (size_t i = 0; i < 3; i++) {
+    // Update the grid dimensions such that each dimension ranges from
+    // {bounds[0] - bounds[1]}
+    grid_dimensions_[2 * i] = bounds[0];
+    grid_dimensions_[2 * i + 1] = bounds[1];
+
+    // If the grid is not perfectly divisible along each dimension by the
+    // box length, extend the grid so that it is
+    int dimension_length = bounds[1] - bounds[0];
+    int r = fmod(dimension_length, box_lengths_[i]);
     if (r > 1e-9) {
-      // std::abs for the case that box_length_ > dimension_length
-      grid_dimensions_[2 * i + 1] += (box_length_ - r);
+      grid_dimensions_[2 * i + 1] += (box_lengths_[i] - r);
     }
-  }
-
-  // Calculate new_dimension_length and new_resolution
-  int new_dimension_length = grid_dimensions_[1] - grid_dimensions_[0];
-  size_t new_resolution = std::ceil(new_dimension_length / box_length_);
 
-  if (new_resolution > resolution_) {
-    // Store the old number of boxes along each axis for comparison
-    size_t tmp_resolution = resolution_;
-
-    // Set new resolution
-    resolution_ = new_resolution;
+    // Calculate new_dimension_length and new number of boxes
+    int new_dimension_length =
+        grid_dimensions_[2 * i + 1] - grid_dimensions_[2 * i];
+    size_t new_num_boxes = std::ceil(new_dimension_length / box_lengths_[i]);
+    if (new_num_boxes <= num_boxes_axis_[i]) {
+      continue;
+    }
 
     // We need to maintain the parity of the number of boxes along each
     // dimension, otherwise copying of the substances to the increases grid
@@ -189,10 +273,22 @@ void DiffusionGrid::Update() {
     // We add a box in the negative direction, because the only way the parity
     // could have changed is because of adding a box in the positive direction
     // (due to the grid not being perfectly divisible; see above)
-    if (resolution_ % 2 != parity_) {
-      grid_dimensions_[0] -= box_length_;
-      resolution_++;
+    if (new_num_boxes % 2 != parity_[i]) {
+      grid_dimensions_[2 * i] -= box_lengths_[i];
+      new_num_boxes++;
     }
+    new_num_boxes_axis[i] = new_num_boxes;
+    grid_increased = true;
+  }
+
+  if (grid_increased) {
+    // Store the old number of boxes along each axis for comparison
+    auto tmp_num_boxes_axis = num_boxes_axis_;
+
+    // Set new number of boxes
+    num_boxes_axis_ = new_num_boxes_axis;
+    resolution_ =
+        *std::max_element(num_boxes_axis_.begin(), num_boxes_axis_.end());
 
     // Temporarily save previous grid data
     auto tmp_c1 = c1_;
@@ -202,15 +298,17 @@ void DiffusionGrid::Update() {
     c2_.clear();
     gradients_.clear();
 
-    total_num_boxes_ = resolution_ * resolution_ * resolution_;
+    total_num_boxes_ =
+        num_boxes_axis_[0] * num_boxes_axis_[1] * num_boxes_axis_[2];
 
-    CopyOldData(tmp_c1, tmp_gradients, tmp_resolution);
+    CopyOldData(tmp_c1, tmp_gradients, tmp_num_boxes_axis);
   }
 }
 
 void DiffusionGrid::CopyOldData(
     const ParallelResizeVector<real_t>& old_c1,
-    const ParallelResizeVector<Real3>& old_gradients, size_t old_resolution) {
+    const ParallelResizeVector<Real3>& old_gradients,
+    const std::array<size_t, 3>& old_num_boxes_axis) {
   // Allocate more memory for the grid data arrays
   locks_.resize(total_num_boxes_);
   c1_.resize(total_num_boxes_);
@@ -227,20 +325,21 @@ void DiffusionGrid::CopyOldData(
       "grid values are mostly zero this is likely to work fine. Evaluate your "
       "results carefully.");
 
-  auto incr_num_boxes = resolution_ - old_resolution;
-  int off_dim = incr_num_boxes / 2;
-
-  int num_box_xy = resolution_ * resolution_;
-  int old_box_xy = old_resolution * old_resolution;
-  int new_origin = off_dim * num_box_xy + off_dim * resolution_ + off_dim;
-  for (size_t k = 0; k < old_resolution; k++) {
-    int offset = new_origin + k * num_box_xy;
-    for (size_t j = 0; j < old_resolution; j++) {
-      if (j != 0) {
-        offset += resolution_;
-      }
-      for (size_t i = 0; i < old_resolution; i++) {
-        auto idx = k * old_box_xy + j * old_resolution + i;
+  std::array<size_t, 3> off_dim;
+  for (size_t i = 0; i < 3; i++) {
+    off_dim[i] = (num_boxes_axis_[i] - old_num_boxes_axis[i]) / 2;
+  }
+
+  const size_t nx = num_boxes_axis_[0];
+  const size_t num_box_xy = nx * num_boxes_axis_[1];
+  const size_t old_nx = old_num_boxes_axis[0];
+  const size_t old_box_xy = old_nx * old_num_boxes_axis[1];
+  for (size_t k = 0; k < old_num_boxes_axis[2]; k++) {
+    for (size_t j = 0; j < old_num_boxes_axis[1]; j++) {
+      size_t offset = (k + off_dim[2]) * num_box_xy + (j + off_dim[1]) * nx +
+                      off_dim[0];
+      for (size_t i = 0; i < old_nx; i++) {
+        auto idx = k * old_box_xy + j * old_nx + i;
         c1_[offset + i] = old_c1[idx];
         gradients_[offset + i] = old_gradients[idx];
       }
@@ -259,7 +358,7 @@ void DiffusionGrid::RunInitializers() {
 
   // Define variables for loop bounds & boundary condition check
   const auto kNumBoxes = total_num_boxes_;
-  const auto kGridSize = resolution_;
+  const auto kGridSize = num_boxes_axis_;
   // For certain boudaries, we also need to copy the values to the c2_ array
   const bool kCopyToC2 =
       (bc_type_ == BoundaryConditionType::kDirichlet ||
@@ -276,17 +375,17 @@ void DiffusionGrid::RunInitializers() {
     std::array<real_t, 3> real_coord;
 #pragma omp simd
     for (size_t i = 0; i < 3; i++) {
-      real_coord[i] = grid_dimensions_[0] +
-                      static_cast<real_t>(box_coord[i]) * box_length_ +
-                      box_length_ / 2.0;
+      real_coord[i] = grid_dimensions_[2 * i] +
+                      static_cast<real_t>(box_coord[i]) * box_lengths_[i] +
+                      box_lengths_[i] / 2.0;
     }
 
     // Calculate the value of the substance in the box
     real_t value{0};
     if (bc_type_ == BoundaryConditionType::kDirichlet &&
-        (box_coord[0] == 0 || box_coord[0] == kGridSize - 1 ||
-         box_coord[1] == 0 || box_coord[1] == kGridSize - 1 ||
-         box_coord[2] == 0 || box_coord[2] == kGridSize - 1)) {
+        (box_coord[0] == 0 || box_coord[0] == kGridSize[0] - 1 ||
+         box_coord[1] == 0 || box_coord[1] == kGridSize[1] - 1 ||
+         box_coord[2] == 0 || box_coord[2] == kGridSize[2] - 1)) {
       // Evaluate the boundary condition in case of Dirichlet boundary
       value = boundary_condition_->Evaluate(real_coord[0], real_coord[1],
                                             real_coord[2], 0);
@@ -326,25 +425,9 @@ void DiffusionGrid::CalculateGradient() {
   }
 
 #pragma omp parallel for collapse(2)
-  for (uint32_t z = 0; z < resolution_; z++) {
-    for (uint32_t y = 0; y < resolution_; y++) {
-      for (uint32_t x = 0; x < resolution_; x++) {
-        size_t idx = x + y * resolution_ + z * resolution_ * resolution_;
-        const std::array<uint32_t, 3> box_coord = {x, y, z};
-        // Get the neighboring boxes
-        const auto neighbors = GetNeighboringBoxes(idx, box_coord);
-        std::array<int, 6> comparison;  // array to determine discretization h
-        std::transform(neighbors.begin(), neighbors.end(), comparison.begin(),
-                       [idx](size_t n) { return (n == idx) ? 0 : 1; });
-
-        // Calculate the gradient (no thread safety issues here)
-        gradients_[idx][0] = (c1_[neighbors[1]] - c1_[neighbors[0]]) /
-                             ((comparison[1] + comparison[0]) * box_length_);
-        gradients_[idx][1] = (c1_[neighbors[3]] - c1_[neighbors[2]]) /
-                             ((comparison[3] + comparison[2]) * box_length_);
-        gradients_[idx][2] = (c1_[neighbors[5]] - c1_[neighbors[4]]) /
-                             ((comparison[5] + comparison[4]) * box_length_);
-      }
+  for (uint32_t z = 0; z < num_boxes_axis_[2]; z++) {
+    for (uint32_t y = 0; y < num_boxes_axis_[1]; y++) {
+      CalculateGradientRow(y, z, 0, num_boxes_axis_[0]);
     }
   }
   if (!init_gradient_) {
@@ -352,6 +435,29 @@ void DiffusionGrid::CalculateGradient() {
   }
 }
 
+void DiffusionGrid::CalculateGradientRow(uint32_t y, uint32_t z,
+                                         uint32_t x_begin, uint32_t x_end) {
+  const size_t nx = num_boxes_axis_[0];
+  const size_t ny = num_boxes_axis_[1];
+  for (uint32_t x = x_begin; x < x_end; x++) {
+    size_t idx = x + y * nx + z * nx * ny;
+    const std::array<uint32_t, 3> box_coord = {x, y, z};
+    // Get the neighboring boxes
+    const auto neighbors = GetNeighboringBoxes(idx, box_coord);
+    std::array<int, 6> comparison;  // array to determine discretization h
+    std::transform(neighbors.begin(), neighbors.end(), comparison.begin(),
+                   [idx](size_t n) { return (n == idx) ? 0 : 1; });
+
+    // Calculate the gradient (no thread safety issues here)
+    gradients_[idx][0] = (c1_[neighbors[1]] - c1_[neighbors[0]]) /
+                         ((comparison[1] + comparison[0]) * box_lengths_[0]);
+    gradients_[idx][1] = (c1_[neighbors[3]] - c1_[neighbors[2]]) /
+                         ((comparison[3] + comparison[2]) * box_lengths_[1]);
+    gradients_[idx][2] = (c1_[neighbors[5]] - c1_[neighbors[4]]) /
+                         ((comparison[5] + comparison[4]) * box_lengths_[2]);
+  }
+}
+
 void DiffusionGrid::ChangeConcentrationBy(const Real3& position, real_t amount,
                                           InteractionMode mode,
                                           bool scale_with_resolution) {
@@ -372,7 +478,7 @@ void DiffusionGrid::ChangeConcentrationBy(size_t idx, real_t amount,
   if (scale_with_resolution) {
     // Convert from amount to concentration of substance by dividing by
     // volume of box
-    amount /= box_length_ * box_length_ * box_length_;
+    amount /= box_volume_;
   }
   std::lock_guard<Spinlock> guard(locks_[idx]);
   assert(idx < locks_.size());
@@ -395,6 +501,7 @@ void DiffusionGrid::ChangeConcentrationBy(size_t idx, real_t amount,
 
   // Enforce upper and lower bounds.
   c1_[idx] = std::clamp(c1_[idx], lower_threshold_, upper_threshold_);
+  ConcentrationChanged(idx);
 }
 
 /// Get the concentration at specified position
@@ -443,12 +550,12 @@ void DiffusionGrid::GetGradient(const Real3& position, Real3* gradient,
     const real_t z_minus = GetConcentration(neighbors[4]);
     const real_t z_plus = GetConcentration(neighbors[5]);
 
-    real_t grad_x =
-        (x_plus - x_minus) / ((comparison[1] + comparison[0]) * box_length_);
-    real_t grad_y =
-        (y_plus - y_minus) / ((comparison[3] + comparison[2]) * box_length_);
-    real_t grad_z =
-        (z_plus - z_minus) / ((comparison[5] + comparison[4]) * box_length_);
+    real_t grad_x = (x_plus - x_minus) /
+                    ((comparison[1] + comparison[0]) * box_lengths_[0]);
+    real_t grad_y = (y_plus - y_minus) /
+                    ((comparison[3] + comparison[2]) * box_lengths_[1]);
+    real_t grad_z = (z_plus - z_minus) /
+                    ((comparison[5] + comparison[4]) * box_lengths_[2]);
 
     *gradient = Real3({grad_x, grad_y, grad_z});
   }
@@ -465,19 +572,19 @@ std::array<uint32_t, 3> DiffusionGrid::GetBoxCoordinates(
   std::array<uint32_t, 3> box_coord;
 
   for (size_t i = 0; i < 3; i++) {
-// Check if position is within boundaries
-#ifndef NDEBUG
-    assert((position[i] >= grid_dimensions_[0]) &&
-           "You tried to get the box coordinates outside the bounds of the "
-           "diffusion grid!");
-    assert((position[i] <= grid_dimensions_[1]) &&
-           "You tried to get the box coordinates outside the bounds of the "
-           "diffusion grid!");
-#endif  // NDEBUG
+    // Positions outside the grid get the coordinate `num_boxes_axis_[i]`,
+    // which does not belong to any box (the check also rejects NaN).
+    if (!(position[i] >= grid_dimensions_[2 * i] &&
+          position[i] <= grid_dimensions_[2 * i + 1])) {
+      box_coord[i] = static_cast<uint32_t>(num_boxes_axis_[i]);
+      continue;
+    }
     // Get box coords (Note: conversion to uint32_t should be save for typical
-    // grid sizes)
-    box_coord[i] = static_cast<uint32_t>(
-        std::floor((position[i] - grid_dimensions_[0]) / box_length_));
+    // grid sizes). The upper edge of the grid belongs to the last box.
+    auto coord = static_cast<size_t>(
+        std::floor((position[i] - grid_dimensions_[2 * i]) / box_lengths_[i]));
+    box_coord[i] =
+        static_cast<uint32_t>(std::min(coord, num_boxes_axis_[i] - 1));
   }
   return box_coord;
 }
@@ -487,23 +594,31 @@ std::array<uint32_t, 3> DiffusionGrid::GetBoxCoordinates(
   // Resolution must be smaller than uint32_t max for the box coordinates to be
   // representable
   assert(resolution_ < std::numeric_limits<uint32_t>::max());
+  const size_t nx = num_boxes_axis_[0];
+  const size_t ny = num_boxes_axis_[1];
   std::array<uint32_t, 3> box_coord;
-  box_coord[0] = static_cast<uint32_t>(idx % resolution_);
-  box_coord[1] = static_cast<uint32_t>((idx / resolution_) % resolution_);
-  box_coord[2] = static_cast<uint32_t>(idx / (resolution_ * resolution_));
+  box_coord[0] = static_cast<uint32_t>(idx % nx);
+  box_coord[1] = static_cast<uint32_t>((idx / nx) % ny);
+  box_coord[2] = static_cast<uint32_t>(idx / (nx * ny));
   return box_coord;
 }
 
 size_t DiffusionGrid::GetBoxIndex(
     const std::array<uint32_t, 3>& box_coord) const {
-  size_t ret = box_coord[2] * resolution_ * resolution_ +
-               box_coord[1] * resolution_ + box_coord[0];
+  const size_t nx = num_boxes_axis_[0];
+  const size_t ny = num_boxes_axis_[1];
+  size_t ret = box_coord[2] * nx * ny + box_coord[1] * nx + box_coord[0];
   return ret;
 }
 
 /// Calculates the box index of the substance at specified position
 size_t DiffusionGrid::GetBoxIndex(const Real3& position) const {
   auto box_coord = GetBoxCoordinates(position);
+  for (size_t i = 0; i < 3; i++) {
+    if (box_coord[i] >= num_boxes_axis_[i]) {
+      return total_num_boxes_;
+    }
+  }
   return GetBoxIndex(box_coord);
 }
 
@@ -514,17 +629,16 @@ std::array<size_t, 6> DiffusionGrid::GetNeighboringBoxes(size_t index) const {
 
 std::array<size_t, 6> DiffusionGrid::GetNeighboringBoxes(
     size_t index, const std::array<uint32_t, 3>& box_coord) const {
+  const size_t nx = num_boxes_axis_[0];
+  const size_t ny = num_boxes_axis_[1];
+  const size_t nz = num_boxes_axis_[2];
   std::array<size_t, 6> neighbors;
   neighbors[0] = (box_coord[0] == 0) ? index : index - 1;
-  neighbors[1] = (box_coord[0] == resolution_ - 1) ? index : index + 1;
-  neighbors[2] = (box_coord[1] == 0) ? index : index - resolution_;
-  neighbors[3] =
-      (box_coord[1] == resolution_ - 1) ? index : index + resolution_;
-  neighbors[4] =
-      (box_coord[2] == 0) ? index : index - resolution_ * resolution_;
-  neighbors[5] = (box_coord[2] == resolution_ - 1)
-                     ? index
-                     : index + resolution_ * resolution_;
+  neighbors[1] = (box_coord[0] == nx - 1) ? index : index + 1;
+  neighbors[2] = (box_coord[1] == 0) ? index : index - nx;
+  neighbors[3] = (box_coord[1] == ny - 1) ? index : index + nx;
+  neighbors[4] = (box_coord[2] == 0) ? index : index - nx * ny;
+  neighbors[5] = (box_coord[2] == nz - 1) ? index : index + nx * ny;
   return neighbors;
 }
 
@@ -563,29 +677,33 @@ void DiffusionGrid::PrintInfo(std::ostream& out) {
   }
 
   // Get all the info
-  auto box_length = GetBoxLength();
+  const auto& box_lengths = GetBoxLengths();
   auto diffusion_coefficient = 1 - GetDiffusionCoefficients()[0];
   auto decay = GetDecayConstant();
-  auto max_dt =
-      (box_length * box_length) / (decay + 12.0 * diffusion_coefficient) * 2.0;
+  auto max_dt = 2.0 / (decay + 4.0 * diffusion_coefficient *
+                                   SumOfInverseSquares(box_lengths));
   auto domain = GetDimensions();
   auto umin = GetLowerThreshold();
   auto umax = GetUpperThreshold();
-  auto resolution = GetResolution();
+  auto resolution = GetNumBoxesArray();
   auto num_boxes = GetNumBoxes();
 
   // Print the info
   out << "DiffusionGrid: " << continuum_name << "\n";
   out << "    D          = " << diffusion_coefficient << "\n";
   out << "    decay      = " << decay << "\n";
-  out << "    dx         = " << box_length << "\n";
+  out << "    dx         = " << box_lengths[0] << "\n";
+  if (box_lengths[1] != box_lengths[0] || box_lengths[2] != box_lengths[0]) {
+    out << "    dy         = " << box_lengths[1] << "\n";
+    out << "    dz         = " << box_lengths[2] << "\n";
+  }
   out << "    max(dt)    <= " << max_dt << "\n";
   out << "    bounds     : " << umin << " < c < " << umax << "\n";
   out << "    domain     : "
       << "[" << domain[0] << ", " << domain[1] << "] x [" << domain[2] << ", "
       << domain[3] << "] x [" << domain[4] << ", " << domain[5] << "]\n";
-  out << "    resolution : " << resolution << " x " << resolution << " x "
-      << resolution << "\n";
+  out << "    resolution : " << resolution[0] << " x " << resolution[1]
+      << " x " << resolution[2] << "\n";
   out << "    num boxes  : " << num_boxes << "\n";
   out << "    boundary   : " << BoundaryTypeToString(bc_type_) << "\n";
 };
@@ -595,12 +713,13 @@ void DiffusionGrid::ParametersCheck(real_t dt) {
   // analysis (https://en.wikipedia.org/wiki/Von_Neumann_stability_analysis,
   // accessed 2022-10-27) of the diffusion equation. In comparison to the
   // Wikipedia article, we use a 3D diffusion equation and also consider the
-  // decay. We end up with the following result:
-  const bool stability =
-      ((mu_ + 12.0 * (1 - dc_[0]) / (box_length_ * box_length_)) * dt <= 2.0);
+  // decay. We end up with the following result (h_i denotes the box length
+  // along axis i):
+  //   (mu + 4 * D * sum_i 1 / h_i^2) * dt <= 2
+  const real_t inv_h2 = SumOfInverseSquares(box_lengths_);
+  const bool stability = ((mu_ + 4.0 * (1 - dc_[0]) * inv_h2) * dt <= 2.0);
   if (!stability) {
-    const double max_dt =
-        2.0 / (mu_ + 12.0 * (1 - dc_[0])) * (box_length_ * box_length_);
+    const double max_dt = 2.0 / (mu_ + 4.0 * (1 - dc_[0]) * inv_h2);
     Log::Fatal(
         "DiffusionGrid", "Stability condition violated. ",
         "The specified parameters of the diffusion grid with substance [",
@@ -618,7 +737,7 @@ void DiffusionGrid::ParametersCheck(real_t dt) {
   // concentration values of the previous time step are positive and demanding
   // the same for the next time step. We arrive at the following condition:
   const bool decay_safety =
-      (1 - (mu_ + 6 * (1 - dc_[0]) / (box_length_ * box_length_) * dt) >= 0);
+      (1 - (mu_ + 2 * (1 - dc_[0]) * inv_h2 * dt) >= 0);
   if (!decay_safety) {
     Log::Fatal(
         "DiffusionGrid", "Decay may overstep into negative regime. ",
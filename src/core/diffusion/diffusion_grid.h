@@ -104,9 +104,27 @@ class DiffusionGrid : public ScalarField {
   /// Updates the grid dimensions, based on the given threshold values. The
   /// diffusion grid dimensions need always be larger than the neighbor grid
   /// dimensions, so that each simulation object can obtain its local
-  /// concentration / gradient
+  /// concentration / gradient. Grids with a domain set via SetDomain() are
+  /// not resized.
   void Update() override;
 
+  /// Sets the number of boxes along each axis [x, y, z]. Must be called before
+  /// Initialize(). The boxes span the domain of the grid along each axis, i.e.
+  /// their side lengths differ if the domain extent divided by the number of
+  /// boxes differs between the axes. By default, the grid uses the
+  /// `resolution` of the constructor for the longest axis and cubic boxes.
+  void SetResolution(const std::array<size_t, 3>& resolution);
+
+  /// Sets the domain {xmin, xmax, ymin, ymax, zmin, zmax} of the diffusion
+  /// grid. Must be called before Initialize(). By default, the grid covers the
+  /// cubic domain given by the dimension thresholds of the environment and
+  /// grows with it. A grid with a user-defined domain keeps its size for the
+  /// entire simulation, such that slab-shaped domains do not allocate boxes
+  /// along the full extent of the longest axis. Positions outside the domain
+  /// do not belong to any box: GetValue(), GetGradient() and
+  /// ChangeConcentrationBy() report them with `Log::Error` and ignore them.
+  void SetDomain(const std::array<int32_t, 6>& domain);
+
   void Step(real_t dt) override { Diffuse(dt); }
   void Diffuse(real_t dt);
 
@@ -125,12 +143,12 @@ class DiffusionGrid : public ScalarField {
   /// Calculates the gradient for each box in the diffusion grid.
   /// The gradient is calculated in each direction (x, y, z) as following:
   ///
-  /// c(x + box_length_) - c(x - box_length) / (2 * box_length_),
+  /// c(x + box_lengths_[0]) - c(x - box_lengths_[0]) / (2 * box_lengths_[0]),
   ///
   /// where c(x) implies the concentration at position x
   ///
   /// At the edges the gradient is the same as the box next to it
-  void CalculateGradient();
+  virtual void CalculateGradient();
 
   /// Initialize the diffusion grid according to the initialization functions.
   /// Note that if your initializers our outside the defined bounds (lower and
@@ -208,7 +226,9 @@ class DiffusionGrid : public ScalarField {
   virtual void GetGradient(const Real3& position, Real3* gradient,
                            bool normalize = true) const;
 
-  /// Get the coordinates of the box at the specified position
+  /// Get the coordinates of the box at the specified position. For each axis
+  /// along which the position lies outside the grid, the coordinate is
+  /// `GetNumBoxesArray()[i]`, i.e. one past the last box.
   std::array<uint32_t, 3> GetBoxCoordinates(const Real3& position) const;
 
   // Get the coordinates of the box at the specified index
@@ -217,7 +237,8 @@ class DiffusionGrid : public ScalarField {
   /// Calculates the box index at specified box coordinates
   size_t GetBoxIndex(const std::array<uint32_t, 3>& box_coord) const;
 
-  /// Calculates the box index of the substance at specified position
+  /// Calculates the box index of the substance at specified position.
+  /// Returns `GetNumBoxes()` if the position lies outside the grid.
   size_t GetBoxIndex(const Real3& position) const;
 
   /// Determines the indices of the neighboring boxes of a given box index.
@@ -257,17 +278,16 @@ class DiffusionGrid : public ScalarField {
 
   const real_t* GetAllGradients() const { return gradients_.data()->data(); }
 
-  std::array<size_t, 3> GetNumBoxesArray() const {
-    std::array<size_t, 3> ret;
-    ret[0] = resolution_;
-    ret[1] = resolution_;
-    ret[2] = resolution_;
-    return ret;
-  }
+  std::array<size_t, 3> GetNumBoxesArray() const { return num_boxes_axis_; }
 
   size_t GetNumBoxes() const { return total_num_boxes_; }
 
-  real_t GetBoxLength() const { return box_length_; }
+  /// Returns the side length of the boxes along the x-axis. See
+  /// GetBoxLengths() for grids with anisotropic boxes.
+  real_t GetBoxLength() const { return box_lengths_[0]; }
+
+  /// Returns the side lengths of the boxes along each axis [x, y, z]
+  const std::array<real_t, 3>& GetBoxLengths() const { return box_lengths_; }
 
   [[deprecated("Use GetContinuumId() instead.")]] int GetSubstanceId() const {
     return GetContinuumId();
@@ -282,27 +302,20 @@ class DiffusionGrid : public ScalarField {
 
   const int32_t* GetDimensionsPtr() const { return grid_dimensions_.data(); }
 
-  std::array<int32_t, 6> GetDimensions() const {
-    std::array<int32_t, 6> ret;
-    ret[0] = grid_dimensions_[0];
-    ret[1] = grid_dimensions_[1];
-    ret[2] = grid_dimensions_[0];
-    ret[3] = grid_dimensions_[1];
-    ret[4] = grid_dimensions_[0];
-    ret[5] = grid_dimensions_[1];
-    return ret;
-  }
+  std::array<int32_t, 6> GetDimensions() const { return grid_dimensions_; }
 
   std::array<int32_t, 3> GetGridSize() const {
     std::array<int32_t, 3> ret;
     ret[0] = grid_dimensions_[1] - grid_dimensions_[0];
-    ret[1] = grid_dimensions_[1] - grid_dimensions_[0];
-    ret[2] = grid_dimensions_[1] - grid_dimensions_[0];
+    ret[1] = grid_dimensions_[3] - grid_dimensions_[2];
+    ret[2] = grid_dimensions_[5] - grid_dimensions_[4];
     return ret;
   }
 
   const std::array<real_t, 7>& GetDiffusionCoefficients() const { return dc_; }
 
+  /// Returns the number of boxes along the longest axis. See
+  /// GetNumBoxesArray() for the number of boxes along each axis.
   size_t GetResolution() const { return resolution_; }
 
   real_t GetBoxVolume() const { return box_volume_; }
@@ -351,9 +364,26 @@ class DiffusionGrid : public ScalarField {
  private:
   friend class EulerGrid;
   friend class EulerDepletionGrid;
+  friend class AdiGrid;
+  friend class SparseEulerGrid;
   friend class TestGrid;  // class used for testing (e.g. initialization)
 
-  void ParametersCheck(real_t dt);
+  /// Checks if the parameters lead to a stable and physically meaningful
+  /// integration with time step `dt`.
+  virtual void ParametersCheck(real_t dt);
+
+  /// Called by ChangeConcentrationBy() after the concentration of box `idx`
+  /// has been changed. Used by `SparseEulerGrid` to track modified regions.
+  virtual void ConcentrationChanged(size_t idx) {}
+
+  /// Calculates the gradients of the boxes [x_begin, x_end) of the row of
+  /// boxes (y, z).
+  void CalculateGradientRow(uint32_t y, uint32_t z, uint32_t x_begin,
+                            uint32_t x_end);
+
+  /// Computes the number of boxes and the box lengths along each axis from
+  /// the grid dimensions.
+  void InitializeBoxes();
 
   /// Copies the concentration and gradients values to the new
   /// (larger) grid. In the 2D case it looks like the following:
@@ -369,10 +399,10 @@ class DiffusionGrid : public ScalarField {
   ///
   void CopyOldData(const ParallelResizeVector<real_t>& old_c1,
                    const ParallelResizeVector<Real3>& old_gradients,
-                   size_t old_resolution);
+                   const std::array<size_t, 3>& old_num_boxes_axis);
 
-  /// The side length of each box
-  real_t box_length_ = 0;
+  /// The side lengths of each box along each axis [x, y, z]
+  std::array<real_t, 3> box_lengths_ = {{0}};
   /// the volume of each box
   real_t box_volume_ = 0;
   /// Lock for each voxel used to prevent race conditions between
@@ -392,19 +422,26 @@ class DiffusionGrid : public ScalarField {
   std::array<real_t, 7> dc_ = {{0}};
   /// The decay constant
   real_t mu_ = 0;
-  /// The grid dimensions of the diffusion grid (cubic shaped)
-  std::array<int32_t, 2> grid_dimensions_ = {{0}};
-  /// The number of boxes at each axis [x, y, z] (same along each axis)
-  uint64_t num_boxes_axis_ = 0;
+  /// The grid dimensions of the diffusion grid
+  /// {xmin, xmax, ymin, ymax, zmin, zmax}
+  std::array<int32_t, 6> grid_dimensions_ = {{0}};
+  /// The number of boxes at each axis [x, y, z]
+  std::array<size_t, 3> num_boxes_axis_ = {{0}};
   /// The total number of boxes in the diffusion grid
   size_t total_num_boxes_ = 0;
-  /// The resolution of the diffusion grid (i.e. number of boxes along each
-  /// axis)
+  /// The resolution of the diffusion grid (i.e. number of boxes along the
+  /// longest axis)
   size_t resolution_ = 0;
+  /// The number of boxes along each axis requested with SetResolution().
+  /// Zero if the grid derives them from `resolution_`.
+  std::array<size_t, 3> axis_resolution_ = {{0}};
+  /// True if the domain was set with SetDomain(); such grids are not resized
+  /// in Update().
+  bool fixed_domain_ = false;
   /// The last timestep `dt` used for the diffusion grid update `Diffuse(dt)`
   real_t last_dt_ = 0.0;
-  /// If false, grid dimensions are even; if true, they are odd
-  bool parity_ = false;
+  /// If false, the number of boxes along the axis is even; if true, it is odd
+  std::array<bool, 3> parity_ = {{false}};
   /// A list of functions that initialize this diffusion grid
   /// ROOT currently doesn't support IO of std::function
   std::vector<std::function<real_t(real_t, real_t, real_t)>> initializers_ =
@@ -424,7 +461,7 @@ class DiffusionGrid : public ScalarField {
   /// are used but the gradient is only needed for one of them.)
   bool precompute_gradients_ = true;
 
-  BDM_CLASS_DEF_OVERRIDE(DiffusionGrid, 1);
+  BDM_CLASS_DEF_OVERRIDE(DiffusionGrid, 2);
 };
 
 }  // namespace bdm
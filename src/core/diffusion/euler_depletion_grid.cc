@@ -13,15 +13,13 @@
 // -----------------------------------------------------------------------------
 
 #include "core/diffusion/euler_depletion_grid.h"
+#include <algorithm>
 #include "core/resource_manager.h"
 #include "core/simulation.h"
 
 namespace bdm {
 
 void EulerDepletionGrid::ApplyDepletion(real_t dt) {
-  auto* sim = Simulation::GetActive();
-  const auto* rm = sim->GetResourceManager();
-
   // The explicit scheme computes the new concentarion c2 based on c1. Efficient
   // updates are ensured by swapping pointers at each step. Here, however, we
   // want to continue to use c1 for the next step. Thus, we swap pointers here
@@ -29,6 +27,20 @@ void EulerDepletionGrid::ApplyDepletion(real_t dt) {
   // is called after the diffusion of the EulerGrid (swaps pointer at the end).
   std::swap(c1_, c2_);
 
+  PrepareDepletion();
+  constexpr size_t kChunkSize = 4096;
+#pragma omp parallel for
+  for (size_t begin = 0; begin < total_num_boxes_; begin += kChunkSize) {
+    ApplyDepletion(dt, begin, std::min(begin + kChunkSize, total_num_boxes_));
+  }
+
+  // See comment above.
+  std::swap(c1_, c2_);
+}
+
+void EulerDepletionGrid::PrepareDepletion() {
+  const auto* rm = Simulation::GetActive()->GetResourceManager();
+  depleting_concentrations_.assign(binding_substances_.size(), nullptr);
   for (size_t s = 0; s < binding_substances_.size(); s++) {
     if (binding_coefficients_[s] == 0.0) {
       // If the binding coefficient is zero, we do not need to apply the
@@ -36,28 +48,35 @@ void EulerDepletionGrid::ApplyDepletion(real_t dt) {
       continue;
     }
 
-    size_t depleting_boxes =
-        rm->GetDiffusionGrid(binding_substances_[s])->GetNumBoxes();
-
-    if (depleting_boxes != GetNumBoxes()) {
-      Log::Fatal(
-          "EulerDepletionGrid::ApplyDepletion()",
-          "The number of voxels of the depleting diffusion grid ",
-          rm->GetDiffusionGrid(binding_substances_[s])->GetContinuumName(),
-          " differs from that of the depleted one (", GetContinuumName(),
-          "). Check the resolution.");
-    } else {
-      auto* depleting_concentration =
-          rm->GetDiffusionGrid(binding_substances_[s])->GetAllConcentrations();
-#pragma omp parallel for simd
-      for (size_t c = 0; c < total_num_boxes_; c++) {
-        c2_[c] -=
-            c1_[c] * binding_coefficients_[s] * depleting_concentration[c] * dt;
-      }
+    // The depletion is applied box by box. Hence, both grids must have the
+    // same boxes, not just the same number of boxes.
+    auto* depleting_grid = rm->GetDiffusionGrid(binding_substances_[s]);
+    if (depleting_grid->GetNumBoxesArray() != GetNumBoxesArray() ||
+        depleting_grid->GetDimensions() != GetDimensions()) {
+      Log::Fatal("EulerDepletionGrid::ApplyDepletion()",
+                 "The number of voxels of the depleting diffusion grid ",
+                 depleting_grid->GetContinuumName(),
+                 " differs from that of the depleted one (",
+                 GetContinuumName(),
+                 ") along at least one axis, or the grids cover different "
+                 "domains. Check the resolution and the domain.");
+    }
+    depleting_concentrations_[s] = depleting_grid->GetAllConcentrations();
+  }
+}
+
+void EulerDepletionGrid::ApplyDepletion(real_t dt, size_t begin, size_t end) {
+  for (size_t s = 0; s < depleting_concentrations_.size(); s++) {
+    const real_t* depleting_concentration = depleting_concentrations_[s];
+    if (depleting_concentration == nullptr) {
+      continue;
+    }
+    const real_t binding_coefficient = binding_coefficients_[s];
+#pragma omp simd
+    for (size_t c = begin; c < end; c++) {
+      c2_[c] -= c1_[c] * binding_coefficient * depleting_concentration[c] * dt;
     }
   }
-  // See comment above.
-  std::swap(c1_, c2_);
 }
 
 void EulerDepletionGrid::DiffuseWithClosedEdge(real_t dt) {
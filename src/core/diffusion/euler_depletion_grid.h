@@ -63,6 +63,12 @@ class EulerDepletionGrid : public EulerGrid {
   /// binding_coefficients_. See ApplyDepletion for details.
   void DiffuseWithPeriodic(real_t dt) override;
 
+  /// The depletion couples the substance to other grids after each step.
+  /// Hence, steps cannot be fused and are executed one after another.
+  void MultiStep(real_t dt, int n_steps) override {
+    DiffusionGrid::MultiStep(dt, n_steps);
+  }
+
   // To avoid missing substances or coefficients, name of the sub and binding
   // coefficient must be set at the same time
 
@@ -82,6 +88,16 @@ class EulerDepletionGrid : public EulerGrid {
     return binding_coefficients_;
   }
 
+ protected:
+  /// Looks up the concentrations of the binding substances and verifies that
+  /// their grids have the same number of boxes.
+  void PrepareDepletion() override;
+
+  /// Depletes the boxes [begin, end) of `c2_` according to the concentration
+  /// `c1_` and the concentrations of the binding substances (see
+  /// `PrepareDepletion`).
+  void ApplyDepletion(real_t dt, size_t begin, size_t end) override;
+
  private:
   /// @brief Depletes the substance according to binding_substances_ and
   /// binding_coefficients_. Iterates over all grid points and calculates the
@@ -94,6 +110,9 @@ class EulerDepletionGrid : public EulerGrid {
   std::vector<real_t> binding_coefficients_ = {};
   /// Vector of binding substances.
   std::vector<int> binding_substances_ = {};
+  /// Concentrations of the binding substances (see `PrepareDepletion`).
+  /// Entries of substances with a binding coefficient of zero are nullptr.
+  std::vector<const real_t*> depleting_concentrations_ = {};  //!
 
   BDM_CLASS_DEF_OVERRIDE(EulerDepletionGrid, 1);
 };
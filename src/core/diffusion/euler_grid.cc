@@ -13,19 +13,22 @@
 // -----------------------------------------------------------------------------
 
 #include "core/diffusion/euler_grid.h"
+#include <algorithm>
+#include <array>
+#include <vector>
+#include "core/param/param.h"
 #include "core/resource_manager.h"
 #include "core/simulation.h"
 
 namespace bdm {
 
-void EulerGrid::DiffuseWithClosedEdge(real_t dt) {
-  const auto nx = resolution_;
-  const auto ny = resolution_;
-  const auto nz = resolution_;
-
-  const real_t ibl2 = 1 / (box_length_ * box_length_);
-  const real_t d = 1 - dc_[0];
+namespace {
 
+/// Calls `f(y, z)` for each row of boxes along the x-axis of a grid with `ny`
+/// boxes along the y-axis and `nz` boxes along the z-axis in parallel. Rows
+/// are processed in blocks of 16 along y.
+template <typename TFunctor>
+void ForEachRowParallel(size_t ny, size_t nz, TFunctor&& f) {
   constexpr size_t YBF = 16;
 #pragma omp parallel for collapse(2)
   for (size_t yy = 0; yy < ny; yy += YBF) {
@@ -35,334 +38,674 @@ void EulerGrid::DiffuseWithClosedEdge(real_t dt) {
         ymax = ny;
       }
       for (size_t y = yy; y < ymax; y++) {
-        size_t x{0};
-        size_t c{0};
-        size_t n{0};
-        size_t s{0};
-        size_t b{0};
-        size_t t{0};
-        c = x + y * nx + z * nx * ny;
-#pragma omp simd
-        for (x = 1; x < nx - 1; x++) {
-          ++c;
-
-          if (y == 0 || y == (ny - 1) || z == 0 || z == (nz - 1)) {
-            continue;
-          }
-
-          n = c - nx;
-          s = c + nx;
-          b = c - nx * ny;
-          t = c + nx * ny;
-
-          c2_[c] = c1_[c] * (1 - mu_ * dt) +
-                   (d * dt * ibl2) *
-                       (c1_[c - 1] - 2 * c1_[c] + c1_[c + 1] + c1_[s] -
-                        2 * c1_[c] + c1_[n] + c1_[b] - 2 * c1_[c] + c1_[t]);
-        }
+        f(y, z);
       }  // tile ny
     }    // tile nz
   }      // block ny
+}
+
+}  // namespace
+
+void EulerGrid::DiffuseWithClosedEdge(real_t dt) {
+  const auto& n = num_boxes_axis_;
+  ForEachRowParallel(n[1], n[2], [&](size_t y, size_t z) {
+    DiffuseRowWithClosedEdge(y, z, 0, n[0], dt);
+  });
   c1_.swap(c2_);
 }
 
 void EulerGrid::DiffuseWithOpenEdge(real_t dt) {
-  const auto nx = resolution_;
-  const auto ny = resolution_;
-  const auto nz = resolution_;
+  const auto& n = num_boxes_axis_;
+  ForEachRowParallel(n[1], n[2], [&](size_t y, size_t z) {
+    DiffuseRowWithOpenEdge(y, z, 0, n[0], dt);
+  });
+  c1_.swap(c2_);
+}
 
-  const real_t ibl2 = 1 / (box_length_ * box_length_);
-  const real_t d = 1 - dc_[0];
-  std::array<int, 4> l;
+void EulerGrid::DiffuseWithDirichlet(real_t dt) {
+  const auto sim_time = GetSimulatedTime();
+  const auto& n = num_boxes_axis_;
+  ForEachRowParallel(n[1], n[2], [&](size_t y, size_t z) {
+    DiffuseRowWithDirichlet(y, z, 0, n[0], dt, sim_time);
+  });
+  c1_.swap(c2_);
+}
 
-  constexpr size_t YBF = 16;
-#pragma omp parallel for collapse(2)
-  for (size_t yy = 0; yy < ny; yy += YBF) {
-    for (size_t z = 0; z < nz; z++) {
-      size_t ymax = yy + YBF;
-      if (ymax >= ny) {
-        ymax = ny;
+void EulerGrid::DiffuseWithNeumann(real_t dt) {
+  const auto sim_time = GetSimulatedTime();
+  const auto& n = num_boxes_axis_;
+  ForEachRowParallel(n[1], n[2], [&](size_t y, size_t z) {
+    DiffuseRowWithNeumann(y, z, 0, n[0], dt, sim_time);
+  });
+  c1_.swap(c2_);
+}
+
+void EulerGrid::DiffuseWithPeriodic(real_t dt) {
+  const auto& n = num_boxes_axis_;
+  ForEachRowParallel(n[1], n[2], [&](size_t y, size_t z) {
+    DiffuseRowWithPeriodic(y, z, 0, n[0], dt);
+  });
+  c1_.swap(c2_);
+}
+
+bool EulerGrid::CanFuseWith(const EulerGrid& other) const {
+  return num_boxes_axis_ == other.num_boxes_axis_ &&
+         box_lengths_ == other.box_lengths_ &&
+         grid_dimensions_ == other.grid_dimensions_ &&
+         bc_type_ == other.bc_type_;
+}
+
+void EulerGrid::DiffuseFused(const std::vector<EulerGrid*>& grids, real_t dt,
+                             int n_steps) {
+  if (grids.empty()) {
+    return;
+  }
+  std::vector<real_t> sim_times(grids.size());
+  for (size_t g = 0; g < grids.size(); g++) {
+    // Same bookkeeping as in DiffusionGrid::Diffuse
+    grids[g]->last_dt_ = dt;
+    grids[g]->ParametersCheck(dt);
+    sim_times[g] = grids[g]->GetSimulatedTime();
+  }
+
+  const auto& n = grids[0]->num_boxes_axis_;
+  for (int step = 0; step < n_steps; step++) {
+    for (auto* grid : grids) {
+      grid->PrepareDepletion();
+    }
+    ForEachRowParallel(n[1], n[2], [&](size_t y, size_t z) {
+      const size_t row_begin = y * n[0] + z * n[0] * n[1];
+      for (size_t g = 0; g < grids.size(); g++) {
+        grids[g]->DiffuseRow(y, z, 0, n[0], dt, sim_times[g]);
+        grids[g]->ApplyDepletion(dt, row_begin, row_begin + n[0]);
       }
-      for (size_t y = yy; y < ymax; y++) {
-        size_t x{0};
-        size_t c{0};
-        size_t n{0};
-        size_t s{0};
-        size_t b{0};
-        size_t t{0};
-        c = x + y * nx + z * nx * ny;
-
-        l.fill(1);
-
-        if (y == 0) {
-          n = c;
-          l[0] = 0;
-        } else {
-          n = c - nx;
-        }
+    });
+    for (auto* grid : grids) {
+      grid->c1_.swap(grid->c2_);
+    }
+  }
+}
 
-        if (y == ny - 1) {
-          s = c;
-          l[1] = 0;
-        } else {
-          s = c + nx;
-        }
+void EulerGrid::CalculateGradientFused(const std::vector<EulerGrid*>& grids) {
+  // Same conditions as in DiffusionGrid::CalculateGradient
+  std::vector<EulerGrid*> active;
+  for (auto* grid : grids) {
+    if ((grid->init_gradient_ && grid->IsFixedSubstance()) ||
+        !grid->precompute_gradients_) {
+      continue;
+    }
+    active.push_back(grid);
+  }
+  if (active.empty()) {
+    return;
+  }
+
+  const auto& n = active[0]->num_boxes_axis_;
+#pragma omp parallel for collapse(2)
+  for (uint32_t z = 0; z < n[2]; z++) {
+    for (uint32_t y = 0; y < n[1]; y++) {
+      for (auto* grid : active) {
+        grid->CalculateGradientRow(y, z, 0, n[0]);
+      }
+    }
+  }
+  for (auto* grid : active) {
+    grid->init_gradient_ = true;
+  }
+}
 
-        if (z == 0) {
-          b = c;
-          l[2] = 0;
-        } else {
-          b = c - nx * ny;
-        }
+void EulerGrid::DiffuseRow(size_t y, size_t z, size_t x_begin, size_t x_end,
+                           real_t dt, real_t sim_time) {
+  switch (bc_type_) {
+    case BoundaryConditionType::kClosedBoundaries:
+      DiffuseRowWithClosedEdge(y, z, x_begin, x_end, dt);
+      break;
+    case BoundaryConditionType::kOpenBoundaries:
+      DiffuseRowWithOpenEdge(y, z, x_begin, x_end, dt);
+      break;
+    case BoundaryConditionType::kDirichlet:
+      DiffuseRowWithDirichlet(y, z, x_begin, x_end, dt, sim_time);
+      break;
+    case BoundaryConditionType::kNeumann:
+      DiffuseRowWithNeumann(y, z, x_begin, x_end, dt, sim_time);
+      break;
+    case BoundaryConditionType::kPeriodic:
+      DiffuseRowWithPeriodic(y, z, x_begin, x_end, dt);
+      break;
+  }
+}
 
-        if (z == nz - 1) {
-          t = c;
-          l[3] = 0;
-        } else {
-          t = c + nx * ny;
-        }
+void EulerGrid::DiffuseRowWithClosedEdge(size_t y, size_t z, size_t x_begin,
+                                         size_t x_end, real_t dt) {
+  const auto nx = num_boxes_axis_[0];
+  const auto ny = num_boxes_axis_[1];
+  const auto nz = num_boxes_axis_[2];
 
-        c2_[c] = c1_[c] * (1 - mu_ * dt) +
-                 (d * dt * ibl2) *
-                     (0 - 2 * c1_[c] + c1_[c + 1] + c1_[s] - 2 * c1_[c] +
-                      c1_[n] + c1_[b] - 2 * c1_[c] + c1_[t]);
+  const real_t d = 1 - dc_[0];
+  const real_t fx = d * dt / (box_lengths_[0] * box_lengths_[0]);
+  const real_t fy = d * dt / (box_lengths_[1] * box_lengths_[1]);
+  const real_t fz = d * dt / (box_lengths_[2] * box_lengths_[2]);
+
+  // Boxes on the boundary keep their concentration. They are copied, such
+  // that the concentration is preserved after swapping c1_ and c2_.
+  const size_t row = y * nx + z * nx * ny;
+  if (y == 0 || y == (ny - 1) || z == 0 || z == (nz - 1)) {
+    std::copy(c1_.begin() + row + x_begin, c1_.begin() + row + x_end,
+              c2_.begin() + row + x_begin);
+    return;
+  }
+  if (x_begin == 0) {
+    c2_[row] = c1_[row];
+  }
+  if (x_end == nx) {
+    c2_[row + nx - 1] = c1_[row + nx - 1];
+  }
+
+  size_t x{0};
+  size_t c{0};
+  size_t n{0};
+  size_t s{0};
+  size_t b{0};
+  size_t t{0};
+  const size_t x_first = std::max<size_t>(x_begin, 1);
+  const size_t x_last = std::min<size_t>(x_end, nx - 1);
+  c = x_first - 1 + row;
 #pragma omp simd
-        for (x = 1; x < nx - 1; x++) {
-          ++c;
-          ++n;
-          ++s;
-          ++b;
-          ++t;
-          c2_[c] =
-              c1_[c] * (1 - mu_ * dt) +
-              (d * dt * ibl2) * (c1_[c - 1] - 2 * c1_[c] + c1_[c + 1] +
-                                 l[0] * c1_[s] - 2 * c1_[c] + l[1] * c1_[n] +
-                                 l[2] * c1_[b] - 2 * c1_[c] + l[3] * c1_[t]);
-        }
-        ++c;
-        ++n;
-        ++s;
-        ++b;
-        ++t;
-        c2_[c] = c1_[c] * (1 - mu_ * dt) +
-                 (d * dt * ibl2) *
-                     (c1_[c - 1] - 2 * c1_[c] + 0 + c1_[s] - 2 * c1_[c] +
-                      c1_[n] + c1_[b] - 2 * c1_[c] + c1_[t]);
-      }  // tile ny
-    }    // tile nz
-  }      // block ny
-  c1_.swap(c2_);
+  for (x = x_first; x < x_last; x++) {
+    ++c;
+
+    n = c - nx;
+    s = c + nx;
+    b = c - nx * ny;
+    t = c + nx * ny;
+
+    c2_[c] = c1_[c] * (1 - mu_ * dt) +
+             fx * (c1_[c - 1] - 2 * c1_[c] + c1_[c + 1]) +
+             fy * (c1_[s] - 2 * c1_[c] + c1_[n]) +
+             fz * (c1_[b] - 2 * c1_[c] + c1_[t]);
+  }
 }
 
-void EulerGrid::DiffuseWithDirichlet(real_t dt) {
-  const auto nx = resolution_;
-  const auto ny = resolution_;
-  const auto nz = resolution_;
+void EulerGrid::DiffuseRowWithOpenEdge(size_t y, size_t z, size_t x_begin,
+                                       size_t x_end, real_t dt) {
+  const auto nx = num_boxes_axis_[0];
+  const auto ny = num_boxes_axis_[1];
+  const auto nz = num_boxes_axis_[2];
 
-  const real_t ibl2 = 1 / (box_length_ * box_length_);
   const real_t d = 1 - dc_[0];
+  const real_t fx = d * dt / (box_lengths_[0] * box_lengths_[0]);
+  const real_t fy = d * dt / (box_lengths_[1] * box_lengths_[1]);
+  const real_t fz = d * dt / (box_lengths_[2] * box_lengths_[2]);
+  std::array<int, 4> l;
 
-  const auto sim_time = GetSimulatedTime();
+  size_t x{0};
+  size_t c{0};
+  size_t n{0};
+  size_t s{0};
+  size_t b{0};
+  size_t t{0};
+  c = x + y * nx + z * nx * ny;
+
+  l.fill(1);
+
+  if (y == 0) {
+    n = c;
+    l[0] = 0;
+  } else {
+    n = c - nx;
+  }
+
+  if (y == ny - 1) {
+    s = c;
+    l[1] = 0;
+  } else {
+    s = c + nx;
+  }
+
+  if (z == 0) {
+    b = c;
+    l[2] = 0;
+  } else {
+    b = c - nx * ny;
+  }
+
+  if (z == nz - 1) {
+    t = c;
+    l[3] = 0;
+  } else {
+    t = c + nx * ny;
+  }
+
+  if (x_begin == 0) {
+    c2_[c] = c1_[c] * (1 - mu_ * dt) + fx * (0 - 2 * c1_[c] + c1_[c + 1]) +
+             fy * (c1_[s] - 2 * c1_[c] + c1_[n]) +
+             fz * (c1_[b] - 2 * c1_[c] + c1_[t]);
+  }
+
+  const size_t x_first = std::max<size_t>(x_begin, 1);
+  const size_t x_last = std::min<size_t>(x_end, nx - 1);
+  c += x_first - 1;
+  n += x_first - 1;
+  s += x_first - 1;
+  b += x_first - 1;
+  t += x_first - 1;
+#pragma omp simd
+  for (x = x_first; x < x_last; x++) {
+    ++c;
+    ++n;
+    ++s;
+    ++b;
+    ++t;
+    c2_[c] = c1_[c] * (1 - mu_ * dt) +
+             fx * (c1_[c - 1] - 2 * c1_[c] + c1_[c + 1]) +
+             fy * (l[0] * c1_[s] - 2 * c1_[c] + l[1] * c1_[n]) +
+             fz * (l[2] * c1_[b] - 2 * c1_[c] + l[3] * c1_[t]);
+  }
+  if (x_end != nx) {
+    return;
+  }
+  ++c;
+  ++n;
+  ++s;
+  ++b;
+  ++t;
+  c2_[c] = c1_[c] * (1 - mu_ * dt) + fx * (c1_[c - 1] - 2 * c1_[c] + 0) +
+           fy * (c1_[s] - 2 * c1_[c] + c1_[n]) +
+           fz * (c1_[b] - 2 * c1_[c] + c1_[t]);
+}
 
-  constexpr size_t YBF = 16;
-#pragma omp parallel for collapse(2)
-  for (size_t yy = 0; yy < ny; yy += YBF) {
-    for (size_t z = 0; z < nz; z++) {
-      size_t ymax = yy + YBF;
-      if (ymax >= ny) {
-        ymax = ny;
-      }
-      for (size_t y = yy; y < ymax; y++) {
-        size_t x{0};
-        size_t c{0};
-        size_t n{0};
-        size_t s{0};
-        size_t b{0};
-        size_t t{0};
-        c = x + y * nx + z * nx * ny;
+void EulerGrid::DiffuseRowWithDirichlet(size_t y, size_t z, size_t x_begin,
+                                        size_t x_end, real_t dt,
+                                        real_t sim_time) {
+  const auto nx = num_boxes_axis_[0];
+  const auto ny = num_boxes_axis_[1];
+  const auto nz = num_boxes_axis_[2];
+
+  const real_t d = 1 - dc_[0];
+  const real_t fx = d * dt / (box_lengths_[0] * box_lengths_[0]);
+  const real_t fy = d * dt / (box_lengths_[1] * box_lengths_[1]);
+  const real_t fz = d * dt / (box_lengths_[2] * box_lengths_[2]);
+
+  size_t x{0};
+  size_t c{0};
+  size_t n{0};
+  size_t s{0};
+  size_t b{0};
+  size_t t{0};
+  c = x_begin + y * nx + z * nx * ny;
 #pragma omp simd
-        for (x = 0; x < nx; x++) {
-          if (x == 0 || x == (nx - 1) || y == 0 || y == (ny - 1) || z == 0 ||
-              z == (nz - 1)) {
-            // For all boxes on the boundary, we simply evaluate the boundary
-            real_t real_x = grid_dimensions_[0] + x * box_length_;
-            real_t real_y = grid_dimensions_[0] + y * box_length_;
-            real_t real_z = grid_dimensions_[0] + z * box_length_;
-            c2_[c] =
-                boundary_condition_->Evaluate(real_x, real_y, real_z, sim_time);
-          } else {
-            // For inner boxes, we compute the regular stencil update
-            n = c - nx;
-            s = c + nx;
-            b = c - nx * ny;
-            t = c + nx * ny;
-
-            c2_[c] = c1_[c] * (1 - mu_ * dt) +
-                     (d * dt * ibl2) *
-                         (c1_[c - 1] - 2 * c1_[c] + c1_[c + 1] + c1_[s] -
-                          2 * c1_[c] + c1_[n] + c1_[b] - 2 * c1_[c] + c1_[t]);
-          }
-          ++c;
-        }
-      }  // tile ny
-    }    // tile nz
-  }      // block ny
-  c1_.swap(c2_);
+  for (x = x_begin; x < x_end; x++) {
+    if (x == 0 || x == (nx - 1) || y == 0 || y == (ny - 1) || z == 0 ||
+        z == (nz - 1)) {
+      // For all boxes on the boundary, we simply evaluate the boundary
+      real_t real_x = grid_dimensions_[0] + x * box_lengths_[0];
+      real_t real_y = grid_dimensions_[2] + y * box_lengths_[1];
+      real_t real_z = grid_dimensions_[4] + z * box_lengths_[2];
+      c2_[c] = boundary_condition_->Evaluate(real_x, real_y, real_z, sim_time);
+    } else {
+      // For inner boxes, we compute the regular stencil update
+      n = c - nx;
+      s = c + nx;
+      b = c - nx * ny;
+      t = c + nx * ny;
+
+      c2_[c] = c1_[c] * (1 - mu_ * dt) +
+               fx * (c1_[c - 1] - 2 * c1_[c] + c1_[c + 1]) +
+               fy * (c1_[s] - 2 * c1_[c] + c1_[n]) +
+               fz * (c1_[b] - 2 * c1_[c] + c1_[t]);
+    }
+    ++c;
+  }
 }
 
-void EulerGrid::DiffuseWithNeumann(real_t dt) {
-  const size_t nx = resolution_;
-  const size_t ny = resolution_;
-  const size_t nz = resolution_;
+void EulerGrid::DiffuseRowWithNeumann(size_t y, size_t z, size_t x_begin,
+                                      size_t x_end, real_t dt,
+                                      real_t sim_time) {
+  const size_t nx = num_boxes_axis_[0];
+  const size_t ny = num_boxes_axis_[1];
+  const size_t nz = num_boxes_axis_[2];
   const size_t num_boxes = nx * ny * nz;
 
-  const real_t ibl2 = 1 / (box_length_ * box_length_);
   const real_t d = 1 - dc_[0];
+  const real_t fx = d * dt / (box_lengths_[0] * box_lengths_[0]);
+  const real_t fy = d * dt / (box_lengths_[1] * box_lengths_[1]);
+  const real_t fz = d * dt / (box_lengths_[2] * box_lengths_[2]);
+
+  size_t x{0};
+  size_t c{0};
+  size_t n{0};
+  size_t s{0};
+  size_t b{0};
+  size_t t{0};
+  c = x_begin + y * nx + z * nx * ny;
+#pragma omp simd
+  for (x = x_begin; x < x_end; x++) {
+    n = c - nx;
+    s = c + nx;
+    b = c - nx * ny;
+    t = c + nx * ny;
+
+    // Clamp to avoid out of bounds access. Clamped values are initialized
+    // to a wrong value but will be overwritten by the boundary condition
+    // evaluation. All other values are correct.
+    real_t left{c1_[std::clamp(c - 1, size_t{0}, num_boxes - 1)]};
+    real_t right{c1_[std::clamp(c + 1, size_t{0}, num_boxes - 1)]};
+    real_t bottom{c1_[std::clamp(b, size_t{0}, num_boxes - 1)]};
+    real_t top{c1_[std::clamp(t, size_t{0}, num_boxes - 1)]};
+    real_t north{c1_[std::clamp(n, size_t{0}, num_boxes - 1)]};
+    real_t south{c1_[std::clamp(s, size_t{0}, num_boxes - 1)]};
+    // Factor of the center box in the stencil along each axis
+    real_t center_x{2.0};
+    real_t center_y{2.0};
+    real_t center_z{2.0};
+
+    if (x == 0 || x == (nx - 1) || y == 0 || y == (ny - 1) || z == 0 ||
+        z == (nz - 1)) {
+      real_t real_x = grid_dimensions_[0] + x * box_lengths_[0];
+      real_t real_y = grid_dimensions_[2] + y * box_lengths_[1];
+      real_t real_z = grid_dimensions_[4] + z * box_lengths_[2];
+      real_t value =
+          boundary_condition_->Evaluate(real_x, real_y, real_z, sim_time);
+
+      if (x == 0) {
+        left = -box_lengths_[0] * value;
+        center_x -= 1.0;
+      } else if (x == (nx - 1)) {
+        right = -box_lengths_[0] * value;
+        center_x -= 1.0;
+      }
 
-  const auto sim_time = GetSimulatedTime();
+      if (y == 0) {
+        north = -box_lengths_[1] * value;
+        center_y -= 1.0;
+      } else if (y == (ny - 1)) {
+        south = -box_lengths_[1] * value;
+        center_y -= 1.0;
+      }
 
-  constexpr size_t YBF = 16;
-#pragma omp parallel for collapse(2)
-  for (size_t yy = 0; yy < ny; yy += YBF) {
-    for (size_t z = 0; z < nz; z++) {
-      size_t ymax = yy + YBF;
-      if (ymax >= ny) {
-        ymax = ny;
+      if (z == 0) {
+        bottom = -box_lengths_[2] * value;
+        center_z -= 1.0;
+      } else if (z == (nz - 1)) {
+        top = -box_lengths_[2] * value;
+        center_z -= 1.0;
       }
-      for (size_t y = yy; y < ymax; y++) {
-        size_t x{0};
-        size_t c{0};
-        size_t n{0};
-        size_t s{0};
-        size_t b{0};
-        size_t t{0};
-        c = x + y * nx + z * nx * ny;
-#pragma omp simd
-        for (x = 0; x < nx; x++) {
-          n = c - nx;
-          s = c + nx;
-          b = c - nx * ny;
-          t = c + nx * ny;
-
-          // Clamp to avoid out of bounds access. Clamped values are initialized
-          // to a wrong value but will be overwritten by the boundary condition
-          // evaluation. All other values are correct.
-          real_t left{c1_[std::clamp(c - 1, size_t{0}, num_boxes - 1)]};
-          real_t right{c1_[std::clamp(c + 1, size_t{0}, num_boxes - 1)]};
-          real_t bottom{c1_[std::clamp(b, size_t{0}, num_boxes - 1)]};
-          real_t top{c1_[std::clamp(t, size_t{0}, num_boxes - 1)]};
-          real_t north{c1_[std::clamp(n, size_t{0}, num_boxes - 1)]};
-          real_t south{c1_[std::clamp(s, size_t{0}, num_boxes - 1)]};
-          real_t center_factor{6.0};
-
-          if (x == 0 || x == (nx - 1) || y == 0 || y == (ny - 1) || z == 0 ||
-              z == (nz - 1)) {
-            real_t real_x = grid_dimensions_[0] + x * box_length_;
-            real_t real_y = grid_dimensions_[0] + y * box_length_;
-            real_t real_z = grid_dimensions_[0] + z * box_length_;
-            real_t boundary_value =
-                -box_length_ *
-                boundary_condition_->Evaluate(real_x, real_y, real_z, sim_time);
+    }
 
-            if (x == 0) {
-              left = boundary_value;
-              center_factor -= 1.0;
-            } else if (x == (nx - 1)) {
-              right = boundary_value;
-              center_factor -= 1.0;
-            }
+    c2_[c] = c1_[c] * (1 - mu_ * dt) + fx * (left + right - center_x * c1_[c]) +
+             fy * (south + north - center_y * c1_[c]) +
+             fz * (top + bottom - center_z * c1_[c]);
 
-            if (y == 0) {
-              north = boundary_value;
-              center_factor -= 1.0;
-            } else if (y == (ny - 1)) {
-              south = boundary_value;
-              center_factor -= 1.0;
-            }
+    ++c;
+  }
+}
 
-            if (z == 0) {
-              bottom = boundary_value;
-              center_factor -= 1.0;
-            } else if (z == (nz - 1)) {
-              top = boundary_value;
-              center_factor -= 1.0;
-            }
-          }
+void EulerGrid::DiffuseRowWithPeriodic(size_t y, size_t z, size_t x_begin,
+                                       size_t x_end, real_t dt) {
+  const size_t nx = num_boxes_axis_[0];
+  const size_t ny = num_boxes_axis_[1];
+  const size_t nz = num_boxes_axis_[2];
 
-          c2_[c] = c1_[c] * (1 - mu_ * dt) +
-                   (d * dt * ibl2) * (left + right + south + north + top +
-                                      bottom - center_factor * c1_[c]);
+  const real_t d = 1 - dc_[0];
+  const real_t fx = d * dt / (box_lengths_[0] * box_lengths_[0]);
+  const real_t fy = d * dt / (box_lengths_[1] * box_lengths_[1]);
+  const real_t fz = d * dt / (box_lengths_[2] * box_lengths_[2]);
+
+  size_t l{0};
+  size_t r{0};
+  size_t n{0};
+  size_t s{0};
+  size_t b{0};
+  size_t t{0};
+  size_t c = x_begin + y * nx + z * nx * ny;
+#pragma omp simd
+  for (size_t x = x_begin; x < x_end; x++) {
+    l = c - 1;
+    r = c + 1;
+    n = c - nx;
+    s = c + nx;
+    b = c - nx * ny;
+    t = c + nx * ny;
+
+    // Adapt neighbor indices for boundary boxes for periodic boundary
+    if (x == 0) {
+      l = nx - 1 + y * nx + z * nx * ny;
+    } else if (x == (nx - 1)) {
+      r = 0 + y * nx + z * nx * ny;
+    }
+
+    if (y == 0) {
+      n = x + (ny - 1) * nx + z * nx * ny;
+    } else if (y == (ny - 1)) {
+      s = x + 0 * nx + z * nx * ny;
+    }
+
+    if (z == 0) {
+      b = x + y * nx + (nz - 1) * nx * ny;
+    } else if (z == (nz - 1)) {
+      t = x + y * nx + 0 * nx * ny;
+    }
+
+    // Stencil update
+    c2_[c] = c1_[c] * (1 - (mu_ * dt)) +
+             fx * (c1_[l] - 2 * c1_[c] + c1_[r]) +
+             fy * (c1_[s] - 2 * c1_[c] + c1_[n]) +
+             fz * (c1_[b] - 2 * c1_[c] + c1_[t]);
+
+    ++c;
+  }
+}
 
-          ++c;
-        }
-      }  // tile ny
-    }    // tile nz
-  }      // block ny
-  c1_.swap(c2_);
+void EulerGrid::MultiStep(real_t dt, int n_steps) {
+  const auto* param = Simulation::GetActive()->GetParam();
+  const int block = static_cast<int>(std::min<uint64_t>(
+      param->diffusion_temporal_blocking, kTemporalTileSize));
+  const bool supported_bc =
+      bc_type_ == BoundaryConditionType::kClosedBoundaries ||
+      bc_type_ == BoundaryConditionType::kDirichlet ||
+      bc_type_ == BoundaryConditionType::kNeumann ||
+      bc_type_ == BoundaryConditionType::kPeriodic;
+  if (block <= 1 || n_steps <= 1 || !supported_bc || IsFixedSubstance()) {
+    DiffusionGrid::MultiStep(dt, n_steps);
+    return;
+  }
+
+  // Same bookkeeping as in DiffusionGrid::Diffuse
+  last_dt_ = dt;
+  ParametersCheck(dt);
+
+  for (int done = 0; done < n_steps;) {
+    const int steps = std::min(block, n_steps - done);
+    if (steps == 1) {
+      Diffuse(dt);
+    } else {
+      DiffuseTemporallyBlocked(dt, steps);
+    }
+    done += steps;
+  }
 }
 
-void EulerGrid::DiffuseWithPeriodic(real_t dt) {
-  const size_t nx = resolution_;
-  const size_t ny = resolution_;
-  const size_t nz = resolution_;
+void EulerGrid::DiffuseTemporallyBlocked(real_t dt, int n_steps) {
+  const int k = n_steps;
+  const bool periodic = bc_type_ == BoundaryConditionType::kPeriodic;
 
-  const real_t dx = box_length_;
   const real_t d = 1 - dc_[0];
+  const real_t decay = 1 - mu_ * dt;
 
-  constexpr size_t YBF = 16;
-#pragma omp parallel for collapse(2)
-  for (size_t yy = 0; yy < ny; yy += YBF) {
-    for (size_t z = 0; z < nz; z++) {
-      size_t ymax = yy + YBF;
-      if (ymax >= ny) {
-        ymax = ny;
-      }
-      for (size_t y = yy; y < ymax; y++) {
-        size_t l{0};
-        size_t r{0};
-        size_t n{0};
-        size_t s{0};
-        size_t b{0};
-        size_t t{0};
-        size_t c = y * nx + z * nx * ny;
+  const auto sim_time = GetSimulatedTime();
+
+  constexpr int kTile = kTemporalTileSize;
+  std::array<int, 3> n;
+  std::array<real_t, 3> factor;
+  std::array<int, 3> num_tiles;
+  size_t buffer_size = 1;
+  for (int i = 0; i < 3; i++) {
+    n[i] = static_cast<int>(num_boxes_axis_[i]);
+    factor[i] = d * dt / (box_lengths_[i] * box_lengths_[i]);
+    num_tiles[i] = (n[i] + kTile - 1) / kTile;
+    buffer_size *= std::min(kTile, n[i]) + 2 * k;
+  }
+  const size_t nxy = static_cast<size_t>(n[0]) * n[1];
+
+#pragma omp parallel
+  {
+    std::vector<real_t> a(buffer_size);
+    std::vector<real_t> b(buffer_size);
+
+#pragma omp for collapse(3) schedule(static)
+    for (int tz = 0; tz < num_tiles[2]; tz++) {
+      for (int ty = 0; ty < num_tiles[1]; ty++) {
+        for (int tx = 0; tx < num_tiles[0]; tx++) {
+          // Tile [begin, end) and the region including the halo [lo, hi) in
+          // global box coordinates. Without periodic boundaries, the halo is
+          // clipped at the grid boundary.
+          const std::array<int, 3> tile{tx, ty, tz};
+          std::array<int, 3> begin;
+          std::array<int, 3> end;
+          std::array<int, 3> lo;
+          std::array<int, 3> hi;
+          for (int i = 0; i < 3; i++) {
+            begin[i] = tile[i] * kTile;
+            end[i] = std::min(begin[i] + kTile, n[i]);
+            lo[i] = periodic ? begin[i] - k : std::max(begin[i] - k, 0);
+            hi[i] = periodic ? end[i] + k : std::min(end[i] + k, n[i]);
+          }
+          const int ex = hi[0] - lo[0];
+          const int ey = hi[1] - lo[1];
+          const int ez = hi[2] - lo[2];
+          const int exy = ex * ey;
+
+          // Load the tile including the halo. Indices outside of the grid
+          // only occur with periodic boundaries and are wrapped around.
+          const bool wrap_x = lo[0] < 0 || hi[0] > n[0];
+          for (int lz = 0; lz < ez; lz++) {
+            const int gz = ((lo[2] + lz) % n[2] + n[2]) % n[2];
+            for (int ly = 0; ly < ey; ly++) {
+              const int gy = ((lo[1] + ly) % n[1] + n[1]) % n[1];
+              const size_t row = static_cast<size_t>(gy) * n[0] +
+                                 static_cast<size_t>(gz) * nxy;
+              real_t* dst = &a[ly * ex + lz * exy];
+              if (wrap_x) {
+                for (int lx = 0; lx < ex; lx++) {
+                  dst[lx] = c1_[row + ((lo[0] + lx) % n[0] + n[0]) % n[0]];
+                }
+              } else {
+                const real_t* src = &c1_[row + lo[0]];
 #pragma omp simd
-        for (size_t x = 0; x < nx; x++) {
-          l = c - 1;
-          r = c + 1;
-          n = c - nx;
-          s = c + nx;
-          b = c - nx * ny;
-          t = c + nx * ny;
-
-          // Adapt neighbor indices for boundary boxes for periodic boundary
-          if (x == 0) {
-            l = nx - 1 + y * nx + z * nx * ny;
-          } else if (x == (nx - 1)) {
-            r = 0 + y * nx + z * nx * ny;
+                for (int lx = 0; lx < ex; lx++) {
+                  dst[lx] = src[lx];
+                }
+              }
+            }
           }
 
-          if (y == 0) {
-            n = x + (ny - 1) * nx + z * nx * ny;
-          } else if (y == (ny - 1)) {
-            s = x + 0 * nx + z * nx * ny;
-          }
+          // Update of a box on the (non-periodic) grid boundary. Mirrors the
+          // boundary treatment of the DiffuseWith* methods.
+          auto boundary_update = [&](const real_t* in, size_t c, int gx,
+                                     int gy, int gz) -> real_t {
+            if (bc_type_ == BoundaryConditionType::kClosedBoundaries) {
+              return in[c];
+            }
+            real_t real_x = grid_dimensions_[0] + gx * box_lengths_[0];
+            real_t real_y = grid_dimensions_[2] + gy * box_lengths_[1];
+            real_t real_z = grid_dimensions_[4] + gz * box_lengths_[2];
+            real_t value =
+                boundary_condition_->Evaluate(real_x, real_y, real_z, sim_time);
+            if (bc_type_ == BoundaryConditionType::kDirichlet) {
+              return value;
+            }
+            // Neumann
+            std::array<real_t, 3> center_factor{{2.0, 2.0, 2.0}};
+            std::array<real_t, 3> sum{{0, 0, 0}};
+            auto add = [&](int axis, bool at_boundary, size_t neighbor) {
+              if (at_boundary) {
+                sum[axis] += -box_lengths_[axis] * value;
+                center_factor[axis] -= 1.0;
+              } else {
+                sum[axis] += in[neighbor];
+              }
+            };
+            add(0, gx == 0, c - 1);
+            add(0, gx == n[0] - 1, c + 1);
+            add(1, gy == 0, c - ex);
+            add(1, gy == n[1] - 1, c + ex);
+            add(2, gz == 0, c - exy);
+            add(2, gz == n[2] - 1, c + exy);
+            return in[c] * decay +
+                   factor[0] * (sum[0] - center_factor[0] * in[c]) +
+                   factor[1] * (sum[1] - center_factor[1] * in[c]) +
+                   factor[2] * (sum[2] - center_factor[2] * in[c]);
+          };
+
+          for (int step = 1; step <= k; step++) {
+            // Region that holds valid values after this step (local coords)
+            std::array<int, 3> from;
+            std::array<int, 3> to;
+            for (int i = 0; i < 3; i++) {
+              const int extent = hi[i] - lo[i];
+              from[i] = (periodic || lo[i] > 0) ? step : 0;
+              to[i] = (periodic || hi[i] < n[i]) ? extent - step : extent;
+            }
 
-          if (z == 0) {
-            b = x + y * nx + (nz - 1) * nx * ny;
-          } else if (z == (nz - 1)) {
-            t = x + y * nx + 0 * nx * ny;
+            const real_t* in = a.data();
+            real_t* out = b.data();
+            for (int lz = from[2]; lz < to[2]; lz++) {
+              const int gz = lo[2] + lz;
+              for (int ly = from[1]; ly < to[1]; ly++) {
+                const int gy = lo[1] + ly;
+                const size_t row = static_cast<size_t>(ly) * ex +
+                                   static_cast<size_t>(lz) * exy;
+                int xs = from[0];
+                int xe = to[0];
+                const bool boundary_row =
+                    !periodic && (gy == 0 || gy == n[1] - 1 || gz == 0 ||
+                                  gz == n[2] - 1);
+                if (boundary_row) {
+                  for (int lx = xs; lx < xe; lx++) {
+                    out[row + lx] =
+                        boundary_update(in, row + lx, lo[0] + lx, gy, gz);
+                  }
+                  continue;
+                }
+                if (!periodic && lo[0] + xs == 0) {
+                  out[row + xs] = boundary_update(in, row + xs, 0, gy, gz);
+                  xs++;
+                }
+                if (!periodic && lo[0] + xe == n[0]) {
+                  xe--;
+                  out[row + xe] =
+                      boundary_update(in, row + xe, n[0] - 1, gy, gz);
+                }
+#pragma omp simd
+                for (int lx = xs; lx < xe; lx++) {
+                  const size_t c = row + lx;
+                  out[c] = in[c] * decay +
+                           factor[0] * (in[c - 1] - 2 * in[c] + in[c + 1]) +
+                           factor[1] * (in[c + ex] - 2 * in[c] + in[c - ex]) +
+                           factor[2] * (in[c - exy] - 2 * in[c] + in[c + exy]);
+                }
+              }
+            }
+            a.swap(b);
           }
 
-          // Stencil update
-          c2_[c] = c1_[c] * (1 - (mu_ * dt)) +
-                   ((d * dt / (dx * dx)) * (c1_[l] + c1_[r] + c1_[n] + c1_[s] +
-                                            c1_[t] + c1_[b] - 6.0 * c1_[c]));
-
-          ++c;
+          // Store the tile without the halo
+          for (int gz = begin[2]; gz < end[2]; gz++) {
+            for (int gy = begin[1]; gy < end[1]; gy++) {
+              const size_t row = static_cast<size_t>(gy) * n[0] +
+                                 static_cast<size_t>(gz) * nxy;
+              const real_t* src = &a[(begin[0] - lo[0]) +
+                                     (gy - lo[1]) * ex + (gz - lo[2]) * exy];
+#pragma omp simd
+              for (int gx = begin[0]; gx < end[0]; gx++) {
+                c2_[row + gx] = src[gx - begin[0]];
+              }
+            }
+          }
         }
-      }  // tile ny
-    }    // tile nz
-  }      // block ny
+      }
+    }
+  }
   c1_.swap(c2_);
 }
 
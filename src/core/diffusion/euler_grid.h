@@ -16,6 +16,7 @@
 #define CORE_DIFFUSION_EULER_GRID_H_
 
 #include <utility>
+#include <vector>
 
 #include "core/diffusion/diffusion_grid.h"
 
@@ -54,7 +55,75 @@ class EulerGrid : public DiffusionGrid {
   void DiffuseWithNeumann(real_t dt) override;
   void DiffuseWithPeriodic(real_t dt) override;
 
+  /// Advances the grid by `n_steps` time steps of length `dt`. If
+  /// `Param::diffusion_temporal_blocking` is larger than one, up to that many
+  /// steps are fused into a single pass over the grid (see
+  /// `DiffuseTemporallyBlocked`). Open boundaries are always advanced with
+  /// one pass per step.
+  void MultiStep(real_t dt, int n_steps) override;
+
+  /// Returns true if this grid and `other` discretize the same domain with
+  /// the same boxes and boundary condition type, i.e. if they can be
+  /// advanced together with `DiffuseFused`.
+  bool CanFuseWith(const EulerGrid& other) const;
+
+  /// Advances all `grids` by `n_steps` time steps of length `dt` in a fused
+  /// kernel. Each step is a single parallel pass over the grid rows that
+  /// updates the row of every substance before moving on to the next row.
+  /// Hence, the rows of all substances are processed while their neighborhood
+  /// is still in the cache, and the depletion of `EulerDepletionGrid`s reads
+  /// the concentration of the binding substance from the cache instead of
+  /// streaming it in a second pass. All grids must be compatible (see
+  /// `CanFuseWith`). Binding substances contribute their concentration from
+  /// the beginning of the step, independent of the order of the grids.
+  static void DiffuseFused(const std::vector<EulerGrid*>& grids, real_t dt,
+                           int n_steps);
+
+  /// Calculates the gradients of all `grids` (see `CalculateGradient`) in a
+  /// single pass. All grids must be compatible (see `CanFuseWith`).
+  static void CalculateGradientFused(const std::vector<EulerGrid*>& grids);
+
+ protected:
+  /// Called once before each step of `DiffuseFused`. Used by
+  /// `EulerDepletionGrid` to look up its binding substances.
+  virtual void PrepareDepletion() {}
+
+  /// Called by `DiffuseFused` for the boxes [begin, end) after their new
+  /// concentration has been written to `c2_` (`c1_` still holds the
+  /// concentration of the previous step).
+  virtual void ApplyDepletion(real_t dt, size_t begin, size_t end) {}
+
+  /// Computes the new concentration of the boxes [x_begin, x_end) of the row
+  /// of boxes (y, z) into `c2_` for the boundary condition type of this grid.
+  void DiffuseRow(size_t y, size_t z, size_t x_begin, size_t x_end, real_t dt,
+                  real_t sim_time);
+
  private:
+  /// Edge length (in boxes) of the tiles of `DiffuseTemporallyBlocked`.
+  static constexpr int kTemporalTileSize = 32;
+
+  /// Advances the grid by `n_steps` time steps in a single pass over `c1_`.
+  /// The grid is split into cubic tiles. Each thread copies a tile together
+  /// with a halo of `n_steps` boxes into a thread-local buffer and performs
+  /// all steps on this buffer, shrinking the updated region by one box per
+  /// step. Thus, the halo is computed redundantly, but each box is read from
+  /// and written to main memory once per pass instead of once per step. The
+  /// result is identical to `n_steps` calls of the corresponding
+  /// `DiffuseWith*` method (up to rounding). Open boundaries are not
+  /// supported.
+  void DiffuseTemporallyBlocked(real_t dt, int n_steps);
+
+  void DiffuseRowWithClosedEdge(size_t y, size_t z, size_t x_begin,
+                                size_t x_end, real_t dt);
+  void DiffuseRowWithOpenEdge(size_t y, size_t z, size_t x_begin,
+                              size_t x_end, real_t dt);
+  void DiffuseRowWithDirichlet(size_t y, size_t z, size_t x_begin,
+                               size_t x_end, real_t dt, real_t sim_time);
+  void DiffuseRowWithNeumann(size_t y, size_t z, size_t x_begin, size_t x_end,
+                             real_t dt, real_t sim_time);
+  void DiffuseRowWithPeriodic(size_t y, size_t z, size_t x_begin,
+                              size_t x_end, real_t dt);
+
   BDM_CLASS_DEF_OVERRIDE(EulerGrid, 1);
 };
 
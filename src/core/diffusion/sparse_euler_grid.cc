@@ -0,0 +1,257 @@
+// -----------------------------------------------------------------------------
+//
+// Copyright (C) 2021 CERN & University of Surrey for the benefit of the
+// BioDynaMo collaboration. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+//
+// See the LICENSE file distributed with this work for details.
+// See the NOTICE file distributed with this work for additional information
+// regarding copyright ownership.
+//
+// -----------------------------------------------------------------------------
+
+#include "core/diffusion/sparse_euler_grid.h"
+#include <algorithm>
+#include <cmath>
+#include "core/param/param.h"
+#include "core/simulation.h"
+
+namespace bdm {
+
+void SparseEulerGrid::Initialize() {
+  EulerGrid::Initialize();
+  InitializeBricks();
+}
+
+void SparseEulerGrid::Update() {
+  const auto old_num_boxes_axis = num_boxes_axis_;
+  EulerGrid::Update();
+  if (num_boxes_axis_ != old_num_boxes_axis) {
+    InitializeBricks();
+  }
+}
+
+void SparseEulerGrid::InitializeBricks() {
+  size_t num_bricks = 1;
+  for (size_t i = 0; i < 3; i++) {
+    num_bricks_[i] = (num_boxes_axis_[i] + kBrickSize - 1) / kBrickSize;
+    num_bricks *= num_bricks_[i];
+  }
+  changed_.assign(num_bricks, 1);
+  modified_.assign(num_bricks, 0);
+  written_.assign(num_bricks, 0);
+  stale_gradient_.assign(num_bricks, 1);
+  active_.assign(num_bricks, 0);
+}
+
+size_t SparseEulerGrid::GetNumActiveBricks() const {
+  return std::count(active_.begin(), active_.end(), 1);
+}
+
+size_t SparseEulerGrid::GetBrickIndex(size_t idx) const {
+  const auto& n = num_boxes_axis_;
+  const size_t x = idx % n[0];
+  const size_t y = (idx / n[0]) % n[1];
+  const size_t z = idx / (n[0] * n[1]);
+  return x / kBrickSize +
+         num_bricks_[0] * (y / kBrickSize + num_bricks_[1] * (z / kBrickSize));
+}
+
+void SparseEulerGrid::ConcentrationChanged(size_t idx) {
+  // Bricks are set up lazily for grids restored from a backup. The first step
+  // of such grids updates all bricks anyway.
+  if (modified_.empty()) {
+    return;
+  }
+  // ChangeConcentrationBy is called by agents in parallel
+  const size_t brick = GetBrickIndex(idx);
+#pragma omp atomic write
+  modified_[brick] = 1;
+#pragma omp atomic write
+  stale_gradient_[brick] = 1;
+}
+
+bool SparseEulerGrid::IsSetInNeighborhood(const std::vector<char>& flags,
+                                          size_t bx, size_t by,
+                                          size_t bz) const {
+  const auto& nb = num_bricks_;
+  const std::array<size_t, 3> brick = {bx, by, bz};
+  auto is_set = [&](const std::array<size_t, 3>& b) {
+    return flags[b[0] + nb[0] * (b[1] + nb[1] * b[2])] != 0;
+  };
+  if (is_set(brick)) {
+    return true;
+  }
+  const bool periodic = bc_type_ == BoundaryConditionType::kPeriodic;
+  for (size_t i = 0; i < 3; i++) {
+    auto neighbor = brick;
+    if (brick[i] > 0 || periodic) {
+      neighbor[i] = (brick[i] + nb[i] - 1) % nb[i];
+      if (is_set(neighbor)) {
+        return true;
+      }
+    }
+    if (brick[i] + 1 < nb[i] || periodic) {
+      neighbor[i] = (brick[i] + 1) % nb[i];
+      if (is_set(neighbor)) {
+        return true;
+      }
+    }
+  }
+  return false;
+}
+
+void SparseEulerGrid::DiffuseSparse(real_t dt) {
+  // The brick state is not stored in backups
+  if (active_.empty()) {
+    InitializeBricks();
+  }
+
+  const auto* param = Simulation::GetActive()->GetParam();
+  const real_t tolerance = param->diffusion_sparse_tolerance;
+  const auto sim_time = GetSimulatedTime();
+  const auto& n = num_boxes_axis_;
+  const auto& nb = num_bricks_;
+
+  // Skipping a quiescent brick is only exact if the update is the same as in
+  // the previous step. The boundary values of Dirichlet and Neumann boundary
+  // conditions may depend on the simulated time.
+  const bool update_all = dt != previous_dt_ || mu_ != previous_mu_ ||
+                          bc_type_ != previous_bc_type_;
+  const bool update_boundary =
+      bc_type_ == BoundaryConditionType::kDirichlet ||
+      bc_type_ == BoundaryConditionType::kNeumann;
+  previous_dt_ = dt;
+  previous_mu_ = mu_;
+  previous_bc_type_ = bc_type_;
+
+  // Determine the bricks that are updated in this step
+#pragma omp parallel for collapse(2)
+  for (size_t bz = 0; bz < nb[2]; bz++) {
+    for (size_t by = 0; by < nb[1]; by++) {
+      for (size_t bx = 0; bx < nb[0]; bx++) {
+        const bool on_boundary = bx == 0 || by == 0 || bz == 0 ||
+                                 bx == nb[0] - 1 || by == nb[1] - 1 ||
+                                 bz == nb[2] - 1;
+        active_[bx + nb[0] * (by + nb[1] * bz)] =
+            update_all || (update_boundary && on_boundary) ||
+            IsSetInNeighborhood(changed_, bx, by, bz) ||
+            IsSetInNeighborhood(modified_, bx, by, bz);
+      }
+    }
+  }
+  std::fill(modified_.begin(), modified_.end(), 0);
+
+  // Each iteration processes the bricks (0..nb[0], by, bz). Consecutive active
+  // bricks along the x-axis are updated with a single call per row of boxes.
+#pragma omp parallel for collapse(2) schedule(dynamic)
+  for (size_t bz = 0; bz < nb[2]; bz++) {
+    for (size_t by = 0; by < nb[1]; by++) {
+      const size_t y_begin = by * kBrickSize;
+      const size_t y_end = std::min(y_begin + kBrickSize, n[1]);
+      const size_t z_begin = bz * kBrickSize;
+      const size_t z_end = std::min(z_begin + kBrickSize, n[2]);
+      const size_t row = nb[0] * (by + nb[1] * bz);
+
+      size_t bx = 0;
+      while (bx < nb[0]) {
+        if (!active_[row + bx]) {
+          // Bricks updated in the last step hold the concentration of the
+          // step before in `c2_`. Copy the current concentration, such that
+          // the brick keeps it after the swap.
+          if (written_[row + bx]) {
+            const size_t x_begin = bx * kBrickSize;
+            const size_t x_end = std::min(x_begin + kBrickSize, n[0]);
+            for (size_t z = z_begin; z < z_end; z++) {
+              for (size_t y = y_begin; y < y_end; y++) {
+                const size_t offset = y * n[0] + z * n[0] * n[1];
+                std::copy(c1_.begin() + offset + x_begin,
+                          c1_.begin() + offset + x_end,
+                          c2_.begin() + offset + x_begin);
+              }
+            }
+            written_[row + bx] = 0;
+          }
+          changed_[row + bx] = 0;
+          bx++;
+          continue;
+        }
+
+        size_t bx_end = bx + 1;
+        while (bx_end < nb[0] && active_[row + bx_end]) {
+          bx_end++;
+        }
+        for (size_t b = bx; b < bx_end; b++) {
+          changed_[row + b] = 0;
+          written_[row + b] = 1;
+        }
+        const size_t x_begin = bx * kBrickSize;
+        const size_t x_end = std::min(bx_end * kBrickSize, n[0]);
+        for (size_t z = z_begin; z < z_end; z++) {
+          for (size_t y = y_begin; y < y_end; y++) {
+            DiffuseRow(y, z, x_begin, x_end, dt, sim_time);
+            // Compare the new concentration while the row is in the cache
+            const size_t offset = y * n[0] + z * n[0] * n[1];
+            for (size_t b = bx; b < bx_end; b++) {
+              if (changed_[row + b]) {
+                continue;
+              }
+              const size_t begin = offset + b * kBrickSize;
+              const size_t end = offset + std::min((b + 1) * kBrickSize, n[0]);
+              for (size_t i = begin; i < end; i++) {
+                if (std::abs(c2_[i] - c1_[i]) > tolerance) {
+                  changed_[row + b] = 1;
+                  stale_gradient_[row + b] = 1;
+                  break;
+                }
+              }
+            }
+          }
+        }
+        bx = bx_end;
+      }
+    }
+  }
+  c1_.swap(c2_);
+}
+
+void SparseEulerGrid::CalculateGradient() {
+  // Same conditions as in DiffusionGrid::CalculateGradient
+  if ((init_gradient_ && IsFixedSubstance()) || !precompute_gradients_) {
+    return;
+  }
+  if (!init_gradient_ || stale_gradient_.empty()) {
+    DiffusionGrid::CalculateGradient();
+    std::fill(stale_gradient_.begin(), stale_gradient_.end(), 0);
+    return;
+  }
+
+  // The gradient of a box depends on the concentration of its neighbors.
+  // Hence, bricks next to a changed brick are recomputed as well.
+  const auto& n = num_boxes_axis_;
+  const auto& nb = num_bricks_;
+#pragma omp parallel for collapse(2) schedule(dynamic)
+  for (size_t bz = 0; bz < nb[2]; bz++) {
+    for (size_t by = 0; by < nb[1]; by++) {
+      for (size_t bx = 0; bx < nb[0]; bx++) {
+        if (!IsSetInNeighborhood(stale_gradient_, bx, by, bz)) {
+          continue;
+        }
+        const size_t x_begin = bx * kBrickSize;
+        const size_t x_end = std::min(x_begin + kBrickSize, n[0]);
+        const size_t y_end = std::min((by + 1) * kBrickSize, n[1]);
+        const size_t z_end = std::min((bz + 1) * kBrickSize, n[2]);
+        for (size_t z = bz * kBrickSize; z < z_end; z++) {
+          for (size_t y = by * kBrickSize; y < y_end; y++) {
+            CalculateGradientRow(y, z, x_begin, x_end);
+          }
+        }
+      }
+    }
+  }
+  std::fill(stale_gradient_.begin(), stale_gradient_.end(), 0);
+}
+
+}  // namespace bdm
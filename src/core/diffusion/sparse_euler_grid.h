@@ -0,0 +1,133 @@
+// -----------------------------------------------------------------------------
+//
+// Copyright (C) 2021 CERN & University of Surrey for the benefit of the
+// BioDynaMo collaboration. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+//
+// See the LICENSE file distributed with this work for details.
+// See the NOTICE file distributed with this work for additional information
+// regarding copyright ownership.
+//
+// -----------------------------------------------------------------------------
+
+#ifndef CORE_DIFFUSION_SPARSE_EULER_GRID_H_
+#define CORE_DIFFUSION_SPARSE_EULER_GRID_H_
+
+#include <array>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "core/diffusion/euler_grid.h"
+
+namespace bdm {
+
+/** @brief Continuum model for the 3D heat equation with exponential decay
+           \f$ \partial_t u = \nabla D \nabla u - \mu u \f$ that skips
+           quiescent regions of the grid.
+
+  Uses the same FTCS scheme as the EulerGrid, but the grid is divided into
+  bricks of `kBrickSize`^3 boxes. A brick is updated in a time step only if
+  its concentration or the concentration of one of its six face neighbors
+  changed by more than `Param::diffusion_sparse_tolerance` during the previous
+  step, or was modified with ChangeConcentrationBy(). All other bricks keep
+  their concentration, which is exact for a tolerance of zero, because the
+  FTCS update of a box only depends on its direct neighbors. Bricks on the
+  boundary of grids with Dirichlet or Neumann boundary conditions are always
+  updated, because the boundary values may depend on the simulated time.
+  Gradients are only recomputed for bricks whose neighborhood changed.
+
+  The concentration is stored densely, so that all accessors, the
+  visualization and the agents' access behave as for the EulerGrid. Skipping
+  bricks saves computation and memory traffic for simulations in which
+  substances are secreted locally into a mostly uniform domain (e.g. a tumor
+  spheroid in a large, empty space). Steps are always executed one after
+  another, i.e. neither `Param::diffusion_temporal_blocking` nor
+  `Param::fuse_diffusion_grids` apply to this grid.
+*/
+class SparseEulerGrid : public EulerGrid {
+ public:
+  /// Number of boxes along each axis of a brick.
+  static constexpr size_t kBrickSize = 8;
+
+  SparseEulerGrid() = default;
+  SparseEulerGrid(int substance_id, std::string substance_name, real_t dc,
+                  real_t mu, int resolution = 10)
+      : EulerGrid(substance_id, std::move(substance_name), dc, mu,
+                  resolution) {}
+
+  void Initialize() override;
+  void Update() override;
+
+  void DiffuseWithClosedEdge(real_t dt) override { DiffuseSparse(dt); }
+  void DiffuseWithOpenEdge(real_t dt) override { DiffuseSparse(dt); }
+  void DiffuseWithDirichlet(real_t dt) override { DiffuseSparse(dt); }
+  void DiffuseWithNeumann(real_t dt) override { DiffuseSparse(dt); }
+  void DiffuseWithPeriodic(real_t dt) override { DiffuseSparse(dt); }
+
+  /// The set of updated bricks is determined before each step. Hence, steps
+  /// cannot be fused and are executed one after another.
+  void MultiStep(real_t dt, int n_steps) override {
+    DiffusionGrid::MultiStep(dt, n_steps);
+  }
+
+  /// Same as DiffusionGrid::CalculateGradient(), but after the first call
+  /// only the gradients of bricks whose neighborhood changed since the last
+  /// call are recomputed.
+  void CalculateGradient() override;
+
+  /// Returns the total number of bricks of the grid.
+  size_t GetNumBricks() const { return active_.size(); }
+
+  /// Returns the number of bricks that were updated in the last time step.
+  size_t GetNumActiveBricks() const;
+
+ private:
+  void ConcentrationChanged(size_t idx) override;
+
+  /// Divides the grid into bricks and marks all bricks as changed, such that
+  /// the next time step updates the entire grid.
+  void InitializeBricks();
+
+  /// Returns the index of the brick that contains box `idx`.
+  size_t GetBrickIndex(size_t idx) const;
+
+  /// Returns true if `flags` is set for brick (bx, by, bz) or one of its face
+  /// neighbors. Neighbors wrap around for periodic boundary conditions.
+  bool IsSetInNeighborhood(const std::vector<char>& flags, size_t bx,
+                           size_t by, size_t bz) const;
+
+  /// Advances the grid by one time step of length `dt`, updating only the
+  /// active bricks (see class description).
+  void DiffuseSparse(real_t dt);
+
+  /// Number of bricks along each axis [x, y, z]
+  std::array<size_t, 3> num_bricks_ = {{0}};  //!
+  /// Bricks whose concentration changed by more than the tolerance in the
+  /// last time step
+  std::vector<char> changed_ = {};  //!
+  /// Bricks whose concentration was modified with ChangeConcentrationBy()
+  /// since the last time step
+  std::vector<char> modified_ = {};  //!
+  /// Bricks that were updated in the last time step, i.e. whose values in
+  /// `c2_` differ from `c1_` by up to the tolerance
+  std::vector<char> written_ = {};  //!
+  /// Bricks whose concentration changed since the last gradient calculation
+  std::vector<char> stale_gradient_ = {};  //!
+  /// Bricks that are updated in the current time step
+  std::vector<char> active_ = {};  //!
+  /// Time step, decay constant, and boundary condition type of the last time
+  /// step. If any of them changes, all bricks are updated.
+  real_t previous_dt_ = 0;  //!
+  real_t previous_mu_ = 0;  //!
+  BoundaryConditionType previous_bc_type_ =
+      BoundaryConditionType::kDirichlet;  //!
+
+  BDM_CLASS_DEF_OVERRIDE(SparseEulerGrid, 1);
+};
+
+}  // namespace bdm
+
+#endif  // CORE_DIFFUSION_SPARSE_EULER_GRID_H_
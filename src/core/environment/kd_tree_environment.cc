@@ -15,6 +15,7 @@
 #include <algorithm>
 
 #include "core/environment/kd_tree_environment.h"
+#include "core/util/thread_info.h"
 
 #include <nanoflann.hpp>
 
@@ -37,8 +38,11 @@ KDTreeEnvironment::KDTreeEnvironment() {
   nf_adapter_ = new NanoFlannAdapter();
   impl_ = std::unique_ptr<KDTreeEnvironment::NanoflannImpl>(
       new KDTreeEnvironment::NanoflannImpl());
+  // build the index with all available threads
+  auto max_threads = ThreadInfo::GetInstance()->GetMaxThreads();
   impl_->index_ = new bdm_kd_tree_t(
-      3, *nf_adapter_, KDTreeSingleIndexAdaptorParams(param->nanoflann_depth));
+      3, *nf_adapter_,
+      KDTreeSingleIndexAdaptorParams(param->nanoflann_depth, max_threads));
 }
 
 KDTreeEnvironment::~KDTreeEnvironment() {
@@ -49,8 +53,8 @@ KDTreeEnvironment::~KDTreeEnvironment() {
 void KDTreeEnvironment::UpdateImplementation() {
   nf_adapter_->rm_ = Simulation::GetActive()->GetResourceManager();
 
-  // Update the flattened indices map
-  nf_adapter_->flat_idx_map_.Update();
+  // Update the flattened indices map and the position snapshot
+  nf_adapter_->Update();
   if (nf_adapter_->rm_->GetNumAgents() != 0) {
     Clear();
     auto inf = Math::kInfinity;
@@ -100,7 +104,11 @@ void KDTreeEnvironment::ForEachNeighbor(Functor<void, Agent*, real_t>& lambda,
                                         const Real3& query_position,
                                         real_t squared_radius,
                                         const Agent* query_agent) {
+  // Reuse the result buffer across queries of the same thread. The buffer is
+  // swapped out, so that nested queries from within `lambda` are safe.
+  thread_local std::vector<std::pair<uint64_t, real_t>> buffer;
   std::vector<std::pair<uint64_t, real_t>> neighbors;
+  neighbors.swap(buffer);
 
   nanoflann::SearchParams params;
   params.sorted = false;
@@ -109,13 +117,36 @@ void KDTreeEnvironment::ForEachNeighbor(Functor<void, Agent*, real_t>& lambda,
   impl_->index_->radiusSearch(&query_position[0], squared_radius, neighbors,
                               params);
 
-  auto* rm = Simulation::GetActive()->GetResourceManager();
+  // The tree is searched on the positions of the last update. Agents might
+  // have moved since then. Hence, the distance is recomputed from the current
+  // positions.
   for (auto& n : neighbors) {
-    Agent* nb_so =
-        rm->GetAgent(nf_adapter_->flat_idx_map_.GetAgentHandle(n.first));
-    if (nb_so != query_agent) {
-      lambda(nb_so, n.second);
+    Agent* nb_so = nf_adapter_->agents_[n.first];
+    if (nb_so == query_agent) {
+      continue;
     }
+    auto diff = nb_so->GetPosition() - query_position;
+    auto squared_distance = diff * diff;
+    if (squared_distance < squared_radius) {
+      lambda(nb_so, squared_distance);
+    }
+  }
+  buffer.swap(neighbors);
+}
+
+void KDTreeEnvironment::FindNeighborsBatch(
+    const std::vector<Real3>& query_positions, real_t squared_radius,
+    std::vector<std::vector<std::pair<uint64_t, real_t>>>* neighbors) const {
+  neighbors->resize(query_positions.size());
+
+  nanoflann::SearchParams params;
+  params.sorted = false;
+
+#pragma omp parallel for schedule(dynamic, 64)
+  for (uint64_t i = 0; i < query_positions.size(); ++i) {
+    // radiusSearch clears the vector, but keeps its capacity
+    impl_->index_->radiusSearch(&query_positions[i][0], squared_radius,
+                                (*neighbors)[i], params);
   }
 }
 
@@ -15,40 +15,58 @@
 #ifndef CORE_ENVIRONMENT_KD_TREE_ENVIRONMENT_
 #define CORE_ENVIRONMENT_KD_TREE_ENVIRONMENT_
 
+#include <utility>
+#include <vector>
+
 #include "core/container/agent_flat_idx_map.h"
 #include "core/container/math_array.h"
 #include "core/environment/environment.h"
+#include "core/functor.h"
 #include "core/simulation.h"
 
 namespace bdm {
 
+/// Exposes a snapshot of the agent positions to nanoflann.
+/// The positions are copied into a contiguous array in `Update`, so that
+/// building and querying the kd-tree does not have to resolve an agent
+/// handle and call the virtual `Agent::GetPosition` for each coordinate.
 struct NanoFlannAdapter {
   using coord_t = Real3;
   using idx_t = uint64_t;
 
   NanoFlannAdapter() { rm_ = Simulation::GetActive()->GetResourceManager(); }
 
-  /// Must return the number of data points
-  inline size_t kdtree_get_point_count() const {
-    return Simulation::GetActive()->GetResourceManager()->GetNumAgents();
+  /// Updates the flat index map and copies the positions and pointers of
+  /// all agents into `positions_` and `agents_`.
+  void Update() {
+    flat_idx_map_.Update();
+    auto num_agents = rm_->GetNumAgents();
+    positions_.resize(num_agents);
+    agents_.resize(num_agents);
+    auto fill = L2F([&](Agent* agent, AgentHandle ah) {
+      auto idx = flat_idx_map_.GetFlatIdx(ah);
+      positions_[idx] = agent->GetPosition();
+      agents_[idx] = agent;
+    });
+    rm_->ForEachAgentParallel(fill);
   }
 
+  /// Must return the number of data points
+  inline size_t kdtree_get_point_count() const { return positions_.size(); }
+
   /// Returns the distance between the vector "p1[0:size-1]" and the data point
   /// with index "idx_p2" stored in the class:
   inline real_t kdtree_distance(const coord_t& p1, const idx_t idx_p2,
                                 size_t /*size*/) const {
-    AgentHandle ah = flat_idx_map_.GetAgentHandle(idx_p2);
-    auto& p2 = rm_->GetAgent(ah)->GetPosition();
-    return p1 * p2;
+    auto diff = p1 - positions_[idx_p2];
+    return diff * diff;
   }
 
   /// Returns the dim'th component of the idx'th point in the class:
   /// Since this is inlined and the "dim" argument is typically an immediate
   /// value, the "if/else's" are actually solved at compile time.
   inline real_t kdtree_get_pt(const idx_t idx, int dim) const {
-    AgentHandle ah = flat_idx_map_.GetAgentHandle(idx);
-    auto& pos = rm_->GetAgent(ah)->GetPosition();
-    return pos[dim];
+    return positions_[idx][dim];
   }
 
   /// Optional bounding-box computation: return false to default to a standard
@@ -64,6 +82,10 @@ struct NanoFlannAdapter {
   }
 
   AgentFlatIdxMap flat_idx_map_;
+  /// Agent positions at the time of the last `Update`, indexed by flat index
+  std::vector<Real3> positions_;
+  /// Agent pointers at the time of the last `Update`, indexed by flat index
+  std::vector<Agent*> agents_;
   ResourceManager* rm_ = nullptr;
 };
 
@@ -85,6 +107,12 @@ class KDTreeEnvironment : public Environment {
 
   void Clear() override;
 
+  // The `ForEachNeighbor` functions search the tree on the positions of the
+  // last update. The distances passed to `lambda` are computed from the
+  // current positions, and neighbors that moved out of the search radius
+  // since the last update are skipped. Agents that moved into the search
+  // radius since the last update are not found.
+
   void ForEachNeighbor(Functor<void, Agent*, real_t>& lambda,
                        const Agent& query, real_t squared_radius) override;
 
@@ -95,6 +123,29 @@ class KDTreeEnvironment : public Environment {
                        const Real3& query_position, real_t squared_radius,
                        const Agent* query_agent = nullptr) override;
 
+  /// Performs a radius search for all `query_positions` in parallel.
+  /// Afterwards, `(*neighbors)[i]` contains the flat index and the squared
+  /// distance of all agents within `squared_radius` of `query_positions[i]`.
+  /// The query agent itself is not excluded. In contrast to
+  /// `ForEachNeighbor`, the distances refer to the positions at the time of
+  /// the last update. Flat indices can be converted with `GetAgent` and
+  /// `GetPosition`. The inner vectors of `neighbors` are reused, so passing
+  /// the same container over several calls avoids allocations.
+  void FindNeighborsBatch(
+      const std::vector<Real3>& query_positions, real_t squared_radius,
+      std::vector<std::vector<std::pair<uint64_t, real_t>>>* neighbors) const;
+
+  /// Returns the agent with the given flat index (see `FindNeighborsBatch`)
+  Agent* GetAgent(uint64_t flat_idx) const {
+    return nf_adapter_->agents_[flat_idx];
+  }
+
+  /// Returns the position of the agent with the given flat index at the time
+  /// of the last update.
+  const Real3& GetPosition(uint64_t flat_idx) const {
+    return nf_adapter_->positions_[flat_idx];
+  }
+
  protected:
   void UpdateImplementation() override;
 
@@ -40,8 +40,8 @@ void OctreeEnvironment::UpdateImplementation() {
   container_->rm_ = Simulation::GetActive()->GetResourceManager();
   auto* param = Simulation::GetActive()->GetParam();
 
-  // Update the flattened indices map
-  container_->flat_idx_map_.Update();
+  // Update the flattened indices map and the position snapshot
+  container_->Update();
   if (container_->rm_->GetNumAgents() != 0) {
     Clear();
     auto inf = Math::kInfinity;
@@ -53,6 +53,7 @@ void OctreeEnvironment::UpdateImplementation() {
     unibn::OctreeParams params;
     params.bucketSize = param->unibn_bucketsize;
 
+    // reuses the octants of the previous iteration
     impl_->octree_->initialize(*container_, params);
   } else {
     // There are no sim objects in this simulation
@@ -103,14 +104,42 @@ void OctreeEnvironment::ForEachNeighbor(Functor<void, Agent*, real_t>& lambda,
       query_position, static_cast<double>(std::sqrt(squared_radius)), neighbors,
       distances);
 
-  auto* rm = Simulation::GetActive()->GetResourceManager();
-  int i = 0;
+  // The octree is searched on the positions of the last update. Agents might
+  // have moved since then. Hence, the distance is recomputed from the current
+  // positions.
   for (auto& n : neighbors) {
-    Agent* nb_so = rm->GetAgent(container_->flat_idx_map_.GetAgentHandle(n));
-    if (nb_so != query_agent) {
-      lambda(nb_so, static_cast<real_t>(distances[i]));
+    Agent* nb_so = container_->agents_[n];
+    if (nb_so == query_agent) {
+      continue;
+    }
+    auto diff = nb_so->GetPosition() - query_position;
+    auto squared_distance = diff * diff;
+    if (squared_distance < squared_radius) {
+      lambda(nb_so, squared_distance);
+    }
+  }
+}
+
+void OctreeEnvironment::FindNeighborsBatch(
+    const std::vector<Real3>& query_positions, real_t squared_radius,
+    std::vector<std::vector<std::pair<uint64_t, real_t>>>* neighbors) const {
+  neighbors->resize(query_positions.size());
+  auto radius = static_cast<double>(std::sqrt(squared_radius));
+
+#pragma omp parallel
+  {
+    std::vector<uint32_t> indices;
+    std::vector<double> distances;
+#pragma omp for schedule(dynamic, 64)
+    for (uint64_t i = 0; i < query_positions.size(); ++i) {
+      impl_->octree_->radiusNeighbors<unibn::L2Distance<Real3>>(
+          query_positions[i], radius, indices, distances);
+      auto& result = (*neighbors)[i];
+      result.clear();
+      for (uint64_t j = 0; j < indices.size(); ++j) {
+        result.emplace_back(indices[j], static_cast<real_t>(distances[j]));
+      }
     }
-    i++;
   }
 }
 
@@ -15,28 +15,50 @@
 #ifndef CORE_ENVIRONMENT_OCTREE_ENVIRONMENT_
 #define CORE_ENVIRONMENT_OCTREE_ENVIRONMENT_
 
+#include <utility>
+#include <vector>
+
 #include "core/agent/agent_uid.h"
 #include "core/container/agent_flat_idx_map.h"
 #include "core/container/math_array.h"
 #include "core/environment/environment.h"
+#include "core/functor.h"
 #include "core/simulation.h"
 
 namespace bdm {
 
 /// This class acts as a contiguous container of simulation object positions for
-/// the Unibn octree API
+/// the Unibn octree API. The positions are copied in `Update`, so that building
+/// and querying the octree does not have to resolve an agent handle and call
+/// the virtual `Agent::GetPosition` for each point access.
 class AgentContainer {
  public:
   AgentContainer() { rm_ = Simulation::GetActive()->GetResourceManager(); }
 
-  size_t size() const { return rm_->GetNumAgents(); }
-
-  const Real3& operator[](size_t idx) const {
-    AgentHandle ah = flat_idx_map_.GetAgentHandle(idx);
-    return rm_->GetAgent(ah)->GetPosition();
+  /// Updates the flat index map and copies the positions and pointers of
+  /// all agents into `positions_` and `agents_`.
+  void Update() {
+    flat_idx_map_.Update();
+    auto num_agents = rm_->GetNumAgents();
+    positions_.resize(num_agents);
+    agents_.resize(num_agents);
+    auto fill = L2F([&](Agent* agent, AgentHandle ah) {
+      auto idx = flat_idx_map_.GetFlatIdx(ah);
+      positions_[idx] = agent->GetPosition();
+      agents_[idx] = agent;
+    });
+    rm_->ForEachAgentParallel(fill);
   }
 
+  size_t size() const { return positions_.size(); }
+
+  const Real3& operator[](size_t idx) const { return positions_[idx]; }
+
   AgentFlatIdxMap flat_idx_map_;
+  /// Agent positions at the time of the last `Update`, indexed by flat index
+  std::vector<Real3> positions_;
+  /// Agent pointers at the time of the last `Update`, indexed by flat index
+  std::vector<Agent*> agents_;
   ResourceManager* rm_ = nullptr;
 };
 
@@ -58,6 +80,12 @@ class OctreeEnvironment : public Environment {
 
   void Clear() override;
 
+  // The `ForEachNeighbor` functions search the octree on the positions of the
+  // last update. The distances passed to `lambda` are computed from the
+  // current positions, and neighbors that moved out of the search radius
+  // since the last update are skipped. Agents that moved into the search
+  // radius since the last update are not found.
+
   void ForEachNeighbor(Functor<void, Agent*, real_t>& lambda,
                        const Agent& query, real_t squared_radius) override;
 
@@ -68,6 +96,29 @@ class OctreeEnvironment : public Environment {
                        const Real3& query_position, real_t squared_radius,
                        const Agent* query_agent = nullptr) override;
 
+  /// Performs a radius search for all `query_positions` in parallel.
+  /// Afterwards, `(*neighbors)[i]` contains the flat index and the squared
+  /// distance of all agents within `squared_radius` of `query_positions[i]`.
+  /// The query agent itself is not excluded. In contrast to
+  /// `ForEachNeighbor`, the distances refer to the positions at the time of
+  /// the last update. Flat indices can be converted with `GetAgent` and
+  /// `GetPosition`. The inner vectors of `neighbors` are reused, so passing
+  /// the same container over several calls avoids allocations.
+  void FindNeighborsBatch(
+      const std::vector<Real3>& query_positions, real_t squared_radius,
+      std::vector<std::vector<std::pair<uint64_t, real_t>>>* neighbors) const;
+
+  /// Returns the agent with the given flat index (see `FindNeighborsBatch`)
+  Agent* GetAgent(uint64_t flat_idx) const {
+    return container_->agents_[flat_idx];
+  }
+
+  /// Returns the position of the agent with the given flat index at the time
+  /// of the last update.
+  const Real3& GetPosition(uint64_t flat_idx) const {
+    return container_->positions_[flat_idx];
+  }
+
  protected:
   void UpdateImplementation() override;
 
@@ -15,6 +15,7 @@
 #include "core/environment/uniform_grid_environment.h"
 #include <morton/morton.h>  // NOLINT
 #include "core/algorithm.h"
+#include "core/execution_context/execution_context.h"
 
 namespace bdm {
 
@@ -113,10 +114,41 @@ void UniformGridEnvironment::UpdateImplementation() {
   auto* rm = Simulation::GetActive()->GetResourceManager();
 
   if (rm->GetNumAgents() != 0) {
-    Clear();
-    timestamp_++;
-
     auto* param = Simulation::GetActive()->GetParam();
+    // The grid is not rebuilt while the Verlet lists are valid. Agents have
+    // moved less than half the skin distance since the last build. Hence,
+    // neighbor searches with radius <= verlet_radius_ still find all
+    // neighbors, because the box length includes the skin distance.
+    if (param->uniform_grid_verlet_skin > 0 && verlet_valid_ &&
+        AreVerletListsValid()) {
+      has_grown_ = false;
+      // The agents are the same as in the last build, but their data has
+      // changed.
+      if (use_snapshot_) {
+        UpdateAgentSnapshot();
+      }
+      if (param->thread_safety_mechanism ==
+          Param::ThreadSafetyMechanism::kAutomatic) {
+        nb_mutex_builder_->Update();
+      }
+      return;
+    }
+    verlet_valid_ = false;
+
+    auto previous_dimensions = grid_dimensions_;
+    auto previous_box_length = box_length_;
+    // successors_ must be retained for an incremental update
+    ClearDimensions();
+
+    if (param->uniform_grid_boxes_per_radius < 1 ||
+        param->uniform_grid_boxes_per_radius > 2) {
+      Log::Fatal("UniformGridEnvironment",
+                 "Param::uniform_grid_boxes_per_radius must be 1 or 2, but is ",
+                 param->uniform_grid_boxes_per_radius, ".");
+    }
+    boxes_per_radius_ =
+        static_cast<int32_t>(param->uniform_grid_boxes_per_radius);
+
     if (determine_sim_size_) {
       auto inf = Math::kInfinity;
       std::array<real_t, 6> tmp_dim = {{inf, -inf, inf, -inf, inf, -inf}};
@@ -132,9 +164,11 @@ void UniformGridEnvironment::UpdateImplementation() {
     }
 
     // If the box_length_ is not set manually, we set it to the largest agent
-    // size
+    // size divided by the number of boxes per search radius
     if (!is_custom_box_length_ && determine_sim_size_) {
-      auto los = ceil(GetLargestAgentSize());
+      auto los =
+          ceil((GetLargestAgentSize() + param->uniform_grid_verlet_skin) /
+               boxes_per_radius_);
       assert(los > 0 &&
              "The largest object size was found to be 0. Please check if your "
              "cells are correctly initialized.");
@@ -148,8 +182,9 @@ void UniformGridEnvironment::UpdateImplementation() {
     box_length_squared_ = box_length_ * box_length_;
 
     if (!determine_sim_size_) {
-      this->largest_object_size_ = box_length_;
-      this->largest_object_size_squared_ = box_length_squared_;
+      this->largest_object_size_ = GetMaxSearchRadius();
+      this->largest_object_size_squared_ =
+          largest_object_size_ * largest_object_size_;
     }
 
     for (int i = 0; i < 3; i++) {
@@ -170,8 +205,8 @@ void UniformGridEnvironment::UpdateImplementation() {
 
     // Pad the grid to avoid out of bounds check when search neighbors
     for (int i = 0; i < 3; i++) {
-      grid_dimensions_[2 * i] -= box_length_;
-      grid_dimensions_[2 * i + 1] += box_length_;
+      grid_dimensions_[2 * i] -= GetMaxSearchRadius();
+      grid_dimensions_[2 * i + 1] += GetMaxSearchRadius();
     }
 
     // Calculate how many boxes fit along each dimension
@@ -196,11 +231,37 @@ void UniformGridEnvironment::UpdateImplementation() {
       boxes_.resize(total_num_boxes_);
     }
 
-    successors_.reserve();
-
     // Assign agents to boxes
-    AssignToBoxesFunctor functor(this);
-    rm->ForEachAgentParallel(param->scheduling_batch_size, functor);
+    use_counting_sort_ = param->uniform_grid_counting_sort;
+    bool incremental = param->uniform_grid_incremental_update &&
+                       !use_counting_sort_ && grid_agents_valid_ &&
+                       previous_dimensions == grid_dimensions_ &&
+                       previous_box_length == box_length_ &&
+                       UpdateBoxesIncrementally();
+    if (!incremental) {
+      timestamp_++;
+      track_agents_ =
+          param->uniform_grid_incremental_update && !use_counting_sort_;
+      if (use_counting_sort_) {
+        AssignToBoxesCountingSort();
+      } else {
+        successors_.reserve();
+        if (track_agents_) {
+          grid_agents_.reserve();
+        }
+        AssignToBoxesFunctor functor(this);
+        rm->ForEachAgentParallel(param->scheduling_batch_size, functor);
+      }
+      grid_agents_valid_ = track_agents_;
+    }
+
+    use_snapshot_ = param->uniform_grid_soa_snapshot;
+    if (use_snapshot_) {
+      UpdateAgentSnapshot();
+    }
+    if (param->uniform_grid_verlet_skin > 0) {
+      UpdateVerletLists();
+    }
     if (param->bound_space) {
       int min = param->min_bound;
       int max = param->max_bound;
@@ -231,6 +292,19 @@ void UniformGridEnvironment::UpdateImplementation() {
       // grid state remains the same, but we have to set has_grown_ to false
       // otherwise the DiffusionGrid will attempt to resize
       has_grown_ = false;
+      grid_agents_valid_ = false;
+      verlet_valid_ = false;
+      // the boxes and the snapshot must not contain the removed agents
+      timestamp_++;
+      use_snapshot_ = param->uniform_grid_soa_snapshot;
+      if (use_snapshot_) {
+        snapshot_.box_offsets.assign(total_num_boxes_ + 1, 0);
+        snapshot_.x.clear();
+        snapshot_.y.clear();
+        snapshot_.z.clear();
+        snapshot_.diameter.clear();
+        snapshot_.agents.clear();
+      }
     } else {
       Log::Fatal(
           "UniformGridEnvironment",
@@ -242,6 +316,469 @@ void UniformGridEnvironment::UpdateImplementation() {
   }
 }
 
+// -----------------------------------------------------------------------------
+void UniformGridEnvironment::ForEachNeighborInStencil(
+    Functor<void, Agent*, real_t>& lambda, const Real3& query_position,
+    real_t squared_radius, const Agent* query_agent, size_t box_idx) {
+  FixedSizeVector<uint64_t, kMaxStencilSize> box_indices;
+  GetStencilBoxIndices(&box_indices, box_idx);
+
+  auto* rm = Simulation::GetActive()->GetResourceManager();
+  for (auto neighbor_box_idx : box_indices) {
+    for (auto it = boxes_[neighbor_box_idx].begin(this); !it.IsAtEnd(); ++it) {
+      auto* agent = rm->GetAgent(*it);
+      if (agent == query_agent) {
+        continue;
+      }
+      const auto& pos = agent->GetPosition();
+      const real_t dx = pos[0] - query_position[0];
+      const real_t dy = pos[1] - query_position[1];
+      const real_t dz = pos[2] - query_position[2];
+      const real_t squared_distance = dx * dx + dy * dy + dz * dz;
+      if (squared_distance < squared_radius) {
+        lambda(agent, squared_distance);
+      }
+    }
+  }
+}
+
+// -----------------------------------------------------------------------------
+void UniformGridEnvironment::UpdateVerletLists() {
+  auto* rm = Simulation::GetActive()->GetResourceManager();
+  auto* param = Simulation::GetActive()->GetParam();
+
+  verlet_radius_ = largest_object_size_;
+  verlet_squared_radius_ = largest_object_size_squared_;
+  const real_t list_radius = verlet_radius_ + param->uniform_grid_verlet_skin;
+  if (list_radius > GetMaxSearchRadius()) {
+    Log::Fatal("UniformGridEnvironment::UpdateVerletLists",
+               "The radius of the Verlet lists (", list_radius,
+               ") exceeds the maximum search radius (", GetMaxSearchRadius(),
+               "). Increase the box length or reduce "
+               "Param::uniform_grid_verlet_skin.");
+  }
+  const real_t squared_list_radius = list_radius * list_radius;
+
+  auto num_numa_nodes = ThreadInfo::GetInstance()->GetNumaNodes();
+  verlet_numa_offsets_.resize(num_numa_nodes + 1);
+  verlet_numa_offsets_[0] = 0;
+  for (int n = 0; n < num_numa_nodes; ++n) {
+    verlet_numa_offsets_[n + 1] =
+        verlet_numa_offsets_[n] + rm->GetNumAgents(n);
+  }
+  auto num_agents = verlet_numa_offsets_[num_numa_nodes];
+  verlet_start_.resize(num_agents + 1);
+  verlet_start_[0] = 0;
+  verlet_agents_.resize(num_agents);
+  verlet_uids_.resize(num_agents);
+  verlet_positions_.resize(num_agents);
+
+  // count neighbors
+  auto count = L2F([&](Agent* agent, AgentHandle ah) {
+    auto idx = verlet_numa_offsets_[ah.GetNumaNode()] + ah.GetElementIdx();
+    verlet_agents_[idx] = agent;
+    verlet_uids_[idx] = agent->GetUid();
+    verlet_positions_[idx] = agent->GetPosition();
+    uint64_t num_neighbors = 0;
+    auto increment = L2F([&](Agent*, real_t) { num_neighbors++; });
+    ForEachNeighbor(increment, agent->GetPosition(), squared_list_radius,
+                    agent);
+    verlet_start_[idx + 1] = num_neighbors;
+  });
+  rm->ForEachAgentParallel(param->scheduling_batch_size, count);
+  InPlaceParallelPrefixSum(verlet_start_, num_agents + 1);
+
+  // fill lists
+  verlet_neighbors_.resize(verlet_start_[num_agents]);
+  auto fill = L2F([&](Agent* agent, AgentHandle ah) {
+    auto idx = verlet_numa_offsets_[ah.GetNumaNode()] + ah.GetElementIdx();
+    auto pos = verlet_start_[idx];
+    auto add = L2F([&](Agent* neighbor, real_t) {
+      verlet_neighbors_[pos++] = neighbor;
+    });
+    ForEachNeighbor(add, agent->GetPosition(), squared_list_radius, agent);
+    assert(pos == verlet_start_[idx + 1]);
+  });
+  rm->ForEachAgentParallel(param->scheduling_batch_size, fill);
+
+  verlet_valid_ = true;
+}
+
+// -----------------------------------------------------------------------------
+bool UniformGridEnvironment::AreVerletListsValid() const {
+  auto* rm = Simulation::GetActive()->GetResourceManager();
+  auto* param = Simulation::GetActive()->GetParam();
+
+  for (int n = 0; n < ThreadInfo::GetInstance()->GetNumaNodes(); ++n) {
+    if (verlet_numa_offsets_[n + 1] - verlet_numa_offsets_[n] !=
+        rm->GetNumAgents(n)) {
+      return false;
+    }
+  }
+
+  // Agents can move up to `simulation_max_displacement` during the next
+  // iteration. Two agents can move towards each other, therefore each one is
+  // only allowed to move half of the skin distance.
+  const real_t max_displacement =
+      param->uniform_grid_verlet_skin / 2 - param->simulation_max_displacement;
+  if (max_displacement <= 0) {
+    return false;
+  }
+  const real_t max_squared_displacement = max_displacement * max_displacement;
+
+  bool valid = true;
+  auto check = L2F([&](Agent* agent, AgentHandle ah) {
+    auto idx = verlet_numa_offsets_[ah.GetNumaNode()] + ah.GetElementIdx();
+    const auto& pos = agent->GetPosition();
+    const auto& list_pos = verlet_positions_[idx];
+    const real_t dx = pos[0] - list_pos[0];
+    const real_t dy = pos[1] - list_pos[1];
+    const real_t dz = pos[2] - list_pos[2];
+    if (verlet_agents_[idx] != agent || verlet_uids_[idx] != agent->GetUid() ||
+        agent->GetDiameter() > verlet_radius_ ||
+        dx * dx + dy * dy + dz * dz > max_squared_displacement) {
+#pragma omp atomic write
+      valid = false;
+    }
+  });
+  rm->ForEachAgentParallel(param->scheduling_batch_size, check);
+  return valid;
+}
+
+// -----------------------------------------------------------------------------
+bool UniformGridEnvironment::ForEachNeighborInVerletList(
+    Functor<void, Agent*, real_t>& lambda, const Agent& query,
+    real_t squared_radius) const {
+  auto* rm = Simulation::GetActive()->GetResourceManager();
+  if (!rm->ContainsAgent(query.GetUid())) {
+    return false;
+  }
+  auto ah = rm->GetAgentHandle(query.GetUid());
+  auto idx = verlet_numa_offsets_[ah.GetNumaNode()] + ah.GetElementIdx();
+  if (idx >= verlet_agents_.size() || verlet_agents_[idx] != &query) {
+    return false;
+  }
+
+  const auto& position = query.GetPosition();
+  for (auto i = verlet_start_[idx]; i < verlet_start_[idx + 1]; ++i) {
+    auto* neighbor = verlet_neighbors_[i];
+    const auto& neighbor_position = neighbor->GetPosition();
+    const real_t dx = neighbor_position[0] - position[0];
+    const real_t dy = neighbor_position[1] - position[1];
+    const real_t dz = neighbor_position[2] - position[2];
+    const real_t squared_distance = dx * dx + dy * dy + dz * dz;
+    if (squared_distance < squared_radius) {
+      lambda(neighbor, squared_distance);
+    }
+  }
+  return true;
+}
+
+// -----------------------------------------------------------------------------
+bool UniformGridEnvironment::UpdateBoxesIncrementally() {
+  auto* rm = Simulation::GetActive()->GetResourceManager();
+  auto* param = Simulation::GetActive()->GetParam();
+
+  // Agent handles are only stable if no agents have been added, removed, or
+  // reordered since the last full update. A memory address might be reused
+  // for a new agent, which has not been assigned to a box yet.
+  for (int n = 0; n < ThreadInfo::GetInstance()->GetNumaNodes(); ++n) {
+    if (grid_agents_.size(n) != rm->GetNumAgents(n)) {
+      return false;
+    }
+  }
+  bool handles_changed = false;
+  auto check = L2F([&](Agent* agent, AgentHandle ah) {
+    if (grid_agents_[ah] != agent || agent->GetBoxIdx() >= total_num_boxes_) {
+#pragma omp atomic write
+      handles_changed = true;
+    }
+  });
+  rm->ForEachAgentParallel(param->scheduling_batch_size, check);
+  if (handles_changed) {
+    return false;
+  }
+
+  auto relocate = L2F([&](Agent* agent, AgentHandle ah) {
+    auto idx = GetBoxIndex(agent->GetPosition());
+    auto previous_idx = agent->GetBoxIdx();
+    if (idx != previous_idx) {
+      boxes_[previous_idx].RemoveObject(ah, &successors_);
+      boxes_[idx].AddObject(ah, &successors_, this);
+      assert(idx <= std::numeric_limits<uint32_t>::max());
+      agent->SetBoxIdx(static_cast<uint32_t>(idx));
+    }
+  });
+  rm->ForEachAgentParallel(param->scheduling_batch_size, relocate);
+  return true;
+}
+
+// -----------------------------------------------------------------------------
+void UniformGridEnvironment::AssignToBoxesCountingSort() {
+  auto* rm = Simulation::GetActive()->GetResourceManager();
+  auto* param = Simulation::GetActive()->GetParam();
+
+  // histogram: box_start_[i + 1] counts the agents in box i
+  box_start_.resize(total_num_boxes_ + 1);
+#pragma omp parallel for
+  for (uint64_t i = 0; i <= total_num_boxes_; ++i) {
+    box_start_[i] = 0;
+  }
+  box_ranks_.reserve();
+  auto count = L2F([&](Agent* agent, AgentHandle ah) {
+    auto idx = GetBoxIndex(agent->GetPosition());
+    assert(idx <= std::numeric_limits<uint32_t>::max());
+    agent->SetBoxIdx(static_cast<uint32_t>(idx));
+    uint64_t rank;
+#pragma omp atomic capture
+    rank = box_start_[idx + 1]++;
+    box_ranks_[ah] = static_cast<uint32_t>(rank);
+  });
+  rm->ForEachAgentParallel(param->scheduling_batch_size, count);
+
+#pragma omp parallel for
+  for (uint64_t i = 0; i < total_num_boxes_; ++i) {
+    auto num_agents = box_start_[i + 1];
+    if (num_agents == 0) {
+      continue;
+    }
+    if (num_agents > std::numeric_limits<uint16_t>::max()) {
+      Log::Fatal(
+          "UniformGridEnvironment::AssignToBoxesCountingSort",
+          "Box overflow. You have added too many agents to a single Box.");
+    }
+    auto& box = boxes_[i];
+    box.timestamp_ = timestamp_;
+    box.length_ = static_cast<uint16_t>(num_agents);
+  }
+
+  InPlaceParallelPrefixSum(box_start_, total_num_boxes_ + 1);
+
+  // scatter
+  sorted_agents_.resize(box_start_[total_num_boxes_]);
+  auto scatter = L2F([&](Agent* agent, AgentHandle ah) {
+    sorted_agents_[box_start_[agent->GetBoxIdx()] + box_ranks_[ah]] = ah;
+  });
+  rm->ForEachAgentParallel(param->scheduling_batch_size, scatter);
+
+  // The GPU implementations of the mechanical forces operation traverse the
+  // linked list directly.
+  bool link_successors = param->compute_target != "cpu";
+  if (link_successors) {
+    successors_.reserve();
+  }
+#pragma omp parallel for schedule(static, 1024)
+  for (uint64_t i = 0; i < total_num_boxes_; ++i) {
+    auto start = box_start_[i];
+    auto end = box_start_[i + 1];
+    if (start == end) {
+      continue;
+    }
+    boxes_[i].start_ = sorted_agents_[start];
+    if (link_successors) {
+      for (auto j = start; j < end - 1; ++j) {
+        successors_[sorted_agents_[j]] = sorted_agents_[j + 1];
+      }
+    }
+  }
+}
+
+// -----------------------------------------------------------------------------
+void UniformGridEnvironment::UpdateAgentSnapshot() {
+  auto* rm = Simulation::GetActive()->GetResourceManager();
+  auto& offsets = snapshot_.box_offsets;
+  offsets.resize(total_num_boxes_ + 1);
+  offsets[0] = 0;
+#pragma omp parallel for
+  for (uint64_t i = 0; i < total_num_boxes_; ++i) {
+    offsets[i + 1] = boxes_[i].Size(timestamp_);
+  }
+  InPlaceParallelPrefixSum(offsets, total_num_boxes_ + 1);
+
+  auto num_agents = offsets[total_num_boxes_];
+  snapshot_.x.resize(num_agents);
+  snapshot_.y.resize(num_agents);
+  snapshot_.z.resize(num_agents);
+  snapshot_.diameter.resize(num_agents);
+  snapshot_.agents.resize(num_agents);
+
+#pragma omp parallel for schedule(static, 1024)
+  for (uint64_t i = 0; i < total_num_boxes_; ++i) {
+    auto idx = offsets[i];
+    for (auto it = boxes_[i].begin(this); !it.IsAtEnd(); ++it) {
+      auto* agent = rm->GetAgent(*it);
+      const auto& pos = agent->GetPosition();
+      snapshot_.x[idx] = pos[0];
+      snapshot_.y[idx] = pos[1];
+      snapshot_.z[idx] = pos[2];
+      snapshot_.diameter[idx] = agent->GetDiameter();
+      snapshot_.agents[idx] = agent;
+      idx++;
+    }
+  }
+}
+
+// -----------------------------------------------------------------------------
+void UniformGridEnvironment::ForEachNeighborInSnapshot(
+    Functor<void, Agent*, real_t>& lambda, const Real3& query_position,
+    real_t squared_radius, const Agent* query_agent, size_t box_idx) const {
+  FixedSizeVector<uint64_t, kMaxStencilSize> box_indices;
+  GetStencilBoxIndices(&box_indices, box_idx);
+
+  const unsigned batch_size = 64;
+  real_t squared_distance[batch_size] __attribute__((aligned(64)));
+  const real_t* x = snapshot_.x.data();
+  const real_t* y = snapshot_.y.data();
+  const real_t* z = snapshot_.z.data();
+  const auto qx = query_position[0];
+  const auto qy = query_position[1];
+  const auto qz = query_position[2];
+
+  // The snapshot holds the positions of the last update. It only serves as a
+  // pre-filter with the search radius widened by the maximum displacement of
+  // an agent since then. The distance passed to `lambda` is computed from the
+  // current position.
+  const auto* param = Simulation::GetActive()->GetParam();
+  const real_t filter_radius =
+      std::sqrt(squared_radius) + param->simulation_max_displacement;
+  const real_t squared_filter_radius = filter_radius * filter_radius;
+
+  for (size_t b = 0; b < box_indices.size(); ++b) {
+    auto start = snapshot_.box_offsets[box_indices[b]];
+    auto end = snapshot_.box_offsets[box_indices[b] + 1];
+    while (start < end) {
+      uint64_t size = std::min<uint64_t>(batch_size, end - start);
+#pragma omp simd
+      for (uint64_t i = 0; i < size; ++i) {
+        const real_t dx = x[start + i] - qx;
+        const real_t dy = y[start + i] - qy;
+        const real_t dz = z[start + i] - qz;
+        squared_distance[i] = dx * dx + dy * dy + dz * dz;
+      }
+
+      for (uint64_t i = 0; i < size; ++i) {
+        auto* agent = snapshot_.agents[start + i];
+        if (squared_distance[i] >= squared_filter_radius ||
+            agent == query_agent) {
+          continue;
+        }
+        const auto& pos = agent->GetPosition();
+        const real_t dx = pos[0] - qx;
+        const real_t dy = pos[1] - qy;
+        const real_t dz = pos[2] - qz;
+        const real_t live_squared_distance = dx * dx + dy * dy + dz * dz;
+        if (live_squared_distance < squared_radius) {
+          lambda(agent, live_squared_distance);
+        }
+      }
+      start += size;
+    }
+  }
+}
+
+// -----------------------------------------------------------------------------
+void UniformGridEnvironment::ForEachNeighborBatch(Agent* const* queries,
+                                                  uint64_t num_queries,
+                                                  real_t squared_radius,
+                                                  NeighborBatch* batch) {
+  const real_t max_radius = GetMaxSearchRadius();
+  if (squared_radius > max_radius * max_radius) {
+    Log::Fatal("UniformGridEnvironment::ForEachNeighborBatch",
+               "The requested search radius (", std::sqrt(squared_radius),
+               ") exceeds the maximum search radius (", max_radius,
+               "). The resulting neighborhood would be incomplete.");
+  }
+
+  batch->clear();
+  batch->offsets.reserve(num_queries + 1);
+
+  // Candidates in the search stencil of box `candidates_box`. Reused across
+  // calls of the same thread.
+  thread_local std::vector<Agent*> candidates;
+  thread_local std::vector<real_t> x;
+  thread_local std::vector<real_t> y;
+  thread_local std::vector<real_t> z;
+  thread_local std::vector<real_t> squared_distance;
+  uint64_t candidates_box = std::numeric_limits<uint64_t>::max();
+
+  auto* rm = Simulation::GetActive()->GetResourceManager();
+  auto add_candidate = [&](Agent* agent, const Real3& pos) {
+    candidates.push_back(agent);
+    x.push_back(pos[0]);
+    y.push_back(pos[1]);
+    z.push_back(pos[2]);
+  };
+  auto gather_candidates = [&](uint64_t box_idx) {
+    candidates.clear();
+    x.clear();
+    y.clear();
+    z.clear();
+    FixedSizeVector<uint64_t, kMaxStencilSize> box_indices;
+    GetStencilBoxIndices(&box_indices, box_idx);
+    for (auto neighbor_box_idx : box_indices) {
+      if (use_snapshot_) {
+        // same agents as ForEachNeighborInSnapshot, but the current positions
+        auto end = snapshot_.box_offsets[neighbor_box_idx + 1];
+        for (auto i = snapshot_.box_offsets[neighbor_box_idx]; i < end; ++i) {
+          auto* agent = snapshot_.agents[i];
+          add_candidate(agent, agent->GetPosition());
+        }
+        continue;
+      }
+      for (auto it = boxes_[neighbor_box_idx].begin(this); !it.IsAtEnd();
+           ++it) {
+        auto* agent = rm->GetAgent(*it);
+        add_candidate(agent, agent->GetPosition());
+      }
+    }
+    squared_distance.resize(candidates.size());
+    candidates_box = box_idx;
+  };
+
+  auto fill = L2F([&](Agent* agent, real_t distance) {
+    batch->agents.push_back(agent);
+    batch->squared_distances.push_back(distance);
+  });
+  for (uint64_t q = 0; q < num_queries; ++q) {
+    const Agent* query = queries[q];
+    auto box_idx = query->GetBoxIdx();
+    // Agents that have not been assigned to the grid yet (e.g. created during
+    // this iteration) are handled by the regular neighbor search.
+    if (box_idx == std::numeric_limits<uint32_t>::max()) {
+      ForEachNeighbor(fill, query->GetPosition(), squared_radius, query);
+      batch->offsets.push_back(batch->agents.size());
+      continue;
+    }
+    if (box_idx != candidates_box) {
+      gather_candidates(box_idx);
+    }
+
+    const auto& position = query->GetPosition();
+    const auto qx = position[0];
+    const auto qy = position[1];
+    const auto qz = position[2];
+    const uint64_t size = candidates.size();
+    const real_t* cx = x.data();
+    const real_t* cy = y.data();
+    const real_t* cz = z.data();
+    real_t* sd = squared_distance.data();
+#pragma omp simd
+    for (uint64_t i = 0; i < size; ++i) {
+      const real_t dx = cx[i] - qx;
+      const real_t dy = cy[i] - qy;
+      const real_t dz = cz[i] - qz;
+      sd[i] = dx * dx + dy * dy + dz * dz;
+    }
+    for (uint64_t i = 0; i < size; ++i) {
+      if (sd[i] < squared_radius && candidates[i] != query) {
+        batch->agents.push_back(candidates[i]);
+        batch->squared_distances.push_back(sd[i]);
+      }
+    }
+    batch->offsets.push_back(batch->agents.size());
+  }
+}
+
 // -----------------------------------------------------------------------------
 void UniformGridEnvironment::LoadBalanceInfoUG::CallHandleIteratorConsumer(
     uint64_t start, uint64_t end,
@@ -295,8 +832,8 @@ using GridNeighborMutexBuilder =
 NeighborMutex* GridNeighborMutexBuilder::GetMutex(uint64_t box_idx) {
   auto* grid = static_cast<UniformGridEnvironment*>(
       Simulation::GetActive()->GetEnvironment());
-  FixedSizeVector<uint64_t, 27> box_indices;
-  grid->GetMooreBoxIndices(&box_indices, box_idx);
+  FixedSizeVector<uint64_t, kMaxStencilSize> box_indices;
+  grid->GetStencilBoxIndices(&box_indices, box_idx);
   thread_local GridNeighborMutex* mutex =
       new GridNeighborMutex(box_indices, this);
   mutex->SetMutexIndices(box_indices);
@@ -309,6 +846,22 @@ void UniformGridEnvironment::ForEachNeighbor(Functor<void, Agent*>& functor,
                                              void* criteria) {
   auto idx = query.GetBoxIdx();
 
+  if (boxes_per_radius_ > 1) {
+    FixedSizeVector<uint64_t, kMaxStencilSize> box_indices;
+    GetStencilBoxIndices(&box_indices, idx);
+    auto* rm = Simulation::GetActive()->GetResourceManager();
+    for (auto neighbor_box_idx : box_indices) {
+      for (auto it = boxes_[neighbor_box_idx].begin(this); !it.IsAtEnd();
+           ++it) {
+        auto* agent = rm->GetAgent(*it);
+        if (agent != &query) {
+          functor(agent);
+        }
+      }
+    }
+    return;
+  }
+
   FixedSizeVector<const Box*, 27> neighbor_boxes;
   GetMooreBoxes(&neighbor_boxes, idx);
 
@@ -342,4 +895,144 @@ void UniformGridEnvironment::ForEachNeighbor(Functor<void, Agent*>& functor,
   process_batch();
 }
 
+// -----------------------------------------------------------------------------
+void UniformGridEnvironment::ForEachNeighborPair(
+    Functor<void, Agent*, AgentHandle, Agent*, AgentHandle, real_t>& functor,
+    real_t squared_radius) {
+  if (squared_radius > box_length_squared_) {
+    Log::Fatal(
+        "UniformGridEnvironment::ForEachNeighborPair",
+        "The requested search radius (", std::sqrt(squared_radius), ")",
+        " of the neighborhood search exceeds the "
+        "box length (",
+        box_length_, "). The resulting neighborhood would be incomplete.");
+  }
+  if (total_num_boxes_ == 0) {
+    return;
+  }
+
+  // number of boxes with coordinate `offset + i * stride` along one axis
+  auto num_colored_boxes = [](uint64_t num_boxes, uint64_t offset,
+                              uint64_t stride) -> uint64_t {
+    return num_boxes > offset ? (num_boxes - offset + stride - 1) / stride : 0;
+  };
+
+  // The half-shell stencil writes to boxes with offsets {-1, 0, 1} along x and
+  // y, and {0, 1} along z. Boxes of the same color are three boxes apart along
+  // x and y, and two boxes apart along z. Their stencils do not overlap.
+  for (uint64_t color = 0; color < 18; ++color) {
+    const uint64_t cx = color % 3;
+    const uint64_t cy = (color / 3) % 3;
+    const uint64_t cz = color / 9;
+    const uint64_t nx = num_colored_boxes(num_boxes_axis_[0], cx, 3);
+    const uint64_t ny = num_colored_boxes(num_boxes_axis_[1], cy, 3);
+    const uint64_t nz = num_colored_boxes(num_boxes_axis_[2], cz, 2);
+    const uint64_t nxy = nx * ny;
+    const uint64_t num_boxes = nxy * nz;
+
+#pragma omp parallel for schedule(dynamic, 1)
+    for (uint64_t i = 0; i < num_boxes; ++i) {
+      std::array<uint64_t, 3> box_coord = {
+          cx + 3 * (i % nx), cy + 3 * ((i % nxy) / nx), cz + 2 * (i / nxy)};
+      ForEachNeighborPairInBox(functor, squared_radius,
+                               GetBoxIndex(box_coord));
+    }
+  }
+}
+
+// -----------------------------------------------------------------------------
+void UniformGridEnvironment::ForEachAgentInColoredBoxes(
+    Functor<void, Agent*, AgentHandle>& functor,
+    Functor<bool, Agent*>* filter) {
+  if (total_num_boxes_ == 0) {
+    return;
+  }
+
+  auto* rm = Simulation::GetActive()->GetResourceManager();
+
+  // number of boxes with coordinate `offset + i * stride` along one axis
+  auto num_colored_boxes = [](uint64_t num_boxes, uint64_t offset,
+                              uint64_t stride) -> uint64_t {
+    return num_boxes > offset ? (num_boxes - offset + stride - 1) / stride : 0;
+  };
+
+  // The neighborhood of a box reaches `boxes_per_radius_` boxes in each
+  // direction. Boxes of the same color are `2 * boxes_per_radius_ + 1` boxes
+  // apart along each axis. Their neighborhoods do not overlap.
+  const uint64_t stride = 2 * boxes_per_radius_ + 1;
+  const uint64_t num_colors = stride * stride * stride;
+  for (uint64_t color = 0; color < num_colors; ++color) {
+    const uint64_t cx = color % stride;
+    const uint64_t cy = (color / stride) % stride;
+    const uint64_t cz = color / (stride * stride);
+    const uint64_t nx = num_colored_boxes(num_boxes_axis_[0], cx, stride);
+    const uint64_t ny = num_colored_boxes(num_boxes_axis_[1], cy, stride);
+    const uint64_t nz = num_colored_boxes(num_boxes_axis_[2], cz, stride);
+    const uint64_t nxy = nx * ny;
+    const uint64_t num_boxes = nxy * nz;
+
+#pragma omp parallel for schedule(dynamic, 1)
+    for (uint64_t i = 0; i < num_boxes; ++i) {
+      std::array<uint64_t, 3> box_coord = {cx + stride * (i % nx),
+                                           cy + stride * ((i % nxy) / nx),
+                                           cz + stride * (i / nxy)};
+      const auto* box = GetBoxPointer(GetBoxIndex(box_coord));
+      for (auto it = box->begin(this); !it.IsAtEnd(); ++it) {
+        auto ah = *it;
+        auto* agent = rm->GetAgent(ah);
+        if (!filter || (*filter)(agent)) {
+          functor(agent, ah);
+        }
+      }
+    }
+  }
+}
+
+// -----------------------------------------------------------------------------
+void UniformGridEnvironment::ForEachNeighborPairInBox(
+    Functor<void, Agent*, AgentHandle, Agent*, AgentHandle, real_t>& functor,
+    real_t squared_radius, size_t box_idx) {
+  const auto* box = GetBoxPointer(box_idx);
+  // Padding boxes are always empty. Therefore, the half-shell of a non-empty
+  // box never exceeds the grid.
+  if (box->IsEmpty(timestamp_)) {
+    return;
+  }
+
+  auto* rm = Simulation::GetActive()->GetResourceManager();
+
+  FixedSizeVector<size_t, 14> half_shell;
+  GetHalfMooreBoxIndices(&half_shell, box_idx);
+
+  auto process_pair = [&](Agent* agent, AgentHandle ah, const Real3& pos,
+                          AgentHandle nah) {
+    auto* neighbor = rm->GetAgent(nah);
+    auto squared_distance =
+        SquaredEuclideanDistance(pos, neighbor->GetPosition());
+    if (squared_distance < squared_radius) {
+      functor(agent, ah, neighbor, nah, squared_distance);
+    }
+  };
+
+  for (auto it = box->begin(this); !it.IsAtEnd(); ++it) {
+    auto ah = *it;
+    auto* agent = rm->GetAgent(ah);
+    const auto& pos = agent->GetPosition();
+
+    // agents in the same box that come after the current one
+    auto nit = it;
+    for (++nit; !nit.IsAtEnd(); ++nit) {
+      process_pair(agent, ah, pos, *nit);
+    }
+
+    // agents in the remaining 13 boxes of the half-shell
+    for (size_t i = 1; i < half_shell.size(); ++i) {
+      const auto* neighbor_box = GetBoxPointer(half_shell[i]);
+      for (auto nit = neighbor_box->begin(this); !nit.IsAtEnd(); ++nit) {
+        process_pair(agent, ah, pos, *nit);
+      }
+    }
+  }
+}
+
 }  // namespace bdm
@@ -54,6 +54,8 @@ namespace detail {
 struct InitializeGPUData;
 }  // namespace detail
 
+struct NeighborBatch;
+
 /// A class that represents Cartesian 3D grid
 class UniformGridEnvironment : public Environment {
   // MechanicalForcesOpCuda needs access to some UniformGridEnvironment private
@@ -125,12 +127,34 @@ class UniformGridEnvironment : public Environment {
       }
     }
 
+    /// @brief      Removes an agent from this box
+    ///
+    /// The agent must be part of this box. Traverses the linked list to find
+    /// its predecessor.
+    void RemoveObject(AgentHandle ah, AgentVector<AgentHandle>* successors) {
+      std::lock_guard<Spinlock> lock_guard(lock_);
+      assert(length_ != 0);
+      if (start_ == ah) {
+        start_ = (*successors)[ah];
+      } else {
+        auto previous = start_;
+        while ((*successors)[previous] != ah) {
+          previous = (*successors)[previous];
+        }
+        (*successors)[previous] = (*successors)[ah];
+      }
+      length_--;
+    }
+
     /// An iterator that iterates over the cells in this box
     struct Iterator {
       Iterator(UniformGridEnvironment* grid, const Box* box)
           : grid_(grid), current_value_(box->start_), countdown_(box->length_) {
         if (grid->timestamp_ != box->timestamp_) {
           countdown_ = 0;
+        } else if (grid->use_counting_sort_) {
+          auto box_idx = box - grid->boxes_.data();
+          sorted_ = &(grid->sorted_agents_[grid->box_start_[box_idx]]);
         }
       }
 
@@ -139,7 +163,11 @@ class UniformGridEnvironment : public Environment {
       Iterator& operator++() {
         countdown_--;
         if (countdown_ > 0) {
-          current_value_ = grid_->successors_[current_value_];
+          if (sorted_ != nullptr) {
+            current_value_ = *(++sorted_);
+          } else {
+            current_value_ = grid_->successors_[current_value_];
+          }
         }
         return *this;
       }
@@ -152,6 +180,9 @@ class UniformGridEnvironment : public Environment {
       AgentHandle current_value_;
       /// The remain number of agents to consider
       int countdown_ = 0;
+      /// Position of `current_value_` in `grid_->sorted_agents_`.
+      /// Only used if the grid has been built with a counting sort.
+      const AgentHandle* sorted_ = nullptr;
     };
 
     Iterator begin(UniformGridEnvironment* grid) const {  // NOLINT
@@ -222,15 +253,43 @@ class UniformGridEnvironment : public Environment {
     }
   };
 
-  /// Enum that determines the degree of adjacency in search neighbor boxes
-  //  todo(ahmad): currently only kHigh is supported (hardcoded 26 several
-  //  places)
+  /// Structure-of-arrays copy of the agent data that is needed for neighbor
+  /// searches. Agents are sorted by box: the agents of box `i` are stored in
+  /// the index range `[box_offsets[i], box_offsets[i + 1])`.\n
+  /// Built once per grid update if `Param::uniform_grid_soa_snapshot` is
+  /// enabled.
+  struct AgentSnapshot {
+    /// Start index of each box. Contains one additional element at the end.
+    ParallelResizeVector<uint64_t> box_offsets;
+    ParallelResizeVector<real_t> x;
+    ParallelResizeVector<real_t> y;
+    ParallelResizeVector<real_t> z;
+    ParallelResizeVector<real_t> diameter;
+    ParallelResizeVector<Agent*> agents;
+
+    /// Returns the number of agents in the snapshot
+    uint64_t size() const { return agents.size(); }  // NOLINT
+
+    /// Number of agents in box `box_idx`
+    uint64_t Size(uint64_t box_idx) const {
+      return box_offsets[box_idx + 1] - box_offsets[box_idx];
+    }
+  };
+
+  /// Enum that determines the degree of adjacency in search neighbor boxes.
+  /// Only `kHigh` guarantees that all neighbors within the search radius are
+  /// found. `kLow` and `kMedium` skip the boxes that are diagonally adjacent,
+  /// which turns the neighbor search into an approximation.
   enum Adjacency {
-    kLow,    /**< The closest 8  neighboring boxes */
-    kMedium, /**< The closest 18  neighboring boxes */
-    kHigh    /**< The closest 26  neighboring boxes */
+    kLow,    /**< The closest 6 neighboring boxes (shared face) */
+    kMedium, /**< The closest 18 neighboring boxes (shared face or edge) */
+    kHigh    /**< The closest 26 neighboring boxes */
   };
 
+  /// Maximum number of boxes in the search stencil (see
+  /// `Param::uniform_grid_boxes_per_radius`)
+  static constexpr uint64_t kMaxStencilSize = 125;
+
   explicit UniformGridEnvironment(Adjacency adjacency = kHigh)
       : adjacency_(adjacency), lbi_(this) {}
 
@@ -241,6 +300,12 @@ class UniformGridEnvironment : public Environment {
 
   /// Clears the grid
   void Clear() override {
+    ClearDimensions();
+    successors_.clear();
+  }
+
+  /// Resets the grid dimensions, but keeps the assignment of agents to boxes
+  void ClearDimensions() {
     if (!is_custom_box_length_) {
       box_length_ = 1;
     }
@@ -250,7 +315,6 @@ class UniformGridEnvironment : public Environment {
     int32_t inf = std::numeric_limits<int32_t>::max();
     grid_dimensions_ = {inf, -inf, inf, -inf, inf, -inf};
     threshold_dimensions_ = {inf, -inf};
-    successors_.clear();
     has_grown_ = false;
   }
 
@@ -264,6 +328,9 @@ class UniformGridEnvironment : public Environment {
       box->AddObject(ah, &(grid_->successors_), grid_);
       assert(idx <= std::numeric_limits<uint32_t>::max());
       agent->SetBoxIdx(static_cast<uint32_t>(idx));
+      if (grid_->track_agents_) {
+        grid_->grid_agents_[ah] = agent;
+      }
     }
 
    private:
@@ -279,6 +346,15 @@ class UniformGridEnvironment : public Environment {
 
   int32_t GetBoxLength() const { return box_length_; }
 
+  /// Returns the number of boxes in each direction that are searched for
+  /// neighbors (see `Param::uniform_grid_boxes_per_radius`)
+  int32_t GetBoxesPerRadius() const { return boxes_per_radius_; }
+
+  /// Returns the largest search radius for which all neighbors are found
+  int32_t GetMaxSearchRadius() const {
+    return box_length_ * boxes_per_radius_;
+  }
+
   /// @brief      Calculates the squared euclidean distance between two points
   ///             in 3D
   ///
@@ -354,12 +430,13 @@ class UniformGridEnvironment : public Environment {
   /// Compares the points coordinates against grid_dimensions_ (without bounding
   /// boxes).
   bool ContainedInGrid(const Real3& point) const {
-    real_t xmin = static_cast<real_t>(grid_dimensions_[0]) + box_length_;
-    real_t xmax = static_cast<real_t>(grid_dimensions_[1]) - box_length_;
-    real_t ymin = static_cast<real_t>(grid_dimensions_[2]) + box_length_;
-    real_t ymax = static_cast<real_t>(grid_dimensions_[3]) - box_length_;
-    real_t zmin = static_cast<real_t>(grid_dimensions_[4]) + box_length_;
-    real_t zmax = static_cast<real_t>(grid_dimensions_[5]) - box_length_;
+    const auto padding = GetMaxSearchRadius();
+    real_t xmin = static_cast<real_t>(grid_dimensions_[0]) + padding;
+    real_t xmax = static_cast<real_t>(grid_dimensions_[1]) - padding;
+    real_t ymin = static_cast<real_t>(grid_dimensions_[2]) + padding;
+    real_t ymax = static_cast<real_t>(grid_dimensions_[3]) - padding;
+    real_t zmin = static_cast<real_t>(grid_dimensions_[4]) + padding;
+    real_t zmax = static_cast<real_t>(grid_dimensions_[5]) - padding;
     if (point[0] >= xmin && point[0] <= xmax && point[1] >= ymin &&
         point[1] <= ymax && point[2] >= zmin && point[2] <= zmax) {
       return true;
@@ -384,6 +461,12 @@ class UniformGridEnvironment : public Environment {
 
   uint64_t GetNumBoxes() const { return boxes_.size(); }
 
+  /// Returns the box-sorted snapshot of the agent data or a nullptr if
+  /// `Param::uniform_grid_soa_snapshot` is disabled.
+  const AgentSnapshot* GetAgentSnapshot() const {
+    return use_snapshot_ ? &snapshot_ : nullptr;
+  }
+
   std::array<uint64_t, 3> GetBoxCoordinates(size_t box_idx) const {
     std::array<uint64_t, 3> box_coord;
     box_coord[2] = box_idx / num_boxes_xy_;
@@ -405,6 +488,10 @@ class UniformGridEnvironment : public Environment {
   ///
   void ForEachNeighbor(Functor<void, Agent*, real_t>& lambda,
                        const Agent& query, real_t squared_radius) override {
+    if (verlet_valid_ && squared_radius <= verlet_squared_radius_ &&
+        ForEachNeighborInVerletList(lambda, query, squared_radius)) {
+      return;
+    }
     ForEachNeighbor(lambda, query.GetPosition(), squared_radius, &query);
   }
 
@@ -421,13 +508,16 @@ class UniformGridEnvironment : public Environment {
   void ForEachNeighbor(Functor<void, Agent*, real_t>& lambda,
                        const Real3& query_position, real_t squared_radius,
                        const Agent* query_agent = nullptr) override {
-    if (squared_radius > box_length_squared_) {
+    const real_t max_radius = GetMaxSearchRadius();
+    if (squared_radius > max_radius * max_radius) {
       Log::Fatal(
           "UniformGridEnvironment::ForEachNeighbor",
           "The requested search radius (", std::sqrt(squared_radius), ")",
           " of the neighborhood search exceeds the "
           "box length (",
-          box_length_, "). The resulting neighborhood would be incomplete.");
+          box_length_, ") times the number of boxes per radius (",
+          boxes_per_radius_,
+          "). The resulting neighborhood would be incomplete.");
     }
     const auto& position = query_position;
     // Use uint32_t for compatibility with Agent::GetBoxIdx();
@@ -445,12 +535,12 @@ class UniformGridEnvironment : public Environment {
           "You provided a query_position that is outside of the environment. ",
           "Neighbor search is not supported in this case. \n",
           "query_position: ", query_position,
-          "\ngrid_dimensions: ", grid_dimensions_[0] + box_length_, ", ",
-          grid_dimensions_[1] - box_length_, ", ",
-          grid_dimensions_[2] + box_length_, ", ",
-          grid_dimensions_[3] - box_length_, ", ",
-          grid_dimensions_[4] + box_length_, ", ",
-          grid_dimensions_[5] - box_length_);
+          "\ngrid_dimensions: ", grid_dimensions_[0] + max_radius, ", ",
+          grid_dimensions_[1] - max_radius, ", ",
+          grid_dimensions_[2] + max_radius, ", ",
+          grid_dimensions_[3] - max_radius, ", ",
+          grid_dimensions_[4] + max_radius, ", ",
+          grid_dimensions_[5] - max_radius);
       return;
     }
     // Freshly created agents are initialized with the largest uint32_t number
@@ -466,6 +556,17 @@ class UniformGridEnvironment : public Environment {
       idx = static_cast<uint32_t>(idx_tmp);
     }
 
+    if (use_snapshot_) {
+      ForEachNeighborInSnapshot(lambda, position, squared_radius, query_agent,
+                                idx);
+      return;
+    }
+    if (boxes_per_radius_ > 1) {
+      ForEachNeighborInStencil(lambda, position, squared_radius, query_agent,
+                               idx);
+      return;
+    }
+
     FixedSizeVector<const Box*, 27> neighbor_boxes;
     GetMooreBoxes(&neighbor_boxes, idx);
 
@@ -518,6 +619,26 @@ class UniformGridEnvironment : public Environment {
     process_batch();
   };
 
+  /// @brief      Determines the neighbors of `num_queries` agents within the
+  ///             squared radius and stores them in `batch`.
+  ///
+  /// Returns the same neighbors as `ForEachNeighbor` for each query. The
+  /// candidates of the search stencil are gathered once for consecutive
+  /// queries that are located in the same box. The distances to all
+  /// candidates are then computed in one vectorized loop per query without a
+  /// functor call per neighbor. Queries should therefore be ordered by box
+  /// (e.g. a chunk of `ResourceManager` after load balancing).\n
+  /// In simulation code do not use this function directly. Use
+  /// `ExecutionContext::ForEachNeighborBatch`.
+  ///
+  /// @param[in]  queries         The query agents
+  /// @param[in]  num_queries     The number of query agents
+  /// @param[in]  squared_radius  The squared search radius
+  /// @param[out] batch           The neighbors of all queries
+  ///
+  void ForEachNeighborBatch(Agent* const* queries, uint64_t num_queries,
+                            real_t squared_radius, NeighborBatch* batch);
+
   /// @brief      Applies the given functor to each neighbor of the specified
   ///             agent that is within the same box as the query agent
   ///             or in the 26 surrounding boxes.
@@ -532,6 +653,47 @@ class UniformGridEnvironment : public Environment {
   void ForEachNeighbor(Functor<void, Agent*>& functor, const Agent& query,
                        void* criteria) override;
 
+  /// @brief      Applies the given functor exactly once to each pair of
+  ///             agents whose squared distance is smaller than
+  ///             `squared_radius`.
+  ///
+  /// Boxes are traversed with a half-shell stencil (see
+  /// `GetHalfMooreBoxIndices`). The stencil reaches one box in both
+  /// directions along the x- and y-axis, but only in positive z direction.
+  /// Boxes are therefore partitioned into 18 colors (3 x 3 x 2), and all
+  /// boxes of one color are processed in parallel. Two concurrent functor
+  /// invocations never share an agent. Hence, the functor can modify data
+  /// associated with both agents without synchronization.
+  ///
+  /// @param[in]  functor         The operation called for each pair:
+  ///                             (agent, handle, neighbor, neighbor handle,
+  ///                             squared distance)
+  /// @param[in]  squared_radius  The squared search radius
+  ///
+  void ForEachNeighborPair(
+      Functor<void, Agent*, AgentHandle, Agent*, AgentHandle, real_t>& functor,
+      real_t squared_radius);
+
+  /// @brief      Applies the given functor to each agent. Agents whose
+  ///             neighborhoods overlap are never processed concurrently.
+  ///
+  /// The neighborhood of an agent reaches `GetBoxesPerRadius()` boxes in
+  /// each direction. Boxes are partitioned into a checkerboard of
+  /// `(2 * GetBoxesPerRadius() + 1)^3` colors (27 for the default grid).
+  /// The neighborhoods of two boxes with the same color do not overlap.
+  /// Colors are processed one after another; the boxes of one color are
+  /// processed in parallel and their agents box by box. Hence, the functor can
+  /// modify the given agent and its neighbors without locks. This is the
+  /// lock-free equivalent of `GridNeighborMutexBuilder`
+  /// (see `Param::ThreadSafetyMechanism::kBoxColoring`).
+  ///
+  /// @param[in]  functor  The operation called for each agent
+  /// @param[in]  filter   Agents for which `filter` returns false are skipped.
+  ///                      A nullptr processes all agents.
+  ///
+  void ForEachAgentInColoredBoxes(Functor<void, Agent*, AgentHandle>& functor,
+                                  Functor<bool, Agent*>* filter = nullptr);
+
   // NeighborMutex ---------------------------------------------------------
 
   /// This class ensures thread-safety for the InPlaceExecutionContext for the
@@ -545,7 +707,8 @@ class UniformGridEnvironment : public Environment {
     class GridNeighborMutex
         : public Environment::NeighborMutexBuilder::NeighborMutex {
      public:
-      GridNeighborMutex(const FixedSizeVector<uint64_t, 27>& mutex_indices,
+      GridNeighborMutex(
+          const FixedSizeVector<uint64_t, kMaxStencilSize>& mutex_indices,
                         GridNeighborMutexBuilder* mutex_builder)
           : mutex_indices_(mutex_indices), mutex_builder_(mutex_builder) {
         // Deadlocks occur if multiple threads try to acquire the same locks,
@@ -572,13 +735,14 @@ class UniformGridEnvironment : public Environment {
         }
       }
 
-      void SetMutexIndices(const FixedSizeVector<uint64_t, 27>& indices) {
+      void SetMutexIndices(
+          const FixedSizeVector<uint64_t, kMaxStencilSize>& indices) {
         mutex_indices_ = indices;
         std::sort(mutex_indices_.begin(), mutex_indices_.end());
       }
 
      private:
-      FixedSizeVector<uint64_t, 27> mutex_indices_;
+      FixedSizeVector<uint64_t, kMaxStencilSize> mutex_indices_;
       GridNeighborMutexBuilder* mutex_builder_;
     };
 
@@ -678,8 +842,48 @@ class UniformGridEnvironment : public Environment {
   ///     AgentHandle current_element = ...;
   ///     AgentHandle next_element = successors_[current_element];
   AgentVector<AgentHandle> successors_;
+  /// Cache the value of `Param::uniform_grid_counting_sort`
+  bool use_counting_sort_ = false;
+  /// Compressed sparse row representation of the grid, which is built if
+  /// `use_counting_sort_` is true. The agents of box `i` are stored in
+  /// `sorted_agents_[box_start_[i]]` to `sorted_agents_[box_start_[i + 1] - 1]`
+  ParallelResizeVector<uint64_t> box_start_;         //!
+  ParallelResizeVector<AgentHandle> sorted_agents_;  //!
+  /// Position of each agent inside its box. Used to scatter the agents into
+  /// `sorted_agents_` without synchronization.
+  AgentVector<uint32_t> box_ranks_;
+  /// If true, `grid_agents_` is filled during the next full grid update
+  bool track_agents_ = false;
+  /// The agent stored at each agent handle during the last full grid update.
+  /// Used to detect if agent handles have been invalidated (e.g. due to
+  /// added or removed agents, or load balancing).
+  AgentVector<Agent*> grid_agents_;
+  /// True if `grid_agents_` has been filled during the last full grid update
+  bool grid_agents_valid_ = false;
+
+  // Verlet lists (see `Param::uniform_grid_verlet_skin`). The lists are
+  // indexed by `verlet_numa_offsets_[numa_node] + element_idx` of the agent
+  // handle. The neighbors of agent `i` are stored in `verlet_neighbors_`
+  // between `verlet_start_[i]` and `verlet_start_[i + 1]`.
+  /// True if the Verlet lists can be used to answer neighbor queries
+  bool verlet_valid_ = false;
+  /// Interaction radius (largest agent size) at the time of the list build
+  real_t verlet_radius_ = 0;
+  real_t verlet_squared_radius_ = 0;
+  std::vector<uint64_t> verlet_numa_offsets_;
+  ParallelResizeVector<uint64_t> verlet_start_;    //!
+  ParallelResizeVector<Agent*> verlet_neighbors_;  //!
+  /// The agent, its uid, and its position at the time of the list build.
+  /// The uid detects agents that have been replaced by a new agent at the
+  /// same memory address.
+  ParallelResizeVector<Agent*> verlet_agents_;    //!
+  ParallelResizeVector<AgentUid> verlet_uids_;    //!
+  ParallelResizeVector<Real3> verlet_positions_;  //!
   /// Determines which boxes to search neighbors in (see enum Adjacency)
   Adjacency adjacency_;
+  /// Number of boxes in each direction that are searched for neighbors.
+  /// Cache the value of `Param::uniform_grid_boxes_per_radius`
+  int32_t boxes_per_radius_ = 1;
   /// Cube which contains all agents
   /// {x_min, x_max, y_min, y_max, z_min, z_max}
   std::array<int32_t, 6> grid_dimensions_;
@@ -689,6 +893,11 @@ class UniformGridEnvironment : public Environment {
 
   LoadBalanceInfoUG lbi_;  //!
 
+  /// Cache the value of `Param::uniform_grid_soa_snapshot`
+  bool use_snapshot_ = false;
+  /// Box-sorted copy of the agent data. Only valid if `use_snapshot_` is true.
+  AgentSnapshot snapshot_;  //!
+
   /// Holds instance of NeighborMutexBuilder.
   /// NeighborMutexBuilder is updated if `Param::thread_safety_mechanism`
   /// is set to `kAutomatic`
@@ -798,6 +1007,36 @@ class UniformGridEnvironment : public Environment {
     }
   }
 
+  /// @brief      Gets the indices of all boxes within `boxes_per_radius_`
+  ///             boxes of the query box (including the query box) that
+  ///             satisfy the adjacency criterion. For `boxes_per_radius_ ==
+  ///             1` the result contains the same boxes as
+  ///             `GetMooreBoxIndices`.
+  ///
+  /// @param[out] box_indices     Result containing all box indices
+  /// @param[in]  box_idx         The query box
+  ///
+  void GetStencilBoxIndices(
+      FixedSizeVector<uint64_t, kMaxStencilSize>* box_indices,
+      size_t box_idx) const {
+    const int64_t reach = boxes_per_radius_;
+    const int64_t max_non_zero = static_cast<int64_t>(adjacency_) + 1;
+    const auto center = static_cast<int64_t>(box_idx);
+    const auto nx = static_cast<int64_t>(num_boxes_axis_[0]);
+    const auto nxy = static_cast<int64_t>(num_boxes_xy_);
+    for (int64_t z = -reach; z <= reach; ++z) {
+      for (int64_t y = -reach; y <= reach; ++y) {
+        for (int64_t x = -reach; x <= reach; ++x) {
+          if ((x != 0) + (y != 0) + (z != 0) > max_non_zero) {
+            continue;
+          }
+          box_indices->push_back(
+              static_cast<uint64_t>(center + z * nxy + y * nx + x));
+        }
+      }
+    }
+  }
+
   /// @brief      Gets the box indices of all adjacent boxes. Also adds the
   ///             query box index.
   ///
@@ -914,6 +1153,62 @@ class UniformGridEnvironment : public Environment {
     neighbor_boxes->push_back(box_idx + num_boxes_xy_ + num_boxes_axis_[0] + 1);
   }
 
+  /// Calls `functor` for each pair of agents in which the first agent is
+  /// located in box `box_idx` and the second agent in the half-shell of
+  /// `box_idx`. Helper function for `ForEachNeighborPair`.
+  void ForEachNeighborPairInBox(
+      Functor<void, Agent*, AgentHandle, Agent*, AgentHandle, real_t>& functor,
+      real_t squared_radius, size_t box_idx);
+
+  /// Neighbor search for `boxes_per_radius_ > 1`, which uses the larger
+  /// stencil returned by `GetStencilBoxIndices`.
+  void ForEachNeighborInStencil(Functor<void, Agent*, real_t>& lambda,
+                                const Real3& query_position,
+                                real_t squared_radius,
+                                const Agent* query_agent, size_t box_idx);
+
+  /// Builds the Verlet lists with radius largest agent size + skin.
+  void UpdateVerletLists();
+
+  /// Returns true if no agent has moved far enough since the last build of
+  /// the Verlet lists that neighbors might have been missed during the next
+  /// iteration. Also returns false if agent handles have been invalidated, or
+  /// agents have grown beyond the interaction radius used for the build.
+  bool AreVerletListsValid() const;
+
+  /// Iterates over the Verlet list of `query` and calls `lambda` for each
+  /// neighbor with a squared distance smaller than `squared_radius`.
+  /// Returns false if there is no Verlet list for `query` (e.g. the agent has
+  /// been created during this iteration).
+  bool ForEachNeighborInVerletList(Functor<void, Agent*, real_t>& lambda,
+                                   const Agent& query,
+                                   real_t squared_radius) const;
+
+  /// Moves only those agents to a new box whose box index has changed since
+  /// the last grid update. The grid dimensions must not have changed.
+  /// Returns false without modifying the grid if agent handles have been
+  /// invalidated since the last full update. In this case, the grid must be
+  /// rebuilt.
+  bool UpdateBoxesIncrementally();
+
+  /// Assigns all agents to boxes with a parallel counting sort (histogram,
+  /// prefix sum and scatter) instead of inserting them into the linked list
+  /// of each box. Does not require any locks.
+  void AssignToBoxesCountingSort();
+
+  /// Copies position, diameter and pointer of all agents into `snapshot_`
+  /// sorted by box.
+  void UpdateAgentSnapshot();
+
+  /// Neighbor search on `snapshot_`. Streams over the contiguous agent data
+  /// of the boxes in the search stencil of box `box_idx`. Agents that pass
+  /// the snapshot pre-filter are checked against their current position.
+  void ForEachNeighborInSnapshot(Functor<void, Agent*, real_t>& lambda,
+                                 const Real3& query_position,
+                                 real_t squared_radius,
+                                 const Agent* query_agent,
+                                 size_t box_idx) const;
+
   /// @brief      Gets the pointer to the box with the given index
   ///
   /// @param[in]  index  The index of the box
@@ -0,0 +1,206 @@
+// -----------------------------------------------------------------------------
+//
+// Copyright (C) 2021 CERN & University of Surrey for the benefit of the
+// BioDynaMo collaboration. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+//
+// See the LICENSE file distributed with this work for details.
+// See the NOTICE file distributed with this work for additional information
+// regarding copyright ownership.
+//
+// -----------------------------------------------------------------------------
+
+#include "core/execution_context/double_buffered_exec_ctxt.h"
+#include <omp.h>
+#include "core/agent/agent.h"
+#include "core/param/param.h"
+#include "core/resource_manager.h"
+#include "core/simulation.h"
+#include "core/util/log.h"
+
+namespace bdm {
+
+// -----------------------------------------------------------------------------
+void DoubleBufferedExecutionContext::SharedState::Buffer::Resize(
+    uint64_t num_agents, const std::vector<DoubleBufferedField>& field_defs) {
+  x.resize(num_agents);
+  y.resize(num_agents);
+  z.resize(num_agents);
+  diameter.resize(num_agents);
+  fields.resize(field_defs.size());
+  for (uint64_t f = 0; f < field_defs.size(); ++f) {
+    fields[f].resize(num_agents * field_defs[f].size);
+  }
+}
+
+// -----------------------------------------------------------------------------
+void DoubleBufferedExecutionContext::Use(
+    Simulation* sim, const std::vector<DoubleBufferedField>& fields) {
+  auto size = sim->GetAllExecCtxts().size();
+  auto map = std::make_shared<
+      typename InPlaceExecutionContext::ThreadSafeAgentUidMap>();
+  auto state = std::make_shared<SharedState>();
+  state->fields = fields;
+  auto numa_nodes = ThreadInfo::GetInstance()->GetNumaNodes();
+  state->front.resize(numa_nodes);
+  state->back.resize(numa_nodes);
+  state->executed.resize(numa_nodes);
+  std::vector<ExecutionContext*> exec_ctxts(size);
+#pragma omp parallel for schedule(static, 1)
+  for (uint64_t i = 0; i < size; i++) {
+    exec_ctxts[i] = new DoubleBufferedExecutionContext(map, state);
+  }
+  sim->SetAllExecCtxts(exec_ctxts);
+
+  auto mechanism = sim->GetParam()->thread_safety_mechanism;
+  if (omp_get_max_threads() > 1 &&
+      (mechanism == Param::ThreadSafetyMechanism::kNone ||
+       mechanism == Param::ThreadSafetyMechanism::kUserSpecified)) {
+    Log::Warning("DoubleBufferedExecutionContext::Use",
+                 "Neighboring agents might be processed at the same time with "
+                 "the selected thread-safety mechanism. Only "
+                 "GetPreviousPosition, GetPreviousDiameter and GetPrevious "
+                 "return the values at the beginning of the agent operations. "
+                 "Select the thread-safety mechanism automatic or "
+                 "box-coloring to obtain them also from the agents.");
+  }
+}
+
+// -----------------------------------------------------------------------------
+DoubleBufferedExecutionContext::DoubleBufferedExecutionContext(
+    const std::shared_ptr<ThreadSafeAgentUidMap>& map,
+    const std::shared_ptr<SharedState>& state)
+    : InPlaceExecutionContext(map), state_(state) {}
+
+// -----------------------------------------------------------------------------
+DoubleBufferedExecutionContext::~DoubleBufferedExecutionContext() = default;
+
+// -----------------------------------------------------------------------------
+void DoubleBufferedExecutionContext::SetupAgentOpsAll(
+    const std::vector<ExecutionContext*>& all_exec_ctxts) {
+  InPlaceExecutionContext::SetupAgentOpsAll(all_exec_ctxts);
+  auto* rm = Simulation::GetActive()->GetResourceManager();
+  for (uint64_t n = 0; n < state_->front.size(); ++n) {
+    auto num_agents = rm->GetNumAgents(n);
+    state_->front[n].Resize(num_agents, state_->fields);
+    state_->back[n].Resize(num_agents, state_->fields);
+    state_->executed[n].assign(num_agents, 0);
+  }
+
+  auto save = L2F([&](Agent* agent, AgentHandle ah) {
+    Save(agent, ah.GetElementIdx(), &state_->front[ah.GetNumaNode()]);
+  });
+  rm->ForEachAgentParallel(save);
+}
+
+// -----------------------------------------------------------------------------
+void DoubleBufferedExecutionContext::TearDownAgentOpsAll(
+    const std::vector<ExecutionContext*>& all_exec_ctxts) {
+  auto* sim = Simulation::GetActive();
+  auto* rm = sim->GetResourceManager();
+  auto commit = L2F([&](Agent* agent, AgentHandle ah) {
+    auto nid = ah.GetNumaNode();
+    auto idx = ah.GetElementIdx();
+    if (state_->executed[nid][idx]) {
+      // use the context of the calling thread for its scratch space
+      auto* ctxt = bdm_static_cast<DoubleBufferedExecutionContext*>(
+          sim->GetExecutionContext());
+      ctxt->Restore(agent, idx, state_->back[nid]);
+    }
+  });
+  rm->ForEachAgentParallel(commit);
+  // flip: the committed state is the front buffer of the next iteration
+  std::swap(state_->front, state_->back);
+  InPlaceExecutionContext::TearDownAgentOpsAll(all_exec_ctxts);
+}
+
+// -----------------------------------------------------------------------------
+void DoubleBufferedExecutionContext::ExecuteOperations(
+    Agent* agent, AgentHandle ah, const std::vector<Operation*>& operations) {
+  auto nid = ah.GetNumaNode();
+  auto idx = ah.GetElementIdx();
+  assert(nid < state_->front.size());
+  assert(idx < state_->executed[nid].size());
+  auto& back = state_->back[nid];
+  // Param::ExecutionOrder::kForEachOpForEachAgent executes an agent several
+  // times. Continue from the values of the last call.
+  if (state_->executed[nid][idx]) {
+    Restore(agent, idx, back);
+  }
+  InPlaceExecutionContext::ExecuteOperations(agent, ah, operations);
+  Save(agent, idx, &back);
+  Restore(agent, idx, state_->front[nid]);
+  state_->executed[nid][idx] = 1;
+}
+
+// -----------------------------------------------------------------------------
+Real3 DoubleBufferedExecutionContext::GetPreviousPosition(
+    const Agent& agent) const {
+  AgentHandle ah;
+  if (!GetBufferHandle(agent, &ah)) {
+    return agent.GetPosition();
+  }
+  auto& front = state_->front[ah.GetNumaNode()];
+  auto idx = ah.GetElementIdx();
+  return {front.x[idx], front.y[idx], front.z[idx]};
+}
+
+// -----------------------------------------------------------------------------
+real_t DoubleBufferedExecutionContext::GetPreviousDiameter(
+    const Agent& agent) const {
+  AgentHandle ah;
+  if (!GetBufferHandle(agent, &ah)) {
+    return agent.GetDiameter();
+  }
+  return state_->front[ah.GetNumaNode()].diameter[ah.GetElementIdx()];
+}
+
+// -----------------------------------------------------------------------------
+bool DoubleBufferedExecutionContext::GetBufferHandle(const Agent& agent,
+                                                     AgentHandle* ah) const {
+  auto* rm = Simulation::GetActive()->GetResourceManager();
+  if (!rm->ContainsAgent(agent.GetUid())) {
+    return false;
+  }
+  *ah = rm->GetAgentHandle(agent.GetUid());
+  return ah->GetElementIdx() < state_->executed[ah->GetNumaNode()].size();
+}
+
+// -----------------------------------------------------------------------------
+void DoubleBufferedExecutionContext::Save(const Agent* agent, uint64_t idx,
+                                          SharedState::Buffer* buffer) {
+  const auto& pos = agent->GetPosition();
+  buffer->x[idx] = pos[0];
+  buffer->y[idx] = pos[1];
+  buffer->z[idx] = pos[2];
+  buffer->diameter[idx] = agent->GetDiameter();
+  for (uint64_t f = 0; f < state_->fields.size(); ++f) {
+    auto size = state_->fields[f].size;
+    state_->fields[f].save(agent, &buffer->fields[f][idx * size]);
+  }
+}
+
+// -----------------------------------------------------------------------------
+void DoubleBufferedExecutionContext::Restore(
+    Agent* agent, uint64_t idx, const SharedState::Buffer& buffer) {
+  Real3 pos = {buffer.x[idx], buffer.y[idx], buffer.z[idx]};
+  if (agent->GetPosition() != pos) {
+    agent->SetPosition(pos);
+  }
+  if (agent->GetDiameter() != buffer.diameter[idx]) {
+    agent->SetDiameter(buffer.diameter[idx]);
+  }
+  for (uint64_t f = 0; f < state_->fields.size(); ++f) {
+    auto& field = state_->fields[f];
+    const auto* value = &buffer.fields[f][idx * field.size];
+    scratch_.resize(field.size);
+    field.save(agent, scratch_.data());
+    if (std::memcmp(scratch_.data(), value, field.size) != 0) {
+      field.restore(agent, value);
+    }
+  }
+}
+
+}  // namespace bdm
@@ -0,0 +1,203 @@
+// -----------------------------------------------------------------------------
+//
+// Copyright (C) 2021 CERN & University of Surrey for the benefit of the
+// BioDynaMo collaboration. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+//
+// See the LICENSE file distributed with this work for details.
+// See the NOTICE file distributed with this work for additional information
+// regarding copyright ownership.
+//
+// -----------------------------------------------------------------------------
+
+#ifndef CORE_EXECUTION_CONTEXT_DOUBLE_BUFFERED_EXEC_CTXT_H_
+#define CORE_EXECUTION_CONTEXT_DOUBLE_BUFFERED_EXEC_CTXT_H_
+
+#include <cstring>
+#include <functional>
+#include <memory>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "core/execution_context/in_place_exec_ctxt.h"
+#include "core/util/log.h"
+
+namespace bdm {
+
+class Simulation;
+
+/// Attribute of an agent that is double buffered by the
+/// `DoubleBufferedExecutionContext` in addition to position and diameter.
+/// Use `DoubleBufferedField::Create` to define one.
+struct DoubleBufferedField {
+  /// Number of bytes per agent
+  uint64_t size = 0;
+  /// Writes the value of the attribute of `agent` to `dest`
+  std::function<void(const Agent* agent, void* dest)> save;
+  /// Sets the attribute of `agent` to the value stored at `src`
+  std::function<void(Agent* agent, const void* src)> restore;
+
+  /// `getter` must have the signature `T(const Agent*)` and `setter`
+  /// `void(Agent*, const T&)`.
+  /// `usage example`:
+  /// \code
+  ///   auto field = DoubleBufferedField::Create<real_t>(
+  ///       [](const Agent* a) {
+  ///         return bdm_static_cast<const MyCell*>(a)->GetX();
+  ///       },
+  ///       [](Agent* a, real_t x) { bdm_static_cast<MyCell*>(a)->SetX(x); });
+  /// \endcode
+  template <typename T, typename TGetter, typename TSetter>
+  static DoubleBufferedField Create(TGetter getter, TSetter setter) {
+    static_assert(std::is_trivially_copyable<T>::value,
+                  "Double buffered fields must be trivially copyable");
+    DoubleBufferedField field;
+    field.size = sizeof(T);
+    field.save = [getter](const Agent* agent, void* dest) {
+      T value = getter(agent);
+      std::memcpy(dest, &value, sizeof(T));
+    };
+    field.restore = [setter](Agent* agent, const void* src) {
+      T value;
+      std::memcpy(&value, src, sizeof(T));
+      setter(agent, value);
+    };
+    return field;
+  }
+};
+
+/// This execution context derives from `InPlaceExecutionContext` and provides
+/// Jacobi-style semantics for the hot state of agents: position, diameter,
+/// and the attributes registered as `DoubleBufferedField`. \n
+/// Before the agent operations are executed, the hot state of all agents is
+/// saved in a structure of arrays (front buffer). An agent is updated in
+/// place, but after its operations its new hot state is moved to a second
+/// structure of arrays (back buffer) and the previous values are restored.
+/// This happens while the locks of the thread-safety mechanism are still
+/// held. The back buffer is committed after all agent operations were
+/// executed, and the buffers are flipped. \n
+/// In contrast to `experimental::CopyExecutionContext` agents are not cloned
+/// and only the hot state is copied. \n
+/// An agent holds its new values only while its own operations are running.
+/// If no neighbor of this agent is processed at the same time, neighbors
+/// observe the previous values also through `GetPosition`, `GetDiameter`,
+/// etc. This is the case for a single thread and for the thread-safety
+/// mechanisms `automatic` and `box-coloring`. Therefore, built-in operations
+/// like the mechanical forces obtain order independent results. With the
+/// mechanisms `none` and `user-specified`, only `GetPreviousPosition`,
+/// `GetPreviousDiameter`, and `GetPrevious` are order independent. \n
+/// Attributes that are not double buffered and agents created or removed
+/// during the iteration behave like in `InPlaceExecutionContext`.
+class DoubleBufferedExecutionContext : public InPlaceExecutionContext {
+ public:
+  /// Buffers and configuration shared between all
+  /// DoubleBufferedExecutionContext instances of a simulation.
+  struct SharedState {
+    /// Hot state of all agents in one numa domain
+    struct Buffer {
+      std::vector<real_t> x;
+      std::vector<real_t> y;
+      std::vector<real_t> z;
+      std::vector<real_t> diameter;
+      /// One byte array per DoubleBufferedField
+      std::vector<std::vector<char>> fields;
+
+      void Resize(uint64_t num_agents,
+                  const std::vector<DoubleBufferedField>& field_defs);
+    };
+
+    std::vector<DoubleBufferedField> fields;
+    /// Indexed by numa node
+    std::vector<Buffer> front;
+    /// Indexed by numa node
+    std::vector<Buffer> back;
+    /// Indicates which agents were executed and must be committed.
+    /// Indexed by numa node and element index.
+    std::vector<std::vector<char>> executed;
+  };
+
+  /// Use the DoubleBufferedExecutionContext for simulation `sim`.
+  /// `fields` specifies the attributes that are double buffered in addition
+  /// to position and diameter.
+  static void Use(Simulation* sim,
+                  const std::vector<DoubleBufferedField>& fields = {});
+
+  DoubleBufferedExecutionContext(
+      const std::shared_ptr<ThreadSafeAgentUidMap>& map,
+      const std::shared_ptr<SharedState>& state);
+
+  ~DoubleBufferedExecutionContext() override;
+
+  void SetupAgentOpsAll(
+      const std::vector<ExecutionContext*>& all_exec_ctxts) override;
+
+  void TearDownAgentOpsAll(
+      const std::vector<ExecutionContext*>& all_exec_ctxts) override;
+
+  /// Returns the position of `agent` at the beginning of the agent
+  /// operations. Can only be called during the execution of agent operations.
+  /// Agents created during the agent operations return their current value.
+  Real3 GetPreviousPosition(const Agent& agent) const;
+
+  /// Returns the diameter of `agent` at the beginning of the agent
+  /// operations. Can only be called during the execution of agent operations.
+  /// Agents created during the agent operations return their current value.
+  real_t GetPreviousDiameter(const Agent& agent) const;
+
+  /// Returns the value of DoubleBufferedField `field_idx` of `agent` at the
+  /// beginning of the agent operations. `T` must match the type used to
+  /// create the field. Agents created during the agent operations return
+  /// their current value.
+  template <typename T>
+  T GetPrevious(const Agent& agent, uint64_t field_idx) const {
+    if (field_idx >= state_->fields.size() ||
+        state_->fields[field_idx].size != sizeof(T)) {
+      Log::Fatal("DoubleBufferedExecutionContext::GetPrevious",
+                 "Type does not match DoubleBufferedField ", field_idx);
+    }
+    T value;
+    AgentHandle ah;
+    if (!GetBufferHandle(agent, &ah)) {
+      state_->fields[field_idx].save(&agent, &value);
+      return value;
+    }
+    std::memcpy(
+        &value,
+        &state_->front[ah.GetNumaNode()]
+             .fields[field_idx][ah.GetElementIdx() * sizeof(T)],
+        sizeof(T));
+    return value;
+  }
+
+ protected:
+  std::shared_ptr<SharedState> state_;
+
+  /// Executes `operations` for `agent`, moves its new hot state to the back
+  /// buffer and restores the previous values.
+  void ExecuteOperations(Agent* agent, AgentHandle ah,
+                         const std::vector<Operation*>& operations) override;
+
+ private:
+  /// Sets `ah` to the handle of `agent` in the buffers. Returns false if
+  /// `agent` was created during the agent operations and is therefore not
+  /// stored in the buffers.
+  bool GetBufferHandle(const Agent& agent, AgentHandle* ah) const;
+
+  /// Copies the hot state of `agent` to element `idx` of `buffer`
+  void Save(const Agent* agent, uint64_t idx, SharedState::Buffer* buffer);
+
+  /// Sets the hot state of `agent` to element `idx` of `buffer`.
+  /// Setters are only called if the value differs, to avoid side effects
+  /// (e.g. staticness propagation) of unchanged attributes.
+  void Restore(Agent* agent, uint64_t idx, const SharedState::Buffer& buffer);
+
+  /// Scratch space to compare the current value of a DoubleBufferedField
+  std::vector<char> scratch_;
+};
+
+}  // namespace bdm
+
+#endif  // CORE_EXECUTION_CONTEXT_DOUBLE_BUFFERED_EXEC_CTXT_H_
@@ -28,6 +28,41 @@ namespace bdm {
 
 class Agent;
 
+/// Neighbors of a range of query agents in compressed sparse row format.
+/// The neighbors of query `i` are stored at the indices
+/// `[offsets[i], offsets[i + 1])` of `agents` and `squared_distances`.
+/// The vectors keep their capacity between queries, so the same object should
+/// be reused to avoid allocations.
+/// `usage example`:
+/// \code
+///   NeighborBatch batch;
+///   ctxt->ForEachNeighborBatch(agents, num_agents, squared_radius, &batch);
+///   for (uint64_t i = 0; i < batch.size(); ++i) {
+///     for (auto j = batch.offsets[i]; j < batch.offsets[i + 1]; ++j) {
+///       // batch.agents[j], batch.squared_distances[j]
+///     }
+///   }
+/// \endcode
+struct NeighborBatch {
+  std::vector<uint64_t> offsets = {0};
+  std::vector<Agent*> agents;
+  std::vector<real_t> squared_distances;
+
+  /// Returns the number of query agents
+  uint64_t size() const { return offsets.size() - 1; }
+
+  /// Returns the number of neighbors of query `i`
+  uint64_t GetNumNeighbors(uint64_t i) const {
+    return offsets[i + 1] - offsets[i];
+  }
+
+  void clear() {
+    offsets.resize(1);
+    agents.clear();
+    squared_distances.clear();
+  }
+};
+
 class ExecutionContext {
  public:
   virtual ~ExecutionContext() = default;
@@ -79,6 +114,29 @@ class ExecutionContext {
                                const Real3& query_position,
                                real_t squared_radius) = 0;
 
+  /// Determines the neighbors of the `num_queries` agents starting at
+  /// `queries` (e.g. the agents of a `ForEachAgentParallel` chunk) within the
+  /// given search radius `sqrt(squared_radius)`, and stores them in `batch`.
+  /// In contrast to `ForEachNeighbor` the neighbors are returned in contiguous
+  /// arrays, so that the caller can process them without a virtual function
+  /// call per neighbor. Previous contents of `batch` are discarded.\n
+  /// The default implementation calls `ForEachNeighbor` for each query.
+  virtual void ForEachNeighborBatch(Agent* const* queries,
+                                    uint64_t num_queries,
+                                    real_t squared_radius,
+                                    NeighborBatch* batch) {
+    batch->clear();
+    batch->offsets.reserve(num_queries + 1);
+    auto fill = L2F([&](Agent* agent, real_t squared_distance) {
+      batch->agents.push_back(agent);
+      batch->squared_distances.push_back(squared_distance);
+    });
+    for (uint64_t i = 0; i < num_queries; ++i) {
+      ForEachNeighbor(fill, *queries[i], squared_radius);
+      batch->offsets.push_back(batch->agents.size());
+    }
+  }
+
   /// @brief  Adds the agent to the simulation (threadsafe, takes ownership).
   ///         Note that we avoid the use of smart pointers for the agents to
   ///         avoid unnecessary overhead during construction of the agent
@@ -15,105 +15,118 @@
 #include "core/execution_context/in_place_exec_ctxt.h"
 
 #include <algorithm>
+#include <limits>
 #include <mutex>
 #include <utility>
 
 #include "core/agent/agent.h"
+#include "core/algorithm.h"
 #include "core/environment/environment.h"
+#include "core/environment/uniform_grid_environment.h"
 #include "core/functor.h"
 #include "core/resource_manager.h"
 #include "core/scheduler.h"
 
 namespace bdm {
 
-InPlaceExecutionContext::ThreadSafeAgentUidMap::ThreadSafeAgentUidMap()
-    : batches_(nullptr) {
+InPlaceExecutionContext::ThreadSafeAgentUidMap::ThreadSafeAgentUidMap() {
+  for (auto& bucket : buckets_) {
+    bucket = nullptr;
+  }
   Resize(kBatchSize);
 }
 
 InPlaceExecutionContext::ThreadSafeAgentUidMap::~ThreadSafeAgentUidMap() {
-  DeleteOldCopies();
-  auto* non_atomic_batches = batches_.load();
-  if (non_atomic_batches != nullptr) {
-    for (uint64_t i = 0; i < num_batches_; ++i) {
-      delete non_atomic_batches[i];
+  for (auto& bucket : buckets_) {
+    delete[] bucket.load();
+  }
+}
+
+uint64_t InPlaceExecutionContext::ThreadSafeAgentUidMap::GetBucketSize(
+    uint64_t bucket) {
+  return kBatchSize << bucket;
+}
+
+std::pair<uint64_t, uint64_t>
+InPlaceExecutionContext::ThreadSafeAgentUidMap::Locate(uint64_t index) {
+  // bucket b covers the indices [kBatchSize * (2^b - 1), kBatchSize *
+  // (2^(b+1) - 1)). Shifting the index by kBatchSize turns the bucket
+  // index into the position of the most significant bit.
+  auto shifted = index + kBatchSize;
+  auto msb = 63 - __builtin_clzll(shifted);
+  return {msb - kBatchSizeLog2, shifted - (uint64_t(1) << msb)};
+}
+
+typename InPlaceExecutionContext::ThreadSafeAgentUidMap::value_type*
+InPlaceExecutionContext::ThreadSafeAgentUidMap::GetOrCreateBucket(
+    uint64_t bucket) {
+  auto* result = buckets_[bucket].load(std::memory_order_acquire);
+  if (result != nullptr) {
+    return result;
+  }
+  // Buckets are allocated in order, such that Size() can stop at the first
+  // missing bucket.
+  for (uint64_t b = 0; b <= bucket; ++b) {
+    auto* current = buckets_[b].load(std::memory_order_acquire);
+    if (current != nullptr) {
+      continue;
+    }
+    auto* allocated = new value_type[GetBucketSize(b)]();
+    if (!buckets_[b].compare_exchange_strong(current, allocated,
+                                             std::memory_order_acq_rel)) {
+      // another thread was faster
+      delete[] allocated;
     }
-    delete[] non_atomic_batches;
   }
+  return buckets_[bucket].load(std::memory_order_acquire);
 }
 
 void InPlaceExecutionContext::ThreadSafeAgentUidMap::Insert(
     const AgentUid& uid,
     const typename InPlaceExecutionContext::ThreadSafeAgentUidMap::value_type&
         value) {
-  auto index = uid.GetIndex();
-  auto bidx = index / kBatchSize;
-  if (bidx >= num_batches_) {
-    auto new_size =
-        std::max(index, static_cast<uint32_t>(num_batches_ * kBatchSize * 1.1));
-    Resize(new_size);
-  }
-
-  auto el_idx = index % kBatchSize;
-  (*batches_.load()[bidx])[el_idx] = value;
+  auto location = Locate(uid.GetIndex());
+  GetOrCreateBucket(location.first)[location.second] = value;
 }
 
 const typename InPlaceExecutionContext::ThreadSafeAgentUidMap::value_type&
 InPlaceExecutionContext::ThreadSafeAgentUidMap::operator[](
     const AgentUid& uid) const {
   static InPlaceExecutionContext::ThreadSafeAgentUidMap::value_type kDefault;
-  auto index = uid.GetIndex();
-  auto bidx = index / kBatchSize;
-  if (bidx >= num_batches_) {
+  auto location = Locate(uid.GetIndex());
+  auto* bucket = buckets_[location.first].load(std::memory_order_acquire);
+  if (bucket == nullptr) {
     Log::Fatal("ThreadSafeAgentUidMap::operator[]",
                Concat("AgentUid out of range access: AgentUid: ", uid,
-                      ", ThreadSafeAgentUidMap max index ",
-                      num_batches_ * kBatchSize));
+                      ", ThreadSafeAgentUidMap max index ", Size()));
     return kDefault;
   }
-
-  auto el_idx = index % kBatchSize;
-  return (*batches_.load()[bidx])[el_idx];
+  return bucket[location.second];
 }
 
 uint64_t InPlaceExecutionContext::ThreadSafeAgentUidMap::Size() const {
-  return num_batches_ * kBatchSize;
-}
-
-void InPlaceExecutionContext::ThreadSafeAgentUidMap::Resize(uint64_t new_size) {
-  using Batch = InPlaceExecutionContext::ThreadSafeAgentUidMap::Batch;
-  auto new_num_batches = new_size / kBatchSize + 1;
-  std::lock_guard<Spinlock> guard(lock_);
-  if (new_num_batches >= num_batches_) {
-    auto bcopy = new Batch*[new_num_batches];
-    auto** non_atomic_batches = batches_.load();
-    for (uint64_t i = 0; i < new_num_batches; ++i) {
-      if (i < num_batches_) {
-        bcopy[i] = non_atomic_batches[i];
-      } else {
-        bcopy[i] = new Batch();
-        bcopy[i]->reserve(kBatchSize);
-      }
+  uint64_t size = 0;
+  for (uint64_t b = 0; b < kMaxBuckets; ++b) {
+    if (buckets_[b].load(std::memory_order_acquire) == nullptr) {
+      break;
     }
-    batches_.exchange(bcopy);
-    old_copies_.push_back(non_atomic_batches);
-    num_batches_ = new_num_batches;
+    size += GetBucketSize(b);
   }
+  return size;
 }
 
-void InPlaceExecutionContext::ThreadSafeAgentUidMap::DeleteOldCopies() {
-  for (auto& entry : old_copies_) {
-    if (entry != nullptr) {
-      delete[] entry;
-    }
+void InPlaceExecutionContext::ThreadSafeAgentUidMap::Resize(uint64_t new_size) {
+  if (new_size == 0) {
+    return;
   }
-  old_copies_.clear();
+  auto max_index = std::min<uint64_t>(
+      new_size - 1, std::numeric_limits<AgentUid::Index_t>::max());
+  GetOrCreateBucket(Locate(max_index).first);
 }
 
 InPlaceExecutionContext::InPlaceExecutionContext(
     const std::shared_ptr<ThreadSafeAgentUidMap>& map)
     : new_agent_map_(map), tinfo_(ThreadInfo::GetInstance()) {
-  new_agents_.reserve(1e3);
   cache_neighbors_ = Simulation::GetActive()->GetParam()->cache_neighbors;
 }
 
@@ -197,11 +210,7 @@ void InPlaceExecutionContext::Execute(
         locks_[i]->unlock();
       }
     }
-    neighbor_cache_.clear();
-    cached_squared_search_radius_ = 0;
-    for (auto& op : operations) {
-      (*op)(agent);
-    }
+    ExecuteOperations(agent, ah, operations);
     for (int i = locks_.size() - 1; i >= 0; --i) {
       locks_[i]->unlock();
     }
@@ -210,18 +219,14 @@ void InPlaceExecutionContext::Execute(
     auto* nb_mutex_builder = env->GetNeighborMutexBuilder();
     auto* mutex = nb_mutex_builder->GetMutex(agent->GetBoxIdx());
     std::lock_guard<decltype(*mutex)> guard(*mutex);
-    neighbor_cache_.clear();
-    cached_squared_search_radius_ = 0;
-    for (auto* op : operations) {
-      (*op)(agent);
-    }
+    ExecuteOperations(agent, ah, operations);
   } else if (param->thread_safety_mechanism ==
-             Param::ThreadSafetyMechanism::kNone) {
-    neighbor_cache_.clear();
-    cached_squared_search_radius_ = 0;
-    for (auto* op : operations) {
-      (*op)(agent);
-    }
+                 Param::ThreadSafetyMechanism::kNone ||
+             param->thread_safety_mechanism ==
+                 Param::ThreadSafetyMechanism::kBoxColoring) {
+    // kBoxColoring: the scheduler guarantees that no other thread processes
+    // an agent in the neighborhood of `agent`
+    ExecuteOperations(agent, ah, operations);
   } else {
     Log::Fatal("InPlaceExecutionContext::Execute",
                "Invalid value for parameter thread_safety_mechanism: ",
@@ -229,6 +234,15 @@ void InPlaceExecutionContext::Execute(
   }
 }
 
+void InPlaceExecutionContext::ExecuteOperations(
+    Agent* agent, AgentHandle ah, const std::vector<Operation*>& operations) {
+  neighbor_cache_.clear();
+  cached_squared_search_radius_ = 0;
+  for (auto* op : operations) {
+    (*op)(agent);
+  }
+}
+
 void InPlaceExecutionContext::AddAgent(Agent* new_agent) {
   new_agents_.push_back(new_agent);
   new_agent_map_->Insert(new_agent->GetUid(), new_agent);
@@ -297,6 +311,19 @@ void InPlaceExecutionContext::ForEachNeighbor(
   env->ForEachNeighbor(for_each, query_position, squared_radius);
 }
 
+void InPlaceExecutionContext::ForEachNeighborBatch(Agent* const* queries,
+                                                   uint64_t num_queries,
+                                                   real_t squared_radius,
+                                                   NeighborBatch* batch) {
+  auto* env = Simulation::GetActive()->GetEnvironment();
+  if (auto* grid = dynamic_cast<UniformGridEnvironment*>(env)) {
+    grid->ForEachNeighborBatch(queries, num_queries, squared_radius, batch);
+    return;
+  }
+  ExecutionContext::ForEachNeighborBatch(queries, num_queries, squared_radius,
+                                         batch);
+}
+
 Agent* InPlaceExecutionContext::GetAgent(const AgentUid& uid) {
   auto* sim = Simulation::GetActive();
   auto* rm = sim->GetResourceManager();
@@ -318,36 +345,44 @@ void InPlaceExecutionContext::RemoveAgent(const AgentUid& uid) {
 
 void InPlaceExecutionContext::AddAgentsToRm(
     const std::vector<ExecutionContext*>& all_exec_ctxts) {
-  // group execution contexts by numa domain
-  std::vector<uint64_t> new_agent_per_numa(tinfo_->GetNumaNodes());
-  std::vector<uint64_t> thread_offsets(tinfo_->GetMaxThreads());
-
+  // Determine the offset of each thread inside its numa domain with an
+  // exclusive prefix sum over the number of staged agents. The last element
+  // of each vector holds the total number of new agents in this numa domain.
+  auto num_numa_nodes = tinfo_->GetNumaNodes();
+  std::vector<std::vector<uint64_t>> thread_offsets(num_numa_nodes);
+  for (int n = 0; n < num_numa_nodes; ++n) {
+    thread_offsets[n].resize(tinfo_->GetThreadsInNumaNode(n) + 1);
+  }
   for (int tid = 0; tid < tinfo_->GetMaxThreads(); ++tid) {
     auto* ctxt = bdm_static_cast<InPlaceExecutionContext*>(all_exec_ctxts[tid]);
-    int nid = tinfo_->GetNumaNode(tid);
-    thread_offsets[tid] = new_agent_per_numa[nid];
-    new_agent_per_numa[nid] += ctxt->new_agents_.size();
+    auto nid = tinfo_->GetNumaNode(tid);
+    auto ntid = tinfo_->GetNumaThreadId(tid);
+    thread_offsets[nid][ntid] = ctxt->new_agents_.size();
+  }
+  for (auto& offsets : thread_offsets) {
+    ExclusivePrefixSum(&offsets, offsets.size() - 1);
   }
 
   // reserve enough memory in ResourceManager
-  std::vector<uint64_t> numa_offsets(tinfo_->GetNumaNodes());
+  std::vector<uint64_t> numa_offsets(num_numa_nodes);
   auto* rm = Simulation::GetActive()->GetResourceManager();
   rm->ResizeAgentUidMap();
-  for (unsigned n = 0; n < new_agent_per_numa.size(); n++) {
-    numa_offsets[n] = rm->GrowAgentContainer(new_agent_per_numa[n], n);
+  for (int n = 0; n < num_numa_nodes; n++) {
+    numa_offsets[n] = rm->GrowAgentContainer(thread_offsets[n].back(), n);
   }
 
-// add new_agents_ to the ResourceManager in parallel
+// Each thread commits its own buffer to its numa domain. Since the target
+// intervals do not overlap, no synchronization is required.
 #pragma omp parallel for schedule(static, 1)
   for (int i = 0; i < tinfo_->GetMaxThreads(); i++) {
     auto* ctxt = bdm_static_cast<InPlaceExecutionContext*>(all_exec_ctxts[i]);
-    int nid = tinfo_->GetNumaNode(i);
-    uint64_t offset = thread_offsets[i] + numa_offsets[nid];
+    auto nid = tinfo_->GetNumaNode(i);
+    auto ntid = tinfo_->GetNumaThreadId(i);
+    uint64_t offset = thread_offsets[nid][ntid] + numa_offsets[nid];
     rm->AddAgents(nid, offset, ctxt->new_agents_);
     ctxt->new_agents_.clear();
   }
 
-  new_agent_map_->DeleteOldCopies();
   if (rm->GetNumAgents() > new_agent_map_->Size()) {
     new_agent_map_->Resize(rm->GetNumAgents() * 1.5);
   }
@@ -25,6 +25,7 @@
 #include "core/agent/agent_pointer.h"
 #include "core/agent/agent_uid.h"
 #include "core/container/agent_uid_map.h"
+#include "core/container/append_buffer.h"
 #include "core/container/math_array.h"
 #include "core/execution_context/execution_context.h"
 #include "core/functor.h"
@@ -53,23 +54,38 @@ class InPlaceExecutionContext_NeighborCacheValidity_Test;
 /// Also removal of an agent happens at the end of each iteration.
 class InPlaceExecutionContext : public ExecutionContext {
  public:
+  /// Lookup table AgentUid -> Agent* that can be grown concurrently without
+  /// locks. Entries are stored in buckets whose size doubles with each
+  /// bucket index. Buckets are allocated on demand and published with a
+  /// compare-and-swap. Existing buckets are never moved or copied, therefore
+  /// concurrent readers never observe a stale batch array.
   struct ThreadSafeAgentUidMap {
     using value_type = Agent*;
-    using Batch = std::vector<value_type>;
     ThreadSafeAgentUidMap();
     ~ThreadSafeAgentUidMap();
 
     void Insert(const AgentUid& uid, const value_type& value);
     const value_type& operator[](const AgentUid& key) const;
+    /// Returns the number of elements that can be stored without allocating
+    /// a new bucket.
     uint64_t Size() const;
+    /// Allocates all buckets required to store `new_size` elements.
     void Resize(uint64_t new_size);
-    void DeleteOldCopies();
 
-    Spinlock lock_;
-    constexpr static uint64_t kBatchSize = 10240;
-    uint64_t num_batches_ = 0;
-    std::atomic<Batch**> batches_;
-    std::vector<Batch**> old_copies_;
+    /// Size of the first bucket. Must be a power of two.
+    constexpr static uint64_t kBatchSize = 16384;
+    constexpr static uint64_t kBatchSizeLog2 = 14;
+    /// Enough buckets to cover the whole range of AgentUid::Index_t
+    constexpr static uint64_t kMaxBuckets =
+        sizeof(AgentUid::Index_t) * 8 - kBatchSizeLog2 + 1;
+    std::atomic<value_type*> buckets_[kMaxBuckets];
+
+   private:
+    static uint64_t GetBucketSize(uint64_t bucket);
+    /// Returns the bucket index and the index within the bucket
+    static std::pair<uint64_t, uint64_t> Locate(uint64_t index);
+    /// Allocates the buckets [0, bucket] that do not exist yet.
+    value_type* GetOrCreateBucket(uint64_t bucket);
   };
 
   explicit InPlaceExecutionContext(
@@ -124,6 +140,10 @@ class InPlaceExecutionContext : public ExecutionContext {
                        const Real3& query_position,
                        real_t squared_radius) override;
 
+  void ForEachNeighborBatch(Agent* const* queries, uint64_t num_queries,
+                            real_t squared_radius,
+                            NeighborBatch* batch) override;
+
   void AddAgent(Agent* new_agent) override;
 
   void RemoveAgent(const AgentUid& uid) override;
@@ -141,8 +161,9 @@ class InPlaceExecutionContext : public ExecutionContext {
 
   ThreadInfo* tinfo_;
 
-  /// Pointer to new agents
-  std::vector<Agent*> new_agents_;
+  /// Pointer to new agents. Chunked, so that appending never moves already
+  /// staged agents and the memory is reused between iterations.
+  AppendBuffer<Agent*> new_agents_;
 
   /// Contains unique ids of agents that will be removed at the end of each
   /// iteration. AgentUids are separated by numa node.
@@ -162,6 +183,11 @@ class InPlaceExecutionContext : public ExecutionContext {
   /// being queried with (`query_squared_radius_`)
   bool IsNeighborCacheValid(real_t query_squared_radius) const;
 
+  /// Executes `operations` for `agent`. Called by `Execute` while the locks
+  /// of the selected thread-safety mechanism are held.
+  virtual void ExecuteOperations(Agent* agent, AgentHandle ah,
+                                 const std::vector<Operation*>& operations);
+
   virtual void AddAgentsToRm(
       const std::vector<ExecutionContext*>& all_exec_ctxts);
 
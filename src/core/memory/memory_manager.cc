@@ -13,8 +13,10 @@
 // -----------------------------------------------------------------------------
 
 #include "core/memory/memory_manager.h"
+#include <sys/mman.h>
 #include <unistd.h>
 #include <algorithm>
+#include <atomic>
 #include <cmath>
 #include <cstdlib>
 #include <limits>
@@ -132,6 +134,17 @@ uint64_t List::Size() const { return size_; }
 
 uint64_t List::GetN() const { return n_; }
 
+void List::PopAll(std::vector<Node*>* nodes) {
+  for (Node* node = head_; node != nullptr; node = node->next) {
+    nodes->push_back(node);
+  }
+  head_ = nullptr;
+  tail_ = nullptr;
+  skip_list_.clear();
+  size_ = 0;
+  nodes_before_skip_list_ = 0;
+}
+
 // -----------------------------------------------------------------------------
 bool AllocatedBlock::IsFullyInitialized() const {
   return initialized_until_ >= end_pointer_;
@@ -147,10 +160,17 @@ void AllocatedBlock::GetNextPageBatch(uint64_t size_n_pages, char** start,
   }
 }
 
+// -----------------------------------------------------------------------------
+uint64_t PoolStats::GetOverhead() const {
+  return bytes_allocated - bytes_in_use - bytes_free - bytes_uninitialized;
+}
+
 // -----------------------------------------------------------------------------
 NumaPoolAllocator::NumaPoolAllocator(uint64_t size, int nid,
                                      uint64_t size_n_pages, real_t growth_rate,
-                                     uint64_t max_mem_per_thread_factor)
+                                     uint64_t max_mem_per_thread_factor,
+                                     HugePagePolicy huge_pages,
+                                     NumaPolicy numa_policy)
     : size_n_pages_(size_n_pages),
       growth_rate_(growth_rate),
       max_nodes_per_thread_((size_n_pages_ - kMetadataSize) / size *
@@ -158,6 +178,8 @@ NumaPoolAllocator::NumaPoolAllocator(uint64_t size, int nid,
       num_elements_per_n_pages_((size_n_pages_ - kMetadataSize) / size),
       size_(size),
       nid_(nid),
+      huge_pages_(huge_pages),
+      numa_policy_(numa_policy),
       tinfo_(ThreadInfo::GetInstance()),
       central_(num_elements_per_n_pages_) {
   free_lists_.reserve(tinfo_->GetMaxThreads());
@@ -168,8 +190,7 @@ NumaPoolAllocator::NumaPoolAllocator(uint64_t size, int nid,
 
 NumaPoolAllocator::~NumaPoolAllocator() {
   for (auto& block : memory_blocks_) {
-    uint64_t size = block.end_pointer_ - block.start_pointer_;
-    numa_free(block.start_pointer_, size);
+    FreeMemoryBlock(block);
   }
 }
 
@@ -203,6 +224,9 @@ void* NumaPoolAllocator::New(int tid) {
     uint64_t size;
     memory_blocks_.back().GetNextPageBatch(size_n_pages_, &start_pointer,
                                            &size);
+    if (size >= kMetadataSize + size_) {
+      num_elements_initialized_ += (size - kMetadataSize) / size_;
+    }
     lock_.unlock();
     // remaining memory not enough to store one element
     if ((size - kMetadataSize) < size_) {
@@ -232,21 +256,204 @@ void NumaPoolAllocator::Delete(void* p) {
 
 uint64_t NumaPoolAllocator::GetSize() const { return size_; }
 
+void NumaPoolAllocator::SetNumaPolicy(NumaPolicy policy) {
+  std::lock_guard<Spinlock> guard(lock_);
+  numa_policy_ = policy;
+}
+
+PoolTlbStats NumaPoolAllocator::GetTlbStats(uint64_t page_size) const {
+  constexpr uint64_t kHugePageSize = MemoryManager::kHugePageSize;
+  std::lock_guard<Spinlock> guard(lock_);
+  PoolTlbStats stats;
+  stats.size = size_;
+  stats.numa_node = nid_;
+  stats.numa_policy = numa_policy_;
+  stats.num_blocks = memory_blocks_.size();
+  for (auto& block : memory_blocks_) {
+    if (block.huge_tlb_) {
+      stats.num_huge_tlb_blocks++;
+    }
+    auto first = RoundUpTo(reinterpret_cast<uint64_t>(block.start_pointer_),
+                           size_n_pages_);
+    auto last = reinterpret_cast<uint64_t>(
+        std::min(block.initialized_until_, block.end_pointer_));
+    if (last <= first) {
+      continue;
+    }
+    stats.pages_touched += (RoundUpTo(last, page_size) - first) / page_size;
+    stats.huge_pages_touched +=
+        (RoundUpTo(last, kHugePageSize) - (first & ~(kHugePageSize - 1))) /
+        kHugePageSize;
+  }
+  return stats;
+}
+
+PoolStats NumaPoolAllocator::GetStats() const {
+  std::lock_guard<Spinlock> guard(lock_);
+  PoolStats stats;
+  stats.size = size_;
+  stats.numa_node = nid_;
+  stats.num_blocks = memory_blocks_.size();
+  stats.bytes_allocated = total_size_;
+  stats.bytes_free_central = central_.Size() * size_;
+  stats.bytes_free = stats.bytes_free_central;
+  stats.bytes_free_per_thread.reserve(free_lists_.size());
+  for (auto& tl_list : free_lists_) {
+    stats.bytes_free_per_thread.push_back(tl_list.Size() * size_);
+    stats.bytes_free += stats.bytes_free_per_thread.back();
+  }
+  stats.bytes_in_use = num_elements_initialized_ * size_ - stats.bytes_free;
+  for (auto& block : memory_blocks_) {
+    if (!block.IsFullyInitialized()) {
+      stats.bytes_uninitialized +=
+          block.end_pointer_ - std::max(block.initialized_until_,
+                                        block.start_pointer_);
+    }
+  }
+  return stats;
+}
+
+uint64_t NumaPoolAllocator::Trim() {
+  std::lock_guard<Spinlock> guard(lock_);
+  if (memory_blocks_.empty()) {
+    return 0;
+  }
+
+  // sort blocks by address to map free elements to their block
+  std::vector<uint64_t> order(memory_blocks_.size());
+  for (uint64_t i = 0; i < order.size(); ++i) {
+    order[i] = i;
+  }
+  std::sort(order.begin(), order.end(), [&](uint64_t lhs, uint64_t rhs) {
+    return memory_blocks_[lhs].start_pointer_ <
+           memory_blocks_[rhs].start_pointer_;
+  });
+  auto find_block = [&](Node* node) {
+    auto* addr = reinterpret_cast<char*>(node);
+    auto it = std::upper_bound(
+        order.begin(), order.end(), addr, [&](char* a, uint64_t idx) {
+          return a < memory_blocks_[idx].start_pointer_;
+        });
+    assert(it != order.begin());
+    return *(--it);
+  };
+
+  // take all free elements out of the free lists and count them per block
+  std::vector<List*> lists;
+  for (auto& tl_list : free_lists_) {
+    lists.push_back(&tl_list);
+  }
+  lists.push_back(&central_);
+  std::vector<std::vector<Node*>> free_nodes(lists.size());
+  std::vector<uint64_t> num_free(memory_blocks_.size(), 0);
+  for (uint64_t i = 0; i < lists.size(); ++i) {
+    lists[i]->PopAll(&free_nodes[i]);
+    for (auto* node : free_nodes[i]) {
+      num_free[find_block(node)]++;
+    }
+  }
+
+  std::vector<bool> release(memory_blocks_.size());
+  for (uint64_t i = 0; i < memory_blocks_.size(); ++i) {
+    release[i] = num_free[i] == GetNumInitializedElements(memory_blocks_[i]);
+  }
+
+  // put back the elements of blocks that are still in use
+  for (uint64_t i = 0; i < lists.size(); ++i) {
+    auto& nodes = free_nodes[i];
+    for (auto it = nodes.rbegin(); it != nodes.rend(); ++it) {
+      if (!release[find_block(*it)]) {
+        lists[i]->PushFront(*it);
+      }
+    }
+  }
+
+  uint64_t released = 0;
+  std::vector<AllocatedBlock> remaining;
+  remaining.reserve(memory_blocks_.size());
+  for (uint64_t i = 0; i < memory_blocks_.size(); ++i) {
+    auto& block = memory_blocks_[i];
+    if (release[i]) {
+      uint64_t size = block.end_pointer_ - block.start_pointer_;
+      num_elements_initialized_ -= num_free[i];
+      total_size_ -= size;
+      released += size;
+      FreeMemoryBlock(block);
+    } else {
+      remaining.push_back(block);
+    }
+  }
+  memory_blocks_.swap(remaining);
+  return released;
+}
+
+void* NumaPoolAllocator::AllocHugeTlb(std::size_t size) {
+#ifdef MAP_HUGETLB
+  void* block = mmap(nullptr, size, PROT_READ | PROT_WRITE,
+                     MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+  if (block == MAP_FAILED) {
+    return nullptr;
+  }
+  // bind the memory before it is touched for the first time
+  if (numa_policy_ == NumaPolicy::kInterleave) {
+    numa_interleave_memory(block, size, numa_all_nodes_ptr);
+  } else {
+    numa_tonode_memory(block, size, nid_);
+  }
+  return block;
+#else
+  return nullptr;
+#endif  // MAP_HUGETLB
+}
+
 void NumaPoolAllocator::AllocNewMemoryBlock(std::size_t size) {
   // check if size is multiple of N pages aligned
   assert((size & (size_n_pages_ - 1)) == 0 &&
          "Size must be a multiple of MemoryManager::kSizeNPages");
-  void* block = numa_alloc_onnode(size, nid_);
+  constexpr uint64_t kHugePageSize = MemoryManager::kHugePageSize;
+  void* block = nullptr;
+  bool huge_tlb = false;
+  if (huge_pages_ != HugePagePolicy::kNone) {
+    size = RoundUpTo(size, kHugePageSize);
+  }
+  if (huge_pages_ == HugePagePolicy::kExplicit) {
+    block = AllocHugeTlb(size);
+    huge_tlb = block != nullptr;
+    static std::atomic<bool> warning_issued(false);
+    if (!huge_tlb && !warning_issued.exchange(true)) {
+      Log::Warning("NumaPoolAllocator::AllocNewMemoryBlock",
+                   "Explicit huge pages are not available. Falling back ",
+                   "to transparent huge pages.");
+    }
+  }
+  if (block == nullptr) {
+    if (numa_policy_ == NumaPolicy::kInterleave) {
+      block = numa_alloc_interleaved(size);
+    } else {
+      block = numa_alloc_onnode(size, nid_);
+    }
+  }
   if (block == nullptr) {
     Log::Fatal("NumaPoolAllocator::AllocNewMemoryBlock", "Allocation failed");
   }
+#ifdef MADV_HUGEPAGE
+  if (!huge_tlb && huge_pages_ != HugePagePolicy::kNone) {
+    // only the 2 MB aligned part of the block can be backed by huge pages
+    auto begin = RoundUpTo(reinterpret_cast<uint64_t>(block), kHugePageSize);
+    auto end = (reinterpret_cast<uint64_t>(block) + size) &
+               ~(kHugePageSize - 1);
+    if (end > begin) {
+      madvise(reinterpret_cast<void*>(begin), end - begin, MADV_HUGEPAGE);
+    }
+  }
+#endif  // MADV_HUGEPAGE
   total_size_ += size;
   auto n_pages_aligned =
       RoundUpTo(reinterpret_cast<uint64_t>(block), size_n_pages_);
   auto* start = reinterpret_cast<char*>(block);
   char* end = start + size;
   memory_blocks_.push_back(
-      {start, end, reinterpret_cast<char*>(n_pages_aligned)});
+      {start, end, reinterpret_cast<char*>(n_pages_aligned), huge_tlb});
 }
 
 void NumaPoolAllocator::InitializeNPages(List* tl_list, char* block,
@@ -264,6 +471,7 @@ void NumaPoolAllocator::InitializeNPages(List* tl_list, char* block,
     auto* head = new (pointer) Node();
     assert(head->next == nullptr);
     auto* tail = head;
+    pointer += size_;
 
     for (uint64_t i = 1; i < num_elements; ++i) {
       assert(pointer >= static_cast<char*>(block));
@@ -286,6 +494,32 @@ void NumaPoolAllocator::InitializeNPages(List* tl_list, char* block,
   }
 }
 
+uint64_t NumaPoolAllocator::GetNumInitializedElements(
+    const AllocatedBlock& block) const {
+  uint64_t num_elements = 0;
+  auto* end = std::min(block.initialized_until_, block.end_pointer_);
+  auto* batch = reinterpret_cast<char*>(
+      RoundUpTo(reinterpret_cast<uint64_t>(block.start_pointer_),
+                size_n_pages_));
+  for (; batch < end; batch += size_n_pages_) {
+    uint64_t batch_size =
+        std::min<uint64_t>(size_n_pages_, block.end_pointer_ - batch);
+    if (batch_size >= kMetadataSize + size_) {
+      num_elements += (batch_size - kMetadataSize) / size_;
+    }
+  }
+  return num_elements;
+}
+
+void NumaPoolAllocator::FreeMemoryBlock(const AllocatedBlock& block) {
+  uint64_t size = block.end_pointer_ - block.start_pointer_;
+  if (block.huge_tlb_) {
+    munmap(block.start_pointer_, size);
+  } else {
+    numa_free(block.start_pointer_, size);
+  }
+}
+
 uint64_t NumaPoolAllocator::RoundUpTo(uint64_t number, uint64_t multiple) {
   assert((multiple & (multiple - 1)) == 0 && multiple &&
          "multiple must be a power of two and non-zero");
@@ -296,12 +530,14 @@ uint64_t NumaPoolAllocator::RoundUpTo(uint64_t number, uint64_t multiple) {
 // -----------------------------------------------------------------------------
 PoolAllocator::PoolAllocator(std::size_t size, uint64_t size_n_pages,
                              real_t growth_rate,
-                             uint64_t max_mem_per_thread_factor)
+                             uint64_t max_mem_per_thread_factor,
+                             HugePagePolicy huge_pages, NumaPolicy numa_policy)
     : size_(size), tinfo_(ThreadInfo::GetInstance()) {
   for (int nid = 0; nid < tinfo_->GetNumaNodes(); ++nid) {
     void* ptr = numa_alloc_onnode(sizeof(NumaPoolAllocator), nid);
     numa_allocators_.push_back(new (ptr) NumaPoolAllocator(
-        size, nid, size_n_pages, growth_rate, max_mem_per_thread_factor));
+        size, nid, size_n_pages, growth_rate, max_mem_per_thread_factor,
+        huge_pages, numa_policy));
   }
 }
 
@@ -326,16 +562,81 @@ void* PoolAllocator::New(std::size_t size) {
   return numa_allocators_[nid]->New(tid);
 }
 
+void PoolAllocator::SetNumaPolicy(NumaPolicy policy) {
+  for (auto* el : numa_allocators_) {
+    el->SetNumaPolicy(policy);
+  }
+}
+
+void PoolAllocator::GetStats(std::vector<PoolStats>* stats) const {
+  for (auto* el : numa_allocators_) {
+    stats->push_back(el->GetStats());
+  }
+}
+
+uint64_t PoolAllocator::Trim() {
+  uint64_t released = 0;
+  for (auto* el : numa_allocators_) {
+    released += el->Trim();
+  }
+  return released;
+}
+
+void PoolAllocator::GetTlbStats(uint64_t page_size,
+                                std::vector<PoolTlbStats>* stats) const {
+  for (auto* el : numa_allocators_) {
+    stats->push_back(el->GetTlbStats(page_size));
+  }
+}
+
 }  // namespace memory_manager_detail
 
+// -----------------------------------------------------------------------------
+uint64_t MemoryManagerStats::GetOverhead() const {
+  return bytes_allocated - bytes_in_use - bytes_free - bytes_uninitialized;
+}
+
+std::ostream& operator<<(std::ostream& str, const MemoryManagerStats& stats) {
+  str << "MemoryManager statistics (bytes):\n";
+  str << "  allocated:     " << stats.bytes_allocated << "\n";
+  str << "  in use:        " << stats.bytes_in_use << "\n";
+  str << "  free:          " << stats.bytes_free << "\n";
+  str << "  uninitialized: " << stats.bytes_uninitialized << "\n";
+  str << "  overhead:      " << stats.GetOverhead() << "\n";
+  str << "  blocks:        " << stats.num_blocks << "\n";
+  for (uint64_t nid = 0; nid < stats.bytes_allocated_per_numa_node.size();
+       ++nid) {
+    str << "  numa node " << nid
+        << ": allocated=" << stats.bytes_allocated_per_numa_node[nid]
+        << " in use=" << stats.bytes_in_use_per_numa_node[nid] << "\n";
+  }
+  for (uint64_t tid = 0; tid < stats.bytes_free_per_thread.size(); ++tid) {
+    str << "  thread " << tid << ": free=" << stats.bytes_free_per_thread[tid]
+        << "\n";
+  }
+  for (auto& pool : stats.pools) {
+    str << "  size class " << pool.size << " numa node " << pool.numa_node
+        << ": blocks=" << pool.num_blocks
+        << " allocated=" << pool.bytes_allocated
+        << " in use=" << pool.bytes_in_use << " free=" << pool.bytes_free
+        << " (central=" << pool.bytes_free_central << ")"
+        << " uninitialized=" << pool.bytes_uninitialized << "\n";
+  }
+  return str;
+}
+
 // -----------------------------------------------------------------------------
 MemoryManager::MemoryManager(uint64_t aligned_pages_shift, real_t growth_rate,
-                             uint64_t max_mem_per_thread_factor)
+                             uint64_t max_mem_per_thread_factor,
+                             HugePagePolicy huge_pages,
+                             uint64_t interleave_min_size)
     : growth_rate_(growth_rate),
       max_mem_per_thread_factor_(max_mem_per_thread_factor),
       page_size_(sysconf(_SC_PAGESIZE)),
       page_shift_(static_cast<uint64_t>(std::log2(page_size_))),
-      num_threads_(ThreadInfo::GetInstance()->GetMaxThreads()) {
+      num_threads_(ThreadInfo::GetInstance()->GetMaxThreads()),
+      huge_pages_(huge_pages),
+      interleave_min_size_(interleave_min_size) {
   aligned_pages_shift_ = aligned_pages_shift;
   aligned_pages_ = (1 << aligned_pages_shift_);
   size_n_pages_ = (1 << (page_shift_ + aligned_pages_shift_));
@@ -364,10 +665,7 @@ void* MemoryManager::New(std::size_t size) {
       std::lock_guard<Spinlock> guard(lock_);
       // check again, another thread might have created it in between
       if (allocators_.find(size) == allocators_.end()) {
-        allocators_.insert(
-            std::make_pair(size, new memory_manager_detail::PoolAllocator(
-                                     size, size_n_pages_, growth_rate_,
-                                     max_mem_per_thread_factor_)));
+        allocators_.insert(std::make_pair(size, CreatePoolAllocator(size)));
       }
       return New(size);
     }
@@ -377,10 +675,7 @@ void* MemoryManager::New(std::size_t size) {
     if (it != allocators_.end()) {
       return it->second->New(size);
     } else {
-      allocators_.insert(std::make_pair(
-          size,
-          new memory_manager_detail::PoolAllocator(
-              size, size_n_pages_, growth_rate_, max_mem_per_thread_factor_)));
+      allocators_.insert(std::make_pair(size, CreatePoolAllocator(size)));
       return allocators_.find(size)->second;
     }
   }
@@ -401,4 +696,80 @@ void MemoryManager::Delete(void* p) {
 
 void MemoryManager::SetIgnoreDelete(bool value) { ignore_delete_ = value; }
 
+void MemoryManager::SetNumaPolicy(std::size_t size, NumaPolicy policy) {
+  std::lock_guard<Spinlock> guard(lock_);
+  numa_policies_[size] = policy;
+  auto it = allocators_.find(size);
+  if (it != allocators_.end()) {
+    it->second->SetNumaPolicy(policy);
+  }
+}
+
+NumaPolicy MemoryManager::GetNumaPolicy(std::size_t size) const {
+  auto it = numa_policies_.find(size);
+  if (it != numa_policies_.end()) {
+    return it->second;
+  }
+  if (interleave_min_size_ != 0 && size >= interleave_min_size_) {
+    return NumaPolicy::kInterleave;
+  }
+  return NumaPolicy::kLocal;
+}
+
+HugePagePolicy MemoryManager::GetHugePagePolicy() const { return huge_pages_; }
+
+std::vector<memory_manager_detail::PoolTlbStats> MemoryManager::GetTlbStats()
+    const {
+  std::lock_guard<Spinlock> guard(lock_);
+  std::vector<memory_manager_detail::PoolTlbStats> stats;
+  for (auto& pair : allocators_) {
+    pair.second->GetTlbStats(page_size_, &stats);
+  }
+  return stats;
+}
+
+MemoryManagerStats MemoryManager::GetStats() const {
+  auto* tinfo = ThreadInfo::GetInstance();
+  MemoryManagerStats stats;
+  stats.bytes_allocated_per_numa_node.resize(tinfo->GetNumaNodes(), 0);
+  stats.bytes_in_use_per_numa_node.resize(tinfo->GetNumaNodes(), 0);
+  stats.bytes_free_per_thread.resize(tinfo->GetMaxThreads(), 0);
+  {
+    std::lock_guard<Spinlock> guard(lock_);
+    for (auto& pair : allocators_) {
+      pair.second->GetStats(&stats.pools);
+    }
+  }
+  for (auto& pool : stats.pools) {
+    stats.num_blocks += pool.num_blocks;
+    stats.bytes_allocated += pool.bytes_allocated;
+    stats.bytes_in_use += pool.bytes_in_use;
+    stats.bytes_free += pool.bytes_free;
+    stats.bytes_uninitialized += pool.bytes_uninitialized;
+    stats.bytes_allocated_per_numa_node[pool.numa_node] +=
+        pool.bytes_allocated;
+    stats.bytes_in_use_per_numa_node[pool.numa_node] += pool.bytes_in_use;
+    for (uint64_t tid = 0; tid < pool.bytes_free_per_thread.size(); ++tid) {
+      stats.bytes_free_per_thread[tid] += pool.bytes_free_per_thread[tid];
+    }
+  }
+  return stats;
+}
+
+uint64_t MemoryManager::Trim() {
+  std::lock_guard<Spinlock> guard(lock_);
+  uint64_t released = 0;
+  for (auto& pair : allocators_) {
+    released += pair.second->Trim();
+  }
+  return released;
+}
+
+memory_manager_detail::PoolAllocator* MemoryManager::CreatePoolAllocator(
+    std::size_t size) {
+  return new memory_manager_detail::PoolAllocator(
+      size, size_n_pages_, growth_rate_, max_mem_per_thread_factor_,
+      huge_pages_, GetNumaPolicy(size));
+}
+
 }  // namespace bdm
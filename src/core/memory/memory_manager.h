@@ -17,6 +17,8 @@
 
 #include <cassert>
 #include <list>
+#include <ostream>
+#include <unordered_map>
 #include <utility>
 #include <vector>
 
@@ -27,6 +29,28 @@
 #include "core/util/thread_info.h"
 
 namespace bdm {
+
+/// Specifies how the memory blocks that the pool allocators request from the
+/// operating system are backed.
+enum class HugePagePolicy {
+  /// Use the default page size of the system.
+  kNone,
+  /// Allocate 2 MB multiples and advise the kernel to back them with
+  /// transparent huge pages (`madvise(MADV_HUGEPAGE)`).
+  kTransparent,
+  /// Request explicit huge pages (`mmap(MAP_HUGETLB)`). Falls back to
+  /// `kTransparent` if no huge pages are reserved on the system.
+  kExplicit
+};
+
+/// Specifies on which NUMA nodes the memory blocks of a size class are placed.
+enum class NumaPolicy {
+  /// Place the memory on the NUMA node of the allocating pool.
+  kLocal,
+  /// Interleave the memory pages across all NUMA nodes.
+  kInterleave
+};
+
 namespace memory_manager_detail {
 
 struct Node {
@@ -67,6 +91,10 @@ class List {
 
   uint64_t GetN() const;
 
+  /// Removes all nodes from the list and appends them to `nodes` in list
+  /// order.
+  void PopAll(std::vector<Node*>* nodes);
+
  private:
   Node* head_ = nullptr;
   Node* tail_ = nullptr;
@@ -88,6 +116,47 @@ struct AllocatedBlock {
   char* end_pointer_;
   /// Memory to the left has been initialized.
   char* initialized_until_;
+  /// True if the block was allocated with `mmap(MAP_HUGETLB)`.
+  bool huge_tlb_ = false;
+};
+
+/// Statistics that determine the TLB footprint of one NumaPoolAllocator.
+struct PoolTlbStats {
+  /// Allocation size of the pool
+  uint64_t size = 0;
+  int numa_node = 0;
+  NumaPolicy numa_policy = NumaPolicy::kLocal;
+  uint64_t num_blocks = 0;
+  /// Number of blocks that are backed by explicit huge pages
+  uint64_t num_huge_tlb_blocks = 0;
+  /// Number of base pages that have been handed out to the free lists
+  uint64_t pages_touched = 0;
+  /// Number of 2 MB regions spanned by the touched pages. Lower bound for
+  /// the number of dTLB entries needed if huge pages are used.
+  uint64_t huge_pages_touched = 0;
+};
+
+/// Memory statistics of one NumaPoolAllocator.
+struct PoolStats {
+  /// Allocation size of the pool
+  uint64_t size = 0;
+  int numa_node = 0;
+  uint64_t num_blocks = 0;
+  /// Bytes requested from the operating system
+  uint64_t bytes_allocated = 0;
+  /// Bytes of elements that are currently handed out
+  uint64_t bytes_in_use = 0;
+  /// Bytes of elements in the free lists (thread-local and central)
+  uint64_t bytes_free = 0;
+  /// Bytes of elements in the central free list
+  uint64_t bytes_free_central = 0;
+  /// Bytes of elements in the free list of each thread
+  std::vector<uint64_t> bytes_free_per_thread;
+  /// Bytes that have not been handed out to the free lists yet
+  uint64_t bytes_uninitialized = 0;
+
+  /// Bytes used for metadata and padding
+  uint64_t GetOverhead() const;
 };
 
 /// Pool allocator for a specific allocation size and numa node. \n
@@ -96,7 +165,9 @@ class NumaPoolAllocator {
   static uint64_t RoundUpTo(uint64_t number, uint64_t multiple);
 
   NumaPoolAllocator(uint64_t size, int nid, uint64_t size_n_pages,
-                    real_t growth_rate, uint64_t max_mem_per_thread_factor);
+                    real_t growth_rate, uint64_t max_mem_per_thread_factor,
+                    HugePagePolicy huge_pages = HugePagePolicy::kNone,
+                    NumaPolicy numa_policy = NumaPolicy::kLocal);
 
   ~NumaPoolAllocator();
 
@@ -106,6 +177,20 @@ class NumaPoolAllocator {
 
   uint64_t GetSize() const;
 
+  /// Changes the NUMA policy for memory blocks allocated in the future.
+  void SetNumaPolicy(NumaPolicy policy);
+
+  PoolTlbStats GetTlbStats(uint64_t page_size) const;
+
+  /// Values of thread-local free lists are only accurate if no other thread
+  /// allocates or frees memory concurrently.
+  PoolStats GetStats() const;
+
+  /// Returns memory blocks whose elements are all free to the operating
+  /// system. Must not be called concurrently with `New` or `Delete`.
+  /// \return number of bytes that have been released
+  uint64_t Trim();
+
  private:
   static constexpr uint64_t kMetadataSize = 8;
   uint64_t size_n_pages_;
@@ -113,23 +198,39 @@ class NumaPoolAllocator {
   uint64_t max_nodes_per_thread_;
   uint64_t num_elements_per_n_pages_;
   uint64_t total_size_ = 0;
+  /// Number of elements that have been handed out to the free lists
+  uint64_t num_elements_initialized_ = 0;
   uint64_t size_;
   int nid_;
+  HugePagePolicy huge_pages_;
+  NumaPolicy numa_policy_;
   ThreadInfo* tinfo_;
   std::vector<AllocatedBlock> memory_blocks_;
   std::vector<List> free_lists_;  // one per thread
   List central_;
-  Spinlock lock_;
+  mutable Spinlock lock_;
 
   void AllocNewMemoryBlock(std::size_t size);
 
+  /// Allocates `size` bytes backed by explicit huge pages.
+  /// Returns nullptr if the system cannot provide them.
+  void* AllocHugeTlb(std::size_t size);
+
   void InitializeNPages(List* tl_list, char* block, uint64_t mem_block_size);
+
+  /// Returns the number of elements that have been handed out to the free
+  /// lists from `block`.
+  uint64_t GetNumInitializedElements(const AllocatedBlock& block) const;
+
+  void FreeMemoryBlock(const AllocatedBlock& block);
 };
 
 class PoolAllocator {
  public:
   PoolAllocator(std::size_t size, uint64_t size_n_pages, real_t growth_rate,
-                uint64_t max_mem_per_thread_factor);
+                uint64_t max_mem_per_thread_factor,
+                HugePagePolicy huge_pages = HugePagePolicy::kNone,
+                NumaPolicy numa_policy = NumaPolicy::kLocal);
 
   PoolAllocator(PoolAllocator&& other) noexcept;
   PoolAllocator(const PoolAllocator& other) = delete;
@@ -138,6 +239,16 @@ class PoolAllocator {
 
   void* New(std::size_t size);
 
+  void SetNumaPolicy(NumaPolicy policy);
+
+  /// Appends the statistics of each NumaPoolAllocator to `stats`.
+  void GetTlbStats(uint64_t page_size, std::vector<PoolTlbStats>* stats) const;
+
+  /// Appends the statistics of each NumaPoolAllocator to `stats`.
+  void GetStats(std::vector<PoolStats>* stats) const;
+
+  uint64_t Trim();
+
  private:
   std::size_t size_;
   ThreadInfo* tinfo_;
@@ -146,10 +257,36 @@ class PoolAllocator {
 
 }  // namespace memory_manager_detail
 
+/// Memory statistics of the MemoryManager. Contains one entry per size class
+/// and NUMA node, together with the aggregated values.
+struct MemoryManagerStats {
+  std::vector<memory_manager_detail::PoolStats> pools;
+  uint64_t num_blocks = 0;
+  uint64_t bytes_allocated = 0;
+  uint64_t bytes_in_use = 0;
+  uint64_t bytes_free = 0;
+  uint64_t bytes_uninitialized = 0;
+  std::vector<uint64_t> bytes_allocated_per_numa_node;
+  std::vector<uint64_t> bytes_in_use_per_numa_node;
+  std::vector<uint64_t> bytes_free_per_thread;
+
+  /// Bytes used for metadata and padding
+  uint64_t GetOverhead() const;
+};
+
+std::ostream& operator<<(std::ostream& str, const MemoryManagerStats& stats);
+
 class MemoryManager {
  public:
+  static constexpr uint64_t kHugePageSize = 2 * 1024 * 1024;
+
+  /// \param interleave_min_size Size classes with an allocation size greater
+  ///        or equal to this value use `NumaPolicy::kInterleave`.
+  ///        Zero disables interleaving.
   MemoryManager(uint64_t aligned_pages_shift, real_t growth_rate,
-                uint64_t max_mem_per_thread_factor);
+                uint64_t max_mem_per_thread_factor,
+                HugePagePolicy huge_pages = HugePagePolicy::kNone,
+                uint64_t interleave_min_size = 0);
 
   ~MemoryManager();
 
@@ -159,6 +296,29 @@ class MemoryManager {
 
   void SetIgnoreDelete(bool value);
 
+  /// Overrides the NUMA policy of size class `size`. Affects memory blocks
+  /// that are allocated after this call. Must not be called concurrently
+  /// with `New`.
+  void SetNumaPolicy(std::size_t size, NumaPolicy policy);
+
+  NumaPolicy GetNumaPolicy(std::size_t size) const;
+
+  HugePagePolicy GetHugePagePolicy() const;
+
+  /// Returns the TLB relevant statistics of all pools (one entry per size
+  /// class and NUMA node).
+  std::vector<memory_manager_detail::PoolTlbStats> GetTlbStats() const;
+
+  /// Returns the memory statistics of all pools. Values of thread-local free
+  /// lists are only accurate if no other thread allocates or frees memory
+  /// concurrently.
+  MemoryManagerStats GetStats() const;
+
+  /// Returns memory blocks whose elements are all free to the operating
+  /// system. Must not be called concurrently with `New` or `Delete`.
+  /// \return number of bytes that have been released
+  uint64_t Trim();
+
  private:
   real_t growth_rate_;
   uint64_t max_mem_per_thread_factor_;
@@ -168,12 +328,18 @@ class MemoryManager {
   uint64_t aligned_pages_;
   uint64_t size_n_pages_;
   uint64_t num_threads_;
+  HugePagePolicy huge_pages_;
+  uint64_t interleave_min_size_;
   bool ignore_delete_ = false;
 
   UnorderedFlatmap<std::size_t, memory_manager_detail::PoolAllocator*>
       allocators_;
+  /// Size classes whose NUMA policy has been set explicitly
+  std::unordered_map<std::size_t, NumaPolicy> numa_policies_;
 
-  Spinlock lock_;
+  mutable Spinlock lock_;
+
+  memory_manager_detail::PoolAllocator* CreatePoolAllocator(std::size_t size);
 };
 
 }  // namespace bdm
@@ -13,9 +13,11 @@
 // -----------------------------------------------------------------------------
 
 #include "core/model_initializer.h"
+#include "core/diffusion/adi_grid.h"
 #include "core/diffusion/diffusion_grid.h"
 #include "core/diffusion/euler_depletion_grid.h"
 #include "core/diffusion/euler_grid.h"
+#include "core/diffusion/sparse_euler_grid.h"
 #include "core/util/log.h"
 
 namespace bdm {
@@ -56,6 +58,22 @@ void ModelInitializer::DefineSubstance(
       dgrid = new EulerGrid(substance_id, substance_name, diffusion_coeff,
                             decay_constant, resolution);
     }
+  } else if (param->diffusion_method == "adi") {
+    if (!binding_substances.empty()) {
+      Log::Fatal("ModelInitializer::DefineSubstance",
+                 "Binding substances are not supported by the diffusion ",
+                 "method 'adi'. Use 'euler' instead.");
+    }
+    dgrid = new AdiGrid(substance_id, substance_name, diffusion_coeff,
+                        decay_constant, resolution);
+  } else if (param->diffusion_method == "sparse_euler") {
+    if (!binding_substances.empty()) {
+      Log::Fatal("ModelInitializer::DefineSubstance",
+                 "Binding substances are not supported by the diffusion ",
+                 "method 'sparse_euler'. Use 'euler' instead.");
+    }
+    dgrid = new SparseEulerGrid(substance_id, substance_name, diffusion_coeff,
+                                decay_constant, resolution);
   } else {
     Log::Error("ModelInitializer::DefineSubstance", "Diffusion method '",
                param->diffusion_method,
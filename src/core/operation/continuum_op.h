@@ -15,12 +15,17 @@
 #ifndef CORE_OPERATION_DIFFUSION_OP_H_
 #define CORE_OPERATION_DIFFUSION_OP_H_
 
+#include <omp.h>
+#include <algorithm>
 #include <string>
 #include <utility>
 #include <vector>
 
 #include "core/container/inline_vector.h"
 #include "core/diffusion/diffusion_grid.h"
+#include "core/diffusion/euler_depletion_grid.h"
+#include "core/diffusion/euler_grid.h"
+#include "core/diffusion/sparse_euler_grid.h"
 #include "core/environment/environment.h"
 #include "core/operation/operation.h"
 #include "core/operation/operation_registry.h"
@@ -40,7 +45,6 @@ class ContinuumOp : public StandaloneOperationImpl {
     // Get active simulation and related pointers
     auto* sim = Simulation::GetActive();
     const auto* rm = sim->GetResourceManager();
-    const auto* env = sim->GetEnvironment();
     const auto* param = sim->GetParam();
 
     // Compute the passed time to update the diffusion grid accordingly.
@@ -53,25 +57,165 @@ class ContinuumOp : public StandaloneOperationImpl {
       return;
     }
 
-    rm->ForEachContinuum([this, &env, &param](Continuum* cm) {
-      // Update the diffusion grid dimension if the environment dimensions
-      // have changed. If the space is bound, we do not need to update the
-      // dimensions, because these should not be changing anyway
+    if (param->fuse_diffusion_grids) {
+      IntegrateFused();
+      return;
+    }
+
+    std::vector<Continuum*> continua;
+    rm->ForEachContinuum([&](Continuum* cm) { continua.push_back(cm); });
+    if (param->parallel_standalone_ops && AreIndependent(continua)) {
+      IntegrateConcurrently(continua);
+      return;
+    }
+    for (auto* cm : continua) {
+      Integrate(cm);
+    }
+  }
+
+  OpDataAccess GetDataAccess() const override {
+    return {{{OpResource::kAgents}, {OpResource::kEnvironment}},
+            {{OpResource::kContinuum}}};
+  }
+
+ private:
+  /// Euler grids that are advanced together with `EulerGrid::DiffuseFused`.
+  struct FusedGroup {
+    std::vector<EulerGrid*> grids;
+    int n_steps = 0;
+    real_t step_dt = 0;
+  };
+
+  /// Advances continuum `cm` by `delta_t_`
+  void Integrate(Continuum* cm) {
+    auto* sim = Simulation::GetActive();
+    const auto* env = sim->GetEnvironment();
+    const auto* param = sim->GetParam();
+    // Update the diffusion grid dimension if the environment dimensions
+    // have changed. If the space is bound, we do not need to update the
+    // dimensions, because these should not be changing anyway
+    if (env->HasGrown() &&
+        param->bound_space == Param::BoundSpaceMode::kOpen) {
+      cm->Update();
+    }
+    cm->IntegrateTimeAsynchronously(delta_t_);
+    auto* dgrid = dynamic_cast<DiffusionGrid*>(cm);
+    if (dgrid && param->calculate_gradients) {
+      dgrid->CalculateGradient();
+    }
+  }
+
+  /// Returns true if there are at least two continua and each of them only
+  /// accesses its own data. Depletion grids read the concentration of other
+  /// grids, and the data accessed by user-defined continua is unknown.
+  static bool AreIndependent(const std::vector<Continuum*>& continua) {
+    if (continua.size() < 2) {
+      return false;
+    }
+    for (auto* cm : continua) {
+      if (dynamic_cast<DiffusionGrid*>(cm) == nullptr ||
+          dynamic_cast<EulerDepletionGrid*>(cm) != nullptr) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  /// Integrates independent continua concurrently
+  /// (see `Param::parallel_standalone_ops`). If this operation runs
+  /// concurrently with other operations, each continuum is integrated in a
+  /// task of the current team. Otherwise, the threads are divided between
+  /// the continua.
+  void IntegrateConcurrently(const std::vector<Continuum*>& continua) {
+    if (omp_in_parallel()) {
+#pragma omp taskgroup
+      {
+        for (auto* cm : continua) {
+#pragma omp task firstprivate(cm)
+          Integrate(cm);
+        }
+      }
+      return;
+    }
+    const int num_threads = omp_get_max_threads();
+    const int num_teams =
+        std::min(static_cast<int>(continua.size()), num_threads);
+    const int threads_per_team = std::max(1, num_threads / num_teams);
+    const int max_active_levels = omp_get_max_active_levels();
+    omp_set_max_active_levels(std::max(max_active_levels, 2));
+#pragma omp parallel for num_threads(num_teams) schedule(dynamic, 1)
+    for (size_t i = 0; i < continua.size(); ++i) {
+      // Only affects the parallel regions of this thread
+      omp_set_num_threads(threads_per_team);
+      Integrate(continua[i]);
+    }
+    omp_set_max_active_levels(max_active_levels);
+  }
+
+  /// Same as the loop in `operator()`, but compatible `EulerGrid`s that are
+  /// due for the same number of steps are integrated in a fused kernel (see
+  /// `Param::fuse_diffusion_grids`). All other continua, including
+  /// `SparseEulerGrid`s, are integrated individually.
+  void IntegrateFused() {
+    auto* sim = Simulation::GetActive();
+    const auto* rm = sim->GetResourceManager();
+    const auto* env = sim->GetEnvironment();
+    const auto* param = sim->GetParam();
+
+    if (param->diffusion_temporal_blocking > 1 && !warned_temporal_blocking_) {
+      Log::Warning("ContinuumOp::IntegrateFused",
+                   "The parameters fuse_diffusion_grids and "
+                   "diffusion_temporal_blocking are mutually exclusive. "
+                   "Fused grids are advanced one time step per pass.");
+      warned_temporal_blocking_ = true;
+    }
+
+    std::vector<FusedGroup> groups;
+    rm->ForEachContinuum([&](Continuum* cm) {
       if (env->HasGrown() &&
           param->bound_space == Param::BoundSpaceMode::kOpen) {
         cm->Update();
       }
-      cm->IntegrateTimeAsynchronously(delta_t_);
-      auto* dgrid = dynamic_cast<DiffusionGrid*>(cm);
-      if (dgrid && param->calculate_gradients) {
-        dgrid->CalculateGradient();
+      auto* egrid = dynamic_cast<EulerGrid*>(cm);
+      if (egrid == nullptr || egrid->IsFixedSubstance() ||
+          dynamic_cast<SparseEulerGrid*>(cm) != nullptr) {
+        cm->IntegrateTimeAsynchronously(delta_t_);
+        auto* dgrid = dynamic_cast<DiffusionGrid*>(cm);
+        if (dgrid && param->calculate_gradients) {
+          dgrid->CalculateGradient();
+        }
+        return;
+      }
+      real_t step_dt{0};
+      int n_steps = egrid->ScheduleTimeSteps(delta_t_, &step_dt);
+      auto it = std::find_if(groups.begin(), groups.end(), [&](auto& group) {
+        return group.n_steps == n_steps && group.step_dt == step_dt &&
+               egrid->CanFuseWith(*group.grids[0]);
+      });
+      if (it == groups.end()) {
+        groups.push_back({{egrid}, n_steps, step_dt});
+      } else {
+        it->grids.push_back(egrid);
       }
     });
+
+    for (auto& group : groups) {
+      if (group.n_steps > 0) {
+        EulerGrid::DiffuseFused(group.grids, group.step_dt, group.n_steps);
+      }
+      for (auto* egrid : group.grids) {
+        egrid->CompleteTimeSteps(group.n_steps, group.step_dt);
+      }
+      if (param->calculate_gradients) {
+        EulerGrid::CalculateGradientFused(group.grids);
+      }
+    }
   }
 
- private:
   /// Last time when the operation was executed
   real_t last_time_run_ = 0.0;
+  /// Prevents repeating the warning of `IntegrateFused`
+  bool warned_temporal_blocking_ = false;
   /// Timestep that is useded for `Diffuse(delta_t)` and computed from this and
   /// the last time the grid was updated.
   real_t delta_t_ = 0.0;
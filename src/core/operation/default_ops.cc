@@ -21,6 +21,7 @@
 #include "core/operation/mechanical_forces_op_cuda.h"
 #include "core/operation/mechanical_forces_op_opencl.h"
 #include "core/operation/operation.h"
+#include "core/operation/trim_memory_op.h"
 #include "core/operation/visualization_op.h"
 
 namespace bdm {
@@ -35,6 +36,8 @@ BDM_REGISTER_OP_WITH_FREQ(LoadBalancingOp, "load balancing", kCpu,
 
 BDM_REGISTER_OP(MechanicalForcesOp, "mechanical forces", kCpu);
 
+BDM_REGISTER_OP(TrimMemoryOp, "trim memory", kCpu);
+
 #ifdef USE_CUDA
 BDM_REGISTER_OP(MechanicalForcesOpCuda, "mechanical forces", kCuda);
 #endif
@@ -109,6 +112,14 @@ struct UpdateTimeSeriesOp : public StandaloneOperationImpl {
   void operator()() override {
     Simulation::GetActive()->GetTimeSeries()->Update();
   }
+
+  OpDataAccess GetDataAccess() const override {
+    // Collectors are user-defined and might query the environment
+    return {{{OpResource::kAgents},
+             {OpResource::kEnvironment},
+             {OpResource::kContinuum}},
+            {{OpResource::kTimeSeries}}};
+  }
 };
 
 BDM_REGISTER_OP(UpdateTimeSeriesOp, "update time series", kCpu);
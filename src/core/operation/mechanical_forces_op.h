@@ -18,19 +18,26 @@
 #include <array>
 #include <cmath>
 #include <limits>
+#include <memory>
+#include <typeinfo>
 #include <vector>
 
 #include "core/agent/agent.h"
+#include "core/agent/cell.h"
+#include "core/container/agent_vector.h"
 #include "core/environment/environment.h"
+#include "core/environment/uniform_grid_environment.h"
 #include "core/interaction_force.h"
 #include "core/operation/bound_space_op.h"
 #include "core/operation/operation.h"
 #include "core/operation/operation_registry.h"
 #include "core/param/param.h"
 #include "core/scheduler.h"
+#include "core/shape.h"
 #include "core/simulation.h"
 #include "core/util/math.h"
 #include "core/util/thread_info.h"
+#include "core/util/type.h"
 
 namespace bdm {
 
@@ -73,6 +80,44 @@ class MechanicalForcesOp : public AgentOperationImpl {
     force_ = force;
   }
 
+  /// If `Param::pairwise_mechanical_forces` is enabled, the forces between
+  /// all neighboring cells are computed here, before the agent operations are
+  /// executed. Each pair of cells is visited only once.
+  void SetUp() override {
+    auto* sim = Simulation::GetActive();
+    auto* param = sim->GetParam();
+    pairwise_ = false;
+    if (!param->pairwise_mechanical_forces) {
+      return;
+    }
+    auto* grid = dynamic_cast<UniformGridEnvironment*>(sim->GetEnvironment());
+    if (grid == nullptr) {
+      Log::Warning("MechanicalForcesOp::SetUp",
+                   "Param::pairwise_mechanical_forces is only supported for "
+                   "the UniformGridEnvironment. Falling back to the per-agent "
+                   "force calculation.");
+      return;
+    }
+    if (grid->GetBoxesPerRadius() != 1) {
+      Log::Warning("MechanicalForcesOp::SetUp",
+                   "Param::pairwise_mechanical_forces requires "
+                   "Param::uniform_grid_boxes_per_radius to be 1. Falling "
+                   "back to the per-agent force calculation.");
+      return;
+    }
+    // The pairwise calculation relies on the default force being
+    // antisymmetric. A user-defined force might not be.
+    if (typeid(*force_) != typeid(InteractionForce)) {
+      Log::Warning("MechanicalForcesOp::SetUp",
+                   "Param::pairwise_mechanical_forces is not supported for "
+                   "user-defined interaction forces. Falling back to the "
+                   "per-agent force calculation.");
+      return;
+    }
+    pairwise_ = true;
+    CalculatePairwiseForces(grid);
+  }
+
   void operator()(Agent* agent) override {
     auto* sim = Simulation::GetActive();
     auto* scheduler = sim->GetScheduler();
@@ -93,8 +138,19 @@ class MechanicalForcesOp : public AgentOperationImpl {
       last_time_run_[tid] = current_time;
     }
 
-    const auto& displacement =
-        agent->CalculateDisplacement(force_, squared_radius_, delta_time_[tid]);
+    Real3 displacement;
+    const PairwiseForce* pf = nullptr;
+    if (pairwise_) {
+      auto* rm = sim->GetResourceManager();
+      pf = &(*pairwise_forces_)[rm->GetAgentHandle(agent->GetUid())];
+    }
+    if (pf != nullptr && pf->enabled) {
+      displacement = bdm_static_cast<Cell*>(agent)->CalculateDisplacement(
+          pf->force, pf->non_zero_forces, delta_time_[tid]);
+    } else {
+      displacement = agent->CalculateDisplacement(force_, squared_radius_,
+                                                  delta_time_[tid]);
+    }
     agent->ApplyDisplacement(displacement);
     if (param->bound_space) {
       ApplyBoundingBox(agent, param->bound_space, param->min_bound,
@@ -103,11 +159,82 @@ class MechanicalForcesOp : public AgentOperationImpl {
   }
 
  private:
+  /// Sum of the neighbor forces acting on one agent.
+  /// Used if `Param::pairwise_mechanical_forces` is enabled.
+  struct PairwiseForce {
+    Real3 force;
+    uint64_t non_zero_forces;
+    /// True if the displacement of this agent is calculated from `force`
+    /// (i.e. the dynamic type of the agent is `Cell`).
+    bool enabled;
+  };
+
   InteractionForce* force_ = nullptr;
   real_t squared_radius_ = 0;
   std::vector<real_t> last_time_run_;
   std::vector<real_t> delta_time_;
   std::vector<uint64_t> last_iteration_;
+  /// True if the neighbor forces have been calculated in `SetUp` for this
+  /// iteration.
+  bool pairwise_ = false;
+  /// Created lazily, because `AgentVector` requires an active simulation.
+  std::unique_ptr<AgentVector<PairwiseForce>> pairwise_forces_;
+
+  void CalculatePairwiseForces(UniformGridEnvironment* grid) {
+    auto* sim = Simulation::GetActive();
+    auto* rm = sim->GetResourceManager();
+    auto* param = sim->GetParam();
+
+    auto search_radius = grid->GetLargestAgentSize();
+    squared_radius_ = search_radius * search_radius;
+
+    if (!pairwise_forces_) {
+      pairwise_forces_ = std::make_unique<AgentVector<PairwiseForce>>();
+    } else {
+      pairwise_forces_->reserve();
+    }
+
+    auto& pairwise_forces = *pairwise_forces_;
+    auto reset = L2F([&](Agent* agent, AgentHandle ah) {
+      auto& pf = pairwise_forces[ah];
+      pf.force = {0, 0, 0};
+      pf.non_zero_forces = 0;
+      // Subclasses of Cell might override CalculateDisplacement. Hence, only
+      // agents of exactly type Cell use the precomputed force.
+      pf.enabled = agent->GetShape() == Shape::kSphere &&
+                   typeid(*agent) == typeid(Cell);
+    });
+    rm->ForEachAgentParallel(param->scheduling_batch_size, reset);
+
+    auto* force = force_;
+    auto add_force = [&](AgentHandle ah, const Real4& f, real_t sign) {
+      if (f[0] != 0 || f[1] != 0 || f[2] != 0) {
+        auto& pf = pairwise_forces[ah];
+        pf.force[0] += sign * f[0];
+        pf.force[1] += sign * f[1];
+        pf.force[2] += sign * f[2];
+        pf.non_zero_forces++;
+      }
+    };
+    auto calculate_pair = L2F([&](Agent* lhs, AgentHandle lhs_ah, Agent* rhs,
+                                  AgentHandle rhs_ah, real_t) {
+      bool lhs_enabled = pairwise_forces[lhs_ah].enabled;
+      bool rhs_enabled = pairwise_forces[rhs_ah].enabled;
+      bool lhs_required = lhs_enabled && !lhs->IsStatic();
+      bool rhs_required = rhs_enabled && !rhs->IsStatic();
+      if (lhs_required) {
+        auto f = force->Calculate(lhs, rhs);
+        add_force(lhs_ah, f, 1);
+        // The force between two spheres is antisymmetric
+        if (rhs_required) {
+          add_force(rhs_ah, f, -1);
+        }
+      } else if (rhs_required) {
+        add_force(rhs_ah, force->Calculate(rhs, lhs), 1);
+      }
+    });
+    grid->ForEachNeighborPair(calculate_pair, squared_radius_);
+  }
 };
 
 }  // namespace bdm
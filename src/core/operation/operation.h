@@ -43,6 +43,62 @@ inline std::string OpComputeTargetString(OpComputeTarget t) {
   }
 }
 
+/// Simulation data that an operation reads or writes.
+/// \see OpDataAccess
+struct OpResource {
+  enum Kind {
+    /// Any data. Conflicts with all other resources.
+    kAll,
+    kAgents,
+    kEnvironment,
+    kContinuum,
+    /// Files, visualization and other output
+    kOutput,
+    /// Data collected in the `TimeSeries` of the simulation
+    kTimeSeries
+  };
+
+  Kind kind = kAll;
+  /// Continuum id if `kind == kContinuum`. -1 refers to all continua.
+  int id = -1;
+
+  bool Overlaps(const OpResource &other) const {
+    if (kind == kAll || other.kind == kAll) {
+      return true;
+    }
+    if (kind != other.kind) {
+      return false;
+    }
+    return kind != kContinuum || id == -1 || other.id == -1 || id == other.id;
+  }
+};
+
+/// Read and write set of an operation. The scheduler uses it to determine
+/// which standalone operations can be executed concurrently.
+/// \see Param::parallel_standalone_ops
+struct OpDataAccess {
+  std::vector<OpResource> reads;
+  std::vector<OpResource> writes;
+
+  /// Returns true if the two operations cannot be executed concurrently,
+  /// i.e. if one writes data that the other one reads or writes.
+  bool ConflictsWith(const OpDataAccess &other) const {
+    auto overlap = [](const std::vector<OpResource> &a,
+                      const std::vector<OpResource> &b) {
+      for (auto &ra : a) {
+        for (auto &rb : b) {
+          if (ra.Overlaps(rb)) {
+            return true;
+          }
+        }
+      }
+      return false;
+    };
+    return overlap(writes, other.reads) || overlap(writes, other.writes) ||
+           overlap(reads, other.writes);
+  }
+};
+
 struct OperationImpl {
   virtual ~OperationImpl() = default;
 
@@ -68,6 +124,13 @@ struct OperationImpl {
   /// Returns whether or not this operations is a stand-alone operation
   virtual bool IsStandalone() = 0;
 
+  /// Returns the data that this operation reads and writes.
+  /// The default conservatively writes everything, so that the operation is
+  /// never executed concurrently with other operations.
+  virtual OpDataAccess GetDataAccess() const {
+    return {{}, {OpResource{OpResource::kAll}}};
+  }
+
   /// The target that this operation implementation is supposed to run on
   OpComputeTarget target_ = kCpu;
 };
@@ -167,6 +230,11 @@ struct Operation {
     return implementations_[active_target_]->IsStandalone();
   }
 
+  /// Returns the data access of the active implementation
+  OpDataAccess GetDataAccess() const {
+    return implementations_[active_target_]->GetDataAccess();
+  }
+
   /// Forwards call to implementation's Setup function
   void SetUp();
 
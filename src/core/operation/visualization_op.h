@@ -50,6 +50,13 @@ class VisualizationOp : public StandaloneOperationImpl {
     }
   }
 
+  OpDataAccess GetDataAccess() const override {
+    return {{{OpResource::kAgents},
+             {OpResource::kEnvironment},
+             {OpResource::kContinuum}},
+            {{OpResource::kOutput}}};
+  }
+
  private:
   VisualizationAdaptor* visualization_ = nullptr;
   bool initialized_ = false;
@@ -162,6 +162,9 @@ void AssignThreadSafetyMechanism(const std::shared_ptr<cpptoml::table>& config,
           Param::ThreadSafetyMechanism::kUserSpecified;
     } else if (str_value == "automatic") {
       param->thread_safety_mechanism = Param::ThreadSafetyMechanism::kAutomatic;
+    } else if (str_value == "box-coloring") {
+      param->thread_safety_mechanism =
+          Param::ThreadSafetyMechanism::kBoxColoring;
     }
   }
 }
@@ -225,6 +228,8 @@ void Param::AssignFromConfig(const std::shared_ptr<cpptoml::table>& config) {
 
   // simulation group
   BDM_ASSIGN_CONFIG_VALUE(random_seed, "simulation.random_seed");
+  BDM_ASSIGN_CONFIG_VALUE(use_counter_based_rng,
+                          "simulation.use_counter_based_rng");
   BDM_ASSIGN_CONFIG_VALUE(output_dir, "simulation.output_dir");
   BDM_ASSIGN_CONFIG_VALUE(environment, "simulation.environment");
   BDM_ASSIGN_CONFIG_VALUE(nanoflann_depth, "simulation.nanoflann_depth");
@@ -338,9 +343,33 @@ void Param::AssignFromConfig(const std::shared_ptr<cpptoml::table>& config) {
   // performance group
   BDM_ASSIGN_CONFIG_VALUE(scheduling_batch_size,
                           "performance.scheduling_batch_size");
+  BDM_ASSIGN_CONFIG_VALUE(deterministic_scheduling,
+                          "performance.deterministic_scheduling");
+  BDM_ASSIGN_CONFIG_VALUE(parallel_standalone_ops,
+                          "performance.parallel_standalone_ops");
+  BDM_ASSIGN_CONFIG_VALUE(diffusion_temporal_blocking,
+                          "performance.diffusion_temporal_blocking");
+  BDM_ASSIGN_CONFIG_VALUE(fuse_diffusion_grids,
+                          "performance.fuse_diffusion_grids");
+  BDM_ASSIGN_CONFIG_VALUE(diffusion_sparse_tolerance,
+                          "performance.diffusion_sparse_tolerance");
   BDM_ASSIGN_CONFIG_VALUE(detect_static_agents,
                           "performance.detect_static_agents");
   BDM_ASSIGN_CONFIG_VALUE(cache_neighbors, "performance.cache_neighbors");
+  BDM_ASSIGN_CONFIG_VALUE(pairwise_mechanical_forces,
+                          "performance.pairwise_mechanical_forces");
+  BDM_ASSIGN_CONFIG_VALUE(uniform_grid_soa_snapshot,
+                          "performance.uniform_grid_soa_snapshot");
+  BDM_ASSIGN_CONFIG_VALUE(uniform_grid_counting_sort,
+                          "performance.uniform_grid_counting_sort");
+  BDM_ASSIGN_CONFIG_VALUE(uniform_grid_incremental_update,
+                          "performance.uniform_grid_incremental_update");
+  BDM_ASSIGN_CONFIG_VALUE(uniform_grid_verlet_skin,
+                          "performance.uniform_grid_verlet_skin");
+  BDM_ASSIGN_CONFIG_VALUE(uniform_grid_boxes_per_radius,
+                          "performance.uniform_grid_boxes_per_radius");
+  BDM_ASSIGN_CONFIG_VALUE(uniform_grid_adjacency,
+                          "performance.uniform_grid_adjacency");
   BDM_ASSIGN_CONFIG_VALUE(use_bdm_mem_mgr, "performance.use_bdm_mem_mgr");
   BDM_ASSIGN_CONFIG_VALUE(mem_mgr_aligned_pages_shift,
                           "performance.mem_mgr_aligned_pages_shift");
@@ -348,8 +377,18 @@ void Param::AssignFromConfig(const std::shared_ptr<cpptoml::table>& config) {
                           "performance.mem_mgr_growth_rate");
   BDM_ASSIGN_CONFIG_VALUE(mem_mgr_max_mem_per_thread_factor,
                           "performance.mem_mgr_max_mem_per_thread_factor");
+  BDM_ASSIGN_CONFIG_VALUE(mem_mgr_huge_pages,
+                          "performance.mem_mgr_huge_pages");
+  BDM_ASSIGN_CONFIG_VALUE(mem_mgr_interleave_min_size,
+                          "performance.mem_mgr_interleave_min_size");
+  BDM_ASSIGN_CONFIG_VALUE(mem_mgr_trim_frequency,
+                          "performance.mem_mgr_trim_frequency");
   BDM_ASSIGN_CONFIG_VALUE(minimize_memory_while_rebalancing,
                           "performance.minimize_memory_while_rebalancing");
+  BDM_ASSIGN_CONFIG_VALUE(in_place_load_balancing,
+                          "performance.in_place_load_balancing");
+  BDM_ASSIGN_CONFIG_VALUE(group_agents_by_type,
+                          "performance.group_agents_by_type");
   AssignMappedDataArrayMode(config, this);
 
   // development group
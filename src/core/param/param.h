@@ -89,6 +89,24 @@ struct Param {
   ///     random_seed = 4357
   uint64_t random_seed = 4357;
 
+  /// Draw the random numbers of `Cell::Divide` (and therefore of the
+  /// `GrowthDivision` behavior) from a counter-based generator keyed by
+  /// (random_seed, `Cell::GetRngKey`, time step, stream) instead of the
+  /// thread-local `Random` instance. The keys of daughter cells are derived
+  /// from the key of their mother. Hence, divisions are independent of the
+  /// number of threads and the scheduling, provided that the initial cells
+  /// are created in a deterministic order.\n
+  /// Other random numbers are still drawn from the thread-local `Random`
+  /// instance, e.g. in `InteractionForce` (coinciding centers), neurites,
+  /// the model initializers and the random walk behaviors of the demos.\n
+  /// \see Random::GetCounterBasedRng\n
+  /// Default value: `false`\n
+  /// TOML config file:
+  ///
+  ///     [simulation]
+  ///     use_counter_based_rng = false
+  bool use_counter_based_rng = false;
+
   /// List of default operation names that should not be scheduled by default
   /// Default value: `{}`\n
   /// TOML config file:
@@ -244,9 +262,12 @@ struct Param {
   std::string diffusion_boundary_condition = "Neumann";
 
   /// A string for determining diffusion type within the simulation space.
-  /// Currently, only the method "euler" implementing a FTCS scheme is
-  /// supported. See for instance here:
-  /// https://en.wikipedia.org/wiki/FTCS_scheme (accessed 2023-07-17)
+  /// Supported methods are "euler" implementing a FTCS scheme (see for
+  /// instance here: https://en.wikipedia.org/wiki/FTCS_scheme, accessed
+  /// 2023-07-17), "adi" implementing the unconditionally stable
+  /// alternating direction implicit scheme (see `AdiGrid`), and
+  /// "sparse_euler" implementing the FTCS scheme on bricks of boxes that
+  /// skips quiescent regions of the grid (see `SparseEulerGrid`).
   /// Default value: `"euler"`\n TOML
   /// config file:
   ///
@@ -269,11 +290,21 @@ struct Param {
   /// `kUserSpecified`: The user has to define all agent that must
   /// not be processed in parallel. \see `Agent::CriticalRegion`.\n
   /// `kAutomatic`: The simulation automatically locks all agents
-  /// of the microenvironment.
-  enum ThreadSafetyMechanism { kNone = 0, kUserSpecified, kAutomatic };
+  /// of the microenvironment.\n
+  /// `kBoxColoring`: Agents are processed box by box in a checkerboard
+  /// order, such that agents with overlapping microenvironments are never
+  /// processed concurrently. Does not require locks, but is only supported
+  /// by the `UniformGridEnvironment`.
+  /// \see `UniformGridEnvironment::ForEachAgentInColoredBoxes`
+  enum ThreadSafetyMechanism {
+    kNone = 0,
+    kUserSpecified,
+    kAutomatic,
+    kBoxColoring
+  };
 
   /// Select the thread-safety mechanism.\n
-  /// Possible values are: none, user-specified, automatic.\n
+  /// Possible values are: none, user-specified, automatic, box-coloring.\n
   /// TOML config file:
   ///
   ///     [simulation]
@@ -436,6 +467,82 @@ struct Param {
   ///     scheduling_batch_size = 1000
   uint64_t scheduling_batch_size = 1000;
 
+  /// Use a deterministic assignment of agents to threads.
+  /// `ResourceManager::ForEachAgentParallel(chunk, ...)` then splits the
+  /// agents into chunks of fixed size (independent of the number of threads)
+  /// that are assigned round robin to threads, instead of using dynamic
+  /// scheduling with work stealing. `bdm::experimental::Reduce` combines
+  /// partial results per chunk in chunk order. Reductions are therefore
+  /// reproducible for any number of threads, as long as the agents are
+  /// distributed identically among NUMA nodes.\n
+  /// Default value: `false`\n
+  /// TOML config file:
+  ///
+  ///     [performance]
+  ///     deterministic_scheduling = false
+  bool deterministic_scheduling = false;
+
+  /// Execute independent standalone operations concurrently as OpenMP tasks.
+  /// The scheduler groups the standalone operations into levels based on
+  /// their read and write sets (see `OperationImpl::GetDataAccess`).
+  /// Operations in the same level do not conflict and run concurrently.
+  /// Levels are executed in the order in which the operations were scheduled.
+  /// A level with a single operation is executed directly, such that the
+  /// operation can use all threads. Operations that run inside a task execute
+  /// nested parallel regions with one thread. The same applies to the
+  /// operations that are executed at the end of each iteration (e.g.
+  /// `visualize` and `update time series`).\n
+  /// The `continuum` operation in addition integrates the diffusion grids
+  /// concurrently if they do not depend on each other, i.e. if there are no
+  /// depletion grids or user-defined continua.\n
+  /// Default value: `false`\n
+  /// TOML config file:
+  ///
+  ///     [performance]
+  ///     parallel_standalone_ops = false
+  bool parallel_standalone_ops = false;
+
+  /// Maximum number of time steps that `EulerGrid` fuses into a single pass
+  /// over the grid if the continuum has to perform several steps per
+  /// simulation step (see `Continuum::SetTimeStep`). The grid is processed in
+  /// cache-resident tiles, which turns the memory-bound stencil into a
+  /// compute-bound one for large grids. Values smaller than two disable the
+  /// temporal blocking. Mutually exclusive with `fuse_diffusion_grids`:
+  /// grids that are integrated in a fused kernel do not use temporal
+  /// blocking.\n
+  /// Default value: `1`\n
+  /// TOML config file:
+  ///
+  ///     [performance]
+  ///     diffusion_temporal_blocking = 1
+  uint64_t diffusion_temporal_blocking = 1;
+
+  /// Advance all `EulerGrid`s that share the same geometry (resolution,
+  /// bounds, boundary condition type, and time step) in a single fused kernel
+  /// instead of one pass per substance (see `EulerGrid::DiffuseFused`). The
+  /// gradients of these grids are also computed in a single pass. Mutually
+  /// exclusive with `diffusion_temporal_blocking`: fused grids are advanced
+  /// one time step per pass, and a warning is logged if both are enabled.\n
+  /// Default value: `false`\n
+  /// TOML config file:
+  ///
+  ///     [performance]
+  ///     fuse_diffusion_grids = false
+  bool fuse_diffusion_grids = false;
+
+  /// Tolerance of `SparseEulerGrid` (diffusion method "sparse_euler"). A
+  /// brick of boxes is considered quiescent if no concentration inside it
+  /// changed by more than this value during the last time step. Quiescent
+  /// bricks whose neighbors are quiescent as well are not updated. With the
+  /// default value of zero, the sparse grid yields the same result as
+  /// `EulerGrid`; larger values skip more bricks at the cost of accuracy.\n
+  /// Default value: `0`\n
+  /// TOML config file:
+  ///
+  ///     [performance]
+  ///     diffusion_sparse_tolerance = 0
+  real_t diffusion_sparse_tolerance = 0;
+
   enum ExecutionOrder { kForEachAgentForEachOp = 0, kForEachOpForEachAgent };
 
   /// This parameter determines whether to execute  `kForEachAgentForEachOp`
@@ -479,6 +586,114 @@ struct Param {
   ///     cache_neighbors = false
   bool cache_neighbors = false;
 
+  /// If set to true, `MechanicalForcesOp` computes the forces between two
+  /// spherical `Cell`s only once per pair and applies them to both cells
+  /// in opposite directions (Newton's third law). Forces are evaluated on the
+  /// agent positions at the beginning of the operation. Therefore, results
+  /// differ slightly from the default mode, in which agents observe the
+  /// displacement of neighbors that have been processed earlier.\n
+  /// Only supported for the `UniformGridEnvironment` and the default
+  /// `InteractionForce`. Only agents whose dynamic type is exactly `Cell` use
+  /// the pairwise forces. Agents of other types, including subclasses of
+  /// `Cell` (which might override `CalculateDisplacement`) and neurite
+  /// elements, still compute their displacement individually.\n
+  /// Default value: `false`\n
+  /// TOML config file:
+  ///
+  ///     [performance]
+  ///     pairwise_mechanical_forces = false
+  bool pairwise_mechanical_forces = false;
+
+  /// If set to true, the `UniformGridEnvironment` copies the position,
+  /// diameter and pointer of all agents into contiguous arrays sorted by box
+  /// during each environment update. Neighbor searches then stream over
+  /// these arrays instead of following the linked list inside each box.\n
+  /// The copied positions are not updated if agents move during an
+  /// iteration. They only pre-filter the candidates with the search radius
+  /// widened by `simulation_max_displacement`. The distances reported to the
+  /// caller are computed from the current positions, as without the
+  /// snapshot. Neighbors that moved farther than
+  /// `simulation_max_displacement` since the last environment update might
+  /// be missed.\n
+  /// Default value: `false`\n
+  /// TOML config file:
+  ///
+  ///     [performance]
+  ///     uniform_grid_soa_snapshot = false
+  bool uniform_grid_soa_snapshot = false;
+
+  /// If set to true, the `UniformGridEnvironment` assigns agents to boxes
+  /// with a parallel counting sort (histogram, prefix sum and scatter). The
+  /// agents of each box are stored contiguously and no locks are required to
+  /// build the grid. Otherwise, agents are inserted into a linked list per
+  /// box, which is protected by a spinlock.\n
+  /// Default value: `false`\n
+  /// TOML config file:
+  ///
+  ///     [performance]
+  ///     uniform_grid_counting_sort = false
+  bool uniform_grid_counting_sort = false;
+
+  /// If set to true, the `UniformGridEnvironment` reuses the grid of the
+  /// previous iteration and only moves agents whose box index has changed.
+  /// The grid is rebuilt from scratch if its dimensions have changed, or if
+  /// agents have been added, removed or reordered (e.g. by load balancing).
+  /// Beneficial if most agents do not cross a box boundary between two
+  /// iterations (e.g. quasi-static tissues).\n
+  /// Has no effect if `uniform_grid_counting_sort` is enabled.\n
+  /// Default value: `false`\n
+  /// TOML config file:
+  ///
+  ///     [performance]
+  ///     uniform_grid_incremental_update = false
+  bool uniform_grid_incremental_update = false;
+
+  /// Skin distance of the Verlet neighbor lists of the
+  /// `UniformGridEnvironment`. If larger than zero, the environment builds a
+  /// neighbor list for each agent with radius largest agent size + skin.
+  /// Neighbor queries of an agent with a radius up to the largest agent size
+  /// then iterate over this list instead of the grid. The lists and the grid
+  /// are only rebuilt if an agent might move more than half the skin distance
+  /// during the next iteration (assuming that agents move at most
+  /// `simulation_max_displacement` per iteration), if agents grew, or if
+  /// agents have been added or removed. The skin distance must therefore be
+  /// larger than `2 * simulation_max_displacement`. A value of zero disables
+  /// Verlet lists.\n
+  /// Default value: `0`\n
+  /// TOML config file:
+  ///
+  ///     [performance]
+  ///     uniform_grid_verlet_skin = 0
+  real_t uniform_grid_verlet_skin = 0;
+
+  /// Number of boxes of the `UniformGridEnvironment` per search radius.
+  /// With the default value of one, the box length is equal to the largest
+  /// agent size and neighbors are searched in the 27 surrounding boxes. With
+  /// a value of two, the box length is half the largest agent size and the
+  /// search stencil covers 125 boxes. The smaller boxes reduce the number of
+  /// candidates that have to be checked, especially if a few agents are much
+  /// larger than the rest of the population.\n
+  /// Allowed values: `1, 2`\n
+  /// Default value: `1`\n
+  /// TOML config file:
+  ///
+  ///     [performance]
+  ///     uniform_grid_boxes_per_radius = 1
+  uint64_t uniform_grid_boxes_per_radius = 1;
+
+  /// Determines which of the surrounding boxes the `UniformGridEnvironment`
+  /// searches for neighbors. `"high"` searches all boxes. `"medium"` skips
+  /// boxes that only share a corner with the query box, and `"low"` only
+  /// searches boxes that share a face. `"low"` and `"medium"` are
+  /// approximations that might miss neighbors.\n
+  /// Default value: `"high"`\n
+  /// Other allowed values: `"low", "medium"`\n
+  /// TOML config file:
+  ///
+  ///     [performance]
+  ///     uniform_grid_adjacency = "high"
+  std::string uniform_grid_adjacency = "high";
+
   /// Default value: `true`\n
   /// TOML config file:
   ///
@@ -521,6 +736,42 @@ struct Param {
   ///     mem_mgr_max_mem_per_thread_factor = 1
   uint64_t mem_mgr_max_mem_per_thread_factor = 1;
 
+  /// Specifies how the memory blocks of the BioDynaMo memory manager are
+  /// backed. Huge pages reduce the dTLB pressure if agents are spread over
+  /// a large amount of memory.\n
+  /// Possible values: `none`, `transparent` (2 MB aligned blocks with
+  /// `madvise(MADV_HUGEPAGE)`), `explicit` (`mmap(MAP_HUGETLB)`; falls back
+  /// to `transparent` if no huge pages are reserved)\n
+  /// Default value: `none`\n
+  /// TOML config file:
+  ///
+  ///     [performance]
+  ///     mem_mgr_huge_pages = "none"
+  std::string mem_mgr_huge_pages = "none";
+
+  /// Size classes of the BioDynaMo memory manager with an allocation size
+  /// greater or equal to this value (in bytes) interleave their memory
+  /// across all NUMA nodes instead of placing it on the local node.\n
+  /// `0` disables interleaving.\n
+  /// Default value: `0`\n
+  /// TOML config file:
+  ///
+  ///     [performance]
+  ///     mem_mgr_interleave_min_size = 0
+  uint64_t mem_mgr_interleave_min_size = 0;
+
+  /// Frequency (in iterations) at which the BioDynaMo memory manager returns
+  /// memory blocks without any used element to the operating system.
+  /// This limits the growth of the resident memory in simulations with
+  /// many agent births and deaths.\n
+  /// `0` disables trimming.\n
+  /// Default value: `0`\n
+  /// TOML config file:
+  ///
+  ///     [performance]
+  ///     mem_mgr_trim_frequency = 0
+  uint64_t mem_mgr_trim_frequency = 0;
+
   /// This parameter is used inside `ResourceManager::LoadBalance`.
   /// If it is set to true, the function will reuse existing memory to rebalance
   /// agents to NUMA nodes. (A small amount of additional memory
@@ -535,6 +786,35 @@ struct Param {
   ///     minimize_memory_while_rebalancing = true
   bool minimize_memory_while_rebalancing = true;
 
+  /// This parameter is used inside `ResourceManager::LoadBalance`.
+  /// If it is set to true, only the agent pointers are reordered along the
+  /// space-filling curve of the environment and distributed to the NUMA
+  /// nodes. Agents are neither copied nor deleted, and keep their memory
+  /// location. Hence, the memory of an agent might reside on a different
+  /// NUMA node than the thread that processes it. This mode is cheap enough
+  /// to increase the frequency of the "load balancing" operation, which
+  /// keeps the order of the agent pointers consistent with their spatial
+  /// position.\n
+  /// Default value: `false`\n
+  /// TOML config file:
+  ///
+  ///     [performance]
+  ///     in_place_load_balancing = false
+  bool in_place_load_balancing = false;
+
+  /// Groups agents by their concrete type. If set to true, the
+  /// `ResourceManager` maintains a `TypeIndex` with one pointer array per
+  /// agent type, which `ResourceManager::ForEachAgentOfTypeParallel` iterates
+  /// over. `ResourceManager::LoadBalance` rebuilds these arrays in the new
+  /// memory order of the agents, so that the agents of one type are traversed
+  /// in the order in which they were allocated.\n
+  /// Default value: `false`\n
+  /// TOML config file:
+  ///
+  ///     [performance]
+  ///     group_agents_by_type = false
+  bool group_agents_by_type = false;
+
   /// MappedDataArrayMode options:
   ///   `kZeroCopy`: access agent data directly only if it is
   ///                requested. \n
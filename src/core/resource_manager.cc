@@ -14,6 +14,7 @@
 
 #include "core/resource_manager.h"
 #include <cmath>
+#include <memory>
 #ifndef NDEBUG
 #include <set>
 #endif  // NDEBUG
@@ -37,7 +38,8 @@ ResourceManager::ResourceManager() {
   agents_lb_.resize(numa_num_configured_nodes());
 
   auto* param = Simulation::GetActive()->GetParam();
-  if (param->export_visualization || param->insitu_visualization) {
+  if (param->export_visualization || param->insitu_visualization ||
+      param->group_agents_by_type) {
     type_index_ = new TypeIndex();
   }
 }
@@ -104,6 +106,15 @@ void ResourceManager::ForEachAgentParallel(Operation& op,
 void ResourceManager::ForEachAgentParallel(
     uint64_t chunk, Functor<void, Agent*, AgentHandle>& function,
     Functor<bool, Agent*>* filter) {
+  if (Simulation::GetActive()->GetParam()->deterministic_scheduling) {
+    auto deterministic_function =
+        L2F([&](Agent* agent, AgentHandle ah, uint64_t) {
+          function(agent, ah);
+        });
+    ForEachAgentParallelDeterministic(chunk, deterministic_function, filter);
+    return;
+  }
+
   // adapt chunk size
   auto num_agents = GetNumAgents();
   uint64_t factor = (num_agents / thread_info_->GetMaxThreads()) / chunk;
@@ -122,8 +133,27 @@ void ResourceManager::ForEachAgentParallel(
     num_chunks_per_numa[n] = agents_[n].size() / chunk + correction;
   }
 
-  std::vector<std::atomic<uint64_t>*> counters(max_threads, nullptr);
-  std::vector<uint64_t> max_counters(max_threads);
+  // Operations that run as concurrent tasks may call this function at the
+  // same time. Each calling thread therefore uses its own counters, which are
+  // only reallocated if the number of threads changes. Nested calls from
+  // within `function` use the next level of the pool, so that the counters of
+  // the outer call are left untouched. The reference below is shared with the
+  // threads of the parallel region.
+  thread_local std::vector<std::unique_ptr<std::vector<WorkCounter>>>
+      tl_work_counters;
+  thread_local uint64_t tl_depth = 0;
+  if (tl_work_counters.size() <= tl_depth) {
+    tl_work_counters.emplace_back(new std::vector<WorkCounter>());
+  }
+  auto& work_counters = *tl_work_counters[tl_depth];
+  if (work_counters.size() != static_cast<uint64_t>(max_threads)) {
+    work_counters = std::vector<WorkCounter>(max_threads);
+  }
+  struct DepthGuard {
+    explicit DepthGuard(uint64_t* depth) : depth_(depth) { ++*depth_; }
+    ~DepthGuard() { --*depth_; }
+    uint64_t* depth_;
+  } depth_guard(&tl_depth);
   for (int thread_cnt = 0; thread_cnt < max_threads; thread_cnt++) {
     uint64_t current_nid = thread_info_->GetNumaNode(thread_cnt);
 
@@ -142,8 +172,8 @@ void ResourceManager::ForEachAgentParallel(
     auto end = std::min(num_chunks_per_numa[current_nid],
                         start + num_chunks_per_thread);
 
-    counters[thread_cnt] = new std::atomic<uint64_t>(start);
-    max_counters[thread_cnt] = end;
+    work_counters[thread_cnt].next = start;
+    work_counters[thread_cnt].end = end;
   }
 
 #pragma omp parallel
@@ -174,8 +204,9 @@ void ResourceManager::ForEachAgentParallel(
         }
 
         auto& numa_agents = agents_[current_nid];
-        uint64_t old_count = (*(counters[current_tid]))++;
-        while (old_count < max_counters[current_tid]) {
+        auto& counter = work_counters[current_tid];
+        uint64_t old_count = counter.next++;
+        while (old_count < counter.end) {
           start = old_count * p_chunk;
           end = std::min(static_cast<uint64_t>(numa_agents.size()),
                          start + p_chunk);
@@ -187,19 +218,63 @@ void ResourceManager::ForEachAgentParallel(
             }
           }
 
-          old_count = (*(counters[current_tid]))++;
+          old_count = counter.next++;
         }
       }  // work stealing loop numa_nodes_
     }    // work stealing loop  threads
   }
+}
 
-  for (auto* counter : counters) {
-    delete counter;
+void ResourceManager::ForEachAgentParallelDeterministic(
+    uint64_t chunk, Functor<void, Agent*, AgentHandle, uint64_t>& function,
+    Functor<bool, Agent*>* filter) {
+  chunk = std::max(chunk, uint64_t{1});
+
+  // chunks do not span numa nodes; chunk_offsets[n] is the global index of
+  // the first chunk of numa node n
+  auto numa_nodes = agents_.size();
+  std::vector<uint64_t> chunk_offsets(numa_nodes + 1, 0);
+  for (uint64_t n = 0; n < numa_nodes; ++n) {
+    chunk_offsets[n + 1] =
+        chunk_offsets[n] + (agents_[n].size() + chunk - 1) / chunk;
+  }
+  auto num_chunks = static_cast<int64_t>(chunk_offsets.back());
+
+  // The chunks are distributed over the team that actually executes the
+  // region, which might be smaller than `ThreadInfo::GetMaxThreads()` (e.g.
+  // inside a task or after `omp_set_num_threads`).
+#pragma omp parallel for schedule(static)
+  for (int64_t c = 0; c < num_chunks; ++c) {
+    auto global_chunk = static_cast<uint64_t>(c);
+    uint64_t nid = 0;
+    while (chunk_offsets[nid + 1] <= global_chunk) {
+      ++nid;
+    }
+    auto& numa_agents = agents_[nid];
+    auto start = (global_chunk - chunk_offsets[nid]) * chunk;
+    auto end =
+        std::min(static_cast<uint64_t>(numa_agents.size()), start + chunk);
+    for (uint64_t i = start; i < end; ++i) {
+      auto* a = numa_agents[i];
+      if (!filter || (filter && (*filter)(a))) {
+        function(a, AgentHandle(nid, i), global_chunk);
+      }
+    }
   }
 }
 
+uint64_t ResourceManager::GetNumChunks(uint64_t chunk) const {
+  chunk = std::max(chunk, uint64_t{1});
+  uint64_t num_chunks = 0;
+  for (auto& numa_agents : agents_) {
+    num_chunks += (numa_agents.size() + chunk - 1) / chunk;
+  }
+  return num_chunks;
+}
+
 struct LoadBalanceFunctor : public Functor<void, Iterator<AgentHandle>*> {
   bool minimize_memory;
+  bool in_place;
   uint64_t offset;
   uint64_t nid;
   std::vector<std::vector<Agent*>>& agents;
@@ -207,10 +282,11 @@ struct LoadBalanceFunctor : public Functor<void, Iterator<AgentHandle>*> {
   AgentUidMap<AgentHandle>& uid_ah_map;
   TypeIndex* type_index;
 
-  LoadBalanceFunctor(bool minimize_memory, uint64_t offset, uint64_t nid,
-                     decltype(agents) agents, decltype(dest) dest,
+  LoadBalanceFunctor(bool minimize_memory, bool in_place, uint64_t offset,
+                     uint64_t nid, decltype(agents) agents, decltype(dest) dest,
                      decltype(uid_ah_map) uid_ah_map, TypeIndex* type_index)
       : minimize_memory(minimize_memory),
+        in_place(in_place),
         offset(offset),
         nid(nid),
         agents(agents),
@@ -222,8 +298,14 @@ struct LoadBalanceFunctor : public Functor<void, Iterator<AgentHandle>*> {
     while (it->HasNext()) {
       auto handle = it->Next();
       auto* agent = agents[handle.GetNumaNode()][handle.GetElementIdx()];
-      auto* copy = agent->NewCopy();
       auto el_idx = offset++;
+      if (in_place) {
+        // only the pointer is moved; the agent keeps its memory location
+        dest[el_idx] = agent;
+        uid_ah_map.Insert(agent->GetUid(), AgentHandle(nid, el_idx));
+        continue;
+      }
+      auto* copy = agent->NewCopy();
       dest[el_idx] = copy;
       uid_ah_map.Insert(copy->GetUid(), AgentHandle(nid, el_idx));
       if (type_index) {
@@ -277,6 +359,10 @@ void ResourceManager::LoadBalance() {
   auto lbi = env->GetLoadBalanceInfo();
 
   const bool minimize_memory = param->minimize_memory_while_rebalancing;
+  const bool in_place = param->in_place_load_balancing;
+  // the type index is rebuilt after the agents have been reordered
+  const bool rebuild_type_index = type_index_ && param->group_agents_by_type;
+  auto* type_index = rebuild_type_index ? nullptr : type_index_;
 
 // create new agents
 #pragma omp parallel
@@ -305,8 +391,9 @@ void ResourceManager::LoadBalance() {
     auto end =
         std::min(agent_per_numa_cumm[nid] + agent_per_numa[nid], start + chunk);
 
-    LoadBalanceFunctor f(minimize_memory, start - agent_per_numa_cumm[nid], nid,
-                         agents_, dest, uid_ah_map_, type_index_);
+    LoadBalanceFunctor f(minimize_memory, in_place,
+                         start - agent_per_numa_cumm[nid], nid, agents_, dest,
+                         uid_ah_map_, type_index);
     lbi->CallHandleIteratorConsumer(start, end, f);
   }
 
@@ -314,7 +401,7 @@ void ResourceManager::LoadBalance() {
   // in the right numa node will delete the object, thus minimizing thread
   // synchronization overheads. The bdm memory allocator does not have this
   // issue.
-  if (!minimize_memory) {
+  if (!minimize_memory && !in_place) {
     auto delete_functor = L2F([](Agent* agent) { delete agent; });
     ForEachAgentParallel(delete_functor);
   }
@@ -329,6 +416,9 @@ void ResourceManager::LoadBalance() {
   if (param->plot_memory_layout) {
     PlotNeighborMemoryHistogram();
   }
+  if (rebuild_type_index) {
+    type_index_->Rebuild(agents_);
+  }
 
   if (Simulation::GetActive()->GetParam()->debug_numa) {
     std::cout << *this << std::endl;
@@ -336,6 +426,23 @@ void ResourceManager::LoadBalance() {
 }
 
 // -----------------------------------------------------------------------------
+void ResourceManager::RemoveAgents(const std::vector<AgentUid>& uids) {
+  // split uids into one block per thread
+  auto max_threads = static_cast<uint64_t>(thread_info_->GetMaxThreads());
+  auto chunk = uids.size() / max_threads;
+  auto remainder = uids.size() % max_threads;
+  std::vector<std::vector<AgentUid>> blocks(max_threads);
+  std::vector<std::vector<AgentUid>*> block_ptrs(max_threads);
+#pragma omp parallel for schedule(static, 1)
+  for (uint64_t i = 0; i < max_threads; ++i) {
+    auto begin = uids.begin() + i * chunk + std::min(i, remainder);
+    auto end = begin + chunk + (i < remainder ? 1 : 0);
+    blocks[i].assign(begin, end);
+    block_ptrs[i] = &blocks[i];
+  }
+  RemoveAgents(block_ptrs);
+}
+
 void ResourceManager::RemoveAgents(
     const std::vector<std::vector<AgentUid>*>& uids) {
   // initialization
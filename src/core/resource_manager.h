@@ -18,6 +18,7 @@
 #include <omp.h>
 #include <sched.h>
 #include <algorithm>
+#include <atomic>
 #include <cmath>
 #include <limits>
 #include <memory>
@@ -33,6 +34,8 @@
 #include "core/agent/agent_uid.h"
 #include "core/agent/agent_uid_generator.h"
 #include "core/container/agent_uid_map.h"
+#include "core/container/append_buffer.h"
+#include "core/container/shared_data.h"
 #include "core/diffusion/continuum_interface.h"
 #include "core/diffusion/diffusion_grid.h"
 #include "core/functor.h"
@@ -329,11 +332,62 @@ class ResourceManager {
   /// `chunk`.
   /// \param chunk number of agents that are assigned to a thread (batch
   /// size)
+  /// If `Param::deterministic_scheduling` is set, this function forwards to
+  /// `ForEachAgentParallelDeterministic`.
   /// \see ForEachAgent
   virtual void ForEachAgentParallel(
       uint64_t chunk, Functor<void, Agent*, AgentHandle>& function,
       Functor<bool, Agent*>* filter = nullptr);
 
+  /// Call a function for all or a subset of agents in the simulation.
+  /// Function invocations are parallelized.\n
+  /// The agents of each NUMA node are split into chunks of `chunk`
+  /// consecutive agents. In contrast to the dynamic scheduling of
+  /// `ForEachAgentParallel`, the chunk boundaries do not depend on the
+  /// number of threads. The chunks are distributed statically over the
+  /// threads of the executing team, which may be smaller than
+  /// `ThreadInfo::GetMaxThreads()`. Agents inside a chunk are processed in
+  /// order by one thread. `function` receives the global index of the chunk
+  /// as third argument (see `GetNumChunks`). Partial results stored per chunk
+  /// and combined in chunk order are therefore reproducible for any number of
+  /// threads.
+  /// \param chunk number of agents per chunk
+  virtual void ForEachAgentParallelDeterministic(
+      uint64_t chunk, Functor<void, Agent*, AgentHandle, uint64_t>& function,
+      Functor<bool, Agent*>* filter = nullptr);
+
+  /// Returns the number of chunks that
+  /// `ForEachAgentParallelDeterministic(chunk, ...)` iterates over.
+  uint64_t GetNumChunks(uint64_t chunk) const;
+
+  /// Call `function` for all agents whose concrete type is `TAgent`.
+  /// Agents of derived types are not included. In contrast to
+  /// `ForEachAgentParallel`, the function is a template parameter and receives
+  /// a `TAgent*`. This allows the compiler to inline `function` and the
+  /// member functions of `TAgent` it calls, if `TAgent` is declared `final`
+  /// or the calls are qualified (e.g. `agent->TAgent::GetDiameter()`).
+  /// Function invocations are parallelized.\n
+  /// Requires `Param::group_agents_by_type`.
+  ///
+  /// /code{.cpp}
+  ///     rm->ForEachAgentOfTypeParallel<Cell>([](Cell* cell) {
+  ///                                            cell->ChangeVolume(10);
+  ///                                          });
+  /// /endcode
+  template <typename TAgent, typename TFunction>
+  void ForEachAgentOfTypeParallel(const TFunction& function) {
+    if (!type_index_) {
+      Log::Fatal("ResourceManager::ForEachAgentOfTypeParallel",
+                 "This function requires Param::group_agents_by_type.");
+      return;
+    }
+    const auto& agents = type_index_->GetType(TAgent::Class());
+#pragma omp parallel for schedule(static)
+    for (uint64_t i = 0; i < agents.size(); ++i) {
+      function(bdm_static_cast<TAgent*>(agents[i]));
+    }
+  }
+
   /// Reserves enough memory to hold `capacity` number of agents for
   /// each numa domain.
   void Reserve(size_t capacity) {
@@ -425,6 +479,88 @@ class ResourceManager {
 
   virtual void EndOfIteration() {}
 
+  /// Creates `num_agents` agents in parallel and adds them directly to the
+  /// ResourceManager. `agent_builder(i)` must return a new agent for each
+  /// `i` in `[0, num_agents)`.\n
+  /// The agents are split into one contiguous range per logical thread id.
+  /// The AgentUids of a range are reserved with a single call to
+  /// `AgentUidGenerator::ReserveUids`, and its agents are written into a
+  /// preallocated, contiguous interval of its NUMA node's agent vector. The
+  /// AgentUid map is resized once. Hence, no per-agent synchronization is
+  /// required. Use this function to initialize large simulations
+  /// instead of `ExecutionContext::AddAgent`.\n
+  /// NB: This method must not be called during agent operations. It
+  /// invalidates agent references pointing into the ResourceManager.
+  ///
+  /// /code{.cpp}
+  ///     rm->CreateAgents(num_agents, [&](uint64_t i) {
+  ///       return new Cell(positions[i]);
+  ///     });
+  /// /endcode
+  template <typename TFunction>
+  void CreateAgents(uint64_t num_agents, const TFunction& agent_builder) {
+    if (num_agents == 0) {
+      return;
+    }
+    auto max_threads = static_cast<uint64_t>(thread_info_->GetMaxThreads());
+    auto numa_nodes = thread_info_->GetNumaNodes();
+    auto chunk = num_agents / max_threads;
+    auto remainder = num_agents % max_threads;
+
+    // group thread ranges by numa domain
+    std::vector<uint64_t> thread_offsets(max_threads);
+    std::vector<uint64_t> new_agent_per_numa(numa_nodes);
+    for (uint64_t tid = 0; tid < max_threads; ++tid) {
+      auto nid = thread_info_->GetNumaNode(tid);
+      thread_offsets[tid] = new_agent_per_numa[nid];
+      new_agent_per_numa[nid] += chunk + (tid < remainder ? 1 : 0);
+    }
+    std::vector<uint64_t> numa_offsets(numa_nodes);
+    for (int n = 0; n < numa_nodes; n++) {
+      numa_offsets[n] = GrowAgentContainer(new_agent_per_numa[n], n);
+    }
+
+    // create agents
+    // The ranges are assigned to the logical thread ids. The loop also covers
+    // all ranges if the team is smaller than `max_threads` (e.g. inside a
+    // task or after `omp_set_num_threads`).
+    auto* uid_generator = Simulation::GetActive()->GetAgentUidGenerator();
+#pragma omp parallel for schedule(static, 1)
+    for (uint64_t tid = 0; tid < max_threads; ++tid) {
+      auto nid = thread_info_->GetNumaNode(tid);
+      auto count = chunk + (tid < remainder ? 1 : 0);
+      auto begin = tid * chunk + std::min(tid, remainder);
+      auto offset = numa_offsets[nid] + thread_offsets[tid];
+      uid_generator->ReserveUids(count);
+      for (uint64_t i = 0; i < count; ++i) {
+        agents_[nid][offset + i] = agent_builder(begin + i);
+      }
+    }
+
+    // insert new agents into the uid map
+    ResizeAgentUidMap();
+#pragma omp parallel for schedule(static, 1)
+    for (uint64_t tid = 0; tid < max_threads; ++tid) {
+      auto nid = thread_info_->GetNumaNode(tid);
+      auto count = chunk + (tid < remainder ? 1 : 0);
+      auto offset = numa_offsets[nid] + thread_offsets[tid];
+      for (uint64_t i = offset; i < offset + count; ++i) {
+        uid_ah_map_.Insert(
+            agents_[nid][i]->GetUid(),
+            AgentHandle(static_cast<AgentHandle::NumaNode_t>(nid),
+                        static_cast<AgentHandle::ElementIdx_t>(i)));
+      }
+    }
+    if (type_index_) {
+      for (int n = 0; n < numa_nodes; n++) {
+        for (uint64_t i = 0; i < new_agent_per_numa[n]; ++i) {
+          type_index_->Add(agents_[n][numa_offsets[n] + i]);
+        }
+      }
+    }
+    MarkEnvironmentOutOfSync();
+  }
+
   /// Adds `new_agents` to `agents_[numa_node]`. `offset` specifies
   /// the index at which the first element is inserted. Agents are inserted
   /// consecutively. This method is thread safe only if insertion intervals do
@@ -432,25 +568,15 @@ class ResourceManager {
   virtual void AddAgents(typename AgentHandle::NumaNode_t numa_node,
                          uint64_t offset,
                          const std::vector<Agent*>& new_agents) {
-    uint64_t i = 0;
-    for (auto* agent : new_agents) {
-      auto uid = agent->GetUid();
-      uid_ah_map_.Insert(
-          uid, AgentHandle(numa_node,
-                           static_cast<AgentHandle::ElementIdx_t>(offset + i)));
-      agents_[numa_node][offset + i] = agent;
-      i++;
-    }
-    if (type_index_) {
-#pragma omp critical
-      for (auto* agent : new_agents) {
-        type_index_->Add(agent);
-      }
-    }
-#pragma omp single
-    if (new_agents.size() != 0) {
-      MarkEnvironmentOutOfSync();
-    }
+    AddAgentsImpl(numa_node, offset, new_agents);
+  }
+
+  /// \see AddAgents(typename AgentHandle::NumaNode_t, uint64_t,
+  ///                 const std::vector<Agent*>&)
+  virtual void AddAgents(typename AgentHandle::NumaNode_t numa_node,
+                         uint64_t offset,
+                         const AppendBuffer<Agent*>& new_agents) {
+    AddAgentsImpl(numa_node, offset, new_agents);
   }
 
   /// Removes the agent with the given uid.\n
@@ -489,6 +615,13 @@ class ResourceManager {
   //              node
   void RemoveAgents(const std::vector<std::vector<AgentUid>*>& uids);
 
+  /// Removes the agents with the given uids in parallel. The agents are
+  /// deleted and their uids are reused.\n
+  /// NB: This method is not thread-safe! This function invalidates
+  /// agent references pointing into the ResourceManager. AgentPointer are
+  /// not affected.
+  void RemoveAgents(const std::vector<AgentUid>& uids);
+
   const TypeIndex* GetTypeIndex() const { return type_index_; }
 
  protected:
@@ -497,6 +630,32 @@ class ResourceManager {
   /// it is aware of the changes.
   void MarkEnvironmentOutOfSync() const;
 
+  /// Implementation of `AddAgents` for all containers that provide `size()`
+  /// and `operator[]`.
+  template <typename TContainer>
+  void AddAgentsImpl(typename AgentHandle::NumaNode_t numa_node,
+                     uint64_t offset, const TContainer& new_agents) {
+    auto num_new_agents = new_agents.size();
+    for (uint64_t i = 0; i < num_new_agents; ++i) {
+      auto* agent = new_agents[i];
+      uid_ah_map_.Insert(
+          agent->GetUid(),
+          AgentHandle(numa_node,
+                      static_cast<AgentHandle::ElementIdx_t>(offset + i)));
+      agents_[numa_node][offset + i] = agent;
+    }
+    if (type_index_) {
+#pragma omp critical
+      for (uint64_t i = 0; i < num_new_agents; ++i) {
+        type_index_->Add(new_agents[i]);
+      }
+    }
+#pragma omp single
+    if (num_new_agents != 0) {
+      MarkEnvironmentOutOfSync();
+    }
+  }
+
   /// Maps an AgentUid to its storage location in `agents_` \n
   AgentUidMap<AgentHandle> uid_ah_map_ = AgentUidMap<AgentHandle>(100u);  //!
   /// Pointer container for all agents
@@ -516,6 +675,13 @@ class ResourceManager {
   /// auxiliary data required for parallel agent removal
   ParallelRemovalAuxData parallel_remove_;  //!
 
+  /// Work counter of one thread used by the dynamic scheduling in
+  /// `ForEachAgentParallel`
+  struct alignas(hardware_destructive_interference_size) WorkCounter {
+    std::atomic<uint64_t> next;
+    uint64_t end;
+  };
+
   friend class SimulationBackup;
   friend std::ostream& operator<<(std::ostream& os, const ResourceManager& rm);
 
@@ -17,6 +17,7 @@
 #include <iomanip>
 #include <string>
 #include <utility>
+#include "core/environment/uniform_grid_environment.h"
 #include "core/execution_context/in_place_exec_ctxt.h"
 #include "core/operation/bound_space_op.h"
 #include "core/operation/continuum_op.h"
@@ -112,6 +113,13 @@ Scheduler::Scheduler() {
     ScheduleOp(NewOperation(def_op), OpType::kPostSchedule);
   }
 
+  // Runs after "tear down iteration" which frees the removed agents
+  if (param->use_bdm_mem_mgr && param->mem_mgr_trim_frequency != 0) {
+    auto* trim_op = NewOperation("trim memory");
+    trim_op->frequency_ = param->mem_mgr_trim_frequency;
+    ScheduleOp(trim_op, OpType::kPostSchedule);
+  }
+
   if (!GetOps("visualize").empty()) {
     GetOps("visualize")[0]->GetImplementation<VisualizationOp>()->Initialize();
   }
@@ -302,18 +310,33 @@ void Scheduler::RunAgentOps(Functor<bool, Agent*>* filter) const {
   const auto& all_exec_ctxts = sim->GetAllExecCtxts();
   all_exec_ctxts[0]->SetupAgentOpsAll(all_exec_ctxts);
 
+  // With box coloring, the environment determines the iteration order
+  UniformGridEnvironment* grid = nullptr;
+  if (param->thread_safety_mechanism ==
+      Param::ThreadSafetyMechanism::kBoxColoring) {
+    grid = dynamic_cast<UniformGridEnvironment*>(sim->GetEnvironment());
+    if (grid == nullptr) {
+      Log::Fatal("Scheduler::RunAgentOps",
+                 "The thread-safety mechanism box-coloring is only supported "
+                 "by the UniformGridEnvironment.");
+    }
+  }
+  auto for_each_agent = [&](Functor<void, Agent*, AgentHandle>& functor) {
+    if (grid != nullptr) {
+      grid->ForEachAgentInColoredBoxes(functor, filter);
+    } else {
+      rm->ForEachAgentParallel(batch_size, functor, filter);
+    }
+  };
+
   if (param->execution_order == Param::ExecutionOrder::kForEachAgentForEachOp) {
     RunAllScheduledOps functor(agent_ops);
-    Timing::Time("agent ops", [&]() {
-      rm->ForEachAgentParallel(batch_size, functor, filter);
-    });
+    Timing::Time("agent ops", [&]() { for_each_agent(functor); });
   } else {
     for (auto* op : agent_ops) {
       decltype(agent_ops) ops = {op};
       RunAllScheduledOps functor(ops);
-      Timing::Time(op->name_, [&]() {
-        rm->ForEachAgentParallel(batch_size, functor, filter);
-      });
+      Timing::Time(op->name_, [&]() { for_each_agent(functor); });
     }
   }
 
@@ -333,22 +356,82 @@ void Scheduler::RunScheduledOps() {
     }
   }
 
-  // Run the column-wise operations
+  RunStandaloneOps();
+
+  TearDownOps();
+}
+
+// -----------------------------------------------------------------------------
+std::vector<std::vector<Operation*>> Scheduler::GetStandaloneOpLevels(
+    const std::vector<Operation*>& ops) {
+  // An operation is placed one level after the last operation it conflicts
+  // with. Thus, the level order respects all dependencies of the DAG.
+  std::vector<OpDataAccess> access(ops.size());
+  std::vector<uint64_t> levels(ops.size(), 0);
+  uint64_t num_levels = 0;
+  for (uint64_t i = 0; i < ops.size(); ++i) {
+    access[i] = ops[i]->GetDataAccess();
+    for (uint64_t j = 0; j < i; ++j) {
+      if (access[j].ConflictsWith(access[i])) {
+        levels[i] = std::max(levels[i], levels[j] + 1);
+      }
+    }
+    num_levels = std::max(num_levels, levels[i] + 1);
+  }
+
+  std::vector<std::vector<Operation*>> result(num_levels);
+  for (uint64_t i = 0; i < ops.size(); ++i) {
+    result[levels[i]].push_back(ops[i]);
+  }
+  return result;
+}
+
+// -----------------------------------------------------------------------------
+void Scheduler::RunStandaloneOps() {
+  std::vector<Operation*> ops;
   for (auto* op : scheduled_standalone_ops_) {
     if (op->frequency_ != 0 && total_steps_ % op->frequency_ == 0) {
+      ops.push_back(op);
+    }
+  }
+  RunStandaloneOpLevels(ops);
+}
+
+// -----------------------------------------------------------------------------
+void Scheduler::RunStandaloneOpLevels(const std::vector<Operation*>& ops) {
+  auto* param = Simulation::GetActive()->GetParam();
+  if (!param->parallel_standalone_ops || ops.size() < 2) {
+    for (auto* op : ops) {
       Timing::Time(op->name_, [&]() { (*op)(); });
     }
+    return;
   }
 
-  TearDownOps();
+  for (auto& level : GetStandaloneOpLevels(ops)) {
+    if (level.size() == 1) {
+      auto* op = level[0];
+      Timing::Time(op->name_, [&]() { (*op)(); });
+      continue;
+    }
+#pragma omp parallel
+#pragma omp single
+    {
+      for (auto* op : level) {
+#pragma omp task firstprivate(op)
+        Timing::Time(op->name_, [&]() { (*op)(); });
+      }
+    }
+  }
 }
 
 void Scheduler::RunPostScheduledOps() const {
+  std::vector<Operation*> ops;
   for (auto* post_op : post_scheduled_ops_) {
     if (post_op->frequency_ != 0 && total_steps_ % post_op->frequency_ == 0) {
-      Timing::Time(post_op->name_, [&]() { (*post_op)(); });
+      ops.push_back(post_op);
     }
   }
+  RunStandaloneOpLevels(ops);
 }
 
 void Scheduler::Execute() {
@@ -216,6 +216,19 @@ class Scheduler {
 
   void RunAgentOps(Functor<bool, Agent*>* filter) const;
 
+  /// Groups `ops` into levels of standalone operations that can be executed
+  /// concurrently. \see Param::parallel_standalone_ops
+  static std::vector<std::vector<Operation*>> GetStandaloneOpLevels(
+      const std::vector<Operation*>& ops);
+
+  // Run the operations in scheduled_standalone_ops_
+  void RunStandaloneOps();
+
+  /// Runs the standalone operations `ops` in the given order. If
+  /// Param::parallel_standalone_ops is set, independent operations are
+  /// executed concurrently (see GetStandaloneOpLevels).
+  static void RunStandaloneOpLevels(const std::vector<Operation*>& ops);
+
   // Run the operations in post_scheduled_ops_ (executed after RunScheduledOps)
   void RunPostScheduledOps() const;
 
@@ -313,9 +313,19 @@ void Simulation::Initialize(CommandLineOptions* clo,
 
 void Simulation::InitializeMembers() {
   if (param_->use_bdm_mem_mgr) {
-    mem_mgr_ = new MemoryManager(param_->mem_mgr_aligned_pages_shift,
-                                 param_->mem_mgr_growth_rate,
-                                 param_->mem_mgr_max_mem_per_thread_factor);
+    auto huge_pages = HugePagePolicy::kNone;
+    if (param_->mem_mgr_huge_pages == "transparent") {
+      huge_pages = HugePagePolicy::kTransparent;
+    } else if (param_->mem_mgr_huge_pages == "explicit") {
+      huge_pages = HugePagePolicy::kExplicit;
+    } else if (param_->mem_mgr_huge_pages != "none") {
+      Log::Error("Simulation::InitializeMembers", "No such huge page policy '",
+                 param_->mem_mgr_huge_pages, "'. Defaulting to 'none'");
+    }
+    mem_mgr_ = new MemoryManager(
+        param_->mem_mgr_aligned_pages_shift, param_->mem_mgr_growth_rate,
+        param_->mem_mgr_max_mem_per_thread_factor, huge_pages,
+        param_->mem_mgr_interleave_min_size);
   }
   agent_uid_generator_ = new AgentUidGenerator();
   if (param_->debug_numa) {
@@ -343,7 +353,16 @@ void Simulation::InitializeMembers() {
   } else if (param_->environment == "octree") {
     environment_ = new OctreeEnvironment();
   } else if (param_->environment == "uniform_grid") {
-    environment_ = new UniformGridEnvironment();
+    auto adjacency = UniformGridEnvironment::Adjacency::kHigh;
+    if (param_->uniform_grid_adjacency == "low") {
+      adjacency = UniformGridEnvironment::Adjacency::kLow;
+    } else if (param_->uniform_grid_adjacency == "medium") {
+      adjacency = UniformGridEnvironment::Adjacency::kMedium;
+    } else if (param_->uniform_grid_adjacency != "high") {
+      Log::Error("Simulation::Initialize", "No such adjacency '",
+                 param_->uniform_grid_adjacency, "'. Defaulting to 'high'");
+    }
+    environment_ = new UniformGridEnvironment(adjacency);
   } else {
     Log::Error("Simulation::Initialize", "No such neighboring method '",
                param_->environment, "'. Defaulting to 'uniform_grid'");
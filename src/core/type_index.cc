@@ -66,6 +66,21 @@ void TypeIndex::Reserve(uint64_t capacity) {
   }
 }
 
+// -----------------------------------------------------------------------------
+void TypeIndex::Rebuild(const std::vector<std::vector<Agent*>>& agents) {
+  Clear();
+  uint64_t num_agents = 0;
+  for (auto& numa_agents : agents) {
+    num_agents += numa_agents.size();
+  }
+  Reserve(num_agents);
+  for (auto& numa_agents : agents) {
+    for (auto* agent : numa_agents) {
+      Add(agent);
+    }
+  }
+}
+
 // -----------------------------------------------------------------------------
 const std::vector<Agent*>& TypeIndex::GetType(TClass* tclass) const {
   return data_[tclass];
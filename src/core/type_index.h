@@ -36,6 +36,10 @@ class TypeIndex {
 
   void Reserve(uint64_t capacity);
 
+  /// Replaces the content of this index with `agents`. Agents of the same
+  /// type are stored in the order in which they appear in `agents`.
+  void Rebuild(const std::vector<std::vector<Agent*>>& agents);
+
   const std::vector<Agent*>& GetType(TClass* tclass) const;
 
  private:
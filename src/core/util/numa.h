@@ -34,7 +34,12 @@ inline int numa_move_pages(int pid, unsigned long count, void **pages,
   return 0;
 }
 inline void *numa_alloc_onnode(uint64_t size, int nid) { return malloc(size); }
+inline void *numa_alloc_interleaved(uint64_t size) { return malloc(size); }
 inline void numa_free(void *p, uint64_t) { free(p); }
+struct bitmask;
+static struct bitmask *numa_all_nodes_ptr = nullptr;
+inline void numa_tonode_memory(void *, uint64_t, int) {}
+inline void numa_interleave_memory(void *, uint64_t, struct bitmask *) {}
 
 // on linux in <sched.h>, but missing on MacOS
 inline int sched_getcpu() { return 0; }
@@ -0,0 +1,217 @@
+// -----------------------------------------------------------------------------
+//
+// Copyright (C) 2021 CERN & University of Surrey for the benefit of the
+// BioDynaMo collaboration. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+//
+// See the LICENSE file distributed with this work for details.
+// See the NOTICE file distributed with this work for additional information
+// regarding copyright ownership.
+//
+// -----------------------------------------------------------------------------
+
+#ifndef CORE_UTIL_PHILOX_RNG_H_
+#define CORE_UTIL_PHILOX_RNG_H_
+
+#include <array>
+#include <cmath>
+#include <cstdint>
+
+#include "core/container/math_array.h"
+#include "core/real_t.h"
+
+namespace bdm {
+
+/// Counter-based random number generator (Philox4x32-10).\n
+/// Salmon et al. 2011, "Parallel random numbers: as easy as 1, 2, 3".\n
+/// In contrast to `Random`, the generated numbers are a pure function of
+/// (seed, agent uid, time step, stream, draw index). They do not depend on
+/// which thread processes an agent, so stochastic behaviors are
+/// reproducible for any number of threads and any scheduling.
+/// All member functions are non-virtual and can be inlined.\n
+/// The seed and the stream are mixed into the 64 bit key, the draw index,
+/// the time step and the agent uid form the 128 bit counter.
+/// Each generator can therefore produce 2^32 blocks of four 32 bit values.
+/// \see Random::GetCounterBasedRng
+class PhiloxRng {
+ public:
+  using Block = std::array<uint32_t, 4>;
+  using Key = std::array<uint32_t, 2>;
+
+  PhiloxRng(uint64_t seed, uint64_t uid, uint64_t step, uint32_t stream = 0)
+      : step_(static_cast<uint32_t>(step)),
+        uid_lo_(static_cast<uint32_t>(uid)),
+        uid_hi_(static_cast<uint32_t>(uid >> 32)) {
+    auto mixed = SplitMix64(seed + stream * 0x9E3779B97F4A7C15ull);
+    key_ = {static_cast<uint32_t>(mixed), static_cast<uint32_t>(mixed >> 32)};
+  }
+
+  /// Derives the key of child `idx` from `key`. Agents that are created
+  /// by division obtain their key in this way, such that it does not depend
+  /// on their uid (which depends on the scheduling).
+  static uint64_t SplitKey(uint64_t key, uint64_t idx) {
+    return SplitMix64(key ^ SplitMix64(idx));
+  }
+
+  /// Philox4x32 bijection with ten rounds.
+  static Block Philox4x32(Block ctr, Key key) {
+    for (int round = 0; round < 10; ++round) {
+      if (round != 0) {
+        key[0] += kWeyl0;
+        key[1] += kWeyl1;
+      }
+      uint64_t prod0 = static_cast<uint64_t>(kMul0) * ctr[0];
+      uint64_t prod1 = static_cast<uint64_t>(kMul1) * ctr[2];
+      ctr = {static_cast<uint32_t>(prod1 >> 32) ^ ctr[1] ^ key[0],
+             static_cast<uint32_t>(prod1),
+             static_cast<uint32_t>(prod0 >> 32) ^ ctr[3] ^ key[1],
+             static_cast<uint32_t>(prod0)};
+    }
+    return ctr;
+  }
+
+  /// Returns the block with index `block_idx` of this generator.
+  /// Does not change the state of the generator.
+  Block GetBlock(uint32_t block_idx) const {
+    return Philox4x32({block_idx, step_, uid_lo_, uid_hi_}, key_);
+  }
+
+  /// Returns a uniform deviate on the interval (0, max).
+  real_t Uniform(real_t max = 1.0) { return max * ToUniform(Next()); }
+
+  /// Returns a uniform deviate on the interval (min, max).
+  real_t Uniform(real_t min, real_t max) {
+    return min + (max - min) * ToUniform(Next());
+  }
+
+  /// Returns a normally distributed sample (Box-Muller transform).
+  real_t Gaus(real_t mean = 0.0, real_t sigma = 1.0) {
+    if (has_spare_) {
+      has_spare_ = false;
+      return mean + sigma * spare_;
+    }
+    real_t gaus[2];
+    BoxMuller(Next(), Next(), gaus);
+    spare_ = gaus[1];
+    has_spare_ = true;
+    return mean + sigma * gaus[0];
+  }
+
+  /// Returns an array of uniform random numbers in the interval (0, max)
+  template <uint64_t N>
+  MathArray<real_t, N> UniformArray(real_t max = 1.0) {
+    MathArray<real_t, N> ret;
+    for (uint64_t i = 0; i < N; i++) {
+      ret[i] = Uniform(max);
+    }
+    return ret;
+  }
+
+  /// Returns an array of uniform random numbers in the interval (min, max)
+  template <uint64_t N>
+  MathArray<real_t, N> UniformArray(real_t min, real_t max) {
+    MathArray<real_t, N> ret;
+    for (uint64_t i = 0; i < N; i++) {
+      ret[i] = Uniform(min, max);
+    }
+    return ret;
+  }
+
+  /// Fills `out` with `n` uniform random numbers in the interval (min, max).
+  /// Whole blocks are generated in a vectorizable loop. The result is
+  /// deterministic, but differs from `n` calls to `Uniform`.
+  void UniformArray(real_t* out, uint64_t n, real_t min = 0,
+                    real_t max = 1.0) {
+    const uint32_t first = block_idx_;
+    const uint64_t num_blocks = n / 4;
+    const auto range = max - min;
+#pragma omp simd
+    for (uint64_t b = 0; b < num_blocks; ++b) {
+      auto block = GetBlock(first + static_cast<uint32_t>(b));
+      for (int j = 0; j < 4; ++j) {
+        out[4 * b + j] = min + range * ToUniform(block[j]);
+      }
+    }
+    block_idx_ += static_cast<uint32_t>(num_blocks);
+    for (uint64_t i = 4 * num_blocks; i < n; ++i) {
+      out[i] = Uniform(min, max);
+    }
+  }
+
+  /// Fills `out` with `n` normally distributed samples.
+  /// Whole blocks are generated in a vectorizable loop. The result is
+  /// deterministic, but differs from `n` calls to `Gaus`.
+  void GausArray(real_t* out, uint64_t n, real_t mean = 0.0,
+                 real_t sigma = 1.0) {
+    const uint32_t first = block_idx_;
+    const uint64_t num_blocks = n / 4;
+#pragma omp simd
+    for (uint64_t b = 0; b < num_blocks; ++b) {
+      auto block = GetBlock(first + static_cast<uint32_t>(b));
+      real_t gaus[4];
+      BoxMuller(block[0], block[1], &gaus[0]);
+      BoxMuller(block[2], block[3], &gaus[2]);
+      for (int j = 0; j < 4; ++j) {
+        out[4 * b + j] = mean + sigma * gaus[j];
+      }
+    }
+    block_idx_ += static_cast<uint32_t>(num_blocks);
+    for (uint64_t i = 4 * num_blocks; i < n; ++i) {
+      out[i] = Gaus(mean, sigma);
+    }
+  }
+
+ private:
+  static constexpr uint32_t kMul0 = 0xD2511F53;
+  static constexpr uint32_t kMul1 = 0xCD9E8D57;
+  static constexpr uint32_t kWeyl0 = 0x9E3779B9;
+  static constexpr uint32_t kWeyl1 = 0xBB67AE85;
+
+  Key key_;
+  uint32_t step_;
+  uint32_t uid_lo_;
+  uint32_t uid_hi_;
+  /// Index of the next block that will be generated
+  uint32_t block_idx_ = 0;
+  Block block_;
+  /// Position of the next unused value in `block_`
+  uint32_t pos_ = 4;
+  real_t spare_ = 0;
+  bool has_spare_ = false;
+
+  static uint64_t SplitMix64(uint64_t x) {
+    x += 0x9E3779B97F4A7C15ull;
+    x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ull;
+    x = (x ^ (x >> 27)) * 0x94D049BB133111EBull;
+    return x ^ (x >> 31);
+  }
+
+  /// Maps a 32 bit integer to the open interval (0, 1)
+  static real_t ToUniform(uint32_t x) {
+    // 2^-32
+    constexpr real_t kScale = real_t(2.3283064365386963e-10);
+    return (static_cast<real_t>(x) + real_t(0.5)) * kScale;
+  }
+
+  static void BoxMuller(uint32_t u0, uint32_t u1, real_t* result) {
+    constexpr real_t kTwoPi = real_t(6.283185307179586);
+    auto radius = std::sqrt(-2 * std::log(ToUniform(u0)));
+    auto angle = kTwoPi * ToUniform(u1);
+    result[0] = radius * std::cos(angle);
+    result[1] = radius * std::sin(angle);
+  }
+
+  uint32_t Next() {
+    if (pos_ == 4) {
+      block_ = GetBlock(block_idx_++);
+      pos_ = 0;
+    }
+    return block_[pos_++];
+  }
+};
+
+}  // namespace bdm
+
+#endif  // CORE_UTIL_PHILOX_RNG_H_
@@ -17,6 +17,7 @@
 #include <TF2.h>
 #include <TF3.h>
 #include <TRandom3.h>
+#include "core/scheduler.h"
 #include "core/simulation.h"
 
 namespace bdm {
@@ -27,6 +28,13 @@ Random::Random() : generator_(new TRandom3()) {}
 // -----------------------------------------------------------------------------
 Random::Random(TRootIOCtor*) {}
 
+// -----------------------------------------------------------------------------
+PhiloxRng Random::GetCounterBasedRng(uint64_t key, uint32_t stream) {
+  auto* sim = Simulation::GetActive();
+  return PhiloxRng(sim->GetParam()->random_seed, key,
+                   sim->GetScheduler()->GetSimulatedSteps(), stream);
+}
+
 // -----------------------------------------------------------------------------
 Random::Random(const Random& other)
     : generator_(static_cast<TRandom*>(other.generator_->Clone())) {}
@@ -18,6 +18,7 @@
 #include <unordered_map>
 #include "core/container/fixed_size_vector.h"
 #include "core/container/math_array.h"
+#include "core/util/philox_rng.h"
 #include "core/util/root.h"
 
 class TRandom;
@@ -411,6 +412,15 @@ class Random {
       real_t ymin, real_t ymax, real_t zmin, real_t zmax,
       const char* option = nullptr);
 
+  /// Returns a counter-based random number generator for the agent with the
+  /// random number key `key` (e.g. `Cell::GetRngKey()`) in the current time
+  /// step. The generator is keyed by `Param::random_seed`, `key`, the number
+  /// of simulated steps and `stream`. It generates the same numbers,
+  /// independent of the thread that calls this function.
+  /// Use different `stream`s for independent random decisions of the same
+  /// agent in the same time step.
+  static PhiloxRng GetCounterBasedRng(uint64_t key, uint32_t stream = 0);
+
   /// Returns a random number generator that draws samples from a
   /// Binomial distribution with given parameters.
   BinomialRng GetBinomialRng(int ntot, real_t prob) const;
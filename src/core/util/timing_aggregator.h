@@ -33,6 +33,8 @@ class TimingAggregator {
   ~TimingAggregator() = default;
 
   void AddEntry(const std::string& key, int64_t value) {
+    // standalone operations might be timed concurrently
+#pragma omp critical(timing_aggregator_add_entry)
     if (!timings_.count(key)) {
       std::vector<int64_t> data;
       data.push_back(value);
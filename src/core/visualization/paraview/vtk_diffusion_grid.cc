@@ -109,7 +109,7 @@ void VtkDiffusionGrid::Update(const DiffusionGrid* grid) {
 
   auto num_boxes = grid->GetNumBoxesArray();
   auto grid_dimensions = grid->GetDimensions();
-  auto box_length = grid->GetBoxLength();
+  const auto& box_lengths = grid->GetBoxLengths();
   auto total_boxes = grid->GetNumBoxes();
 
   auto* tinfo = ThreadInfo::GetInstance();
@@ -119,15 +119,15 @@ void VtkDiffusionGrid::Update(const DiffusionGrid* grid) {
   Dissect(num_boxes[2], tinfo->GetMaxThreads());
   CalcPieceExtents(num_boxes);
   uint64_t xy_num_boxes = num_boxes[0] * num_boxes[1];
-  real_t origin_x = grid_dimensions[0] + box_length / 2.;
-  real_t origin_y = grid_dimensions[2] + box_length / 2.;
-  real_t origin_z = grid_dimensions[4] + box_length / 2.;
+  real_t origin_x = grid_dimensions[0] + box_lengths[0] / 2.;
+  real_t origin_y = grid_dimensions[2] + box_lengths[1] / 2.;
+  real_t origin_z = grid_dimensions[4] + box_lengths[2] / 2.;
 
   // do not partition data for insitu visualization
   if (data_.size() == 1) {
     data_[0]->SetOrigin(origin_x, origin_y, origin_z);
     data_[0]->SetDimensions(num_boxes[0], num_boxes[1], num_boxes[2]);
-    data_[0]->SetSpacing(box_length, box_length, box_length);
+    data_[0]->SetSpacing(box_lengths[0], box_lengths[1], box_lengths[2]);
 
     if (concentration_array_idx_ != -1) {
       auto* co_ptr = const_cast<real_t*>(grid->GetAllConcentrations());
@@ -161,9 +161,9 @@ void VtkDiffusionGrid::Update(const DiffusionGrid* grid) {
       data_[i]->SetExtent(e[0], e[1], e[2], e[3], e[4],
                           e[4] + piece_boxes_z_last_ - 1);
     }
-    real_t piece_origin_z = origin_z + box_length * piece_boxes_z_ * i;
+    real_t piece_origin_z = origin_z + box_lengths[2] * piece_boxes_z_ * i;
     data_[i]->SetOrigin(origin_x, origin_y, piece_origin_z);
-    data_[i]->SetSpacing(box_length, box_length, box_length);
+    data_[i]->SetSpacing(box_lengths[0], box_lengths[1], box_lengths[2]);
 
     if (concentration_array_idx_ != -1) {
       auto* co_ptr = const_cast<real_t*>(grid->GetAllConcentrations());
@@ -165,6 +165,20 @@ TEST(CellTest, DivideVolumeRatioAxis) {
   EXPECT_NEAR(cell.captured_theta_, 0.72664234068172562, kEpsilon);
 }
 
+TEST(CellTest, DivideRngKey) {
+  auto set_param = [](Param* param) { param->use_counter_based_rng = true; };
+  Simulation simulation(TEST_NAME, set_param);
+
+  Cell mother;
+  uint64_t key = mother.GetRngKey();
+  EXPECT_EQ(static_cast<uint64_t>(mother.GetUid()), key);
+
+  auto* daughter = mother.Divide();
+  EXPECT_EQ(PhiloxRng::SplitKey(key, 0), mother.GetRngKey());
+  EXPECT_EQ(PhiloxRng::SplitKey(key, 1), daughter->GetRngKey());
+  EXPECT_NE(mother.GetRngKey(), daughter->GetRngKey());
+}
+
 #ifdef USE_DICT
 TEST(CellTest, IO) { RunIOTest(); }
 #endif  // USE_DICT
@@ -43,6 +43,48 @@ TEST(Reduce, Reduce) {
   EXPECT_EQ(1999000u, result);
 }
 
+// -----------------------------------------------------------------------------
+TEST(Reduce, ReduceDeterministic) {
+  auto set_param = [](Param* param) {
+    param->deterministic_scheduling = true;
+    param->scheduling_batch_size = 100;
+  };
+  Simulation sim(TEST_NAME, set_param);
+  auto* rm = sim.GetResourceManager();
+
+  for (uint64_t i = 0; i < 2050; ++i) {
+    auto* a = new TestAgent();
+    a->SetDiameter(1.0 / (i + 1));
+    rm->AddAgent(a);
+  }
+  EXPECT_EQ(21u, rm->GetNumChunks(100));
+
+  // expected result: partial results of chunks combined in chunk order
+  std::vector<real_t> chunk_results(rm->GetNumChunks(100), 0);
+  uint64_t chunk_offset = 0;
+  uint64_t current_nid = 0;
+  rm->ForEachAgent([&](Agent* agent, AgentHandle ah) {
+    if (ah.GetNumaNode() != current_nid) {
+      chunk_offset += (rm->GetNumAgents(current_nid) + 99) / 100;
+      current_nid = ah.GetNumaNode();
+    }
+    chunk_results[chunk_offset + ah.GetElementIdx() / 100] +=
+        agent->GetDiameter();
+  });
+  real_t expected = 0;
+  for (auto& el : chunk_results) {
+    expected += el;
+  }
+
+  auto sum_diameter = L2F([](Agent* agent, real_t* result) {
+    *result += agent->GetDiameter();
+  });
+  SumReduction<real_t> combine_results;
+  for (int i = 0; i < 3; ++i) {
+    EXPECT_EQ(expected, Reduce(&sim, sum_diameter, combine_results));
+  }
+}
+
 // -----------------------------------------------------------------------------
 TEST(Reduce, GenericReducer) {
   Simulation sim(TEST_NAME);
@@ -0,0 +1,75 @@
+// -----------------------------------------------------------------------------
+//
+// Copyright (C) 2021 CERN & University of Surrey for the benefit of the
+// BioDynaMo collaboration. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+//
+// See the LICENSE file distributed with this work for details.
+// See the NOTICE file distributed with this work for additional information
+// regarding copyright ownership.
+//
+// -----------------------------------------------------------------------------
+
+#include "core/container/append_buffer.h"
+#include <gtest/gtest.h>
+
+namespace bdm {
+
+TEST(AppendBufferTest, Basics) {
+  AppendBuffer<uint64_t, 4> buffer;
+  EXPECT_TRUE(buffer.empty());
+  EXPECT_EQ(0u, buffer.capacity());
+
+  for (uint64_t i = 0; i < 10; ++i) {
+    buffer.push_back(i);
+  }
+  ASSERT_EQ(10u, buffer.size());
+  EXPECT_EQ(12u, buffer.capacity());
+
+  // subscript operator
+  for (uint64_t i = 0; i < buffer.size(); ++i) {
+    EXPECT_EQ(i, buffer[i]);
+  }
+
+  // iterator
+  uint64_t cnt = 0;
+  for (auto& el : buffer) {
+    EXPECT_EQ(cnt++, el);
+  }
+  EXPECT_EQ(10u, cnt);
+
+  // references stay valid while the buffer grows
+  auto* first = &buffer[0];
+  for (uint64_t i = 10; i < 100; ++i) {
+    buffer.push_back(i);
+  }
+  EXPECT_EQ(first, &buffer[0]);
+  EXPECT_EQ(0u, *first);
+
+  // clear keeps the memory
+  auto capacity = buffer.capacity();
+  buffer.clear();
+  EXPECT_TRUE(buffer.empty());
+  EXPECT_EQ(capacity, buffer.capacity());
+  buffer.push_back(123);
+  EXPECT_EQ(first, &buffer[0]);
+  EXPECT_EQ(123u, buffer[0]);
+}
+
+TEST(AppendBufferTest, CopyTo) {
+  AppendBuffer<int, 8> buffer;
+  for (int i = 0; i < 21; ++i) {
+    buffer.push_back(i);
+  }
+  std::vector<int> dest(23, -1);
+  buffer.CopyTo(dest.data() + 1);
+  EXPECT_EQ(-1, dest[0]);
+  for (int i = 0; i < 21; ++i) {
+    EXPECT_EQ(i, dest[i + 1]);
+  }
+  EXPECT_EQ(-1, dest[22]);
+}
+
+}  // namespace bdm
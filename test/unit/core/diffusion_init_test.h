@@ -57,9 +57,9 @@ class TestGrid : public DiffusionGrid {
 
   // Compares all inner values of the array c1_ with a specific value.
   bool ComapareInnerArrayWithValue(real_t value) {
-    auto nx = GetResolution();
-    auto ny = GetResolution();
-    auto nz = GetResolution();
+    auto nx = GetNumBoxesArray()[0];
+    auto ny = GetNumBoxesArray()[1];
+    auto nz = GetNumBoxesArray()[2];
 
     for (uint32_t x = 1; x < nx - 1; x++) {
       for (uint32_t y = 1; y < ny - 1; y++) {
@@ -77,9 +77,9 @@ class TestGrid : public DiffusionGrid {
 
   // Compare all boundary values of the array c1_ with a specific value.
   bool CompareBoundaryValues(real_t value) {
-    auto nx = GetResolution();
-    auto ny = GetResolution();
-    auto nz = GetResolution();
+    auto nx = GetNumBoxesArray()[0];
+    auto ny = GetNumBoxesArray()[1];
+    auto nz = GetNumBoxesArray()[2];
 
     for (uint32_t x = 0; x < nx; x++) {
       for (uint32_t y = 0; y < ny; y++) {
@@ -15,9 +15,11 @@
 #include <fstream>
 
 #include "core/agent/cell.h"
+#include "core/diffusion/adi_grid.h"
 #include "core/diffusion/diffusion_grid.h"
 #include "core/diffusion/euler_depletion_grid.h"
 #include "core/diffusion/euler_grid.h"
+#include "core/diffusion/sparse_euler_grid.h"
 #include "core/environment/environment.h"
 #include "core/model_initializer.h"
 #include "core/substance_initializers.h"
@@ -404,6 +406,113 @@ TEST(DiffusionTest, GetNeighboringBoxes) {
   delete dgrid;
 }
 
+TEST(DiffusionTest, SlabDomain) {
+  Simulation simulation(TEST_NAME);
+
+  // 2000 x 2000 x 100 slab with 40 boxes along the longest axis
+  EulerGrid dgrid(0, "Kalium", 0.4, 0, 40);
+  dgrid.SetDomain({-1000, 1000, -1000, 1000, 0, 100});
+  dgrid.Initialize();
+
+  const auto num_boxes = dgrid.GetNumBoxesArray();
+  EXPECT_EQ(40u, num_boxes[0]);
+  EXPECT_EQ(40u, num_boxes[1]);
+  EXPECT_EQ(2u, num_boxes[2]);
+  EXPECT_EQ(3200u, dgrid.GetNumBoxes());
+  EXPECT_EQ(40u, dgrid.GetResolution());
+  for (auto box_length : dgrid.GetBoxLengths()) {
+    EXPECT_REAL_EQ(50, box_length);
+  }
+  EXPECT_REAL_EQ(50 * 50 * 50, dgrid.GetBoxVolume());
+  std::array<int32_t, 3> grid_size = {2000, 2000, 100};
+  EXPECT_EQ(grid_size, dgrid.GetGridSize());
+
+  const Real3 position = {-990, 990, 60};
+  std::array<uint32_t, 3> box_coord = {0, 39, 1};
+  EXPECT_EQ(box_coord, dgrid.GetBoxCoordinates(position));
+  const size_t idx = dgrid.GetBoxIndex(position);
+  EXPECT_EQ(39u * 40 + 1 * 1600, idx);
+  const auto neighbors = dgrid.GetNeighboringBoxes(idx);
+  EXPECT_EQ(idx, neighbors[0]);
+  EXPECT_EQ(idx + 1, neighbors[1]);
+  EXPECT_EQ(idx - 40, neighbors[2]);
+  EXPECT_EQ(idx, neighbors[3]);
+  EXPECT_EQ(idx - 1600, neighbors[4]);
+  EXPECT_EQ(idx, neighbors[5]);
+
+  for (size_t i = 0; i < dgrid.GetNumBoxes(); i++) {
+    EXPECT_EQ(i, dgrid.GetBoxIndex(dgrid.GetBoxCoordinates(i)));
+  }
+
+  // A user-defined domain does not follow the environment
+  dgrid.Update();
+  std::array<int32_t, 6> domain = {-1000, 1000, -1000, 1000, 0, 100};
+  EXPECT_EQ(domain, dgrid.GetDimensions());
+  EXPECT_EQ(3200u, dgrid.GetNumBoxes());
+}
+
+TEST(DiffusionTest, PositionOutsideSlabDomain) {
+  Simulation simulation(TEST_NAME);
+
+  EulerGrid dgrid(0, "Kalium", 0.4, 0, 40);
+  dgrid.SetDomain({-1000, 1000, -1000, 1000, 0, 100});
+  dgrid.Initialize();
+
+  // The upper edge of the domain belongs to the last box
+  EXPECT_EQ(dgrid.GetNumBoxes() - 1, dgrid.GetBoxIndex({1000, 1000, 100}));
+
+  // Agents past the edge along each axis must not be folded into another box
+  for (const Real3& position :
+       {Real3{1010, 0, 50}, Real3{-1010, 0, 50}, Real3{0, 1010, 50},
+        Real3{0, -1010, 50}, Real3{0, 0, 150}, Real3{0, 0, -10}}) {
+    Cell cell(position);
+    EXPECT_EQ(dgrid.GetNumBoxes(), dgrid.GetBoxIndex(cell.GetPosition()));
+    dgrid.ChangeConcentrationBy(cell.GetPosition(), 1,
+                                InteractionMode::kAdditive, false);
+    EXPECT_EQ(0, dgrid.GetValue(cell.GetPosition()));
+  }
+
+  const auto* conc = dgrid.GetAllConcentrations();
+  for (size_t i = 0; i < dgrid.GetNumBoxes(); i++) {
+    EXPECT_EQ(0, conc[i]);
+  }
+}
+
+TEST(DiffusionTest, AnisotropicResolution) {
+  Simulation simulation(TEST_NAME);
+
+  EulerGrid dgrid(0, "Kalium", 0.4, 0);
+  dgrid.SetDomain({-50, 50, -50, 50, -50, 50});
+  dgrid.SetResolution({20, 10, 5});
+  dgrid.Initialize();
+
+  EXPECT_EQ(1000u, dgrid.GetNumBoxes());
+  EXPECT_EQ(20u, dgrid.GetResolution());
+  EXPECT_REAL_EQ(5, dgrid.GetBoxLengths()[0]);
+  EXPECT_REAL_EQ(10, dgrid.GetBoxLengths()[1]);
+  EXPECT_REAL_EQ(20, dgrid.GetBoxLengths()[2]);
+  EXPECT_REAL_EQ(1000, dgrid.GetBoxVolume());
+
+  std::array<uint32_t, 3> box_coord = {0, 0, 4};
+  EXPECT_EQ(box_coord, dgrid.GetBoxCoordinates({-46, -41, 31}));
+
+  // Box centers are at -47.5 + 5 * x, -45 + 10 * y and -40 + 20 * z
+  dgrid.ChangeConcentrationBy({-37.5, -35, -20}, 1e4,
+                              InteractionMode::kAdditive, true);
+  EXPECT_REAL_EQ(10, dgrid.GetValue({-37.5, -35, -20}));
+  dgrid.CalculateGradient();
+
+  // Central differences with the box length of each axis
+  Real3 gradient;
+  dgrid.GetGradient({-42.5, -35, -20}, &gradient, false);
+  EXPECT_REAL_EQ(1, gradient[0]);
+  dgrid.GetGradient({-37.5, -45, -20}, &gradient, false);
+  EXPECT_REAL_EQ(1, gradient[1]);
+  // Forward difference at the edge of the grid
+  dgrid.GetGradient({-37.5, -35, -40}, &gradient, false);
+  EXPECT_REAL_EQ(0.5, gradient[2]);
+}
+
 // Create a 5x5x5 diffusion grid, with a substance being
 // added at center box 2,2,2, causing a symmetrical diffusion
 TEST(DiffusionTest, Thresholds) {
@@ -970,6 +1079,37 @@ TEST(DiffusionTest, DepletionMissmatch) {
       "that of the depleted one (ECM)*");
 }
 
+// Tests Fatal if depletion grids have the same number of boxes, but a different
+// number of boxes along the axes
+TEST(DiffusionTest, DepletionMissmatchAxes) {
+  ASSERT_DEATH(
+      {
+        auto set_param = [](auto* param) {
+          param->bound_space = Param::BoundSpaceMode::kClosed;
+          param->min_bound = -100;
+          param->max_bound = 100;
+        };
+        Simulation simulation(TEST_NAME, set_param);
+        simulation.GetEnvironment()->Update();
+        auto* rm = simulation.GetResourceManager();
+
+        auto* dgrid_depletes = new EulerGrid(0, "MMP", 0.0, 0.0);
+        auto* dgrid_depleted = new EulerDepletionGrid(1, "ECM", 0.0, 0.01);
+        dgrid_depletes->SetResolution({10, 20, 30});
+        dgrid_depleted->SetResolution({30, 20, 10});
+        dgrid_depletes->Initialize();
+        rm->AddContinuum(dgrid_depletes);
+        dgrid_depleted->Initialize();
+        rm->AddContinuum(dgrid_depleted);
+        ASSERT_EQ(dgrid_depletes->GetNumBoxes(), dgrid_depleted->GetNumBoxes());
+
+        dgrid_depleted->SetBindingSubstance(0, 0.01);
+        dgrid_depleted->Diffuse(0.1);
+      },
+      ".*The number of voxels of the depleting diffusion grid MMP differs from "
+      "that of the depleted one \\(ECM\\) along at least one axis.*");
+}
+
 TEST(DiffusionTest, EulerDirichletBoundaries) {
   double simulation_time_step{0.1};
   auto set_param = [](auto* param) {
@@ -1199,6 +1339,438 @@ TEST(DiffusionTest, EulerPeriodicBoundaries) {
   }
 }
 
+/// Fusing several steps with temporal blocking must give the same result as
+/// executing the steps one after another.
+TEST(DiffusionTest, EulerTemporalBlocking) {
+  auto set_param = [](auto* param) {
+    param->bound_space = Param::BoundSpaceMode::kClosed;
+    param->min_bound = -100;
+    param->max_bound = 100;
+    param->diffusion_temporal_blocking = 3;
+  };
+  Simulation simulation(TEST_NAME, set_param);
+  simulation.GetEnvironment()->Update();
+
+  std::vector<BoundaryConditionType> bc_types = {
+      BoundaryConditionType::kClosedBoundaries,
+      BoundaryConditionType::kDirichlet, BoundaryConditionType::kNeumann,
+      BoundaryConditionType::kPeriodic};
+  for (auto bc_type : bc_types) {
+    // 40 boxes per axis, i.e. several tiles along each axis
+    EulerGrid blocked(0, "Blocked", 10.0, 0.01, 40);
+    EulerGrid reference(1, "Reference", 10.0, 0.01, 40);
+    for (auto* dgrid : {&blocked, &reference}) {
+      dgrid->Initialize();
+      dgrid->SetBoundaryConditionType(bc_type);
+      dgrid->SetBoundaryCondition(
+          std::make_unique<ConstantBoundaryCondition>(0.5));
+      dgrid->SetUpperThreshold(1e15);
+      dgrid->ChangeConcentrationBy({0, 0, 0}, 1e3);
+      dgrid->ChangeConcentrationBy({-95, 95, -95}, 1e3);
+      dgrid->ChangeConcentrationBy({52, -7, 98}, 1e3);
+    }
+
+    // 8 steps: two blocked passes with 3 steps and one with 2 steps
+    const real_t dt = 0.25;
+    blocked.MultiStep(dt, 8);
+    for (int i = 0; i < 8; i++) {
+      reference.Diffuse(dt);
+    }
+
+    auto* conc_blocked = blocked.GetAllConcentrations();
+    auto* conc_reference = reference.GetAllConcentrations();
+    for (size_t i = 0; i < reference.GetNumBoxes(); i++) {
+      EXPECT_NEAR(conc_reference[i], conc_blocked[i],
+                  1e-5 * (1 + std::abs(conc_reference[i])));
+    }
+    EXPECT_EQ(dt, blocked.GetLastTimestep());
+  }
+}
+
+/// A concentration that only varies along one axis must evolve identically on
+/// a grid with fewer boxes along the other axes and on a cubic grid.
+TEST(DiffusionTest, AnisotropicBoxes) {
+  auto set_param = [](auto* param) {
+    param->diffusion_temporal_blocking = 3;
+  };
+  Simulation simulation(TEST_NAME, set_param);
+
+  auto make_grid = [](bool adi, int id, const std::string& name) {
+    if (adi) {
+      return std::unique_ptr<DiffusionGrid>(new AdiGrid(id, name, 1, 0.01));
+    }
+    return std::unique_ptr<DiffusionGrid>(new EulerGrid(id, name, 1, 0.01));
+  };
+
+  for (bool adi : {false, true}) {
+    for (auto bc_type :
+         {BoundaryConditionType::kNeumann, BoundaryConditionType::kPeriodic}) {
+      for (size_t axis = 0; axis < 3; axis++) {
+        std::array<size_t, 3> resolution = {4, 6, 3};
+        resolution[axis] = 20;
+        auto anisotropic = make_grid(adi, 0, "Anisotropic");
+        auto cubic = make_grid(adi, 1, "Cubic");
+        anisotropic->SetResolution(resolution);
+        cubic->SetResolution({20, 20, 20});
+        for (auto* dgrid : {anisotropic.get(), cubic.get()}) {
+          dgrid->SetDomain({0, 100, 0, 100, 0, 100});
+          dgrid->AddInitializer([axis](real_t x, real_t y, real_t z) {
+            const real_t coord[3] = {x, y, z};
+            return 1 + std::sin(2 * Math::kPi * coord[axis] / 100);
+          });
+          dgrid->Initialize();
+          dgrid->SetBoundaryConditionType(bc_type);
+          dgrid->RunInitializers();
+          dgrid->MultiStep(1, 10);
+        }
+
+        auto* conc_anisotropic = anisotropic->GetAllConcentrations();
+        auto* conc_cubic = cubic->GetAllConcentrations();
+        for (size_t i = 0; i < anisotropic->GetNumBoxes(); i++) {
+          auto box_coord = anisotropic->GetBoxCoordinates(i);
+          std::array<uint32_t, 3> line_coord = {0, 0, 0};
+          line_coord[axis] = box_coord[axis];
+          EXPECT_NEAR(conc_cubic[cubic->GetBoxIndex(line_coord)],
+                      conc_anisotropic[i], 1e-9);
+        }
+      }
+    }
+  }
+}
+
+/// The fused kernel must give the same result as diffusing the grids one
+/// after another. Binding substances contribute their concentration from the
+/// beginning of the step, which corresponds to diffusing the depleted
+/// substance first.
+TEST(DiffusionTest, EulerFusedGrids) {
+  auto set_param = [](auto* param) {
+    param->bound_space = Param::BoundSpaceMode::kClosed;
+    param->min_bound = -100;
+    param->max_bound = 100;
+    param->diffusion_boundary_condition = "Neumann";
+  };
+  Simulation simulation(TEST_NAME, set_param);
+  simulation.GetEnvironment()->Update();
+  auto* rm = simulation.GetResourceManager();
+
+  int res = 20;
+  auto* fused_depleting = new EulerGrid(0, "FusedMMP", 10.0, 0.01, res);
+  auto* fused_depleted =
+      new EulerDepletionGrid(1, "FusedECM", 5.0, 0.02, res);
+  auto* depleting = new EulerGrid(2, "MMP", 10.0, 0.01, res);
+  auto* depleted = new EulerDepletionGrid(3, "ECM", 5.0, 0.02, res);
+  fused_depleted->SetBindingSubstance(0, 0.1);
+  depleted->SetBindingSubstance(2, 0.1);
+  for (DiffusionGrid* dgrid :
+       {static_cast<DiffusionGrid*>(fused_depleting),
+        static_cast<DiffusionGrid*>(fused_depleted),
+        static_cast<DiffusionGrid*>(depleting),
+        static_cast<DiffusionGrid*>(depleted)}) {
+    dgrid->Initialize();
+    dgrid->SetUpperThreshold(1e15);
+    rm->AddContinuum(dgrid);
+  }
+  fused_depleting->ChangeConcentrationBy({10, 10, 10}, 1e3);
+  depleting->ChangeConcentrationBy({10, 10, 10}, 1e3);
+  fused_depleted->ChangeConcentrationBy({0, 0, 0}, 1e3);
+  depleted->ChangeConcentrationBy({0, 0, 0}, 1e3);
+
+  ASSERT_TRUE(fused_depleting->CanFuseWith(*fused_depleted));
+
+  const real_t dt = 0.5;
+  const int steps = 20;
+  EulerGrid::DiffuseFused({fused_depleting, fused_depleted}, dt, steps);
+  for (int i = 0; i < steps; i++) {
+    depleted->Diffuse(dt);
+    depleting->Diffuse(dt);
+  }
+
+  EulerGrid::CalculateGradientFused({fused_depleting, fused_depleted});
+  depleting->CalculateGradient();
+  depleted->CalculateGradient();
+
+  for (size_t i = 0; i < depleted->GetNumBoxes(); i++) {
+    EXPECT_REAL_EQ(depleting->GetAllConcentrations()[i],
+                   fused_depleting->GetAllConcentrations()[i]);
+    EXPECT_REAL_EQ(depleted->GetAllConcentrations()[i],
+                   fused_depleted->GetAllConcentrations()[i]);
+  }
+  Real3 marker = {5, 5, 5};
+  auto expected = depleted->GetGradient(marker);
+  auto actual = fused_depleted->GetGradient(marker);
+  for (int i = 0; i < 3; i++) {
+    EXPECT_REAL_EQ(expected[i], actual[i]);
+  }
+}
+
+/// With a tolerance of zero, the sparse grid must give the same result as the
+/// EulerGrid, while only updating the bricks that the substance has reached.
+TEST(DiffusionTest, SparseEulerGrid) {
+  auto set_param = [](auto* param) {
+    param->bound_space = Param::BoundSpaceMode::kClosed;
+    param->min_bound = -100;
+    param->max_bound = 100;
+  };
+  Simulation simulation(TEST_NAME, set_param);
+  simulation.GetEnvironment()->Update();
+
+  std::vector<BoundaryConditionType> bc_types = {
+      BoundaryConditionType::kClosedBoundaries,
+      BoundaryConditionType::kOpenBoundaries,
+      BoundaryConditionType::kDirichlet, BoundaryConditionType::kNeumann,
+      BoundaryConditionType::kPeriodic};
+  for (auto bc_type : bc_types) {
+    // 40 boxes per axis, i.e. 5 bricks per axis
+    SparseEulerGrid sparse(0, "Sparse", 10.0, 0.01, 40);
+    EulerGrid reference(1, "Reference", 10.0, 0.01, 40);
+    for (DiffusionGrid* dgrid : {static_cast<DiffusionGrid*>(&sparse),
+                                 static_cast<DiffusionGrid*>(&reference)}) {
+      dgrid->Initialize();
+      dgrid->SetBoundaryConditionType(bc_type);
+      dgrid->SetBoundaryCondition(
+          std::make_unique<ConstantBoundaryCondition>(0.5));
+      dgrid->SetUpperThreshold(1e15);
+      dgrid->ChangeConcentrationBy({12, 12, 12}, 1e3);
+    }
+    ASSERT_EQ(125u, sparse.GetNumBricks());
+
+    const real_t dt = 0.25;
+    for (int i = 0; i < 20; i++) {
+      if (i == 10) {
+        // Secretion into a region that the substance has not reached yet
+        sparse.ChangeConcentrationBy({-88, 87, -88}, 1e3);
+        reference.ChangeConcentrationBy({-88, 87, -88}, 1e3);
+      }
+      sparse.Diffuse(dt);
+      reference.Diffuse(dt);
+      sparse.CalculateGradient();
+      reference.CalculateGradient();
+
+      // The first step updates all bricks. Afterwards, only the center brick
+      // and its neighbors are updated, unless the boundary values change the
+      // concentration along the boundary.
+      if (i == 1 && bc_type != BoundaryConditionType::kDirichlet &&
+          bc_type != BoundaryConditionType::kNeumann) {
+        EXPECT_EQ(7u, sparse.GetNumActiveBricks());
+      }
+    }
+
+    auto* conc_sparse = sparse.GetAllConcentrations();
+    auto* conc_reference = reference.GetAllConcentrations();
+    for (size_t i = 0; i < reference.GetNumBoxes(); i++) {
+      EXPECT_REAL_EQ(conc_reference[i], conc_sparse[i]);
+    }
+    auto* grad_sparse = sparse.GetAllGradients();
+    auto* grad_reference = reference.GetAllGradients();
+    for (size_t i = 0; i < 3 * reference.GetNumBoxes(); i++) {
+      EXPECT_REAL_EQ(grad_reference[i], grad_sparse[i]);
+    }
+  }
+}
+
+TEST(DiffusionTest, AdiDirichletBoundaries) {
+  auto set_param = [](auto* param) {
+    param->bound_space = Param::BoundSpaceMode::kClosed;
+    param->min_bound = -50;
+    param->max_bound = 50;
+    param->diffusion_boundary_condition = "Dirichlet";
+  };
+  Simulation simulation(TEST_NAME, set_param);
+  simulation.GetEnvironment()->Update();
+  auto* rm = simulation.GetResourceManager();
+
+  double decay_coef = 0.0;
+  double diff_coef = 100.0;
+  int res = 10;
+  auto* dgrid = new AdiGrid(0, "Kalium", diff_coef, decay_coef, res);
+
+  dgrid->Initialize();
+  dgrid->SetBoundaryConditionType(BoundaryConditionType::kDirichlet);
+  dgrid->SetBoundaryCondition(std::make_unique<ConstantBoundaryCondition>(1.0));
+  dgrid->SetUpperThreshold(1e15);
+  rm->AddContinuum(dgrid);
+
+  // The time step is far beyond the stability limit of the explicit scheme
+  // (dt <= dx^2 / (6 D) ~ 0.02).
+  double simulation_time_step{1.0};
+  int tot = 200;
+  for (int t = 0; t < tot; t++) {
+    dgrid->Diffuse(simulation_time_step);
+  }
+
+  auto conc = dgrid->GetAllConcentrations();
+  real_t average_concentration = 0.0;
+  for (size_t i = 0; i < dgrid->GetNumBoxes(); i++) {
+    average_concentration += conc[i];
+  }
+  average_concentration /= dgrid->GetNumBoxes();
+  EXPECT_FLOAT_EQ(average_concentration, 1.0);
+}
+
+TEST(DiffusionTest, AdiNeumannZeroBoundaries) {
+  auto set_param = [](auto* param) {
+    param->bound_space = Param::BoundSpaceMode::kClosed;
+    param->min_bound = -50;
+    param->max_bound = 50;
+    param->diffusion_boundary_condition = "Neumann";
+  };
+  Simulation simulation(TEST_NAME, set_param);
+  simulation.GetEnvironment()->Update();
+  auto* rm = simulation.GetResourceManager();
+
+  double decay_coef = 0.0;
+  double diff_coef = 10.0;
+  int res = 10;
+  double init = 1e5;
+  std::vector<Real3> sources;
+  sources.push_back({0, 0, 0});
+  sources.push_back({49, 49, 49});
+  sources.push_back({-49, -49, -49});
+
+  for (size_t s = 0; s < sources.size(); s++) {
+    auto* dgrid = new AdiGrid(0, "Kalium", diff_coef, decay_coef, res);
+    dgrid->Initialize();
+    dgrid->ChangeConcentrationBy(sources[s], init);
+    dgrid->SetBoundaryConditionType(BoundaryConditionType::kNeumann);
+    dgrid->SetBoundaryCondition(
+        std::make_unique<ConstantBoundaryCondition>(0.0));
+    dgrid->SetUpperThreshold(1e15);
+    rm->AddContinuum(dgrid);
+
+    // D * dt / dx^2 = 1, six times the explicit stability limit.
+    double simulation_time_step{10.0};
+    int tot = 100;
+    for (int t = 0; t < tot; t++) {
+      dgrid->Diffuse(simulation_time_step);
+    }
+    double expected_solution = 0.0;
+    auto conc = dgrid->GetAllConcentrations();
+    for (size_t i = 0; i < dgrid->GetNumBoxes(); i++) {
+      EXPECT_GE(conc[i], 0.0);
+      expected_solution += conc[i];
+    }
+    EXPECT_LT(std::abs(init - expected_solution) / init, 0.0001);
+    rm->RemoveContinuum(0);
+  }
+}
+
+TEST(DiffusionTest, AdiPeriodicBoundaries) {
+  auto set_param = [&](Param* param) {
+    param->bound_space = Param::BoundSpaceMode::kClosed;
+    param->min_bound = -50;
+    param->max_bound = 50;
+    param->diffusion_boundary_condition = "Periodic";
+  };
+  Simulation simulation(TEST_NAME, set_param);
+  simulation.GetEnvironment()->Update();
+  auto* rm = simulation.GetResourceManager();
+
+  double decay_coef = 0.0;
+  double diff_coef = 100.0;
+  int res = 10;
+  double init = 1e5;
+
+  // Same setup as in EulerPeriodicBoundaries: the source sits next to the
+  // boundary and the two boxes neighbouring it across the periodic boundary
+  // must see the same concentration.
+  std::vector<Real3> sources;
+  sources.push_back({45, 5, 5});
+  sources.push_back({-45, 5, 5});
+  sources.push_back({5, 45, 5});
+  sources.push_back({5, -45, 5});
+  sources.push_back({5, 5, 45});
+  sources.push_back({5, 5, -45});
+
+  std::vector<Real3> inside;
+  inside.push_back({35, 5, 5});
+  inside.push_back({-35, 5, 5});
+  inside.push_back({5, 35, 5});
+  inside.push_back({5, -35, 5});
+  inside.push_back({5, 5, 35});
+  inside.push_back({5, 5, -35});
+
+  std::vector<Real3> outside;
+  outside.push_back({-45, 5, 5});
+  outside.push_back({45, 5, 5});
+  outside.push_back({5, -45, 5});
+  outside.push_back({5, 45, 5});
+  outside.push_back({5, 5, -45});
+  outside.push_back({5, 5, 45});
+
+  for (size_t s = 0; s < sources.size(); s++) {
+    auto* dgrid = new AdiGrid(0, "Kalium", diff_coef, decay_coef, res);
+    dgrid->Initialize();
+    dgrid->SetUpperThreshold(1e15);
+    dgrid->ChangeConcentrationBy(sources[s], init);
+    rm->AddContinuum(dgrid);
+
+    double simulation_time_step{0.5};
+    int tot = 20;
+    for (int t = 0; t < tot; t++) {
+      dgrid->Diffuse(simulation_time_step);
+      auto in = dgrid->GetValue(inside[s]);
+      EXPECT_NEAR(in, dgrid->GetValue(outside[s]), 1e-4 * in);
+    }
+    double total = 0.0;
+    auto conc = dgrid->GetAllConcentrations();
+    for (size_t i = 0; i < dgrid->GetNumBoxes(); i++) {
+      total += conc[i];
+    }
+    EXPECT_LT(std::abs(init - total) / init, 0.0001);
+    rm->RemoveContinuum(0);
+  }
+}
+
+/// Compares the ADI solution obtained with a large time step against the
+/// explicit Euler solution with a small time step.
+TEST(DiffusionTest, AdiMatchesEuler) {
+  auto set_param = [](auto* param) {
+    param->bound_space = Param::BoundSpaceMode::kClosed;
+    param->min_bound = -50;
+    param->max_bound = 50;
+    param->diffusion_boundary_condition = "Neumann";
+  };
+  Simulation simulation(TEST_NAME, set_param);
+  simulation.GetEnvironment()->Update();
+
+  real_t diff_coef = 1.0;
+  real_t decay_coef = 0.01;
+  int res = 20;
+  auto* euler = new EulerGrid(0, "Euler", diff_coef, decay_coef, res);
+  auto* adi = new AdiGrid(1, "Adi", diff_coef, decay_coef, res);
+  for (DiffusionGrid* dgrid : {static_cast<DiffusionGrid*>(euler),
+                               static_cast<DiffusionGrid*>(adi)}) {
+    dgrid->Initialize();
+    dgrid->SetBoundaryConditionType(BoundaryConditionType::kNeumann);
+    dgrid->SetBoundaryCondition(
+        std::make_unique<ConstantBoundaryCondition>(0.0));
+    dgrid->SetUpperThreshold(1e15);
+    dgrid->ChangeConcentrationBy({0, 0, 0}, 1e3);
+  }
+
+  // Euler: D * dt / dx^2 = 0.004, ADI: D * dt / dx^2 = 0.4
+  for (int t = 0; t < 1000; t++) {
+    euler->Diffuse(0.1);
+  }
+  for (int t = 0; t < 10; t++) {
+    adi->Diffuse(10.0);
+  }
+
+  auto conc_euler = euler->GetAllConcentrations();
+  auto conc_adi = adi->GetAllConcentrations();
+  real_t max_euler = 0.0;
+  real_t max_error = 0.0;
+  for (size_t i = 0; i < euler->GetNumBoxes(); i++) {
+    max_euler = std::max(max_euler, conc_euler[i]);
+    max_error = std::max(max_error, std::abs(conc_euler[i] - conc_adi[i]));
+  }
+  EXPECT_GT(max_euler, 0.0);
+  EXPECT_LT(max_error / max_euler, 0.05);
+
+  delete euler;
+  delete adi;
+}
+
 TEST(DiffusionTest, DynamicTimeStepping) {
   auto set_param = [](auto* param) {
     param->bound_space = Param::BoundSpaceMode::kClosed;
@@ -128,4 +128,82 @@ TEST(KDTreeTest, FindAllNeighbors) {
   TestNeighborSearch(simulation);
 }
 
+// Compares the batched radius search with the per-agent ForEachNeighbor on a
+// tree that is large enough to be built concurrently.
+TEST(KDTreeTest, FindNeighborsBatch) {
+  auto set_param = [](auto* param) { param->environment = "kd_tree"; };
+  Simulation simulation(TEST_NAME, set_param);
+  auto* rm = simulation.GetResourceManager();
+  auto* kdtree = dynamic_cast<KDTreeEnvironment*>(simulation.GetEnvironment());
+  ASSERT_NE(kdtree, nullptr);
+
+  CellFactory(rm, 12);
+  kdtree->Update();
+
+  std::vector<Real3> query_positions;
+  std::vector<Agent*> query_agents;
+  rm->ForEachAgent([&](Agent* agent) {
+    query_positions.push_back(agent->GetPosition());
+    query_agents.push_back(agent);
+  });
+
+  real_t squared_radius = 1201;
+  std::vector<std::vector<std::pair<uint64_t, real_t>>> batch;
+  kdtree->FindNeighborsBatch(query_positions, squared_radius, &batch);
+  ASSERT_EQ(query_positions.size(), batch.size());
+
+  for (size_t i = 0; i < query_agents.size(); ++i) {
+    std::vector<AgentUid> expected;
+    auto fill = L2F([&](Agent* neighbor, real_t) {
+      expected.push_back(neighbor->GetUid());
+    });
+    kdtree->ForEachNeighbor(fill, *query_agents[i], squared_radius);
+
+    std::vector<AgentUid> actual;
+    for (auto& n : batch[i]) {
+      auto* neighbor = kdtree->GetAgent(n.first);
+      EXPECT_EQ(neighbor->GetPosition(), kdtree->GetPosition(n.first));
+      auto diff = neighbor->GetPosition() - query_positions[i];
+      EXPECT_NEAR(diff * diff, n.second, 1e-6);
+      if (neighbor != query_agents[i]) {
+        actual.push_back(neighbor->GetUid());
+      }
+    }
+    std::sort(expected.begin(), expected.end());
+    std::sort(actual.begin(), actual.end());
+    EXPECT_EQ(expected, actual);
+  }
+}
+
+// Agents that move after the update must be reported with their current
+// distance.
+TEST(KDTreeTest, DistanceAfterMovement) {
+  auto set_param = [](auto* param) { param->environment = "kd_tree"; };
+  Simulation simulation(TEST_NAME, set_param);
+  auto* rm = simulation.GetResourceManager();
+  auto* env = simulation.GetEnvironment();
+
+  auto* query = new Cell({0, 0, 0});
+  auto* neighbor = new Cell({10, 0, 0});
+  auto* leaving = new Cell({0, 10, 0});
+  for (auto* cell : {query, neighbor, leaving}) {
+    cell->SetDiameter(30);
+    rm->AddAgent(cell);
+  }
+  env->Update();
+
+  neighbor->SetPosition({12, 0, 0});
+  leaving->SetPosition({0, 40, 0});
+
+  std::vector<std::pair<AgentUid, real_t>> result;
+  auto fill = L2F([&](Agent* agent, real_t squared_distance) {
+    result.push_back({agent->GetUid(), squared_distance});
+  });
+  env->ForEachNeighbor(fill, *query, 400);
+
+  ASSERT_EQ(1u, result.size());
+  EXPECT_EQ(neighbor->GetUid(), result[0].first);
+  EXPECT_REAL_EQ(144, result[0].second);
+}
+
 }  // namespace bdm
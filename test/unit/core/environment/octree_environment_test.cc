@@ -128,4 +128,96 @@ TEST(OctreeTest, FindAllNeighbors) {
   TestNeighborSearch(simulation);
 }
 
+// Compares the batched radius search with a brute force search. The octree is
+// rebuilt after the agents moved, to check that reusing the octants of the
+// previous iteration does not corrupt the tree.
+TEST(OctreeTest, FindNeighborsBatch) {
+  auto set_param = [](auto* param) { param->environment = "octree"; };
+  Simulation simulation(TEST_NAME, set_param);
+  auto* rm = simulation.GetResourceManager();
+  auto* octree = dynamic_cast<OctreeEnvironment*>(simulation.GetEnvironment());
+  ASSERT_NE(octree, nullptr);
+
+  CellFactory(rm, 8);
+
+  for (int iteration = 0; iteration < 2; ++iteration) {
+    if (iteration == 1) {
+      rm->ForEachAgent([](Agent* agent) {
+        auto pos = agent->GetPosition();
+        agent->SetPosition({pos[1], pos[0] * 0.5, pos[2] + 3});
+      });
+    }
+    octree->Update();
+
+    std::vector<Real3> query_positions;
+    std::vector<Agent*> query_agents;
+    rm->ForEachAgent([&](Agent* agent) {
+      query_positions.push_back(agent->GetPosition());
+      query_agents.push_back(agent);
+    });
+
+    real_t squared_radius = 1201;
+    std::vector<std::vector<std::pair<uint64_t, real_t>>> batch;
+    octree->FindNeighborsBatch(query_positions, squared_radius, &batch);
+    ASSERT_EQ(query_positions.size(), batch.size());
+
+    for (size_t i = 0; i < query_agents.size(); ++i) {
+      // brute force
+      std::vector<AgentUid> expected;
+      for (auto* other : query_agents) {
+        auto diff = other->GetPosition() - query_positions[i];
+        if (other != query_agents[i] && diff * diff < squared_radius) {
+          expected.push_back(other->GetUid());
+        }
+      }
+
+      std::vector<AgentUid> actual;
+      for (auto& n : batch[i]) {
+        auto* neighbor = octree->GetAgent(n.first);
+        EXPECT_EQ(neighbor->GetPosition(), octree->GetPosition(n.first));
+        auto diff = neighbor->GetPosition() - query_positions[i];
+        EXPECT_NEAR(diff * diff, n.second, 1e-6);
+        EXPECT_GT(squared_radius, n.second);
+        if (neighbor != query_agents[i]) {
+          actual.push_back(neighbor->GetUid());
+        }
+      }
+      std::sort(expected.begin(), expected.end());
+      std::sort(actual.begin(), actual.end());
+      EXPECT_EQ(expected, actual);
+    }
+  }
+}
+
+// Agents that move after the update must be reported with their current
+// distance.
+TEST(OctreeTest, DistanceAfterMovement) {
+  auto set_param = [](auto* param) { param->environment = "octree"; };
+  Simulation simulation(TEST_NAME, set_param);
+  auto* rm = simulation.GetResourceManager();
+  auto* env = simulation.GetEnvironment();
+
+  auto* query = new Cell({0, 0, 0});
+  auto* neighbor = new Cell({10, 0, 0});
+  auto* leaving = new Cell({0, 10, 0});
+  for (auto* cell : {query, neighbor, leaving}) {
+    cell->SetDiameter(30);
+    rm->AddAgent(cell);
+  }
+  env->Update();
+
+  neighbor->SetPosition({12, 0, 0});
+  leaving->SetPosition({0, 40, 0});
+
+  std::vector<std::pair<AgentUid, real_t>> result;
+  auto fill = L2F([&](Agent* agent, real_t squared_distance) {
+    result.push_back({agent->GetUid(), squared_distance});
+  });
+  env->ForEachNeighbor(fill, *query, 400);
+
+  ASSERT_EQ(1u, result.size());
+  EXPECT_EQ(neighbor->GetUid(), result[0].first);
+  EXPECT_REAL_EQ(144, result[0].second);
+}
+
 }  // namespace bdm
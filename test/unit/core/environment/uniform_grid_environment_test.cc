@@ -13,8 +13,11 @@
 // -----------------------------------------------------------------------------
 
 #include "core/environment/uniform_grid_environment.h"
+#include <set>
 #include <sstream>
 #include <string>
+#include <utility>
+#include <vector>
 #include "core/agent/cell.h"
 #include "core/environment/environment.h"
 #include "core/functor.h"
@@ -151,6 +154,342 @@ TEST(UniformGridEnvironmentTest, ForEachNeighborWithoutDistance) {
   EXPECT_EQ(expected_63, neighbors[AgentUid(63)]);
 }
 
+TEST(UniformGridEnvironmentTest, ForEachNeighborPair) {
+  Simulation simulation(TEST_NAME);
+  auto* rm = simulation.GetResourceManager();
+  auto* grid =
+      static_cast<UniformGridEnvironment*>(simulation.GetEnvironment());
+
+  CellFactory(rm, 4);
+  // make sure that there are multiple cells per box
+  rm->GetAgent(AgentUid(0))->SetDiameter(60);
+
+  grid->Update();
+
+  // expected pairs (smaller uid first)
+  std::set<std::pair<AgentUid, AgentUid>> expected;
+  rm->ForEachAgent([&](Agent* agent) {
+    auto uid = agent->GetUid();
+    auto fill_pairs = L2F([&](Agent* neighbor, real_t) {
+      auto nuid = neighbor->GetUid();
+      expected.insert({std::min(uid, nuid), std::max(uid, nuid)});
+    });
+    grid->ForEachNeighbor(fill_pairs, *agent, 900);
+  });
+
+  std::vector<std::pair<AgentUid, AgentUid>> pairs;
+  auto collect_pairs = L2F([&](Agent* lhs, AgentHandle lhs_ah, Agent* rhs,
+                               AgentHandle rhs_ah, real_t squared_distance) {
+    EXPECT_EQ(lhs, rm->GetAgent(lhs_ah));
+    EXPECT_EQ(rhs, rm->GetAgent(rhs_ah));
+    EXPECT_GT(900, squared_distance);
+    auto lhs_uid = lhs->GetUid();
+    auto rhs_uid = rhs->GetUid();
+#pragma omp critical
+    pairs.push_back({std::min(lhs_uid, rhs_uid), std::max(lhs_uid, rhs_uid)});
+  });
+  grid->ForEachNeighborPair(collect_pairs, 900);
+
+  // each pair must be visited exactly once
+  std::set<std::pair<AgentUid, AgentUid>> unique_pairs(pairs.begin(),
+                                                       pairs.end());
+  EXPECT_EQ(unique_pairs.size(), pairs.size());
+  EXPECT_EQ(expected, unique_pairs);
+}
+
+TEST(UniformGridEnvironmentTest, ForEachAgentInColoredBoxes) {
+  Simulation simulation(TEST_NAME);
+  auto* rm = simulation.GetResourceManager();
+  auto* grid =
+      static_cast<UniformGridEnvironment*>(simulation.GetEnvironment());
+
+  CellFactory(rm, 10);
+  grid->Update();
+
+  // Each functor call increments the counter of the agent and of all its
+  // neighbors without synchronization. Concurrent calls for agents with
+  // overlapping neighborhoods would lose updates.
+  std::vector<uint64_t> counter(rm->GetNumAgents());
+  std::vector<uint64_t> expected(rm->GetNumAgents());
+  rm->ForEachAgent([&](Agent* agent) {
+    expected[agent->GetUid().GetIndex()]++;
+    auto count = L2F([&](Agent* neighbor, real_t) {
+      expected[neighbor->GetUid().GetIndex()]++;
+    });
+    grid->ForEachNeighbor(count, *agent, 900);
+  });
+
+  auto increment = L2F([&](Agent* agent, AgentHandle ah) {
+    EXPECT_EQ(agent, rm->GetAgent(ah));
+    counter[agent->GetUid().GetIndex()]++;
+    auto count = L2F([&](Agent* neighbor, real_t) {
+      counter[neighbor->GetUid().GetIndex()]++;
+    });
+    grid->ForEachNeighbor(count, *agent, 900);
+  });
+  grid->ForEachAgentInColoredBoxes(increment);
+  EXPECT_EQ(expected, counter);
+
+  // filter
+  std::vector<uint64_t> visited(rm->GetNumAgents());
+  auto visit = L2F([&](Agent* agent, AgentHandle) {
+    visited[agent->GetUid().GetIndex()]++;
+  });
+  auto even =
+      L2F([](Agent* agent) { return agent->GetUid().GetIndex() % 2 == 0; });
+  grid->ForEachAgentInColoredBoxes(visit, &even);
+  for (uint64_t i = 0; i < visited.size(); ++i) {
+    EXPECT_EQ(i % 2 == 0 ? 1u : 0u, visited[i]);
+  }
+}
+
+// Compares the result of ForEachNeighbor with a brute force search
+void ExpectBruteForceNeighbors(Simulation* simulation) {
+  auto* rm = simulation->GetResourceManager();
+  auto* grid =
+      static_cast<UniformGridEnvironment*>(simulation->GetEnvironment());
+
+  rm->ForEachAgent([&](Agent* agent) {
+    std::vector<AgentUid> actual;
+    auto fill_neighbor_list = L2F([&](Agent* neighbor, real_t) {
+      actual.push_back(neighbor->GetUid());
+    });
+    grid->ForEachNeighbor(fill_neighbor_list, *agent, 900);
+
+    std::vector<AgentUid> expected;
+    rm->ForEachAgent([&](Agent* neighbor) {
+      auto diff = neighbor->GetPosition() - agent->GetPosition();
+      if (neighbor != agent && diff * diff < 900) {
+        expected.push_back(neighbor->GetUid());
+      }
+    });
+
+    std::sort(actual.begin(), actual.end());
+    std::sort(expected.begin(), expected.end());
+    EXPECT_EQ(expected, actual);
+  });
+}
+
+void RunBruteForceNeighborTest(Simulation* simulation) {
+  auto* rm = simulation->GetResourceManager();
+  auto* grid =
+      static_cast<UniformGridEnvironment*>(simulation->GetEnvironment());
+
+  CellFactory(rm, 4);
+  // make sure that there are multiple cells per box
+  rm->GetAgent(AgentUid(0))->SetDiameter(60);
+
+  grid->Update();
+  ExpectBruteForceNeighbors(simulation);
+}
+
+TEST(UniformGridEnvironmentTest, SoaSnapshotBruteForce) {
+  auto set_param = [](Param* param) {
+    param->uniform_grid_soa_snapshot = true;
+  };
+  Simulation simulation(TEST_NAME, set_param);
+  RunBruteForceNeighborTest(&simulation);
+
+  auto* rm = simulation.GetResourceManager();
+  auto* grid =
+      static_cast<UniformGridEnvironment*>(simulation.GetEnvironment());
+  auto* snapshot = grid->GetAgentSnapshot();
+  ASSERT_TRUE(snapshot != nullptr);
+  EXPECT_EQ(rm->GetNumAgents(), snapshot->size());
+  EXPECT_EQ(rm->GetNumAgents(), snapshot->box_offsets[grid->GetNumBoxes()]);
+}
+
+// Agents that move after the update must be reported with their current
+// distance.
+TEST(UniformGridEnvironmentTest, SoaSnapshotDistanceAfterMovement) {
+  auto set_param = [](Param* param) {
+    param->uniform_grid_soa_snapshot = true;
+  };
+  Simulation simulation(TEST_NAME, set_param);
+  auto* rm = simulation.GetResourceManager();
+  auto* env = simulation.GetEnvironment();
+
+  auto* query = new Cell({0, 0, 0});
+  auto* neighbor = new Cell({10, 0, 0});
+  auto* leaving = new Cell({0, 18, 0});
+  auto* arriving = new Cell({0, 0, 22});
+  for (auto* cell : {query, neighbor, leaving, arriving}) {
+    cell->SetDiameter(30);
+    rm->AddAgent(cell);
+  }
+  env->Update();
+
+  // displacements below Param::simulation_max_displacement
+  neighbor->SetPosition({12, 0, 0});
+  leaving->SetPosition({0, 21, 0});
+  arriving->SetPosition({0, 0, 19});
+
+  std::vector<std::pair<AgentUid, real_t>> result;
+  auto fill = L2F([&](Agent* agent, real_t squared_distance) {
+    result.push_back({agent->GetUid(), squared_distance});
+  });
+  env->ForEachNeighbor(fill, *query, 400);
+  std::sort(result.begin(), result.end());
+
+  ASSERT_EQ(2u, result.size());
+  EXPECT_EQ(neighbor->GetUid(), result[0].first);
+  EXPECT_REAL_EQ(144, result[0].second);
+  EXPECT_EQ(arriving->GetUid(), result[1].first);
+  EXPECT_REAL_EQ(361, result[1].second);
+}
+
+TEST(UniformGridEnvironmentTest, CountingSortBruteForce) {
+  auto set_param = [](Param* param) {
+    param->uniform_grid_counting_sort = true;
+  };
+  Simulation simulation(TEST_NAME, set_param);
+  RunBruteForceNeighborTest(&simulation);
+
+  // every agent must be assigned to the box that corresponds to its position
+  auto* rm = simulation.GetResourceManager();
+  auto* grid =
+      static_cast<UniformGridEnvironment*>(simulation.GetEnvironment());
+  rm->ForEachAgent([&](Agent* agent) {
+    EXPECT_EQ(grid->GetBoxIndex(agent->GetPosition()), agent->GetBoxIdx());
+  });
+}
+
+TEST(UniformGridEnvironmentTest, IncrementalUpdate) {
+  auto set_param = [](Param* param) {
+    param->uniform_grid_incremental_update = true;
+  };
+  Simulation simulation(TEST_NAME, set_param);
+  auto* rm = simulation.GetResourceManager();
+  auto* grid =
+      static_cast<UniformGridEnvironment*>(simulation.GetEnvironment());
+
+  CellFactory(rm, 4);
+  grid->ForcedUpdate();
+  ExpectBruteForceNeighbors(&simulation);
+
+  // move agents to different boxes without changing the grid dimensions
+  rm->GetAgent(AgentUid(0))->SetPosition({35, 35, 5});
+  rm->GetAgent(AgentUid(21))->SetPosition({45, 5, 55});
+  rm->GetAgent(AgentUid(63))->SetPosition({1, 1, 1});
+  grid->ForcedUpdate();
+  ExpectBruteForceNeighbors(&simulation);
+  rm->ForEachAgent([&](Agent* agent) {
+    EXPECT_EQ(grid->GetBoxIndex(agent->GetPosition()), agent->GetBoxIdx());
+  });
+
+  // removing agents invalidates agent handles and requires a full update
+  rm->RemoveAgent(AgentUid(5));
+  rm->GetAgent(AgentUid(42))->SetPosition({59, 0, 0});
+  grid->ForcedUpdate();
+  ExpectBruteForceNeighbors(&simulation);
+
+  // grid dimensions change
+  rm->GetAgent(AgentUid(42))->SetPosition({100, 0, 0});
+  grid->ForcedUpdate();
+  ExpectBruteForceNeighbors(&simulation);
+}
+
+TEST(UniformGridEnvironmentTest, VerletLists) {
+  auto set_param = [](Param* param) {
+    param->uniform_grid_verlet_skin = 10;
+    param->simulation_max_displacement = 1;
+  };
+  Simulation simulation(TEST_NAME, set_param);
+  auto* rm = simulation.GetResourceManager();
+  auto* grid =
+      static_cast<UniformGridEnvironment*>(simulation.GetEnvironment());
+
+  CellFactory(rm, 4);
+  grid->ForcedUpdate();
+  // box length includes the skin distance
+  EXPECT_EQ(40, grid->GetBoxLength());
+  ExpectBruteForceNeighbors(&simulation);
+
+  // small displacement: lists and grid are not rebuilt, but the reported
+  // distances must be up to date
+  auto* agent = rm->GetAgent(AgentUid(2));
+  auto box_idx = agent->GetBoxIdx();
+  agent->SetPosition({38, 0, 0});
+  rm->GetAgent(AgentUid(21))->SetPosition({18, 21, 22});
+  grid->ForcedUpdate();
+  EXPECT_EQ(box_idx, agent->GetBoxIdx());
+  EXPECT_NE(box_idx, grid->GetBoxIndex(agent->GetPosition()));
+  ExpectBruteForceNeighbors(&simulation);
+
+  // large displacement: lists must be rebuilt
+  rm->GetAgent(AgentUid(5))->SetPosition({45, 5, 5});
+  grid->ForcedUpdate();
+  ExpectBruteForceNeighbors(&simulation);
+
+  // removed agents invalidate the lists
+  rm->RemoveAgent(AgentUid(6));
+  grid->ForcedUpdate();
+  ExpectBruteForceNeighbors(&simulation);
+
+  // an agent that is replaced by a new one (same number of agents, the new
+  // agent might reuse the memory of the removed one) invalidates the lists
+  rm->RemoveAgent(AgentUid(7));
+  auto* cell = new Cell({25, 5, 5});
+  cell->SetDiameter(30);
+  rm->AddAgent(cell);
+  grid->ForcedUpdate();
+  ExpectBruteForceNeighbors(&simulation);
+}
+
+TEST(UniformGridEnvironmentTest, TwoBoxesPerRadius) {
+  auto set_param = [](Param* param) {
+    param->uniform_grid_boxes_per_radius = 2;
+  };
+  Simulation simulation(TEST_NAME, set_param);
+  auto* grid =
+      static_cast<UniformGridEnvironment*>(simulation.GetEnvironment());
+  RunBruteForceNeighborTest(&simulation);
+  // the largest agent has a diameter of 60
+  EXPECT_EQ(30, grid->GetBoxLength());
+  EXPECT_EQ(60, grid->GetMaxSearchRadius());
+}
+
+TEST(UniformGridEnvironmentTest, TwoBoxesPerRadiusSoaSnapshot) {
+  auto set_param = [](Param* param) {
+    param->uniform_grid_boxes_per_radius = 2;
+    param->uniform_grid_soa_snapshot = true;
+  };
+  Simulation simulation(TEST_NAME, set_param);
+  RunBruteForceNeighborTest(&simulation);
+}
+
+TEST(UniformGridEnvironmentTest, StencilAdjacency) {
+  Simulation simulation(TEST_NAME);
+  auto* rm = simulation.GetResourceManager();
+  // 3 x 3 x 3 cells; each one in a separate box
+  for (size_t i = 0; i < 3; i++) {
+    for (size_t j = 0; j < 3; j++) {
+      for (size_t k = 0; k < 3; k++) {
+        Cell* cell = new Cell({k * 30.0, j * 30.0, i * 30.0});
+        cell->SetDiameter(30);
+        rm->AddAgent(cell);
+      }
+    }
+  }
+
+  std::vector<std::pair<UniformGridEnvironment::Adjacency, uint64_t>>
+      expected_sizes = {{UniformGridEnvironment::kLow, 7},
+                        {UniformGridEnvironment::kMedium, 19},
+                        {UniformGridEnvironment::kHigh, 27}};
+  for (auto& el : expected_sizes) {
+    auto* grid = new UniformGridEnvironment(el.first);
+    simulation.SetEnvironment(grid);
+    grid->Update();
+
+    // center cell
+    auto* agent = rm->GetAgent(AgentUid(13));
+    uint64_t num_neighbors = 0;
+    auto count = L2F([&](Agent* neighbor) { num_neighbors++; });
+    grid->ForEachNeighbor(count, *agent, nullptr);
+    EXPECT_EQ(el.second - 1, num_neighbors);
+  }
+}
+
 void RunUpdateGridTest(Simulation* simulation) {
   auto* rm = simulation->GetResourceManager();
   auto* grid =
@@ -221,6 +560,39 @@ TEST(UniformGridEnvironmentTest, UpdateGrid) {
   RunUpdateGridTest(&simulation);
 }
 
+void RunRemoveAllAgentsTest(Simulation* simulation) {
+  auto* rm = simulation->GetResourceManager();
+  auto* grid =
+      static_cast<UniformGridEnvironment*>(simulation->GetEnvironment());
+
+  CellFactory(rm, 4);
+  grid->ForcedUpdate();
+
+  rm->ClearAgents();
+  grid->ForcedUpdate();
+
+  // query agent inside a box that contained agents before the removal
+  Cell query({30, 30, 30});
+  query.SetBoxIdx(grid->GetBoxIndex(query.GetPosition()));
+  uint64_t num_neighbors = 0;
+  auto count = L2F([&](Agent*, real_t) { num_neighbors++; });
+  grid->ForEachNeighbor(count, query, 900);
+  EXPECT_EQ(0u, num_neighbors);
+}
+
+TEST(UniformGridEnvironmentTest, RemoveAllAgents) {
+  Simulation simulation(TEST_NAME);
+  RunRemoveAllAgentsTest(&simulation);
+}
+
+TEST(UniformGridEnvironmentTest, RemoveAllAgentsSoaSnapshot) {
+  auto set_param = [](Param* param) {
+    param->uniform_grid_soa_snapshot = true;
+  };
+  Simulation simulation(TEST_NAME, set_param);
+  RunRemoveAllAgentsTest(&simulation);
+}
+
 TEST(UniformGridEnvironmentTest, NoRaceConditionDuringUpdate) {
   Simulation simulation(TEST_NAME);
   auto* rm = simulation.GetResourceManager();
@@ -458,6 +830,30 @@ TEST(UniformGridEnvironmentTest, FindAllNeighbors) {
   TestNeighborSearch(simulation);
 }
 
+TEST(UniformGridEnvironmentTest, FindAllNeighborsSoaSnapshot) {
+  auto set_param = [](auto* param) {
+    param->environment = "uniform_grid";
+    param->uniform_grid_soa_snapshot = true;
+    param->unschedule_default_operations = {"load balancing",
+                                            "mechanical forces"};
+  };
+  Simulation simulation(TEST_NAME, set_param);
+
+  TestNeighborSearch(simulation);
+}
+
+TEST(UniformGridEnvironmentTest, FindAllNeighborsCountingSort) {
+  auto set_param = [](auto* param) {
+    param->environment = "uniform_grid";
+    param->uniform_grid_counting_sort = true;
+    param->unschedule_default_operations = {"load balancing",
+                                            "mechanical forces"};
+  };
+  Simulation simulation(TEST_NAME, set_param);
+
+  TestNeighborSearch(simulation);
+}
+
 // Tests if ForEachNeighbor of the respective environment finds the correct
 // number of neighbors. The same test is implemented for kdtree and octree
 // environments. Important: In contrast to the previous test, load balancing
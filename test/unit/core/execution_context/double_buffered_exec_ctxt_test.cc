@@ -0,0 +1,188 @@
+// -----------------------------------------------------------------------------
+//
+// Copyright (C) 2021 CERN & University of Surrey for the benefit of the
+// BioDynaMo collaboration. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+//
+// See the LICENSE file distributed with this work for details.
+// See the NOTICE file distributed with this work for additional information
+// regarding copyright ownership.
+//
+// -----------------------------------------------------------------------------
+
+#include <gtest/gtest.h>
+#include <unordered_map>
+
+#include "core/execution_context/double_buffered_exec_ctxt.h"
+#include "core/operation/operation_registry.h"
+#include "core/resource_manager.h"
+#include "unit/test_util/test_agent.h"
+#include "unit/test_util/test_util.h"
+
+namespace bdm {
+namespace double_buffered_exec_ctxt_test_internal {
+
+/// Uid of the partner of each agent
+static std::unordered_map<AgentUid, AgentUid> partners;
+
+// -----------------------------------------------------------------------------
+/// Each agent takes over the diameter, position and data of its partner.
+/// The result only depends on the order of execution if the partner already
+/// observes the new values.
+struct DoubleBufferedSwapOp : public AgentOperationImpl {
+  BDM_OP_HEADER(DoubleBufferedSwapOp);
+
+  void operator()(Agent* agent) override {
+    auto* sim = Simulation::GetActive();
+    auto* ctxt = bdm_static_cast<DoubleBufferedExecutionContext*>(
+        sim->GetExecutionContext());
+    auto* partner = sim->GetResourceManager()->GetAgent(
+        partners[agent->GetUid()]);
+    agent->SetDiameter(ctxt->GetPreviousDiameter(*partner));
+    agent->SetPosition(ctxt->GetPreviousPosition(*partner));
+    static_cast<TestAgent*>(agent)->SetData(
+        ctxt->GetPrevious<int>(*partner, 0));
+  }
+};
+
+BDM_REGISTER_OP(DoubleBufferedSwapOp, "DoubleBufferedSwapOp", kCpu);
+
+// -----------------------------------------------------------------------------
+DoubleBufferedField DataField() {
+  return DoubleBufferedField::Create<int>(
+      [](const Agent* a) {
+        return static_cast<const TestAgent*>(a)->GetData();
+      },
+      [](Agent* a, int data) { static_cast<TestAgent*>(a)->SetData(data); });
+}
+
+// -----------------------------------------------------------------------------
+TEST(DoubleBufferedExecutionContext, Execute) {
+  Simulation sim(TEST_NAME);
+  DoubleBufferedExecutionContext::Use(&sim, {DataField()});
+
+  auto* ctxt = bdm_static_cast<DoubleBufferedExecutionContext*>(
+      sim.GetExecutionContext());
+  auto* rm = sim.GetResourceManager();
+
+  auto* a0 = new TestAgent({1, 2, 3});
+  a0->SetDiameter(10);
+  a0->SetData(100);
+  auto* a1 = new TestAgent({4, 5, 6});
+  a1->SetDiameter(20);
+  a1->SetData(200);
+  partners[a0->GetUid()] = a1->GetUid();
+  partners[a1->GetUid()] = a0->GetUid();
+  ctxt->AddAgent(a0);
+  ctxt->AddAgent(a1);
+
+  ctxt->SetupIterationAll(sim.GetAllExecCtxts());
+  ctxt->SetupAgentOpsAll(sim.GetAllExecCtxts());
+  ASSERT_EQ(2u, rm->GetNumAgents());
+
+  auto* op = NewOperation("DoubleBufferedSwapOp");
+  std::vector<Operation*> operations = {op};
+  ctxt->Execute(a0, rm->GetAgentHandle(a0->GetUid()), operations);
+
+  // a0 still shows its previous state until the changes are committed
+  EXPECT_REAL_EQ(10, a0->GetDiameter());
+  EXPECT_ARR_NEAR(a0->GetPosition(), {1, 2, 3});
+  EXPECT_EQ(100, a0->GetData());
+  EXPECT_REAL_EQ(10, ctxt->GetPreviousDiameter(*a0));
+  EXPECT_ARR_NEAR(ctxt->GetPreviousPosition(*a0), {1, 2, 3});
+  EXPECT_EQ(100, ctxt->GetPrevious<int>(*a0, 0));
+
+  ctxt->Execute(a1, rm->GetAgentHandle(a1->GetUid()), operations);
+
+  // commit
+  ctxt->TearDownAgentOpsAll(sim.GetAllExecCtxts());
+
+  EXPECT_REAL_EQ(20, a0->GetDiameter());
+  EXPECT_ARR_NEAR(a0->GetPosition(), {4, 5, 6});
+  EXPECT_EQ(200, a0->GetData());
+  EXPECT_REAL_EQ(10, a1->GetDiameter());
+  EXPECT_ARR_NEAR(a1->GetPosition(), {1, 2, 3});
+  EXPECT_EQ(100, a1->GetData());
+
+  partners.clear();
+  delete op;
+}
+
+// -----------------------------------------------------------------------------
+TEST(DoubleBufferedExecutionContext, Simulate) {
+  Simulation sim(TEST_NAME);
+  DoubleBufferedExecutionContext::Use(&sim, {DataField()});
+  auto* rm = sim.GetResourceManager();
+
+  std::vector<TestAgent*> agents;
+  for (int i = 0; i < 100; ++i) {
+    auto* agent = new TestAgent({i * 10.0, 0, 0});
+    agent->SetDiameter(5);
+    agent->SetData(i);
+    agents.push_back(agent);
+    rm->AddAgent(agent);
+  }
+  for (int i = 0; i < 100; i += 2) {
+    partners[agents[i]->GetUid()] = agents[i + 1]->GetUid();
+    partners[agents[i + 1]->GetUid()] = agents[i]->GetUid();
+  }
+  auto* op = NewOperation("DoubleBufferedSwapOp");
+  sim.GetScheduler()->ScheduleOp(op);
+  sim.GetScheduler()->Simulate(1);
+
+  for (int i = 0; i < 100; ++i) {
+    auto partner = i % 2 == 0 ? i + 1 : i - 1;
+    EXPECT_EQ(partner, agents[i]->GetData());
+    EXPECT_REAL_EQ(partner * 10.0, agents[i]->GetPosition()[0]);
+  }
+  partners.clear();
+}
+
+// -----------------------------------------------------------------------------
+TEST(DoubleBufferedExecutionContext, GetPreviousNewAgent) {
+  Simulation sim(TEST_NAME);
+  DoubleBufferedExecutionContext::Use(&sim, {DataField()});
+
+  auto* ctxt = bdm_static_cast<DoubleBufferedExecutionContext*>(
+      sim.GetExecutionContext());
+  auto* agent = new TestAgent({1, 2, 3});
+  sim.GetResourceManager()->AddAgent(agent);
+
+  ctxt->SetupIterationAll(sim.GetAllExecCtxts());
+  ctxt->SetupAgentOpsAll(sim.GetAllExecCtxts());
+
+  // agents created during the agent operations are not buffered
+  auto* new_agent = new TestAgent({4, 5, 6});
+  new_agent->SetDiameter(7);
+  new_agent->SetData(8);
+  ctxt->AddAgent(new_agent);
+  EXPECT_ARR_NEAR(ctxt->GetPreviousPosition(*new_agent), {4, 5, 6});
+  EXPECT_REAL_EQ(7, ctxt->GetPreviousDiameter(*new_agent));
+  EXPECT_EQ(8, ctxt->GetPrevious<int>(*new_agent, 0));
+
+  ctxt->TearDownAgentOpsAll(sim.GetAllExecCtxts());
+  ctxt->TearDownIterationAll(sim.GetAllExecCtxts());
+}
+
+// -----------------------------------------------------------------------------
+TEST(DoubleBufferedExecutionContextDeathTest, GetPreviousTypeMismatch) {
+  ASSERT_DEATH(
+      {
+        Simulation sim(TEST_NAME);
+        DoubleBufferedExecutionContext::Use(&sim, {DataField()});
+
+        auto* ctxt = bdm_static_cast<DoubleBufferedExecutionContext*>(
+            sim.GetExecutionContext());
+        auto* agent = new TestAgent({1, 2, 3});
+        sim.GetResourceManager()->AddAgent(agent);
+        ctxt->SetupIterationAll(sim.GetAllExecCtxts());
+        ctxt->SetupAgentOpsAll(sim.GetAllExecCtxts());
+        ctxt->GetPrevious<double>(*agent, 0);
+      },
+      ".*Type does not match DoubleBufferedField 0.*");
+}
+
+}  // namespace double_buffered_exec_ctxt_test_internal
+}  // namespace bdm
@@ -390,6 +390,33 @@ TEST(InPlaceExecutionContext, PushBackMultithreadingTest) {
   }
 }
 
+TEST(InPlaceExecutionContext, ThreadSafeAgentUidMapConcurrentGrowth) {
+  Simulation simulation(TEST_NAME);
+  using Map = InPlaceExecutionContext::ThreadSafeAgentUidMap;
+  Map map;
+  EXPECT_EQ(Map::kBatchSize, map.Size());
+
+  // insert out of order from several threads such that multiple threads
+  // race for the allocation of the same buckets
+  std::vector<TestAgent> agents(200000);
+#pragma omp parallel for
+  for (uint64_t i = 0; i < agents.size(); ++i) {
+    auto idx = agents.size() - 1 - i;
+    map.Insert(AgentUid(idx), &agents[idx]);
+  }
+  EXPECT_LE(agents.size(), map.Size());
+  for (uint64_t i = 0; i < agents.size(); ++i) {
+    EXPECT_EQ(&agents[i], map[AgentUid(i)]);
+  }
+
+  // buckets are never moved
+  const auto* before = &map[AgentUid(0)];
+  map.Resize(10 * agents.size());
+  EXPECT_LE(10 * agents.size(), map.Size());
+  EXPECT_EQ(before, &map[AgentUid(0)]);
+  EXPECT_EQ(nullptr, map[AgentUid(10 * agents.size() - 1)]);
+}
+
 TEST(InPlaceExecutionContext, DefaultSearchRadius) {
   Simulation sim(TEST_NAME);
   auto* env = sim.GetEnvironment();
@@ -499,5 +526,74 @@ TEST(InPlaceExecutionContext, ForEachNeighbor) {
   all_exec_ctxts[0]->ForEachNeighbor(for_each, *agent0, 400);
 }
 
+TEST(InPlaceExecutionContext, ForEachNeighborBatch) {
+  Simulation sim(TEST_NAME);
+  auto* rm = sim.GetResourceManager();
+
+  auto construct = [](const Real3& position) {
+    Cell* cell = new Cell(position);
+    cell->SetDiameter(20);
+    return cell;
+  };
+  ModelInitializer::Grid3D(3, 10, construct);
+
+  const auto& all_exec_ctxts = sim.GetAllExecCtxts();
+  all_exec_ctxts[0]->SetupIterationAll(all_exec_ctxts);
+  sim.GetEnvironment()->Update();
+
+  std::vector<Agent*> queries;
+  rm->ForEachAgent([&](Agent* agent) { queries.push_back(agent); });
+  // agents move during an iteration of the in-place execution context
+  queries[4]->SetPosition(queries[4]->GetPosition() + Real3{1, 1, 1});
+  // agent that has not been assigned to the grid yet
+  Cell new_cell(Real3{15, 15, 15});
+  queries.push_back(&new_cell);
+
+  auto expect_same_neighbors = [&](const NeighborBatch& batch) {
+    ASSERT_EQ(queries.size(), batch.size());
+    EXPECT_EQ(batch.agents.size(), batch.offsets.back());
+    EXPECT_EQ(batch.agents.size(), batch.squared_distances.size());
+    for (uint64_t q = 0; q < queries.size(); ++q) {
+      std::vector<std::pair<Agent*, real_t>> expected;
+      auto for_each = L2F([&](Agent* agent, real_t squared_distance) {
+        expected.push_back({agent, squared_distance});
+      });
+      all_exec_ctxts[0]->ForEachNeighbor(for_each, *queries[q], 101);
+
+      std::vector<std::pair<Agent*, real_t>> actual;
+      for (auto j = batch.offsets[q]; j < batch.offsets[q + 1]; ++j) {
+        actual.push_back({batch.agents[j], batch.squared_distances[j]});
+      }
+      ASSERT_EQ(expected.size(), batch.GetNumNeighbors(q));
+      std::sort(expected.begin(), expected.end());
+      std::sort(actual.begin(), actual.end());
+      for (uint64_t j = 0; j < expected.size(); ++j) {
+        EXPECT_EQ(expected[j].first, actual[j].first);
+        EXPECT_NEAR(expected[j].second, actual[j].second,
+                    abs_error<real_t>::value);
+      }
+    }
+  };
+
+  NeighborBatch batch;
+  // run twice to check that the buffer is reset
+  for (int i = 0; i < 2; ++i) {
+    all_exec_ctxts[0]->ForEachNeighborBatch(queries.data(), queries.size(),
+                                            101, &batch);
+    expect_same_neighbors(batch);
+  }
+
+  // queries that are not ordered by box
+  std::reverse(queries.begin(), queries.end());
+  all_exec_ctxts[0]->ForEachNeighborBatch(queries.data(), queries.size(), 101,
+                                          &batch);
+  expect_same_neighbors(batch);
+
+  // default implementation of ExecutionContext
+  all_exec_ctxts[0]->ExecutionContext::ForEachNeighborBatch(
+      queries.data(), queries.size(), 101, &batch);
+  expect_same_neighbors(batch);
+}
+
 }  // namespace in_place_exec_ctxt_detail
 }  // namespace bdm
@@ -285,5 +285,127 @@ TEST(MemoryManagerTest, New) {
   }
 }
 
+TEST(MemoryManagerTest, HugePagesAndNumaPolicy) {
+  MemoryManager mem_mgr(5, 1.1, 1, HugePagePolicy::kTransparent, 128);
+  mem_mgr.SetNumaPolicy(256, NumaPolicy::kLocal);
+  EXPECT_EQ(HugePagePolicy::kTransparent, mem_mgr.GetHugePagePolicy());
+  EXPECT_EQ(NumaPolicy::kLocal, mem_mgr.GetNumaPolicy(64));
+  EXPECT_EQ(NumaPolicy::kInterleave, mem_mgr.GetNumaPolicy(128));
+  EXPECT_EQ(NumaPolicy::kLocal, mem_mgr.GetNumaPolicy(256));
+
+  std::vector<void*> pointers;
+  for (uint64_t size : {64, 128, 256}) {
+    for (uint64_t i = 0; i < 10000; ++i) {
+      pointers.push_back(mem_mgr.New(size));
+    }
+  }
+
+  uint64_t page_size = sysconf(_SC_PAGESIZE);
+  auto stats = mem_mgr.GetTlbStats();
+  EXPECT_EQ(3u * ThreadInfo::GetInstance()->GetNumaNodes(), stats.size());
+  for (auto& s : stats) {
+    if (s.size == 128) {
+      EXPECT_EQ(NumaPolicy::kInterleave, s.numa_policy);
+    } else {
+      EXPECT_EQ(NumaPolicy::kLocal, s.numa_policy);
+    }
+    if (s.num_blocks == 0) {
+      continue;
+    }
+    EXPECT_EQ(0u, s.num_huge_tlb_blocks);
+    EXPECT_GE(s.pages_touched * page_size, 10000 * s.size);
+    auto max_huge_pages =
+        s.pages_touched * page_size / MemoryManager::kHugePageSize +
+        2 * s.num_blocks;
+    EXPECT_LE(s.huge_pages_touched, max_huge_pages);
+    EXPECT_GE(s.huge_pages_touched, s.num_blocks);
+  }
+
+  for (auto* p : pointers) {
+    mem_mgr.Delete(p);
+  }
+}
+
+TEST(ListTest, PopAll) {
+  List l(2);
+
+  Node n1;
+  Node n2;
+  Node n3;
+  l.PushFront(&n1);
+  l.PushFront(&n2);
+  l.PushFront(&n3);
+
+  std::vector<Node*> nodes;
+  l.PopAll(&nodes);
+  EXPECT_TRUE(l.Empty());
+  EXPECT_EQ(0u, l.Size());
+  EXPECT_FALSE(l.CanPopBackN());
+  ASSERT_EQ(3u, nodes.size());
+  EXPECT_EQ(&n3, nodes[0]);
+  EXPECT_EQ(&n2, nodes[1]);
+  EXPECT_EQ(&n1, nodes[2]);
+}
+
+TEST(MemoryManagerTest, StatsAndTrim) {
+  MemoryManager mem_mgr(5, 1.1, 1);
+  uint64_t num_elements = 20000;
+
+  std::vector<void*> pointers;
+  for (uint64_t i = 0; i < num_elements; ++i) {
+    pointers.push_back(mem_mgr.New(64));
+  }
+
+  auto stats = mem_mgr.GetStats();
+  EXPECT_EQ(num_elements * 64, stats.bytes_in_use);
+  EXPECT_LT(0u, stats.num_blocks);
+  EXPECT_GE(stats.bytes_allocated,
+            stats.bytes_in_use + stats.bytes_free + stats.bytes_uninitialized);
+  uint64_t in_use_numa = 0;
+  for (auto bytes : stats.bytes_in_use_per_numa_node) {
+    in_use_numa += bytes;
+  }
+  EXPECT_EQ(stats.bytes_in_use, in_use_numa);
+
+  // free every second element: no block is fully free
+  for (uint64_t i = 0; i < num_elements; i += 2) {
+    mem_mgr.Delete(pointers[i]);
+  }
+  stats = mem_mgr.GetStats();
+  EXPECT_EQ(num_elements / 2 * 64, stats.bytes_in_use);
+  uint64_t free_threads = 0;
+  for (auto bytes : stats.bytes_free_per_thread) {
+    free_threads += bytes;
+  }
+  uint64_t free_central = 0;
+  for (auto& pool : stats.pools) {
+    free_central += pool.bytes_free_central;
+  }
+  EXPECT_EQ(stats.bytes_free, free_threads + free_central);
+  auto allocated = stats.bytes_allocated;
+  EXPECT_EQ(0u, mem_mgr.Trim());
+  EXPECT_EQ(allocated, mem_mgr.GetStats().bytes_allocated);
+
+  for (uint64_t i = 1; i < num_elements; i += 2) {
+    mem_mgr.Delete(pointers[i]);
+  }
+  EXPECT_EQ(allocated, mem_mgr.Trim());
+  stats = mem_mgr.GetStats();
+  EXPECT_EQ(0u, stats.bytes_allocated);
+  EXPECT_EQ(0u, stats.bytes_in_use);
+  EXPECT_EQ(0u, stats.bytes_free);
+  EXPECT_EQ(0u, stats.num_blocks);
+
+  // memory manager is still usable after trimming
+  pointers.clear();
+  for (uint64_t i = 0; i < num_elements; ++i) {
+    pointers.push_back(mem_mgr.New(64));
+  }
+  EXPECT_EQ(num_elements * 64, mem_mgr.GetStats().bytes_in_use);
+  for (auto* p : pointers) {
+    mem_mgr.Delete(p);
+  }
+}
+
 }  // namespace memory_manager_detail
 }  // namespace bdm
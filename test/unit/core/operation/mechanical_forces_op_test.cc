@@ -26,5 +26,11 @@ TEST(DisplacementOpTest, ComputeNewUniformGrid) { RunTest2("uniform_grid"); }
 TEST(DisplacementOpTest, ComputeNewKDTree) { RunTest2("kd_tree"); }
 TEST(DisplacementOpTest, ComputeNewOctree) { RunTest2("octree"); }
 
+TEST(DisplacementOpTest, ComputePairwiseUniformGrid) { RunPairwiseTest(); }
+
+TEST(DisplacementOpTest, ComputePairwiseSubclass) {
+  RunPairwiseSubclassTest();
+}
+
 }  // namespace mechanical_forces_op_test_internal
 }  // namespace bdm
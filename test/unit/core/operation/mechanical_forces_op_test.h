@@ -15,12 +15,29 @@
 #ifndef UNIT_CORE_OPERATION_MECHANICAL_FORCES_OP_TEST_H_
 #define UNIT_CORE_OPERATION_MECHANICAL_FORCES_OP_TEST_H_
 
+#include <unordered_map>
+
 #include "core/agent/cell.h"
 #include "core/operation/mechanical_forces_op.h"
 #include "unit/test_util/test_util.h"
 
 namespace bdm {
 namespace mechanical_forces_op_test_internal {
+
+/// Cell that moves by a constant displacement, independent of its neighbors.
+class FixedDisplacementCell : public Cell {
+  BDM_AGENT_HEADER(FixedDisplacementCell, Cell, 1);
+
+ public:
+  FixedDisplacementCell() = default;
+  explicit FixedDisplacementCell(const Real3& position) : Cell(position) {}
+
+  Real3 CalculateDisplacement(const InteractionForce* force,
+                              real_t squared_radius, real_t dt) override {
+    return {1, 0, 0};
+  }
+};
+
 inline void RunTest(const std::string& environment) {
   auto set_param = [&](auto* param) { param->environment = environment; };
   Simulation simulation("mechanical_forces_op_test_RunTest", set_param);
@@ -161,6 +178,95 @@ inline void RunTest2(const std::string& environment) {
   delete mechanical_forces_op;
 }
 
+// Pairwise forces are calculated on the positions at the beginning of the
+// operation. Compare them with the displacements of the per-agent calculation
+// if all displacements are applied after they have been calculated.
+inline void RunPairwiseTest() {
+  auto set_param = [](auto* param) {
+    param->pairwise_mechanical_forces = true;
+  };
+  Simulation simulation("mechanical_forces_op_test_RunPairwiseTest",
+                        set_param);
+  auto* rm = simulation.GetResourceManager();
+  auto* env = simulation.GetEnvironment();
+  auto* param = simulation.GetParam();
+
+  real_t space = 20;
+  for (size_t i = 0; i < 4; i++) {
+    for (size_t j = 0; j < 4; j++) {
+      for (size_t k = 0; k < 4; k++) {
+        Cell* cell = new Cell({k * space, j * space, i * space});
+        cell->SetDiameter(30 + k + j);
+        cell->SetAdherence(0.4);
+        cell->SetMass(1.0);
+        rm->AddAgent(cell);
+      }
+    }
+  }
+
+  env->Clear();
+  env->Update();
+
+  InteractionForce force;
+  auto squared_radius = env->GetLargestAgentSize() * env->GetLargestAgentSize();
+  std::unordered_map<AgentUid, Real3> expected;
+  rm->ForEachAgent([&](Agent* agent) {
+    expected[agent->GetUid()] =
+        agent->GetPosition() +
+        agent->CalculateDisplacement(&force, squared_radius,
+                                     param->simulation_time_step);
+  });
+
+  auto* op = NewOperation("mechanical forces");
+  op->SetUp();
+  auto* ctxt = simulation.GetExecutionContext();
+  rm->ForEachAgent([&](Agent* agent, AgentHandle ah) {
+    ctxt->Execute(agent, ah, {op});
+  });
+
+  rm->ForEachAgent([&](Agent* agent) {
+    EXPECT_ARR_NEAR(expected[agent->GetUid()], agent->GetPosition());
+  });
+
+  delete op;
+}
+
+// Subclasses of Cell must use their own CalculateDisplacement, even if the
+// pairwise forces are enabled.
+inline void RunPairwiseSubclassTest() {
+  auto set_param = [](auto* param) {
+    param->pairwise_mechanical_forces = true;
+  };
+  Simulation simulation("mechanical_forces_op_test_RunPairwiseSubclassTest",
+                        set_param);
+  auto* rm = simulation.GetResourceManager();
+  auto* env = simulation.GetEnvironment();
+
+  auto* cell = new Cell({0, 0, 0});
+  cell->SetDiameter(30);
+  cell->SetMass(1.0);
+  auto* fixed = new FixedDisplacementCell({10, 0, 0});
+  fixed->SetDiameter(30);
+  rm->AddAgent(cell);
+  rm->AddAgent(fixed);
+
+  env->Clear();
+  env->Update();
+
+  auto* op = NewOperation("mechanical forces");
+  op->SetUp();
+  auto* ctxt = simulation.GetExecutionContext();
+  rm->ForEachAgent([&](Agent* agent, AgentHandle ah) {
+    ctxt->Execute(agent, ah, {op});
+  });
+
+  EXPECT_ARR_NEAR(fixed->GetPosition(), {11, 0, 0});
+  // The plain cell is pushed away from its overlapping neighbor
+  EXPECT_GT(0, cell->GetPosition()[0]);
+
+  delete op;
+}
+
 }  // namespace mechanical_forces_op_test_internal
 }  // namespace bdm
 
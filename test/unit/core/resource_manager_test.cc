@@ -14,6 +14,9 @@
 
 // I/O related code must be in header file
 #include "unit/core/resource_manager_test.h"
+#include <omp.h>
+#include <atomic>
+#include <numeric>
 #include "core/model_initializer.h"
 #include "unit/test_util/io_test.h"
 #include "unit/test_util/test_agent.h"
@@ -164,6 +167,214 @@ TEST(ResourceManagerTest, SortAndForEachAgentParallelDynamic) {
   RunSortAndForEachAgentParallelDynamic();
 }
 
+TEST(ResourceManagerTest, InPlaceLoadBalance) {
+  auto set_param = [](Param* param) { param->in_place_load_balancing = true; };
+  Simulation simulation(TEST_NAME, set_param);
+  auto* rm = simulation.GetResourceManager();
+
+  // add agents in reverse spatial order
+  std::unordered_map<AgentUid, Agent*> agents;
+  const uint64_t num_agents = 1000;
+  for (uint64_t i = 0; i < num_agents; ++i) {
+    A* a = new A(i);
+    a->SetDiameter(10);
+    a->SetPosition({(num_agents - i) * 30.0, 0, 0});
+    rm->AddAgent(a);
+    agents[a->GetUid()] = a;
+  }
+
+  simulation.GetEnvironment()->Update();
+  rm->LoadBalance();
+
+  // agents must not have been copied
+  EXPECT_EQ(num_agents, rm->GetNumAgents());
+  for (auto& entry : agents) {
+    EXPECT_EQ(entry.second, rm->GetAgent(entry.first));
+  }
+
+  // agent handles are sorted along the space filling curve
+  real_t previous_x = -1;
+  rm->ForEachAgent([&](Agent* agent, AgentHandle ah) {
+    EXPECT_EQ(ah, rm->GetAgentHandle(agent->GetUid()));
+    EXPECT_LT(previous_x, agent->GetPosition()[0]);
+    previous_x = agent->GetPosition()[0];
+  });
+}
+
+TEST(ResourceManagerTest, ForEachAgentOfTypeParallel) {
+  auto set_param = [](Param* param) { param->group_agents_by_type = true; };
+  Simulation simulation(TEST_NAME, set_param);
+  auto* rm = simulation.GetResourceManager();
+
+  for (int i = 0; i < 100; ++i) {
+    A* a = new A(i);
+    a->SetDiameter(10);
+    a->SetPosition({i * 20.0, 0, 0});
+    rm->AddAgent(a);
+    B* b = new B(i);
+    b->SetDiameter(10);
+    b->SetPosition({i * 20.0, 20, 0});
+    rm->AddAgent(b);
+  }
+
+  for (int iteration = 0; iteration < 2; ++iteration) {
+    if (iteration == 1) {
+      // the type index must be rebuilt after the agents have been copied
+      simulation.GetEnvironment()->Update();
+      rm->LoadBalance();
+    }
+    std::vector<int> a_visited(100);
+    rm->ForEachAgentOfTypeParallel<A>([&](A* a) { a_visited[a->GetData()]++; });
+    std::vector<int> b_visited(100);
+    rm->ForEachAgentOfTypeParallel<B>([&](B* b) {
+      b_visited[static_cast<int>(b->GetData())]++;
+    });
+    EXPECT_EQ(std::vector<int>(100, 1), a_visited);
+    EXPECT_EQ(std::vector<int>(100, 1), b_visited);
+  }
+
+  // all agents must be valid after load balancing
+  uint64_t num_a = 0;
+  rm->ForEachAgentOfTypeParallel<A>([&](A* a) {
+    EXPECT_TRUE(rm->ContainsAgent(a->GetUid()));
+    EXPECT_EQ(a, rm->GetAgent(a->GetUid()));
+#pragma omp atomic
+    num_a++;
+  });
+  EXPECT_EQ(100u, num_a);
+}
+
+TEST(ResourceManagerTest, CreateAndRemoveAgentsInBulk) {
+  Simulation simulation(TEST_NAME);
+  auto* rm = simulation.GetResourceManager();
+  auto* uid_generator = simulation.GetAgentUidGenerator();
+
+  rm->AddAgent(new A(-1));
+  auto first_idx = uid_generator->GetHighestIndex();
+
+  const uint64_t num_agents = 10000;
+  rm->CreateAgents(num_agents, [](uint64_t i) { return new A(i); });
+
+  EXPECT_EQ(num_agents + 1, rm->GetNumAgents());
+  EXPECT_EQ(first_idx + num_agents, uid_generator->GetHighestIndex());
+
+  // every index is created exactly once and the uids are contiguous
+  std::vector<int> created(num_agents);
+  std::vector<AgentUid> remove;
+  rm->ForEachAgent([&](Agent* agent, AgentHandle ah) {
+    EXPECT_EQ(ah, rm->GetAgentHandle(agent->GetUid()));
+    auto data = bdm_static_cast<A*>(agent)->GetData();
+    if (data == -1) {
+      return;
+    }
+    created[data]++;
+    auto idx = agent->GetUid().GetIndex();
+    EXPECT_LE(first_idx, idx);
+    EXPECT_GT(first_idx + num_agents, idx);
+    if (data % 2 == 0) {
+      remove.push_back(agent->GetUid());
+    }
+  });
+  EXPECT_EQ(std::vector<int>(num_agents, 1), created);
+
+  rm->RemoveAgents(remove);
+  EXPECT_EQ(num_agents / 2 + 1, rm->GetNumAgents());
+  for (auto& uid : remove) {
+    EXPECT_FALSE(rm->ContainsAgent(uid));
+  }
+  rm->ForEachAgent([&](Agent* agent, AgentHandle ah) {
+    EXPECT_EQ(ah, rm->GetAgentHandle(agent->GetUid()));
+    auto data = bdm_static_cast<A*>(agent)->GetData();
+    EXPECT_TRUE(data == -1 || data % 2 == 1);
+  });
+}
+
+TEST(ResourceManagerTest, ForEachAgentParallelDeterministicSmallTeam) {
+  Simulation simulation(TEST_NAME);
+  auto* rm = simulation.GetResourceManager();
+
+  const uint64_t num_agents = 1000;
+  for (uint64_t i = 0; i < num_agents; ++i) {
+    rm->AddAgent(new A(i));
+  }
+
+  auto run = [&]() {
+    std::vector<int> visited(num_agents);
+    std::vector<int> chunk_visited(rm->GetNumChunks(7));
+    auto count = L2F([&](Agent* agent, AgentHandle, uint64_t chunk) {
+      visited[bdm_static_cast<A*>(agent)->GetData()]++;
+#pragma omp atomic
+      chunk_visited[chunk]++;
+    });
+    rm->ForEachAgentParallelDeterministic(7, count);
+    EXPECT_EQ(std::vector<int>(num_agents, 1), visited);
+    EXPECT_EQ(num_agents, static_cast<uint64_t>(std::accumulate(
+                              chunk_visited.begin(), chunk_visited.end(), 0)));
+  };
+
+  // team with fewer threads than ThreadInfo::GetMaxThreads()
+  auto max_threads = omp_get_max_threads();
+  omp_set_num_threads(1);
+  run();
+  omp_set_num_threads(max_threads);
+
+  // nested one-thread team inside a task
+#pragma omp parallel
+#pragma omp single
+  {
+#pragma omp task
+    run();
+  }
+}
+
+TEST(ResourceManagerTest, NestedForEachAgentParallel) {
+  Simulation simulation(TEST_NAME);
+  auto* rm = simulation.GetResourceManager();
+
+  const uint64_t num_agents = 100;
+  for (uint64_t i = 0; i < num_agents; ++i) {
+    rm->AddAgent(new A(i));
+  }
+
+  // the inner call must not disturb the work counters of the outer call
+  std::vector<std::atomic<int>> outer_visited(num_agents);
+  std::atomic<uint64_t> inner_visits(0);
+  auto inner = L2F([&](Agent*, AgentHandle) { inner_visits++; });
+  auto outer = L2F([&](Agent* agent, AgentHandle) {
+    outer_visited[bdm_static_cast<A*>(agent)->GetData()]++;
+    if (bdm_static_cast<A*>(agent)->GetData() % 10 == 0) {
+      rm->ForEachAgentParallel(3, inner);
+    }
+  });
+  rm->ForEachAgentParallel(7, outer);
+
+  for (auto& visited : outer_visited) {
+    EXPECT_EQ(1, visited.load());
+  }
+  EXPECT_EQ(10 * num_agents, inner_visits.load());
+}
+
+TEST(ResourceManagerTest, CreateAgentsSmallTeam) {
+  Simulation simulation(TEST_NAME);
+  auto* rm = simulation.GetResourceManager();
+
+  // team with fewer threads than ThreadInfo::GetMaxThreads()
+  const uint64_t num_agents = 1001;
+  auto max_threads = omp_get_max_threads();
+  omp_set_num_threads(1);
+  rm->CreateAgents(num_agents, [](uint64_t i) { return new A(i); });
+  omp_set_num_threads(max_threads);
+
+  EXPECT_EQ(num_agents, rm->GetNumAgents());
+  std::vector<int> created(num_agents);
+  rm->ForEachAgent([&](Agent* agent, AgentHandle ah) {
+    ASSERT_TRUE(agent != nullptr);
+    EXPECT_EQ(ah, rm->GetAgentHandle(agent->GetUid()));
+    created[bdm_static_cast<A*>(agent)->GetData()]++;
+  });
+  EXPECT_EQ(std::vector<int>(num_agents, 1), created);
+}
+
 TEST(ResourceManagerTest, DiffusionGrid) {
   Simulation simulation(TEST_NAME);
   auto* rm = simulation.GetResourceManager();
@@ -16,6 +16,7 @@
 #include "core/environment/uniform_grid_environment.h"
 #include "core/model_initializer.h"
 #include "core/operation/operation_registry.h"
+#include "core/substance_initializers.h"
 #include "unit/test_util/test_agent.h"
 
 namespace bdm {
@@ -44,6 +45,11 @@ class SchedulerTest : public ::testing::Test {
     return scheduler_->GetListOfScheduledStandaloneOps();
   }
 
+  static std::vector<std::vector<Operation*>> GetStandaloneOpLevels(
+      const std::vector<Operation*>& ops) {
+    return Scheduler::GetStandaloneOpLevels(ops);
+  }
+
   void SetUp() override {}
 
   void TestBody() override {}
@@ -667,4 +673,104 @@ TEST(Scheduler, ForEachOpForEachAgent_ExecutionOrder) {
   EXPECT_EQ(AgentUid(1), execution_order[3].second);
 }
 
+struct DataAccessOp : public StandaloneOperationImpl {
+  BDM_OP_HEADER(DataAccessOp);
+  void operator()() override {
+#pragma omp atomic
+    counter++;
+  }
+  OpDataAccess GetDataAccess() const override { return access; }
+  uint64_t counter = 0;
+  OpDataAccess access = {{}, {OpResource{}}};
+};
+
+BDM_REGISTER_OP(DataAccessOp, "data_access_op", kCpu)
+
+TEST_F(SchedulerTest, ParallelStandaloneOps) {
+  auto set_param = [](Param* param) { param->parallel_standalone_ops = true; };
+  Simulation simulation(TEST_NAME, set_param);
+  auto* scheduler = simulation.GetScheduler();
+
+  std::vector<Operation*> ops;
+  for (int i = 0; i < 5; ++i) {
+    ops.push_back(NewOperation("data_access_op"));
+  }
+  auto impl = [&](int i) { return ops[i]->GetImplementation<DataAccessOp>(); };
+  // two independent substances
+  impl(0)->access = {{}, {{OpResource::kContinuum, 0}}};
+  impl(1)->access = {{{OpResource::kAgents}}, {{OpResource::kContinuum, 1}}};
+  // export of all substances
+  impl(2)->access = {{{OpResource::kContinuum}}, {{OpResource::kOutput}}};
+  // only reads agents
+  impl(3)->access = {{{OpResource::kAgents}}, {}};
+  // default: depends on everything
+
+  auto levels = SchedulerTest::GetStandaloneOpLevels(ops);
+  ASSERT_EQ(3u, levels.size());
+  EXPECT_EQ(std::vector<Operation*>({ops[0], ops[1], ops[3]}), levels[0]);
+  EXPECT_EQ(std::vector<Operation*>({ops[2]}), levels[1]);
+  EXPECT_EQ(std::vector<Operation*>({ops[4]}), levels[2]);
+
+  for (auto* op : ops) {
+    scheduler->ScheduleOp(op);
+  }
+  scheduler->Simulate(3);
+  for (int i = 0; i < 5; ++i) {
+    EXPECT_EQ(3u, impl(i)->counter);
+  }
+}
+
+TEST_F(SchedulerTest, ParallelStandaloneOpsDefaultOps) {
+  Simulation simulation(TEST_NAME);
+
+  std::vector<Operation*> ops = {
+      NewOperation("continuum"), NewOperation("load balancing"),
+      NewOperation("visualize"), NewOperation("update time series")};
+  auto levels = SchedulerTest::GetStandaloneOpLevels(ops);
+  ASSERT_EQ(3u, levels.size());
+  EXPECT_EQ(std::vector<Operation*>({ops[0]}), levels[0]);
+  EXPECT_EQ(std::vector<Operation*>({ops[1]}), levels[1]);
+  EXPECT_EQ(std::vector<Operation*>({ops[2], ops[3]}), levels[2]);
+  for (auto* op : ops) {
+    delete op;
+  }
+}
+
+/// Simulates two substances and returns their concentrations
+std::vector<std::vector<real_t>> SimulateTwoSubstances(
+    bool parallel_standalone_ops) {
+  auto set_param = [&](Param* param) {
+    param->parallel_standalone_ops = parallel_standalone_ops;
+    param->bound_space = Param::BoundSpaceMode::kClosed;
+    param->min_bound = 0;
+    param->max_bound = 250;
+  };
+  Simulation simulation("SimulateTwoSubstances", set_param);
+  simulation.GetResourceManager()->AddAgent(new TestAgent({10, 10, 10}));
+  ModelInitializer::DefineSubstance(0, "Substance0", 0.5, 0.1, 20);
+  ModelInitializer::DefineSubstance(1, "Substance1", 0.2, 0.01, 25);
+  ModelInitializer::InitializeSubstance(0,
+                                        GaussianBand(125, 50, Axis::kXAxis));
+  ModelInitializer::InitializeSubstance(1,
+                                        GaussianBand(100, 30, Axis::kYAxis));
+  simulation.GetScheduler()->Simulate(5);
+
+  std::vector<std::vector<real_t>> result;
+  for (int i = 0; i < 2; ++i) {
+    auto* dgrid = simulation.GetResourceManager()->GetDiffusionGrid(i);
+    const auto* c = dgrid->GetAllConcentrations();
+    result.emplace_back(c, c + dgrid->GetNumBoxes());
+  }
+  return result;
+}
+
+// Continua are integrated concurrently if they are independent
+TEST(Scheduler, ParallelStandaloneOpsContinuum) {
+  auto expected = SimulateTwoSubstances(false);
+  auto actual = SimulateTwoSubstances(true);
+  ASSERT_EQ(2u, actual.size());
+  EXPECT_EQ(expected[0], actual[0]);
+  EXPECT_EQ(expected[1], actual[1]);
+}
+
 }  // namespace bdm
@@ -37,6 +37,7 @@ class SimulationTest : public ::testing::Test {
       "[simulation]\n"
       "unschedule_default_operations = [\"mechanical forces\"]\n"
       "random_seed = 123\n"
+      "use_counter_based_rng = true\n"
       "output_dir = \"result-dir\"\n"
       "backup_file = \"backup.root\"\n"
       "restore_file = \"restore.root\"\n"
@@ -76,13 +77,30 @@ class SimulationTest : public ::testing::Test {
       "\n"
       "[performance]\n"
       "scheduling_batch_size = 123\n"
+      "deterministic_scheduling = true\n"
+      "parallel_standalone_ops = true\n"
+      "diffusion_temporal_blocking = 4\n"
+      "fuse_diffusion_grids = true\n"
+      "diffusion_sparse_tolerance = 0.25\n"
       "detect_static_agents = true\n"
       "cache_neighbors = true\n"
+      "pairwise_mechanical_forces = true\n"
+      "uniform_grid_soa_snapshot = true\n"
+      "uniform_grid_counting_sort = true\n"
+      "uniform_grid_incremental_update = true\n"
+      "uniform_grid_verlet_skin = 12.5\n"
+      "uniform_grid_boxes_per_radius = 2\n"
+      "uniform_grid_adjacency = \"medium\"\n"
       "use_bdm_mem_mgr = false\n"
       "mem_mgr_aligned_pages_shift = 7\n"
       "mem_mgr_growth_rate = 1.123\n"
       "mem_mgr_max_mem_per_thread_factor = 3\n"
+      "mem_mgr_huge_pages = \"transparent\"\n"
+      "mem_mgr_interleave_min_size = 512\n"
+      "mem_mgr_trim_frequency = 20\n"
       "minimize_memory_while_rebalancing = false\n"
+      "in_place_load_balancing = true\n"
+      "group_agents_by_type = true\n"
       "mapped_data_array_mode = \"cache\"\n"
       "\n"
       "[development]\n"
@@ -115,6 +133,7 @@ class SimulationTest : public ::testing::Test {
 
   void ValidateNonCLIParameter(const Param* param) {
     EXPECT_EQ(123u, param->random_seed);
+    EXPECT_TRUE(param->use_counter_based_rng);
     EXPECT_EQ("paraview", param->visualization_engine);
     EXPECT_EQ("result-dir", param->output_dir);
     EXPECT_EQ("euler", param->diffusion_method);
@@ -172,11 +191,30 @@ class SimulationTest : public ::testing::Test {
 
     // performance group
     EXPECT_EQ(123u, param->scheduling_batch_size);
+    EXPECT_TRUE(param->deterministic_scheduling);
+    EXPECT_TRUE(param->parallel_standalone_ops);
+    EXPECT_EQ(4u, param->diffusion_temporal_blocking);
+    EXPECT_TRUE(param->fuse_diffusion_grids);
+    EXPECT_NEAR(0.25, param->diffusion_sparse_tolerance,
+                abs_error<real_t>::value);
     EXPECT_TRUE(param->detect_static_agents);
     EXPECT_TRUE(param->cache_neighbors);
+    EXPECT_TRUE(param->pairwise_mechanical_forces);
+    EXPECT_TRUE(param->uniform_grid_soa_snapshot);
+    EXPECT_TRUE(param->uniform_grid_counting_sort);
+    EXPECT_TRUE(param->uniform_grid_incremental_update);
+    EXPECT_NEAR(12.5, param->uniform_grid_verlet_skin,
+                abs_error<real_t>::value);
+    EXPECT_EQ(2u, param->uniform_grid_boxes_per_radius);
+    EXPECT_EQ("medium", param->uniform_grid_adjacency);
     EXPECT_NEAR(1.123, param->mem_mgr_growth_rate, abs_error<real_t>::value);
     EXPECT_EQ(3u, param->mem_mgr_max_mem_per_thread_factor);
+    EXPECT_EQ("transparent", param->mem_mgr_huge_pages);
+    EXPECT_EQ(512u, param->mem_mgr_interleave_min_size);
+    EXPECT_EQ(20u, param->mem_mgr_trim_frequency);
     EXPECT_FALSE(param->minimize_memory_while_rebalancing);
+    EXPECT_TRUE(param->in_place_load_balancing);
+    EXPECT_TRUE(param->group_agents_by_type);
     EXPECT_EQ(Param::MappedDataArrayMode::kCache,
               param->mapped_data_array_mode);
 
@@ -0,0 +1,109 @@
+// -----------------------------------------------------------------------------
+//
+// Copyright (C) 2021 CERN & University of Surrey for the benefit of the
+// BioDynaMo collaboration. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+//
+// See the LICENSE file distributed with this work for details.
+// See the NOTICE file distributed with this work for additional information
+// regarding copyright ownership.
+//
+// -----------------------------------------------------------------------------
+
+#include "core/util/philox_rng.h"
+#include <gtest/gtest.h>
+#include <omp.h>
+#include <vector>
+
+namespace bdm {
+
+// Known answer tests from the Random123 library
+TEST(PhiloxRngTest, KnownAnswers) {
+  auto result = PhiloxRng::Philox4x32({0, 0, 0, 0}, {0, 0});
+  EXPECT_EQ(PhiloxRng::Block({0x6627e8d5, 0xe169c58d, 0xbc57ac4c, 0x9b00dbd8}),
+            result);
+
+  result = PhiloxRng::Philox4x32(
+      {0xffffffff, 0xffffffff, 0xffffffff, 0xffffffff},
+      {0xffffffff, 0xffffffff});
+  EXPECT_EQ(PhiloxRng::Block({0x408f276d, 0x41c83b0e, 0xa20bc7c6, 0x6d5451fd}),
+            result);
+
+  result = PhiloxRng::Philox4x32(
+      {0x243f6a88, 0x85a308d3, 0x13198a2e, 0x03707344},
+      {0xa4093822, 0x299f31d0});
+  EXPECT_EQ(PhiloxRng::Block({0xd16cfe09, 0x94fdcceb, 0x5001e420, 0x24126ea1}),
+            result);
+}
+
+TEST(PhiloxRngTest, Reproducible) {
+  PhiloxRng rng1(42, 7, 3, 1);
+  PhiloxRng rng2(42, 7, 3, 1);
+  for (int i = 0; i < 100; ++i) {
+    EXPECT_EQ(rng1.Uniform(), rng2.Uniform());
+    EXPECT_EQ(rng1.Gaus(), rng2.Gaus());
+  }
+
+  // every component of the key and the counter changes the numbers
+  auto first = PhiloxRng(42, 7, 3, 1).Uniform();
+  EXPECT_NE(first, PhiloxRng(43, 7, 3, 1).Uniform());
+  EXPECT_NE(first, PhiloxRng(42, 8, 3, 1).Uniform());
+  EXPECT_NE(first, PhiloxRng(42, 7, 4, 1).Uniform());
+  EXPECT_NE(first, PhiloxRng(42, 7, 3, 2).Uniform());
+}
+
+TEST(PhiloxRngTest, ThreadIndependent) {
+  const uint64_t num_agents = 10000;
+  std::vector<real_t> serial(num_agents);
+  for (uint64_t uid = 0; uid < num_agents; ++uid) {
+    serial[uid] = PhiloxRng(1, uid, 5).Uniform();
+  }
+
+  std::vector<real_t> parallel(num_agents);
+#pragma omp parallel for schedule(dynamic, 7)
+  for (uint64_t i = 0; i < num_agents; ++i) {
+    // process agents in reverse order
+    auto uid = num_agents - i - 1;
+    parallel[uid] = PhiloxRng(1, uid, 5).Uniform();
+  }
+  EXPECT_EQ(serial, parallel);
+}
+
+TEST(PhiloxRngTest, UniformArray) {
+  const uint64_t n = 100003;
+  std::vector<real_t> samples(n);
+  PhiloxRng rng(1, 2, 3);
+  rng.UniformArray(samples.data(), n, 2, 4);
+
+  real_t sum = 0;
+  for (auto sample : samples) {
+    EXPECT_LT(2, sample);
+    EXPECT_GT(4, sample);
+    sum += sample;
+  }
+  EXPECT_NEAR(3, sum / n, 0.01);
+
+  std::vector<real_t> samples2(n);
+  PhiloxRng(1, 2, 3).UniformArray(samples2.data(), n, 2, 4);
+  EXPECT_EQ(samples, samples2);
+}
+
+TEST(PhiloxRngTest, GausArray) {
+  const uint64_t n = 100003;
+  std::vector<real_t> samples(n);
+  PhiloxRng rng(1, 2, 3);
+  rng.GausArray(samples.data(), n, 1, 2);
+
+  real_t sum = 0;
+  real_t sum_sq = 0;
+  for (auto sample : samples) {
+    sum += sample;
+    sum_sq += (sample - 1) * (sample - 1);
+  }
+  EXPECT_NEAR(1, sum / n, 0.03);
+  EXPECT_NEAR(4, sum_sq / n, 0.05);
+}
+
+}  // namespace bdm
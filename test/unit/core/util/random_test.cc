@@ -18,6 +18,7 @@
 #include <TRandom3.h>
 #include <gtest/gtest.h>
 #include <limits>
+#include "core/scheduler.h"
 #include "unit/test_util/io_test.h"
 #include "unit/test_util/test_util.h"
 
@@ -52,6 +53,23 @@ TEST(RandomTest, Uniform) {
   }
 }
 
+TEST(RandomTest, GetCounterBasedRng) {
+  Simulation simulation(TEST_NAME);
+  simulation.GetScheduler()->Simulate(2);
+  auto seed = simulation.GetParam()->random_seed;
+
+  auto expected = PhiloxRng(seed, 123, 2, 4).Uniform();
+  std::vector<real_t> results(omp_get_max_threads());
+#pragma omp parallel
+  {
+    auto rng = Random::GetCounterBasedRng(123, 4);
+    results[omp_get_thread_num()] = rng.Uniform();
+  }
+  for (auto result : results) {
+    EXPECT_EQ(expected, result);
+  }
+}
+
 TEST(RandomTest, UniformArray) {
   Simulation simulation(TEST_NAME);
   auto* random = simulation.GetRandom();
@@ -49,12 +49,15 @@
 
 #include <algorithm>
 #include <array>
+#include <atomic>
 #include <cassert>
 #include <cmath>   // for abs()
 #include <cstdio>  // for fwrite()
 #include <cstdlib> // for abs()
 #include <functional>
+#include <future>
 #include <limits> // std::reference_wrapper
+#include <mutex>
 #include <stdexcept>
 #include <vector>
 
@@ -545,10 +548,13 @@ struct metric_SO3 : public Metric {
 
 /**  Parameters (see README.md) */
 struct KDTreeSingleIndexAdaptorParams {
-  KDTreeSingleIndexAdaptorParams(size_t _leaf_max_size = 10)
-      : leaf_max_size(_leaf_max_size) {}
+  KDTreeSingleIndexAdaptorParams(size_t _leaf_max_size = 10,
+                                 unsigned int _n_thread_build = 1)
+      : leaf_max_size(_leaf_max_size), n_thread_build(_n_thread_build) {}
 
   size_t leaf_max_size;
+  /** Number of threads used to build the index. 1 builds it sequentially. */
+  unsigned int n_thread_build;
 };
 
 /** Search options for KDTreeSingleIndexAdaptor::findNeighbors() */
@@ -782,6 +788,8 @@ public:
 
   size_t m_leaf_max_size;
 
+  unsigned int n_thread_build = 1; //!< Number of threads to build the index
+
   size_t m_size;                //!< Number of current points in the dataset
   size_t m_size_at_index_build; //!< Number of points in the dataset when the
                                 //!< index was built
@@ -907,6 +915,85 @@ public:
     return node;
   }
 
+  /**
+   * Same as divideTree, but builds the two subtrees of a node concurrently as
+   * long as fewer than n_thread_build threads are busy. Node allocations are
+   * serialized with \a mutex, because the pool allocator is not thread-safe.
+   * The resulting tree is identical to the one of divideTree.
+   */
+  NodePtr divideTreeConcurrent(Derived &obj, const IndexType left,
+                               const IndexType right, BoundingBox &bbox,
+                               std::atomic<unsigned int> &thread_count,
+                               std::mutex &mutex) {
+    std::unique_lock<std::mutex> lock(mutex);
+    NodePtr node = obj.pool.template allocate<Node>(); // allocate memory
+    lock.unlock();
+
+    /* If too few exemplars remain, then make this a leaf node. */
+    if ((right - left) <= static_cast<IndexType>(obj.m_leaf_max_size)) {
+      node->child1 = node->child2 = NULL; /* Mark as leaf node. */
+      node->node_type.lr.left = left;
+      node->node_type.lr.right = right;
+
+      // compute bounding-box of leaf points
+      for (int i = 0; i < (DIM > 0 ? DIM : obj.dim); ++i) {
+        bbox[i].low = dataset_get(obj, obj.vind[left], i);
+        bbox[i].high = dataset_get(obj, obj.vind[left], i);
+      }
+      for (IndexType k = left + 1; k < right; ++k) {
+        for (int i = 0; i < (DIM > 0 ? DIM : obj.dim); ++i) {
+          if (bbox[i].low > dataset_get(obj, obj.vind[k], i))
+            bbox[i].low = dataset_get(obj, obj.vind[k], i);
+          if (bbox[i].high < dataset_get(obj, obj.vind[k], i))
+            bbox[i].high = dataset_get(obj, obj.vind[k], i);
+        }
+      }
+    } else {
+      IndexType idx;
+      int cutfeat;
+      DistanceType cutval;
+      middleSplit_(obj, &obj.vind[0] + left, right - left, idx, cutfeat, cutval,
+                   bbox);
+
+      node->node_type.sub.divfeat = cutfeat;
+
+      std::future<NodePtr> left_future;
+      BoundingBox left_bbox(bbox);
+      left_bbox[cutfeat].high = cutval;
+      if (++thread_count < obj.n_thread_build) {
+        left_future = std::async(std::launch::async,
+                                 &KDTreeBaseClass::divideTreeConcurrent, this,
+                                 std::ref(obj), left, left + idx,
+                                 std::ref(left_bbox), std::ref(thread_count),
+                                 std::ref(mutex));
+      } else {
+        --thread_count;
+        node->child1 = this->divideTreeConcurrent(obj, left, left + idx,
+                                                  left_bbox, thread_count, mutex);
+      }
+
+      BoundingBox right_bbox(bbox);
+      right_bbox[cutfeat].low = cutval;
+      node->child2 = this->divideTreeConcurrent(obj, left + idx, right,
+                                                right_bbox, thread_count, mutex);
+
+      if (left_future.valid()) {
+        node->child1 = left_future.get();
+        --thread_count;
+      }
+
+      node->node_type.sub.divlow = left_bbox[cutfeat].high;
+      node->node_type.sub.divhigh = right_bbox[cutfeat].low;
+
+      for (int i = 0; i < (DIM > 0 ? DIM : obj.dim); ++i) {
+        bbox[i].low = std::min(left_bbox[i].low, right_bbox[i].low);
+        bbox[i].high = std::max(left_bbox[i].high, right_bbox[i].high);
+      }
+    }
+
+    return node;
+  }
+
   void middleSplit_(Derived &obj, IndexType *ind, IndexType count,
                     IndexType &index, int &cutfeat, DistanceType &cutval,
                     const BoundingBox &bbox) {
@@ -1180,6 +1267,7 @@ public:
     if (DIM > 0)
       BaseClassRef::dim = DIM;
     BaseClassRef::m_leaf_max_size = params.leaf_max_size;
+    BaseClassRef::n_thread_build = std::max(params.n_thread_build, 1u);
 
     // Create a permutable array of indices to the input vectors.
     init_vind();
@@ -1197,9 +1285,17 @@ public:
     if (BaseClassRef::m_size == 0)
       return;
     computeBoundingBox(BaseClassRef::root_bbox);
-    BaseClassRef::root_node =
-        this->divideTree(*this, 0, BaseClassRef::m_size,
-                         BaseClassRef::root_bbox); // construct the tree
+    if (BaseClassRef::n_thread_build == 1) {
+      BaseClassRef::root_node =
+          this->divideTree(*this, 0, BaseClassRef::m_size,
+                           BaseClassRef::root_bbox); // construct the tree
+    } else {
+      std::atomic<unsigned int> thread_count(0u);
+      std::mutex mutex;
+      BaseClassRef::root_node = this->divideTreeConcurrent(
+          *this, 0, BaseClassRef::m_size, BaseClassRef::root_bbox,
+          thread_count, mutex); // construct the tree
+    }
   }
 
   /** \name Query methods
@@ -27,6 +27,7 @@
 #include <cassert>
 #include <cmath>
 #include <cstring>  // memset.
+#include <deque>
 #include <limits>
 #include <vector>
 
@@ -346,10 +347,17 @@ class Octree
   template <typename Distance>
   static bool inside(const PointT& query, double radius, const Octant* octant);
 
+  /** \brief returns an octant from the pool; allocates a new one if all octants are in use. **/
+  Octant* allocateOctant();
+
   OctreeParams params_;
   Octant* root_;
   const ContainerT* data_;
 
+  // octants are owned by the pool and reused by subsequent calls of initialize.
+  std::deque<Octant> octants_;
+  size_t numOctants_;  // number of octants of octants_ used by the current tree
+
   std::vector<uint32_t> successors_;  // single connected list of next point indices...
 
   friend class ::OctreeTest;
@@ -365,19 +373,18 @@ Octree<PointT, ContainerT>::Octant::Octant()
 template <typename PointT, typename ContainerT>
 Octree<PointT, ContainerT>::Octant::~Octant()
 {
-  for (uint32_t i = 0; i < 8; ++i) delete child[i];
+  // children are owned by the octant pool of the octree.
 }
 
 template <typename PointT, typename ContainerT>
 Octree<PointT, ContainerT>::Octree()
-    : root_(0), data_(0)
+    : root_(0), data_(0), numOctants_(0)
 {
 }
 
 template <typename PointT, typename ContainerT>
 Octree<PointT, ContainerT>::~Octree()
 {
-  delete root_;
   if (params_.copyPoints) delete data_;
 }
 
@@ -393,7 +400,7 @@ void Octree<PointT, ContainerT>::initialize(const ContainerT& pts, const OctreeP
     data_ = &pts;
 
   const uint32_t N = pts.size();
-  successors_ = std::vector<uint32_t>(N);
+  successors_.resize(N);
 
   // determine axis-aligned bounding box.
   double min[3], max[3];
@@ -446,7 +453,7 @@ void Octree<PointT, ContainerT>::initialize(const ContainerT& pts, const std::ve
     data_ = &pts;
 
   const uint32_t N = pts.size();
-  successors_ = std::vector<uint32_t>(N);
+  successors_.resize(N);
 
   if (indexes.size() == 0) return;
 
@@ -495,20 +502,30 @@ void Octree<PointT, ContainerT>::initialize(const ContainerT& pts, const std::ve
 template <typename PointT, typename ContainerT>
 void Octree<PointT, ContainerT>::clear()
 {
-  delete root_;
   if (params_.copyPoints) delete data_;
   root_ = 0;
   data_ = 0;
+  // keep the memory of the octants and successors for the next initialize.
+  numOctants_ = 0;
   successors_.clear();
 }
 
+template <typename PointT, typename ContainerT>
+typename Octree<PointT, ContainerT>::Octant* Octree<PointT, ContainerT>::allocateOctant()
+{
+  if (numOctants_ == octants_.size()) octants_.emplace_back();
+  Octant* octant = &octants_[numOctants_++];
+  memset(&octant->child, 0, 8 * sizeof(Octant*));
+  return octant;
+}
+
 template <typename PointT, typename ContainerT>
 typename Octree<PointT, ContainerT>::Octant* Octree<PointT, ContainerT>::createOctant(double x, double y, double z,
                                                                                       double extent, uint32_t startIdx,
                                                                                       uint32_t endIdx, uint32_t size)
 {
   // For a leaf we don't have to change anything; points are already correctly linked or correctly reordered.
-  Octant* octant = new Octant;
+  Octant* octant = allocateOctant();
 
   octant->isLeaf = true;
 
@@ -529,9 +546,9 @@ typename Octree<PointT, ContainerT>::Octant* Octree<PointT, ContainerT>::createO
     octant->isLeaf = false;
 
     const ContainerT& points = *data_;
-    std::vector<uint32_t> childStarts(8, 0);
-    std::vector<uint32_t> childEnds(8, 0);
-    std::vector<uint32_t> childSizes(8, 0);
+    uint32_t childStarts[8] = {0};
+    uint32_t childEnds[8] = {0};
+    uint32_t childSizes[8] = {0};
 
     // re-link disjoint child subsets...
     uint32_t idx = startIdx;